@@ -202,6 +202,7 @@ public:
      */
     typedef typename BaseType::MatrixType MatrixType;
     typedef boost::numeric::ublas::compressed_matrix<typename MatrixType::value_type> CompressedMatrixType;
+    typedef boost::shared_ptr<const CompressedMatrixType> CompressedMatrixPointerType;
 
     /**
      * Type of Vector
@@ -238,7 +239,7 @@ public:
     , mpBezierGeometryData(rOther.mpBezierGeometryData)
     , mOrder(rOther.mOrder)
     , mNumber(rOther.mNumber)
-    , mExtractionOperator(rOther.mExtractionOperator)
+    , mpExtractionOperator(rOther.mpExtractionOperator)
     , mCtrlWeights(rOther.mCtrlWeights)
     {
         GeometryType::mpGeometryData = &(*mpBezierGeometryData);
@@ -260,7 +261,7 @@ public:
     , mpBezierGeometryData(rOther.mpBezierGeometryData)
     , mOrder(rOther.mOrder)
     , mNumber(rOther.mNumber)
-    , mExtractionOperator(rOther.mExtractionOperator)
+    , mpExtractionOperator(rOther.mpExtractionOperator)
     , mCtrlWeights(rOther.mCtrlWeights)
     {
         Geometry<TOtherPointType>::mpGeometryData = &(*mpBezierGeometryData);
@@ -293,7 +294,7 @@ public:
         GeometryType::mpGeometryData = &(*(this->mpBezierGeometryData));
         this->mOrder = rOther.mOrder;
         this->mNumber = rOther.mNumber;
-        this->mExtractionOperator = rOther.mExtractionOperator;
+        this->mpExtractionOperator = rOther.mpExtractionOperator;
         this->mCtrlWeights = rOther.mCtrlWeights;
         return *this;
     }
@@ -317,7 +318,7 @@ public:
         Geometry<TOtherPointType>::mpGeometryData = &(*(this->mpBezierGeometryData));
         this->mOrder = rOther.mOrder;
         this->mNumber = rOther.mNumber;
-        this->mExtractionOperator = rOther.mExtractionOperator;
+        this->mpExtractionOperator = rOther.mpExtractionOperator;
         this->mCtrlWeights = rOther.mCtrlWeights;
         return *this;
     }
@@ -333,7 +334,7 @@ public:
         if (mpBezierGeometryData != NULL)
         {
             pNewGeom->AssignGeometryData(DummyKnots, DummyKnots, DummyKnots,
-                mCtrlWeights, mExtractionOperator, mOrder, 0, 0,
+                mCtrlWeights, mpExtractionOperator, mOrder, 0, 0,
                 static_cast<int>(mpBezierGeometryData->DefaultIntegrationMethod()) + 1);
         }
         return pNewGeom;
@@ -825,12 +826,12 @@ public:
         BezierUtils::bernstein(bezier_functions_values, mOrder, rPoint[0]);
 
         //compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
         double denom = inner_prod(bezier_functions_values, bezier_weights);
 
         //compute the shape function values
         VectorType shape_functions_values(this->PointsNumber());
-        noalias( shape_functions_values ) = prod(mExtractionOperator, bezier_functions_values);
+        noalias( shape_functions_values ) = prod(*mpExtractionOperator, bezier_functions_values);
 
         return shape_functions_values(ShapeFunctionIndex) *
                     mCtrlWeights(ShapeFunctionIndex) / denom;
@@ -851,12 +852,12 @@ public:
         BezierUtils::bernstein(bezier_functions_values, mOrder, rPoint[0]);
 
         //compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
         double denom = inner_prod(bezier_functions_values, bezier_weights);
 
         //compute the shape function values
         rResults.resize(this->PointsNumber(), false);
-        noalias( rResults ) = prod(mExtractionOperator, bezier_functions_values);
+        noalias( rResults ) = prod(*mpExtractionOperator, bezier_functions_values);
 
         for(IndexType i = 0; i < this->PointsNumber(); ++i)
             rResults(i) *= (mCtrlWeights(i) / denom);
@@ -876,12 +877,12 @@ public:
         BezierUtils::bernstein(bezier_functions_values, bezier_functions_derivatives, mOrder, rPoint[0]);
 
         //compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
         double denom = inner_prod(bezier_functions_values, bezier_weights);
 
         //compute the shape function values
         VectorType shape_functions_values(this->PointsNumber());
-        noalias(shape_functions_values) = prod(mExtractionOperator, bezier_functions_values);
+        noalias(shape_functions_values) = prod(*mpExtractionOperator, bezier_functions_values);
         for(IndexType i = 0; i < this->PointsNumber(); ++i)
             shape_functions_values(i) *= (mCtrlWeights(i) / denom);
 
@@ -890,7 +891,7 @@ public:
         double tmp = inner_prod(bezier_functions_derivatives, bezier_weights);
         VectorType tmp_gradients =
             prod(
-                mExtractionOperator,
+                *mpExtractionOperator,
                     (1 / denom) * bezier_functions_derivatives -
                         (tmp / pow(denom, 2)) * bezier_functions_values
             );
@@ -909,12 +910,12 @@ public:
         BezierUtils::bernstein(bezier_functions_values, bezier_functions_derivatives, mOrder, rPoint[0]);
 
         //compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
         double denom = inner_prod(bezier_functions_values, bezier_weights);
 
         //compute the shape function values
         shape_functions_values.resize(this->PointsNumber(), false);
-        noalias( shape_functions_values ) = prod(mExtractionOperator, bezier_functions_values);
+        noalias( shape_functions_values ) = prod(*mpExtractionOperator, bezier_functions_values);
         for(IndexType i = 0; i < this->PointsNumber(); ++i)
             shape_functions_values(i) *= (mCtrlWeights(i) / denom);
 
@@ -923,7 +924,7 @@ public:
         double tmp = inner_prod(bezier_functions_derivatives, bezier_weights);
         VectorType tmp_gradients =
             prod(
-                mExtractionOperator,
+                *mpExtractionOperator,
                     (1 / denom) * bezier_functions_derivatives -
                         (tmp / pow(denom, 2)) * bezier_functions_values
             );
@@ -973,7 +974,7 @@ public:
                                rCoordinates[0]);
 
         //compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
         double denom = inner_prod(bezier_functions_values, bezier_weights);
 
         //compute the shape function local second gradients
@@ -981,7 +982,7 @@ public:
         double aux = inner_prod(bezier_functions_derivatives, bezier_weights);
         double aux2 = inner_prod(bezier_functions_second_derivatives, bezier_weights);
         VectorType tmp_gradients =
-            prod(mExtractionOperator,
+            prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_second_derivatives
                     - 2.0 * (aux / pow(denom, 2)) * bezier_functions_derivatives
                     - (aux2 / pow(denom, 2)) * bezier_functions_values
@@ -1014,7 +1015,7 @@ public:
                                rCoordinates[0]);
 
         //compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
         double denom = inner_prod(bezier_functions_values, bezier_weights);
 
         //compute the shape function local third gradients
@@ -1023,7 +1024,7 @@ public:
         double aux2 = inner_prod(bezier_functions_second_derivatives, bezier_weights);
         double aux3 = inner_prod(bezier_functions_third_derivatives, bezier_weights);
         VectorType tmp_gradients =
-            prod(mExtractionOperator,
+            prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_third_derivatives
                     - 3.0 * (aux / pow(denom, 2)) * bezier_functions_second_derivatives
                     + ( - 3.0 * (aux2 / pow(denom, 2))
@@ -1056,7 +1057,7 @@ public:
         rPoints.reserve(number_of_local_points);
 
         // compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
 
         // compute the Bezier control points
         typedef typename PointType::Pointer PointPointerType;
@@ -1064,7 +1065,7 @@ public:
         {
             PointPointerType pPoint = PointPointerType(new PointType(0, 0.0, 0.0, 0.0));
             for(std::size_t j = 0; j < number_of_points; ++j)
-                noalias(*pPoint) += mExtractionOperator(j, i) * this->GetPoint(j).GetInitialPosition() * mCtrlWeights[j] / bezier_weights[i];
+                noalias(*pPoint) += (*mpExtractionOperator)(j, i) * this->GetPoint(j).GetInitialPosition() * mCtrlWeights[j] / bezier_weights[i];
             pPoint->SetInitialPosition(*pPoint);
             pPoint->SetSolutionStepVariablesList(this->GetPoint(0).pGetVariablesList());
             pPoint->SetBufferSize(this->GetPoint(0).GetBufferSize());
@@ -1120,14 +1121,14 @@ public:
             rValues.resize(number_of_local_points);
 
         // compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
 
         // compute the Bezier control points
         for(std::size_t i = 0; i < number_of_local_points; ++i)
         {
             rValues[i] = TDataType(0.0);
             for(std::size_t j = 0; j < number_of_points; ++j)
-                rValues[i] += mExtractionOperator(j, i) * this->GetPoint(j).GetSolutionStepValue(rVariable) * mCtrlWeights[j] / bezier_weights[i];
+                rValues[i] += (*mpExtractionOperator)(j, i) * this->GetPoint(j).GetSolutionStepValue(rVariable) * mCtrlWeights[j] / bezier_weights[i];
         }
     }
 
@@ -1219,13 +1220,36 @@ public:
         rOStream << "    Jacobian in the origin\t : " << jacobian;
     }
 
+    /**
+     * Copy the extraction operator to a shared compressed matrix, see the overload below
+     */
+    virtual void AssignGeometryData(
+        const ValuesContainerType& Knots1,
+        const ValuesContainerType& Knots2,
+        const ValuesContainerType& Knots3,
+        const ValuesContainerType& Weights,
+        const MatrixType& ExtractionOperator,
+        const int& Degree1,
+        const int& Degree2,
+        const int& Degree3,
+        const int& NumberOfIntegrationMethod
+    )
+    {
+        this->AssignGeometryData(Knots1, Knots2, Knots3, Weights,
+            CompressedMatrixPointerType(new CompressedMatrixType(ExtractionOperator)),
+            Degree1, Degree2, Degree3, NumberOfIntegrationMethod);
+    }
+
+    /**
+     * TO BE CALLED BY ELEMENT. The extraction operator is shared, not copied.
+     */
     virtual void AssignGeometryData
     (
         const ValuesContainerType& Knots1,
         const ValuesContainerType& Knots2,
         const ValuesContainerType& Knots3,
         const ValuesContainerType& Weights,
-        const MatrixType& ExtractionOperator,
+        const CompressedMatrixPointerType& pExtractionOperator,
         const int& Degree1,
         const int& Degree2,
         const int& Degree3,
@@ -1235,12 +1259,12 @@ public:
         mCtrlWeights = Weights;
         mOrder = Degree1;
         mNumber = mOrder + 1;
-        mExtractionOperator = ExtractionOperator;
+        mpExtractionOperator = pExtractionOperator;
 
         // size checking
-        if(mExtractionOperator.size1() != this->PointsNumber())
+        if(mpExtractionOperator->size1() != this->PointsNumber())
             KRATOS_THROW_ERROR(std::logic_error, "The number of row of extraction operator must be equal to number of nodes", __FUNCTION__)
-        if(mExtractionOperator.size2() != mNumber)
+        if(mpExtractionOperator->size2() != mNumber)
             KRATOS_THROW_ERROR(std::logic_error, "The number of column of extraction operator must be equal to (p_u+1)", __FUNCTION__)
         if(mCtrlWeights.size() != this->PointsNumber())
             KRATOS_THROW_ERROR(std::logic_error, "The number of weights must be equal to number of nodes", __FUNCTION__)
@@ -1267,7 +1291,7 @@ private:
 
     GeometryData::Pointer mpBezierGeometryData;
 
-    MatrixType mExtractionOperator;
+    CompressedMatrixPointerType mpExtractionOperator; // shared with the other geometries on the same cell, never modified
 
     ValuesContainerType mCtrlWeights; // weight of control points
 
@@ -177,6 +177,7 @@ public:
      */
     typedef typename BaseType::MatrixType MatrixType;
     typedef boost::numeric::ublas::compressed_matrix<typename MatrixType::value_type> CompressedMatrixType;
+    typedef boost::shared_ptr<const CompressedMatrixType> CompressedMatrixPointerType;
 
     /**
      * Type of Vector
@@ -220,7 +221,7 @@ public:
     , mOrder2(rOther.mOrder2)
     , mNumber1(rOther.mNumber1)
     , mNumber2(rOther.mNumber2)
-    , mExtractionOperator(rOther.mExtractionOperator)
+    , mpExtractionOperator(rOther.mpExtractionOperator)
     , mCtrlWeights(rOther.mCtrlWeights)
     {
         GeometryType::mpGeometryData = &(*mpBezierGeometryData);
@@ -244,7 +245,7 @@ public:
     , mOrder2(rOther.mOrder2)
     , mNumber1(rOther.mNumber1)
     , mNumber2(rOther.mNumber2)
-    , mExtractionOperator(rOther.mExtractionOperator)
+    , mpExtractionOperator(rOther.mpExtractionOperator)
     , mCtrlWeights(rOther.mCtrlWeights)
     {
         Geometry<TOtherPointType>::mpGeometryData = &(*mpBezierGeometryData);
@@ -279,7 +280,7 @@ public:
         this->mOrder2 = rOther.mOrder2;
         this->mNumber1 = rOther.mNumber1;
         this->mNumber2 = rOther.mNumber2;
-        this->mExtractionOperator = rOther.mExtractionOperator;
+        this->mpExtractionOperator = rOther.mpExtractionOperator;
         this->mCtrlWeights = rOther.mCtrlWeights;
         return *this;
     }
@@ -305,7 +306,7 @@ public:
         this->mOrder2 = rOther.mOrder2;
         this->mNumber1 = rOther.mNumber1;
         this->mNumber2 = rOther.mNumber2;
-        this->mExtractionOperator = rOther.mExtractionOperator;
+        this->mpExtractionOperator = rOther.mpExtractionOperator;
         this->mCtrlWeights = rOther.mCtrlWeights;
         return *this;
     }
@@ -321,7 +322,7 @@ public:
         if (mpBezierGeometryData != NULL)
         {
             pNewGeom->AssignGeometryData(DummyKnots, DummyKnots, DummyKnots,
-                mCtrlWeights, mExtractionOperator, mOrder1, mOrder2, 0,
+                mCtrlWeights, mpExtractionOperator, mOrder1, mOrder2, 0,
                 static_cast<int>(mpBezierGeometryData->DefaultIntegrationMethod()) + 1);
         }
         return pNewGeom;
@@ -378,7 +379,7 @@ public:
         #ifdef DEBUG_LEVEL3
         KRATOS_WATCH(NumberOfIntegrationPoints)
         KRATOS_WATCH(mCtrlWeights)
-        KRATOS_WATCH(mExtractionOperator)
+        KRATOS_WATCH(*mpExtractionOperator)
         KRATOS_WATCH(mNumber1)
         KRATOS_WATCH(mNumber2)
         KRATOS_WATCH(this->PointsNumber())
@@ -402,11 +403,11 @@ public:
             noalias(temp_bezier_values) = row(bezier_functions_values, i);
 
             //compute the Bezier weight
-            noalias(bezier_weights) = prod(trans(mExtractionOperator), mCtrlWeights);
+            noalias(bezier_weights) = prod(trans(*mpExtractionOperator), mCtrlWeights);
             denom = inner_prod(temp_bezier_values, bezier_weights);
 
             //compute the shape function values
-            VectorType temp_values = prod(mExtractionOperator, temp_bezier_values);
+            VectorType temp_values = prod(*mpExtractionOperator, temp_bezier_values);
             for(IndexType j = 0; j < this->PointsNumber(); ++j)
                 shape_functions_values(i, j) = (temp_values(j) * mCtrlWeights(j)) / denom;
 
@@ -415,10 +416,10 @@ public:
             tmp1 = inner_prod(row(bezier_functions_local_gradients[i], 0), bezier_weights);
             tmp2 = inner_prod(row(bezier_functions_local_gradients[i], 1), bezier_weights);
 
-            noalias(tmp_gradients1) = prod(mExtractionOperator,
+            noalias(tmp_gradients1) = prod(*mpExtractionOperator,
                     (1 / denom) * row(bezier_functions_local_gradients[i], 0) - (tmp1 / pow(denom, 2)) * temp_bezier_values );
 
-            noalias(tmp_gradients2) = prod(mExtractionOperator,
+            noalias(tmp_gradients2) = prod(*mpExtractionOperator,
                     (1 / denom) * row(bezier_functions_local_gradients[i], 1) - (tmp2 / pow(denom, 2)) * temp_bezier_values );
 
             for(IndexType j = 0; j < this->PointsNumber(); ++j)
@@ -662,13 +663,13 @@ public:
         }
 
         //compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
         double denom = inner_prod(bezier_functions_values, bezier_weights);
 
         //compute the shape function values
         if(rResults.size() != this->PointsNumber())
             rResults.resize(this->PointsNumber(), false);
-        noalias( rResults ) = prod(mExtractionOperator, bezier_functions_values);
+        noalias( rResults ) = prod(*mpExtractionOperator, bezier_functions_values);
         for(IndexType i = 0; i < this->PointsNumber(); ++i)
             rResults(i) *= (mCtrlWeights(i) / denom);
 
@@ -724,7 +725,7 @@ public:
         }
 
         //compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
         double denom = inner_prod(bezier_functions_values, bezier_weights);
 
         //compute the shape function local gradients
@@ -733,13 +734,13 @@ public:
         double tmp2 = inner_prod(bezier_functions_local_derivatives2, bezier_weights);
         VectorType tmp_gradients1 =
             prod(
-                mExtractionOperator,
+                *mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_derivatives1 -
                         (tmp1 / pow(denom, 2)) * bezier_functions_values
             );
         VectorType tmp_gradients2 =
             prod(
-                mExtractionOperator,
+                *mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_derivatives2 -
                         (tmp2 / pow(denom, 2)) * bezier_functions_values
             );
@@ -833,7 +834,7 @@ public:
         }
 
         //compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
         double denom = inner_prod(bezier_functions_values, bezier_weights);
 
         //compute the shape function local second gradients
@@ -844,21 +845,21 @@ public:
         double auxs12 = inner_prod(bezier_functions_local_second_derivatives12, bezier_weights);
         double auxs22 = inner_prod(bezier_functions_local_second_derivatives22, bezier_weights);
         VectorType tmp_gradients11 =
-            prod(mExtractionOperator,
+            prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_second_derivatives11
                     - (aux1 / pow(denom, 2)) * bezier_functions_local_derivatives1 * 2
                     - (auxs11 / pow(denom, 2)) * bezier_functions_values
                     + 2.0 * pow(aux1, 2) / pow(denom, 3) * bezier_functions_values
             );
         VectorType tmp_gradients12 =
-            prod(mExtractionOperator,
+            prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_second_derivatives12
                     - ((aux1 + aux2) / pow(denom, 2)) * bezier_functions_local_derivatives1
                     - (auxs12 / pow(denom, 2)) * bezier_functions_values
                     + 2.0 * aux1 * aux2 / pow(denom, 3) * bezier_functions_values
             );
         VectorType tmp_gradients22 =
-            prod(mExtractionOperator,
+            prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_second_derivatives22
                     - (aux2 / pow(denom, 2)) * bezier_functions_local_derivatives2 * 2
                     - (auxs22 / pow(denom, 2)) * bezier_functions_values
@@ -908,7 +909,7 @@ public:
         rPoints.reserve(number_of_local_points);
 
         // compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
 
         // compute the Bezier control points
         typedef typename PointType::Pointer PointPointerType;
@@ -916,7 +917,7 @@ public:
         {
             PointPointerType pPoint = PointPointerType(new PointType(0, 0.0, 0.0, 0.0));
             for(std::size_t j = 0; j < number_of_points; ++j)
-                noalias(*pPoint) += mExtractionOperator(j, i) * this->GetPoint(j).GetInitialPosition() * mCtrlWeights[j] / bezier_weights[i];
+                noalias(*pPoint) += (*mpExtractionOperator)(j, i) * this->GetPoint(j).GetInitialPosition() * mCtrlWeights[j] / bezier_weights[i];
             pPoint->SetInitialPosition(*pPoint);
             pPoint->SetSolutionStepVariablesList(this->GetPoint(0).pGetVariablesList());
             pPoint->SetBufferSize(this->GetPoint(0).GetBufferSize());
@@ -977,14 +978,14 @@ public:
             rValues.resize(number_of_local_points);
 
         // compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
 
         // compute the Bezier control points
         for(std::size_t i = 0; i < number_of_local_points; ++i)
         {
             rValues[i] = TDataType(0.0);
             for(std::size_t j = 0; j < number_of_points; ++j)
-                rValues[i] += mExtractionOperator(j, i) * this->GetPoint(j).GetSolutionStepValue(rVariable) * mCtrlWeights[j] / bezier_weights[i];
+                rValues[i] += (*mpExtractionOperator)(j, i) * this->GetPoint(j).GetSolutionStepValue(rVariable) * mCtrlWeights[j] / bezier_weights[i];
         }
     }
 
@@ -1088,7 +1089,27 @@ public:
         rOStream << "    Control Weights: " << mCtrlWeights << std::endl;
         rOStream << "    Order: " << mOrder1 << " " << mOrder2 << std::endl;
         rOStream << "    Number: " << mNumber1 << " " << mNumber2 << std::endl;
-        rOStream << "    Extraction Operator: " << mExtractionOperator << std::endl;
+        rOStream << "    Extraction Operator: " << *mpExtractionOperator << std::endl;
+    }
+
+    /**
+     * Copy the extraction operator to a shared compressed matrix, see the overload below
+     */
+    virtual void AssignGeometryData(
+        const ValuesContainerType& Knots1,
+        const ValuesContainerType& Knots2,
+        const ValuesContainerType& Knots3,
+        const ValuesContainerType& Weights,
+        const MatrixType& ExtractionOperator,
+        const int& Degree1,
+        const int& Degree2,
+        const int& Degree3,
+        const int& NumberOfIntegrationMethod
+    )
+    {
+        this->AssignGeometryData(Knots1, Knots2, Knots3, Weights,
+            CompressedMatrixPointerType(new CompressedMatrixType(ExtractionOperator)),
+            Degree1, Degree2, Degree3, NumberOfIntegrationMethod);
     }
 
     /**
@@ -1100,7 +1121,7 @@ public:
         const ValuesContainerType& Knots2, //not used
         const ValuesContainerType& Knots3, //not used
         const ValuesContainerType& Weights,
-        const MatrixType& ExtractionOperator,
+        const CompressedMatrixPointerType& pExtractionOperator,
         const int& Degree1,
         const int& Degree2,
         const int& Degree3, //not used
@@ -1112,14 +1133,13 @@ public:
         mOrder2 = Degree2;
         mNumber1 = mOrder1 + 1;
         mNumber2 = mOrder2 + 1;
-        // TODO we have to check here if the compressed_matrix copy is called or not. Otherwise, maybe the full matrix is populated.
-        mExtractionOperator = ExtractionOperator;
+        mpExtractionOperator = pExtractionOperator;
 
         // size checking
-        if(mExtractionOperator.size1() != this->PointsNumber())
-            KRATOS_THROW_ERROR(std::logic_error, "The number of row of extraction operator must be equal to number of nodes, mExtractionOperator.size1() =", mExtractionOperator.size1())
-        if(mExtractionOperator.size2() != mNumber1*mNumber2)
-            KRATOS_THROW_ERROR(std::logic_error, "The number of column of extraction operator must be equal to (p_u+1) * (p_v+1), mExtractionOperator.size2() =", mExtractionOperator.size2())
+        if(mpExtractionOperator->size1() != this->PointsNumber())
+            KRATOS_THROW_ERROR(std::logic_error, "The number of row of extraction operator must be equal to number of nodes, mExtractionOperator.size1() =", mpExtractionOperator->size1())
+        if(mpExtractionOperator->size2() != mNumber1*mNumber2)
+            KRATOS_THROW_ERROR(std::logic_error, "The number of column of extraction operator must be equal to (p_u+1) * (p_v+1), mExtractionOperator.size2() =", mpExtractionOperator->size2())
         if(mCtrlWeights.size() != this->PointsNumber())
             KRATOS_THROW_ERROR(std::logic_error, "The number of weights must be equal to number of nodes", __FUNCTION__)
 
@@ -1139,8 +1159,7 @@ protected:
 //    static const GeometryData msGeometryData;
     GeometryData::Pointer mpBezierGeometryData;
 
-    MatrixType mExtractionOperator;
-    // CompressedMatrixType mExtractionOperator;
+    CompressedMatrixPointerType mpExtractionOperator; // shared with the other geometries on the same cell, never modified
 
     ValuesContainerType mCtrlWeights; //weight of control points
 
@@ -1229,13 +1248,13 @@ private:
         }
 
         //compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
         double denom = inner_prod(bezier_functions_values, bezier_weights);
 
         //compute the shape function values
         if(shape_functions_values.size() != this->PointsNumber())
             shape_functions_values.resize(this->PointsNumber(), false);
-        noalias( shape_functions_values ) = prod(mExtractionOperator, bezier_functions_values);
+        noalias( shape_functions_values ) = prod(*mpExtractionOperator, bezier_functions_values);
         for(IndexType i = 0; i < this->PointsNumber(); ++i)
             shape_functions_values(i) *= (mCtrlWeights(i) / denom);
 
@@ -1245,9 +1264,9 @@ private:
             shape_functions_local_gradients.resize(this->PointsNumber(), 2, false);
         double tmp1 = inner_prod(bezier_functions_local_derivatives1, bezier_weights);
         double tmp2 = inner_prod(bezier_functions_local_derivatives2, bezier_weights);
-        VectorType tmp_gradients1 = prod(mExtractionOperator,
+        VectorType tmp_gradients1 = prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_derivatives1 - (tmp1 / pow(denom, 2)) * bezier_functions_values );
-        VectorType tmp_gradients2 = prod(mExtractionOperator,
+        VectorType tmp_gradients2 = prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_derivatives2 - (tmp2 / pow(denom, 2)) * bezier_functions_values );
         for(IndexType i = 0; i < this->PointsNumber(); ++i)
         {
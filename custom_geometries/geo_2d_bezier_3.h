@@ -172,6 +172,8 @@ public:
      * Type of Matrix
      */
     typedef typename BaseType::MatrixType MatrixType;
+    typedef typename BaseType::CompressedMatrixType CompressedMatrixType;
+    typedef typename BaseType::CompressedMatrixPointerType CompressedMatrixPointerType;
 
     /**
      * Type of Vector
@@ -279,7 +281,7 @@ public:
         if (BaseType::mpBezierGeometryData != NULL)
         {
             pNewGeom->AssignGeometryData(DummyKnots, DummyKnots, DummyKnots,
-                BaseType::mCtrlWeights, BaseType::mExtractionOperator, BaseType::mOrder1, BaseType::mOrder2, 0,
+                BaseType::mCtrlWeights, BaseType::mpExtractionOperator, BaseType::mOrder1, BaseType::mOrder2, 0,
                 static_cast<int>(BaseType::mpBezierGeometryData->DefaultIntegrationMethod()) + 1);
         }
         return pNewGeom;
@@ -557,6 +559,26 @@ public:
         BaseType::PrintData( rOStream );
     }
 
+    /**
+     * Copy the extraction operator to a shared compressed matrix, see the overload below
+     */
+    virtual void AssignGeometryData(
+        const ValuesContainerType& Knots1,
+        const ValuesContainerType& Knots2,
+        const ValuesContainerType& Knots3,
+        const ValuesContainerType& Weights,
+        const MatrixType& ExtractionOperator,
+        const int& Degree1,
+        const int& Degree2,
+        const int& Degree3,
+        const int& NumberOfIntegrationMethod
+    )
+    {
+        this->AssignGeometryData(Knots1, Knots2, Knots3, Weights,
+            CompressedMatrixPointerType(new CompressedMatrixType(ExtractionOperator)),
+            Degree1, Degree2, Degree3, NumberOfIntegrationMethod);
+    }
+
     /**
      * TO BE CALLED BY ELEMENT
      * TODO: optimized this by integrating pre-computed values at Gauss points
@@ -566,7 +588,7 @@ public:
         const ValuesContainerType& Knots2, //not used
         const ValuesContainerType& Knots3, //not used
         const ValuesContainerType& Weights,
-        const MatrixType& ExtractionOperator,
+        const CompressedMatrixPointerType& pExtractionOperator,
         const int& Degree1,
         const int& Degree2,
         const int& Degree3, //not used
@@ -579,14 +601,13 @@ public:
         BaseType::mNumber1 = BaseType::mOrder1 + 1;
         BaseType::mNumber2 = BaseType::mOrder2 + 1;
 
-        // TODO we have to check here if the compressed_matrix copy is called or not. Otherwise, maybe the full matrix is populated.
-        BaseType::mExtractionOperator = ExtractionOperator;
+        BaseType::mpExtractionOperator = pExtractionOperator;
 
         // size checking
-        if(BaseType::mExtractionOperator.size1() != this->PointsNumber())
-            KRATOS_THROW_ERROR(std::logic_error, "The number of row of extraction operator must be equal to number of nodes, mExtractionOperator.size1() =", BaseType::mExtractionOperator.size1())
-        if(BaseType::mExtractionOperator.size2() != BaseType::mNumber1*BaseType::mNumber2)
-            KRATOS_THROW_ERROR(std::logic_error, "The number of column of extraction operator must be equal to (p_u+1) * (p_v+1), mExtractionOperator.size2() =", BaseType::mExtractionOperator.size2())
+        if(BaseType::mpExtractionOperator->size1() != this->PointsNumber())
+            KRATOS_THROW_ERROR(std::logic_error, "The number of row of extraction operator must be equal to number of nodes, mExtractionOperator.size1() =", BaseType::mpExtractionOperator->size1())
+        if(BaseType::mpExtractionOperator->size2() != BaseType::mNumber1*BaseType::mNumber2)
+            KRATOS_THROW_ERROR(std::logic_error, "The number of column of extraction operator must be equal to (p_u+1) * (p_v+1), mExtractionOperator.size2() =", BaseType::mpExtractionOperator->size2())
         if(BaseType::mCtrlWeights.size() != this->PointsNumber())
             KRATOS_THROW_ERROR(std::logic_error, "The number of weights must be equal to number of nodes", __FUNCTION__)
 
@@ -176,6 +176,7 @@ public:
      */
     typedef typename BaseType::MatrixType MatrixType;
     typedef boost::numeric::ublas::compressed_matrix<typename MatrixType::value_type> CompressedMatrixType;
+    typedef boost::shared_ptr<const CompressedMatrixType> CompressedMatrixPointerType;
 
     /**
      * Type of Vector
@@ -218,7 +219,7 @@ public:
     , mNumber1(rOther.mNumber1)
     , mNumber2(rOther.mNumber2)
     , mNumber3(rOther.mNumber3)
-    , mExtractionOperator(rOther.mExtractionOperator)
+    , mpExtractionOperator(rOther.mpExtractionOperator)
     , mCtrlWeights(rOther.mCtrlWeights)
     {
         GeometryType::mpGeometryData = &(*mpBezierGeometryData);
@@ -244,7 +245,7 @@ public:
     , mNumber1(rOther.mNumber1)
     , mNumber2(rOther.mNumber2)
     , mNumber3(rOther.mNumber3)
-    , mExtractionOperator(rOther.mExtractionOperator)
+    , mpExtractionOperator(rOther.mpExtractionOperator)
     , mCtrlWeights(rOther.mCtrlWeights)
     {
         Geometry<TOtherPointType>::mpGeometryData = &(*mpBezierGeometryData);
@@ -281,7 +282,7 @@ public:
         this->mNumber1 = rOther.mNumber1;
         this->mNumber2 = rOther.mNumber2;
         this->mNumber3 = rOther.mNumber3;
-        this->mExtractionOperator = rOther.mExtractionOperator;
+        this->mpExtractionOperator = rOther.mpExtractionOperator;
         this->mCtrlWeights = rOther.mCtrlWeights;
         return *this;
     }
@@ -309,7 +310,7 @@ public:
         this->mNumber1 = rOther.mNumber1;
         this->mNumber2 = rOther.mNumber2;
         this->mNumber3 = rOther.mNumber3;
-        this->mExtractionOperator = rOther.mExtractionOperator;
+        this->mpExtractionOperator = rOther.mpExtractionOperator;
         this->mCtrlWeights = rOther.mCtrlWeights;
         return *this;
     }
@@ -325,7 +326,7 @@ public:
         {
             ValuesContainerType DummyKnots;
             pNewGeom->AssignGeometryData(DummyKnots, DummyKnots, DummyKnots,
-                mCtrlWeights, mExtractionOperator, mOrder1, mOrder2, mOrder3,
+                mCtrlWeights, mpExtractionOperator, mOrder1, mOrder2, mOrder3,
                 static_cast<int>(mpBezierGeometryData->DefaultIntegrationMethod()) + 1);
         }
         return pNewGeom;
@@ -420,11 +421,11 @@ public:
             noalias(temp_bezier_values) = row(bezier_functions_values, i);
 
             //compute the Bezier weight
-            noalias(bezier_weights) = prod(trans(mExtractionOperator), mCtrlWeights);
+            noalias(bezier_weights) = prod(trans(*mpExtractionOperator), mCtrlWeights);
             denom = inner_prod(temp_bezier_values, bezier_weights);
 
             //compute the shape function values
-            VectorType temp_values = prod(mExtractionOperator, temp_bezier_values);
+            VectorType temp_values = prod(*mpExtractionOperator, temp_bezier_values);
             for(IndexType j = 0; j < this->PointsNumber(); ++j)
                 shape_functions_values(i, j) = (temp_values(j) * mCtrlWeights(j) / denom);
 
@@ -434,13 +435,13 @@ public:
             tmp2 = inner_prod(row(bezier_functions_local_gradients[i], 1), bezier_weights);
             tmp3 = inner_prod(row(bezier_functions_local_gradients[i], 2), bezier_weights);
 
-            noalias(tmp_gradients1) = prod( mExtractionOperator,
+            noalias(tmp_gradients1) = prod(*mpExtractionOperator,
                         (1 / denom) * row(bezier_functions_local_gradients[i], 0) - (tmp1 / pow(denom, 2)) * temp_bezier_values );
 
-            noalias(tmp_gradients2) = prod(mExtractionOperator,
+            noalias(tmp_gradients2) = prod(*mpExtractionOperator,
                         (1 / denom) * row(bezier_functions_local_gradients[i], 1) - (tmp2 / pow(denom, 2)) * temp_bezier_values );
 
-            noalias(tmp_gradients3) = prod(mExtractionOperator,
+            noalias(tmp_gradients3) = prod(*mpExtractionOperator,
                         (1 / denom) * row(bezier_functions_local_gradients[i], 2) - (tmp3 / pow(denom, 2)) * temp_bezier_values );
 
             for(IndexType j = 0; j < this->PointsNumber(); ++j)
@@ -867,13 +868,13 @@ public:
         }
 
         //compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
         double denom = inner_prod(bezier_functions_values, bezier_weights);
 
         //compute the shape function values
         if(rResults.size() != this->PointsNumber())
             rResults.resize(this->PointsNumber(), false);
-        noalias( rResults ) = prod(mExtractionOperator, bezier_functions_values);
+        noalias( rResults ) = prod(*mpExtractionOperator, bezier_functions_values);
         for(IndexType i = 0; i < this->PointsNumber(); ++i)
             rResults(i) *= (mCtrlWeights(i) / denom);
 
@@ -946,7 +947,7 @@ public:
         }
 
         //compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
         double denom = inner_prod(bezier_functions_values, bezier_weights);
 
         //compute the shape function local gradients
@@ -956,19 +957,19 @@ public:
         double tmp3 = inner_prod(bezier_functions_local_derivatives3, bezier_weights);
         VectorType tmp_gradients1 =
             prod(
-                mExtractionOperator,
+                *mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_derivatives1 -
                         (tmp1 / pow(denom, 2)) * bezier_functions_values
             );
         VectorType tmp_gradients2 =
             prod(
-                mExtractionOperator,
+                *mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_derivatives2 -
                         (tmp2 / pow(denom, 2)) * bezier_functions_values
             );
         VectorType tmp_gradients3 =
             prod(
-                mExtractionOperator,
+                *mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_derivatives3 -
                         (tmp3 / pow(denom, 2)) * bezier_functions_values
             );
@@ -1109,7 +1110,7 @@ public:
         }
 
         //compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
         double denom = inner_prod(bezier_functions_values, bezier_weights);
 
         //compute the shape function local second gradients
@@ -1124,42 +1125,42 @@ public:
         double auxs23 = inner_prod(bezier_functions_local_second_derivatives23, bezier_weights);
         double auxs33 = inner_prod(bezier_functions_local_second_derivatives33, bezier_weights);
         VectorType tmp_gradients11 =
-            prod(mExtractionOperator,
+            prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_second_derivatives11
                     - (aux1 / pow(denom, 2)) * bezier_functions_local_derivatives1 * 2
                     - (auxs11 / pow(denom, 2)) * bezier_functions_values
                     + 2.0 * pow(aux1, 2) / pow(denom, 3) * bezier_functions_values
             );
         VectorType tmp_gradients12 =
-            prod(mExtractionOperator,
+            prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_second_derivatives12
                     - ((aux1 + aux2) / pow(denom, 2)) * bezier_functions_local_derivatives1
                     - (auxs12 / pow(denom, 2)) * bezier_functions_values
                     + 2.0 * aux1 * aux2 / pow(denom, 3) * bezier_functions_values
             );
         VectorType tmp_gradients13 =
-            prod(mExtractionOperator,
+            prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_second_derivatives13
                     - ((aux1 + aux3) / pow(denom, 2)) * bezier_functions_local_derivatives1
                     - (auxs13 / pow(denom, 2)) * bezier_functions_values
                     + 2.0 * aux1 * aux3 / pow(denom, 3) * bezier_functions_values
             );
         VectorType tmp_gradients22 =
-            prod(mExtractionOperator,
+            prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_second_derivatives22
                     - (aux2 / pow(denom, 2)) * bezier_functions_local_derivatives2 * 2
                     - (auxs22 / pow(denom, 2)) * bezier_functions_values
                     + 2.0 * pow(aux2, 2) / pow(denom, 3) * bezier_functions_values
             );
         VectorType tmp_gradients23 =
-            prod(mExtractionOperator,
+            prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_second_derivatives23
                     - ((aux2 + aux3) / pow(denom, 2)) * bezier_functions_local_derivatives2
                     - (auxs23 / pow(denom, 2)) * bezier_functions_values
                     + 2.0 * aux2 * aux3 / pow(denom, 3) * bezier_functions_values
             );
         VectorType tmp_gradients33 =
-            prod(mExtractionOperator,
+            prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_second_derivatives33
                     - (aux3 / pow(denom, 2)) * bezier_functions_local_derivatives3 * 2
                     - (auxs33 / pow(denom, 2)) * bezier_functions_values
@@ -1214,7 +1215,7 @@ public:
         rPoints.reserve(number_of_local_points);
 
         // compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
 
         // compute the Bezier control points
         typedef typename PointType::Pointer PointPointerType;
@@ -1222,7 +1223,7 @@ public:
         {
             PointPointerType pPoint = PointPointerType(new PointType(0, 0.0, 0.0, 0.0));
             for(std::size_t j = 0; j < number_of_points; ++j)
-                noalias(*pPoint) += mExtractionOperator(j, i) * this->GetPoint(j).GetInitialPosition() * mCtrlWeights[j] / bezier_weights[i];
+                noalias(*pPoint) += (*mpExtractionOperator)(j, i) * this->GetPoint(j).GetInitialPosition() * mCtrlWeights[j] / bezier_weights[i];
             pPoint->SetInitialPosition(*pPoint);
             pPoint->SetSolutionStepVariablesList(this->GetPoint(0).pGetVariablesList());
             pPoint->SetBufferSize(this->GetPoint(0).GetBufferSize());
@@ -1284,14 +1285,14 @@ public:
             rValues.resize(number_of_local_points);
 
         // compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
 
         // compute the Bezier control points
         for(std::size_t i = 0; i < number_of_local_points; ++i)
         {
             rValues[i] = TDataType(0.0);
             for(std::size_t j = 0; j < number_of_points; ++j)
-                rValues[i] += mExtractionOperator(j, i) * this->GetPoint(j).GetSolutionStepValue(rVariable) * mCtrlWeights[j] / bezier_weights[i];
+                rValues[i] += (*mpExtractionOperator)(j, i) * this->GetPoint(j).GetSolutionStepValue(rVariable) * mCtrlWeights[j] / bezier_weights[i];
         }
     }
 
@@ -1401,7 +1402,27 @@ public:
         rOStream << "    Control Weights: " << mCtrlWeights << std::endl;
         rOStream << "    Order: " << mOrder1 << " " << mOrder2 << " " << mOrder3 << std::endl;
         rOStream << "    Number: " << mNumber1 << " " << mNumber2 << " " << mNumber3 << std::endl;
-        rOStream << "    Extraction Operator: " << mExtractionOperator << std::endl;
+        rOStream << "    Extraction Operator: " << *mpExtractionOperator << std::endl;
+    }
+
+    /**
+     * Copy the extraction operator to a shared compressed matrix, see the overload below
+     */
+    virtual void AssignGeometryData(
+        const ValuesContainerType& Knots1,
+        const ValuesContainerType& Knots2,
+        const ValuesContainerType& Knots3,
+        const ValuesContainerType& Weights,
+        const MatrixType& ExtractionOperator,
+        const int& Degree1,
+        const int& Degree2,
+        const int& Degree3,
+        const int& NumberOfIntegrationMethod
+    )
+    {
+        this->AssignGeometryData(Knots1, Knots2, Knots3, Weights,
+            CompressedMatrixPointerType(new CompressedMatrixType(ExtractionOperator)),
+            Degree1, Degree2, Degree3, NumberOfIntegrationMethod);
     }
 
     virtual void AssignGeometryData(
@@ -1409,7 +1430,7 @@ public:
         const ValuesContainerType& Knots2, //not used
         const ValuesContainerType& Knots3, //not used
         const ValuesContainerType& Weights,
-        const MatrixType& ExtractionOperator,
+        const CompressedMatrixPointerType& pExtractionOperator,
         const int& Degree1,
         const int& Degree2,
         const int& Degree3,
@@ -1423,18 +1444,18 @@ public:
         mNumber1 = mOrder1 + 1;
         mNumber2 = mOrder2 + 1;
         mNumber3 = mOrder3 + 1;
-        mExtractionOperator = ExtractionOperator;
+        mpExtractionOperator = pExtractionOperator;
 
         // size checking
-        if(mExtractionOperator.size1() != this->PointsNumber())
+        if(mpExtractionOperator->size1() != this->PointsNumber())
         {
             KRATOS_WATCH(this->PointsNumber())
-            KRATOS_WATCH(mExtractionOperator)
+            KRATOS_WATCH(*mpExtractionOperator)
             KRATOS_THROW_ERROR(std::logic_error, "The number of row of extraction operator must be equal to number of nodes", __FUNCTION__)
         }
-        if(mExtractionOperator.size2() != mNumber1 * mNumber2 * mNumber3)
+        if(mpExtractionOperator->size2() != mNumber1 * mNumber2 * mNumber3)
         {
-            KRATOS_WATCH(mExtractionOperator)
+            KRATOS_WATCH(*mpExtractionOperator)
             KRATOS_WATCH(mOrder1)
             KRATOS_WATCH(mOrder2)
             KRATOS_WATCH(mOrder3)
@@ -1497,7 +1518,7 @@ protected:
     GeometryData::Pointer mpGeometryData;
     #endif
 
-    MatrixType mExtractionOperator;
+    CompressedMatrixPointerType mpExtractionOperator; // shared with the other geometries on the same cell, never modified
 
     ValuesContainerType mCtrlWeights; //weight of control points
 
@@ -1606,13 +1627,13 @@ private:
         }
 
         //compute the Bezier weight
-        VectorType bezier_weights = prod(trans(mExtractionOperator), mCtrlWeights);
+        VectorType bezier_weights = prod(trans(*mpExtractionOperator), mCtrlWeights);
         double denom = inner_prod(bezier_functions_values, bezier_weights);
 
         //compute the shape function values
         if(shape_functions_values.size() != this->PointsNumber())
             shape_functions_values.resize(this->PointsNumber(), false);
-        noalias( shape_functions_values ) = prod(mExtractionOperator, bezier_functions_values);
+        noalias( shape_functions_values ) = prod(*mpExtractionOperator, bezier_functions_values);
         for(IndexType i = 0; i < this->PointsNumber(); ++i)
             shape_functions_values(i) *= (mCtrlWeights(i) / denom);
 
@@ -1623,11 +1644,11 @@ private:
         double tmp1 = inner_prod(bezier_functions_local_derivatives1, bezier_weights);
         double tmp2 = inner_prod(bezier_functions_local_derivatives2, bezier_weights);
         double tmp3 = inner_prod(bezier_functions_local_derivatives3, bezier_weights);
-        VectorType tmp_gradients1 = prod(mExtractionOperator,
+        VectorType tmp_gradients1 = prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_derivatives1 - (tmp1 / pow(denom, 2)) * bezier_functions_values );
-        VectorType tmp_gradients2 = prod(mExtractionOperator,
+        VectorType tmp_gradients2 = prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_derivatives2 - (tmp2 / pow(denom, 2)) * bezier_functions_values );
-        VectorType tmp_gradients3 = prod(mExtractionOperator,
+        VectorType tmp_gradients3 = prod(*mpExtractionOperator,
                     (1 / denom) * bezier_functions_local_derivatives3 - (tmp3 / pow(denom, 2)) * bezier_functions_values );
         for(IndexType i = 0; i < this->PointsNumber(); ++i)
         {
@@ -236,6 +236,12 @@ public:
      */
     typedef Matrix MatrixType;
 
+    /**
+     * Type of the extraction operator shared between the geometries, e.g. of the cell they are created on
+     */
+    typedef boost::numeric::ublas::compressed_matrix<double> CompressedMatrixType;
+    typedef boost::shared_ptr<const CompressedMatrixType> CompressedMatrixPointerType;
+
     /**
      * Type of Vector
      */
@@ -466,6 +472,23 @@ public:
         KRATOS_THROW_ERROR(std::logic_error, "Calling IsogeometricGeometry base class function", __FUNCTION__)
     }
 
+    /**
+     * Same as above, but the extraction operator is shared with the caller instead of copied. It must not be modified afterwards.
+     */
+    virtual void AssignGeometryData(
+        const ValuesContainerType& Knots1,
+        const ValuesContainerType& Knots2,
+        const ValuesContainerType& Knots3,
+        const ValuesContainerType& Weights,
+        const CompressedMatrixPointerType& pExtractionOperator,
+        const int& Degree1,
+        const int& Degree2,
+        const int& Degree3,
+        const int& NumberOfIntegrationMethod)
+    {
+        KRATOS_THROW_ERROR(std::logic_error, "Calling IsogeometricGeometry base class function", __FUNCTION__)
+    }
+
     /**
      * lumping factors for the calculation of the lumped mass matrix
      */
@@ -112,6 +112,59 @@ boost::python::list GridFunction_GetDerivative2(TGridFrunctionType& rDummy, cons
     return results;
 }
 
+template<class TGridFrunctionType>
+void GridFunction_ExtractPoints(std::vector<double>& points, const boost::python::list& list_points)
+{
+    typedef boost::python::stl_input_iterator<boost::python::list> iterator_point_type;
+    typedef boost::python::stl_input_iterator<double> iterator_value_type;
+    BOOST_FOREACH(const iterator_point_type::value_type& point, std::make_pair(iterator_point_type(list_points), iterator_point_type() ) )
+    {
+        std::size_t cnt = 0;
+        BOOST_FOREACH(const iterator_value_type::value_type& v, std::make_pair(iterator_value_type(point), iterator_value_type() ) )
+        {
+            if (cnt++ < TGridFrunctionType::FESpaceType::Dim())
+                points.push_back(v);
+        }
+    }
+}
+
+template<class TGridFrunctionType>
+boost::python::list GridFunction_GetValues(TGridFrunctionType& rDummy, const boost::python::list& list_points)
+{
+    std::vector<double> points;
+    GridFunction_ExtractPoints<TGridFrunctionType>(points, list_points);
+
+    std::vector<double> values;
+    rDummy.GetValues(values, points);
+
+    boost::python::list results;
+    for (std::size_t i = 0; i < values.size(); ++i)
+        results.append(values[i]);
+
+    return results;
+}
+
+template<class TGridFrunctionType>
+boost::python::list GridFunction_GetValuesAndDerivatives(TGridFrunctionType& rDummy, const boost::python::list& list_points)
+{
+    std::vector<double> points;
+    GridFunction_ExtractPoints<TGridFrunctionType>(points, list_points);
+
+    std::vector<double> values, derivatives;
+    rDummy.GetValuesAndDerivatives(values, derivatives, points);
+
+    boost::python::list py_values, py_derivatives;
+    for (std::size_t i = 0; i < values.size(); ++i)
+        py_values.append(values[i]);
+    for (std::size_t i = 0; i < derivatives.size(); ++i)
+        py_derivatives.append(derivatives[i]);
+
+    boost::python::list results;
+    results.append(py_values);
+    results.append(py_derivatives);
+    return results;
+}
+
 template<class TGridFrunctionType, typename TCoordinatesType>
 boost::python::list GridFunction_LocalCoordinates(TGridFrunctionType& rDummy,
         const typename TGridFrunctionType::DataType& v, const TCoordinatesType& xi0)
@@ -159,6 +212,8 @@ void IsogeometricApplication_AddGridFunctionsToPython()
     .def("GetValue", &GridFunction_GetValue2<DoubleGridFunctionType>)
     .def("GetDerivative", &GridFunction_GetDerivative1<DoubleGridFunctionType>)
     .def("GetDerivative", &GridFunction_GetDerivative2<DoubleGridFunctionType>)
+    .def("GetValues", &GridFunction_GetValues<DoubleGridFunctionType>)
+    .def("GetValuesAndDerivatives", &GridFunction_GetValuesAndDerivatives<DoubleGridFunctionType>)
     .def(self_ns::str(self))
     ;
 
@@ -173,6 +228,8 @@ void IsogeometricApplication_AddGridFunctionsToPython()
     .def("GetValue", &GridFunction_GetValue2<Array1DGridFunctionType>)
     .def("GetDerivative", &GridFunction_GetDerivative1<Array1DGridFunctionType>)
     .def("GetDerivative", &GridFunction_GetDerivative2<Array1DGridFunctionType>)
+    .def("GetValues", &GridFunction_GetValues<Array1DGridFunctionType>)
+    .def("GetValuesAndDerivatives", &GridFunction_GetValuesAndDerivatives<Array1DGridFunctionType>)
     .def("LocalCoordinates", &GridFunction_LocalCoordinates<Array1DGridFunctionType, array_1d<double, 3> >)
     .def(self_ns::str(self))
     ;
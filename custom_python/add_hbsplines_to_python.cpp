@@ -97,6 +97,61 @@ std::size_t HBSplinesFESpace_MaxLevel(HBSplinesFESpace<TDim>& rDummy)
     return rDummy.MaxLevel();
 }
 
+template<int TDim>
+bool HBSplinesFESpace_IsTruncated(HBSplinesFESpace<TDim>& rDummy)
+{
+    return rDummy.IsTruncated();
+}
+
+template<int TDim>
+bool HBSplinesFESpace_IsCoarseningEnabled(HBSplinesFESpace<TDim>& rDummy)
+{
+    return rDummy.IsCoarseningEnabled();
+}
+
+template<int TDim>
+void HBSplinesFESpace_SetRefinementRatios(HBSplinesFESpace<TDim>& rDummy, std::size_t level, int dim, boost::python::list& ratios)
+{
+    std::vector<double> ratio_list;
+    typedef boost::python::stl_input_iterator<double> iterator_value_type;
+    BOOST_FOREACH(const iterator_value_type::value_type& v, std::make_pair(iterator_value_type(ratios), iterator_value_type() ) )
+    {
+        ratio_list.push_back(v);
+    }
+    rDummy.SetRefinementRatios(level, dim, ratio_list);
+}
+
+template<int TDim>
+void HBSplinesFESpace_SetDefaultRefinementRatios(HBSplinesFESpace<TDim>& rDummy, int dim, boost::python::list& ratios)
+{
+    std::vector<double> ratio_list;
+    typedef boost::python::stl_input_iterator<double> iterator_value_type;
+    BOOST_FOREACH(const iterator_value_type::value_type& v, std::make_pair(iterator_value_type(ratios), iterator_value_type() ) )
+    {
+        ratio_list.push_back(v);
+    }
+    rDummy.SetRefinementRatios(dim, ratio_list);
+}
+
+template<int TDim>
+boost::python::list HBSplinesFESpace_RefinementRatios(HBSplinesFESpace<TDim>& rDummy, std::size_t level, int dim)
+{
+    boost::python::list ratio_list;
+    const std::vector<double>& ratios = rDummy.RefinementRatios(level, dim);
+    for (std::size_t i = 0; i < ratios.size(); ++i)
+        ratio_list.append(ratios[i]);
+    return ratio_list;
+}
+
+template<int TDim>
+boost::python::list HBSplinesFESpace_GetRefinedBfs(HBSplinesFESpace<TDim>& rDummy)
+{
+    boost::python::list bf_list;
+    for (typename HBSplinesFESpace<TDim>::refined_bf_iterator it = rDummy.refined_bf_begin(); it != rDummy.refined_bf_end(); ++it)
+        bf_list.append(it->second);
+    return bf_list;
+}
+
 template<int TDim>
 typename HBSplinesBasisFunction<TDim>::Pointer HBSplinesFESpace_GetItem(HBSplinesFESpace<TDim>& rDummy, std::size_t i)
 {
@@ -149,6 +204,20 @@ void HBSplinesRefinementUtility_RefineBf(HBSplinesRefinementUtility& rDummy,
     rDummy.Refine<TDim>(pPatch, p_bf, EchoLevel);
 }
 
+template<int TDim>
+void HBSplinesRefinementUtility_RefineBfs(HBSplinesRefinementUtility& rDummy,
+        typename Patch<TDim>::Pointer pPatch, boost::python::list& bfs, const int& EchoLevel)
+{
+    typedef typename HBSplinesFESpace<TDim>::bf_t bf_t;
+    std::vector<bf_t> bf_list;
+    typedef boost::python::stl_input_iterator<bf_t> iterator_value_type;
+    BOOST_FOREACH(const typename iterator_value_type::value_type& p_bf, std::make_pair(iterator_value_type(bfs), iterator_value_type() ) )
+    {
+        bf_list.push_back(p_bf);
+    }
+    rDummy.Refine<TDim>(pPatch, bf_list, EchoLevel);
+}
+
 template<int TDim>
 void HBSplinesRefinementUtility_RefineWindow(HBSplinesRefinementUtility& rDummy,
         typename Patch<TDim>::Pointer pPatch, boost::python::list& window, const int& EchoLevel)
@@ -169,6 +238,38 @@ void HBSplinesRefinementUtility_RefineWindow(HBSplinesRefinementUtility& rDummy,
     rDummy.RefineWindow<TDim>(pPatch, window_vector, EchoLevel);
 }
 
+template<int TDim>
+void HBSplinesRefinementUtility_Coarsen(HBSplinesRefinementUtility& rDummy,
+        typename Patch<TDim>::Pointer pPatch, boost::python::list& Ids, const int& EchoLevel)
+{
+    std::vector<std::size_t> id_list;
+    typedef boost::python::stl_input_iterator<std::size_t> iterator_value_type;
+    BOOST_FOREACH(const typename iterator_value_type::value_type& id, std::make_pair(iterator_value_type(Ids), iterator_value_type() ) )
+    {
+        id_list.push_back(id);
+    }
+    rDummy.Coarsen<TDim>(pPatch, id_list, EchoLevel);
+}
+
+template<int TDim>
+void HBSplinesRefinementUtility_CoarsenWindow(HBSplinesRefinementUtility& rDummy,
+        typename Patch<TDim>::Pointer pPatch, boost::python::list& window, const int& EchoLevel)
+{
+    std::vector<std::vector<double> > window_vector;
+    typedef boost::python::stl_input_iterator<boost::python::list> iterator_value_type;
+    BOOST_FOREACH(const iterator_value_type::value_type& vect, std::make_pair(iterator_value_type(window), iterator_value_type() ) )
+    {
+        typedef boost::python::stl_input_iterator<double> iterator_value_type2;
+        std::vector<double> win_vect;
+        BOOST_FOREACH(const iterator_value_type2::value_type& v, std::make_pair(iterator_value_type2(vect), iterator_value_type2() ) )
+        {
+            win_vect.push_back(v);
+        }
+        window_vector.push_back(win_vect);
+    }
+    rDummy.CoarsenWindow<TDim>(pPatch, window_vector, EchoLevel);
+}
+
 template<int TDim>
 void HBSplinesRefinementUtility_LinearDependencyRefine(HBSplinesRefinementUtility& rDummy,
         typename Patch<TDim>::Pointer pPatch, const std::size_t& refine_cycle, const int& EchoLevel)
@@ -176,6 +277,13 @@ void HBSplinesRefinementUtility_LinearDependencyRefine(HBSplinesRefinementUtilit
     rDummy.LinearDependencyRefine<TDim>(pPatch, refine_cycle, EchoLevel);
 }
 
+template<int TDim>
+void HBSplinesRefinementUtility_SetTruncation(HBSplinesRefinementUtility& rDummy,
+        typename Patch<TDim>::Pointer pPatch, const bool& IsTruncated)
+{
+    rDummy.SetTruncation<TDim>(pPatch, IsTruncated);
+}
+
 ////////////////////////////////////////
 
 // template<typename TDataType, class TFESpaceType>
@@ -221,9 +329,19 @@ void IsogeometricApplication_AddHBSplinesSpaceToPython()
     .def("UpdateCells", &HBSplinesFESpace<TDim>::UpdateCells)
     .def("MaxLevel", &HBSplinesFESpace_MaxLevel<TDim>)
     .def("SetMaxLevel", &HBSplinesFESpace<TDim>::SetMaxLevel)
+    .def("IsTruncated", &HBSplinesFESpace_IsTruncated<TDim>)
     .def("GetBfByEquationId", &HBSplinesFESpace<TDim>::pGetBfByEquationId)
     .def("HasBfByEquationId", &HBSplinesFESpace<TDim>::HasBfByEquationId)
     .def("HasBfById", &HBSplinesFESpace<TDim>::HasBfById)
+    .def("GetRefinedBfs", &HBSplinesFESpace_GetRefinedBfs<TDim>)
+    .def("SetRefinementRatios", &HBSplinesFESpace_SetRefinementRatios<TDim>)
+    .def("SetRefinementRatios", &HBSplinesFESpace_SetDefaultRefinementRatios<TDim>)
+    .def("SetNumberOfInsertedKnots", &HBSplinesFESpace<TDim>::SetNumberOfInsertedKnots)
+    .def("RefinementRatios", &HBSplinesFESpace_RefinementRatios<TDim>)
+    .def("HasRefinedBf", &HBSplinesFESpace<TDim>::HasRefinedBf)
+    .def("ClearRefinedBfs", &HBSplinesFESpace<TDim>::ClearRefinedBfs)
+    .def("IsCoarseningEnabled", &HBSplinesFESpace_IsCoarseningEnabled<TDim>)
+    .def("SetCoarseningEnabled", &HBSplinesFESpace<TDim>::SetCoarseningEnabled)
     .def(self_ns::str(self))
     ;
 
@@ -307,10 +425,18 @@ void IsogeometricApplication_AddHBSplinesToPython()
     .def("Refine", &HBSplinesRefinementUtility_Refine<3>)
     .def("Refine", &HBSplinesRefinementUtility_RefineBf<2>)
     .def("Refine", &HBSplinesRefinementUtility_RefineBf<3>)
+    .def("Refine", &HBSplinesRefinementUtility_RefineBfs<2>)
+    .def("Refine", &HBSplinesRefinementUtility_RefineBfs<3>)
     .def("RefineWindow", &HBSplinesRefinementUtility_RefineWindow<2>)
     .def("RefineWindow", &HBSplinesRefinementUtility_RefineWindow<3>)
+    .def("Coarsen", &HBSplinesRefinementUtility_Coarsen<2>)
+    .def("Coarsen", &HBSplinesRefinementUtility_Coarsen<3>)
+    .def("CoarsenWindow", &HBSplinesRefinementUtility_CoarsenWindow<2>)
+    .def("CoarsenWindow", &HBSplinesRefinementUtility_CoarsenWindow<3>)
     .def("LinearDependencyRefine", &HBSplinesRefinementUtility_LinearDependencyRefine<2>)
     .def("LinearDependencyRefine", &HBSplinesRefinementUtility_LinearDependencyRefine<3>)
+    .def("SetTruncation", &HBSplinesRefinementUtility_SetTruncation<2>)
+    .def("SetTruncation", &HBSplinesRefinementUtility_SetTruncation<3>)
     .def(self_ns::str(self))
     ;
 
@@ -28,6 +28,7 @@ LICENSE: see isogeometric_application/LICENSE.txt
 #include "custom_utilities/nonconforming_variable_multipatch_lagrange_mesh.h"
 #include "custom_utilities/multipatch_model_part.h"
 #include "custom_utilities/multi_multipatch_model_part.h"
+#include "custom_utilities/hbsplines/hbsplines_adaptive_refinement.h"
 #include "custom_python/add_mesh_and_model_part_to_python.h"
 
 
@@ -84,6 +85,27 @@ ModelPart::ConditionsContainerType MultiPatchModelPart_AddConditions_OnBoundary2
     return rDummy.AddConditions(pBoundaryPatch, condition_name, starting_id, pProperties);
 }
 
+template<int TDim>
+ModelPart::ConditionsContainerType HBSplinesAdaptiveRefinement_AddConditions(HBSplinesAdaptiveRefinement<TDim>& rDummy,
+    typename Patch<TDim>::Pointer pPatch, const int& iside,
+    const std::string& condition_name, Properties::Pointer pProperties)
+{
+    BoundarySide side = static_cast<BoundarySide>(iside);
+    return rDummy.AddConditions(pPatch, side, condition_name, pProperties);
+}
+
+template<int TDim>
+std::size_t HBSplinesAdaptiveRefinement_RefineElements(HBSplinesAdaptiveRefinement<TDim>& rDummy, boost::python::list element_list)
+{
+    std::vector<std::size_t> element_ids;
+    typedef boost::python::stl_input_iterator<int> iterator_value_type;
+    BOOST_FOREACH(const iterator_value_type::value_type& id, std::make_pair(iterator_value_type(element_list), iterator_value_type() ) )
+    {
+        element_ids.push_back(static_cast<std::size_t>(id));
+    }
+    return rDummy.RefineElements(element_ids);
+}
+
 template<int TDim>
 ModelPart::ConditionsContainerType MultiMultiPatchModelPart_AddConditions_OnBoundary(MultiMultiPatchModelPart<TDim>& rDummy,
     typename Patch<TDim>::Pointer pPatch, const int& iside,
@@ -309,6 +331,28 @@ void IsogeometricApplication_AddModelPartToPython()
     ;
 }
 
+template<int TDim>
+void IsogeometricApplication_AddAdaptiveRefinementToPython()
+{
+    std::stringstream ss;
+
+    typedef HBSplinesAdaptiveRefinement<TDim> HBSplinesAdaptiveRefinementType;
+    void(HBSplinesAdaptiveRefinementType::*pointer_to_AddTransferVariable_double)(const Variable<double>&) = &HBSplinesAdaptiveRefinementType::AddTransferVariable;
+    void(HBSplinesAdaptiveRefinementType::*pointer_to_AddTransferVariable_array_1d)(const Variable<array_1d<double, 3> >&) = &HBSplinesAdaptiveRefinementType::AddTransferVariable;
+
+    ss.str(std::string());
+    ss << "HBSplinesAdaptiveRefinement" << TDim << "D";
+    class_<HBSplinesAdaptiveRefinementType, typename HBSplinesAdaptiveRefinementType::Pointer, bases<IsogeometricEcho>, boost::noncopyable>
+    (ss.str().c_str(), init<typename MultiPatchModelPart<TDim>::Pointer>())
+    .def("AddElements", &HBSplinesAdaptiveRefinementType::AddElements)
+    .def("AddConditions", &HBSplinesAdaptiveRefinement_AddConditions<TDim>)
+    .def("AddTransferVariable", pointer_to_AddTransferVariable_double)
+    .def("AddTransferVariable", pointer_to_AddTransferVariable_array_1d)
+    .def("MarkAndRefine", &HBSplinesAdaptiveRefinementType::MarkAndRefine)
+    .def("RefineElements", &HBSplinesAdaptiveRefinement_RefineElements<TDim>)
+    .def(self_ns::str(self))
+    ;
+}
 
 void IsogeometricApplication_AddMeshAndModelPartToPython()
 {
@@ -320,6 +364,9 @@ void IsogeometricApplication_AddMeshAndModelPartToPython()
     IsogeometricApplication_AddModelPartToPython<2>();
     IsogeometricApplication_AddModelPartToPython<3>();
 
+    IsogeometricApplication_AddAdaptiveRefinementToPython<2>();
+    IsogeometricApplication_AddAdaptiveRefinementToPython<3>();
+
 }
 
 }  // namespace Python.
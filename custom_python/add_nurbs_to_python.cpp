@@ -513,6 +513,7 @@ void IsogeometricApplication_AddNURBSToPython()
     .def("AddYcoord", &DomainManager2D::AddYcoord)
     .def("AddCell", &DomainManager2D_AddCell)
     .def("IsInside", &DomainManager2D_IsInside)
+    .def("MemoryUsage", &DomainManager2D::MemoryUsage)
     .def(self_ns::str(self))
     ;
 
@@ -197,6 +197,48 @@ boost::python::list Patch_LocalCoordinates(TPatchType& rDummy, boost::python::li
     return output;
 }
 
+template<class TPatchType>
+boost::python::list Patch_LocalCoordinatesBatch(TPatchType& rDummy, boost::python::list& list_points)
+{
+    typedef boost::python::stl_input_iterator<boost::python::list> iterator_point_type;
+    typedef boost::python::stl_input_iterator<double> iterator_value_type;
+
+    std::vector<array_1d<double, 3> > points;
+    BOOST_FOREACH(const iterator_point_type::value_type& P, std::make_pair(iterator_point_type(list_points), iterator_point_type() ) )
+    {
+        array_1d<double, 3> point;
+        noalias(point) = ZeroVector(3);
+
+        std::size_t cnt = 0;
+        BOOST_FOREACH(const iterator_value_type::value_type& v, std::make_pair(iterator_value_type(P), iterator_value_type() ) )
+        {
+            if (cnt < 3)
+                point[cnt++] = v;
+        }
+
+        points.push_back(point);
+    }
+
+    std::vector<array_1d<double, 3> > xis;
+    std::vector<int> stats;
+    rDummy.LocalCoordinates(points, xis, stats);
+
+    boost::python::list output;
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+        boost::python::list out_point;
+        out_point.append(xis[i][0]);
+        out_point.append(xis[i][1]);
+        out_point.append(xis[i][2]);
+
+        boost::python::list out;
+        out.append(stats[i]);
+        out.append(out_point);
+        output.append(out);
+    }
+    return output;
+}
+
 template<class TPatchType>
 bool Patch_IsInside(TPatchType& rDummy, boost::python::list& P, boost::python::list& xi0)
 {
@@ -345,6 +387,7 @@ void IsogeometricApplication_AddPatchesToPython_Helper()
     .def("FESpace", &Patch_pFESpace<Patch<TDim> >)
     .def("Predict", &Patch_Predict<Patch<TDim> >)
     .def("LocalCoordinates", &Patch_LocalCoordinates<Patch<TDim> >)
+    .def("LocalCoordinates", &Patch_LocalCoordinatesBatch<Patch<TDim> >)
     .def("IsInside", &Patch_IsInside<Patch<TDim> >)
     .def("NumberOfInterfaces", &Patch<TDim>::NumberOfInterfaces)
     .def("AddInterface", &Patch<TDim>::AddInterface)
@@ -584,6 +584,40 @@ public:
         return N[nt-s+p];
     }
 
+    /// Compute the value and the first derivative of the B-spline basis function on a local knot vector
+    /// This version uses the extended knot vector, as CoxDeBoor3
+    //    % Input:
+    //    %   u       knot to be compute the function value
+    //    %   p       B-spline degree
+    //    %   knots   local knot vector, must be ascending
+    //    % Output: function value and derivative
+    template<class ValuesContainerType>
+    static void CoxDeBoor3Der(double& value, double& derivative, const double& u, const int& p, const ValuesContainerType& knots)
+    {
+        value = 0.0;
+        derivative = 0.0;
+
+        double last_knot = *(knots.end()-1);
+        double first_knot = *(knots.begin());
+        if ((u > last_knot) || (u < first_knot))
+            return;
+
+        // compute the extended knot vector
+        ValuesContainerType ubar;
+        int nt;
+        IsogeometricMathUtils::compute_extended_knot_vector(ubar, nt, knots, p);
+
+        // find span
+        int s = BSplineUtils::FindSpan(ubar.size()-p-1, p, u, ubar);
+
+        // evaluate the basis functions and their first derivatives
+        std::vector<std::vector<double> > ders;
+        BSplineUtils::BasisFunsDer(ders, s, u, p, ubar, 1, BSplineUtils::StdVector2DOp<double>());
+
+        value = ders[0][nt-s+p];
+        derivative = ders[1][nt-s+p];
+    }
+
     /// Compute the refinement coefficients for one knot insertion B-Splines refinement in 1D
     /// REF: Eq (5.10) the NURBS books
     template<class MatrixType, class ValuesContainerType>
@@ -12,6 +12,7 @@
 // System includes
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <iostream>
 
 // Project includes
@@ -19,7 +20,6 @@
 #include "includes/ublas_interface.h"
 
 // External includes
-#include <boost/numeric/ublas/vector_sparse.hpp>
 
 
 namespace Kratos
@@ -34,12 +34,11 @@ public:
     /// Pointer definition
     KRATOS_CLASS_POINTER_DEFINITION(Cell);
 
-    /// Type definitions
-    typedef boost::numeric::ublas::mapped_vector<double> SparseVectorType;
-    // typedef boost::numeric::ublas::vector<double> SparseVectorType;
+    /// Type definition
+    typedef boost::shared_ptr<const CompressedMatrix> CompressedMatrixPointerType;
 
     /// Default constructor
-    Cell(const std::size_t& Id) : mId(Id)
+    Cell(const std::size_t& Id) : mId(Id), mCrowSize(0)
     {}
 
     /// Destructor
@@ -60,24 +59,46 @@ public:
     {
         mSupportedAnchors.clear();
         mAnchorWeights.clear();
-        mCrows.clear();
+        mCrowSize = 0;
+        mCrowPointers.clear();
+        mCrowIndices.clear();
+        mCrowValues.clear();
+        mpCompressedExtractionOperator.reset();
     }
 
     /// Add supported anchor and the respective extraction operator of this cell to the anchor
     void AddAnchor(const std::size_t& Id, const double& W, const Vector& Crow)
     {
+        this->CheckCrowSize(Crow.size());
+
         mSupportedAnchors.push_back(Id);
         mAnchorWeights.push_back(W);
 
-        std::vector<std::size_t> inz;
-        inz.reserve(Crow.size());
         for (std::size_t i = 0; i < Crow.size(); ++i)
+        {
             if (Crow[i] != 0.0)
-                inz.push_back(i);
-        SparseVectorType Crow_sparse(Crow.size(), inz.size());
-        for (std::size_t i = 0; i < inz.size(); ++i)
-            Crow_sparse[inz[i]] = Crow[inz[i]];
-        mCrows.push_back(Crow_sparse);
+            {
+                mCrowIndices.push_back(i);
+                mCrowValues.push_back(Crow[i]);
+            }
+        }
+        mCrowPointers.push_back(mCrowValues.size());
+        mpCompressedExtractionOperator.reset();
+    }
+
+    /// Add supported anchor and the respective extraction operator row given by its nonzeros, i.e. Crow[indices[k]] = values[k], k < nnz
+    void AddAnchor(const std::size_t& Id, const double& W, const std::size_t& size,
+            const std::size_t& nnz, const std::size_t* indices, const double* values)
+    {
+        this->CheckCrowSize(size);
+
+        mSupportedAnchors.push_back(Id);
+        mAnchorWeights.push_back(W);
+
+        mCrowIndices.insert(mCrowIndices.end(), indices, indices + nnz);
+        mCrowValues.insert(mCrowValues.end(), values, values + nnz);
+        mCrowPointers.push_back(mCrowValues.size());
+        mpCompressedExtractionOperator.reset();
     }
 
     /// Absorb the information from the other cell
@@ -87,7 +108,10 @@ public:
         {
             if (std::find(mSupportedAnchors.begin(), mSupportedAnchors.end(), pOther->GetSupportedAnchors()[i]) == mSupportedAnchors.end())
             {
-                this->AddAnchor(pOther->GetSupportedAnchors()[i], pOther->GetAnchorWeights()[i], pOther->GetCrows()[i]);
+                const std::size_t& begin = pOther->GetCrowPointers()[i];
+                const std::size_t& end = pOther->GetCrowPointers()[i+1];
+                this->AddAnchor(pOther->GetSupportedAnchors()[i], pOther->GetAnchorWeights()[i], pOther->GetCrowSize(),
+                    end - begin, pOther->GetCrowIndices().data() + begin, pOther->GetCrowValues().data() + begin);
             }
         }
     }
@@ -113,47 +137,64 @@ public:
         std::copy(mAnchorWeights.begin(), mAnchorWeights.end(), rWeights.begin());
     }
 
-    /// Get the internal data of row of the extraction operator
-    const std::vector<SparseVectorType>& GetCrows() const {return mCrows;}
+    /// Get the length of the rows of the extraction operator, i.e. the number of Bernstein basis functions on the cell
+    const std::size_t& GetCrowSize() const {return mCrowSize;}
+
+    /// Get the internal data of the rows of the extraction operator in CSR format. The nonzeros of the row of anchor i
+    /// are GetCrowIndices()[k] and GetCrowValues()[k], GetCrowPointers()[i] <= k < GetCrowPointers()[i+1]. The row pointers are empty if there is no anchor.
+    const std::vector<std::size_t>& GetCrowPointers() const {return mCrowPointers;}
+    const std::vector<std::size_t>& GetCrowIndices() const {return mCrowIndices;}
+    const std::vector<double>& GetCrowValues() const {return mCrowValues;}
+
+    /// Get the number of nonzeros of the extraction operator
+    std::size_t GetCrowNonzeros() const {return mCrowValues.size();}
 
     /// Get the extraction operator matrix
     Matrix GetExtractionOperator() const
     {
-        Matrix M(mCrows.size(), mCrows[0].size());
-        for(std::size_t i = 0; i < mCrows.size(); ++i)
-            noalias(row(M, i)) = mCrows[i];
+        Matrix M(mSupportedAnchors.size(), mCrowSize);
+        noalias(M) = ZeroMatrix(mSupportedAnchors.size(), mCrowSize);
+        for(std::size_t i = 0; i < mSupportedAnchors.size(); ++i)
+            for(std::size_t k = mCrowPointers[i]; k < mCrowPointers[i+1]; ++k)
+                M(i, mCrowIndices[k]) = mCrowValues[k];
         return M;
     }
 
     /// Get the extraction as compressed matrix
     CompressedMatrix GetCompressedExtractionOperator() const
     {
-        CompressedMatrix M(mCrows.size(), mCrows[0].size());
-        // here we just naively copy the data. However we shall initialize the compressed matrix properly as in the kernel (TODO)
-        for(std::size_t i = 0; i < mCrows.size(); ++i)
-            noalias(row(M, i)) = mCrows[i];
-        M.complete_index1_data();
+        CompressedMatrix M;
+        this->FillCompressedExtractionOperator(M);
         return M;
     }
 
-    /// Get the extraction operator as CSR triplet
-    void GetExtractionOperator(std::vector<int>& rowPtr, std::vector<int>& colInd, std::vector<double>& values) const
+    /// Get the extraction as compressed matrix shared with the caller, e.g. the geometries created on this cell. It is
+    /// built once and kept until the rows are changed; the geometries keep the former matrix, which is never modified.
+    /// It is not thread-safe, it shall be called from the serial creation of the entities.
+    CompressedMatrixPointerType pGetCompressedExtractionOperator() const
     {
-        int cnt = 0;
-        rowPtr.push_back(cnt);
-        for(std::size_t i = 0; i < mCrows.size(); ++i)
+        if (mpCompressedExtractionOperator == NULL)
         {
-            for(std::size_t j = 0; j < mCrows[i].size(); ++j)
-            {
-                if(mCrows[i](j) != 0)
-                {
-                    colInd.push_back(j);
-                    values.push_back(mCrows[i](j));
-                    ++cnt;
-                }
-            }
-            rowPtr.push_back(cnt);
+            boost::shared_ptr<CompressedMatrix> pM = boost::shared_ptr<CompressedMatrix>(new CompressedMatrix());
+            this->FillCompressedExtractionOperator(*pM);
+            mpCompressedExtractionOperator = pM;
         }
+        return mpCompressedExtractionOperator;
+    }
+
+    /// Get the extraction operator as CSR triplet
+    void GetExtractionOperator(std::vector<int>& rowPtr, std::vector<int>& colInd, std::vector<double>& values) const
+    {
+        rowPtr.reserve(rowPtr.size() + mCrowPointers.size());
+        colInd.reserve(colInd.size() + mCrowIndices.size());
+        values.reserve(values.size() + mCrowValues.size());
+
+        rowPtr.push_back(0);
+        for(std::size_t i = 1; i < mCrowPointers.size(); ++i)
+            rowPtr.push_back(static_cast<int>(mCrowPointers[i]));
+        for(std::size_t k = 0; k < mCrowIndices.size(); ++k)
+            colInd.push_back(static_cast<int>(mCrowIndices[k]));
+        values.insert(values.end(), mCrowValues.begin(), mCrowValues.end());
     }
 
     /// Implement relational operator for automatic arrangement in container
@@ -187,7 +228,40 @@ protected:
     std::size_t mId;
     std::vector<std::size_t> mSupportedAnchors;
     std::vector<double> mAnchorWeights; // weight of the anchor
-    std::vector<SparseVectorType> mCrows; // bezier extraction operator row to each anchor
+
+    // bezier extraction operator row to each anchor, stored contiguously in CSR format
+    std::size_t mCrowSize;
+    std::vector<std::size_t> mCrowPointers;
+    std::vector<std::size_t> mCrowIndices;
+    std::vector<double> mCrowValues;
+
+    // the extraction operator shared with the geometries, see pGetCompressedExtractionOperator
+    mutable CompressedMatrixPointerType mpCompressedExtractionOperator;
+
+private:
+
+    /// Fill the compressed matrix with the rows. The nonzeros are appended row by row, which is the storage order of the compressed matrix.
+    void FillCompressedExtractionOperator(CompressedMatrix& M) const
+    {
+        M.resize(mSupportedAnchors.size(), mCrowSize, false);
+        M.reserve(mCrowValues.size(), false);
+        for(std::size_t i = 0; i < mSupportedAnchors.size(); ++i)
+            for(std::size_t k = mCrowPointers[i]; k < mCrowPointers[i+1]; ++k)
+                M.push_back(i, mCrowIndices[k], mCrowValues[k]);
+    }
+
+    /// All the rows of the extraction operator must have the same length
+    void CheckCrowSize(const std::size_t& size)
+    {
+        if (mSupportedAnchors.empty())
+        {
+            mCrowSize = size;
+            if (mCrowPointers.empty())
+                mCrowPointers.push_back(0);
+        }
+        else if (size != mCrowSize)
+            KRATOS_THROW_ERROR(std::logic_error, "The extraction operator row has incompatible size", size)
+    }
 };
 
 /// output stream function
@@ -62,7 +62,7 @@ public:
     /// Insert a cell to the container.
     iterator insert(cell_t p_cell)
     {
-        mpCells.insert(p_cell);
+        return mpCells.insert(p_cell).first;
     }
 
     /// Iterators
@@ -81,7 +81,7 @@ public:
     }
 
     /// Overload comparison operator
-    bool operator==(const CellContainer& rOther)
+    bool operator==(const CellContainer& rOther) const
     {
         if (this->size() != rOther.size())
             return false;
@@ -92,7 +92,7 @@ public:
     }
 
     /// Overload comparison operator
-    bool operator!=(const CellContainer& rOther)
+    bool operator!=(const CellContainer& rOther) const
     {
         return !(*this == rOther);
     }
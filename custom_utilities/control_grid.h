@@ -35,10 +35,10 @@ public:
     typedef TDataType DataType;
 
     /// Default constructor
-    ControlGrid() : mName("UNKNOWN") {}
+    ControlGrid() : mName("UNKNOWN"), mVersion(0) {}
 
     /// Constructor with name
-    ControlGrid(const std::string& Name) : mName(Name) {}
+    ControlGrid(const std::string& Name) : mName(Name), mVersion(0) {}
 
     /// Destructor
     virtual ~ControlGrid() {}
@@ -50,6 +50,7 @@ public:
     ControlGrid<TDataType>& operator=(const ControlGrid<TDataType>& rOther)
     {
         this->mName = rOther.mName;
+        this->Modified();
         return *this;
     }
 
@@ -67,6 +68,14 @@ public:
     /// Get the name
     const std::string& Name() const {return mName;}
 
+    /// Get the version of the control values. It is increased by the setters, i.e. SetData, the copy and the resize
+    /// operations, and by every mutable access, i.e. the non-const operator[] and the non-const access to the underlying data.
+    /// A reference obtained by the mutable access and written later is not tracked; call Modified afterwards.
+    virtual std::size_t Version() const {return mVersion;}
+
+    /// Mark the control values as changed
+    void Modified() {++mVersion;}
+
     /// Get the size of underlying data
     virtual std::size_t Size() const
     {
@@ -155,6 +164,7 @@ public:
 private:
 
     std::string mName;
+    std::size_t mVersion;
 };
 
 /// output stream function
@@ -19,6 +19,7 @@
 #include "includes/define.h"
 #include "includes/serializer.h"
 #include "custom_utilities/iga_define.h"
+#include "custom_utilities/global_to_local_map.h"
 // #include "custom_utilities/nurbs/bcell.h"
 // #include "custom_utilities/nurbs/cell_manager.h"
 #include "custom_utilities/cell_container.h"
@@ -166,6 +167,65 @@ public:
         KRATOS_THROW_ERROR(std::logic_error, "Calling base class function", __FUNCTION__)
     }
 
+    ///////////////
+
+    /// Get the local indices and values of the nonzero basis functions at point xi
+    /// The default implementation evaluates all the basis functions and compresses the result. The derived
+    /// classes shall override it to evaluate only the active functions.
+    virtual void GetActiveValues(std::vector<std::size_t>& indices, std::vector<double>& values, const std::vector<double>& xi) const
+    {
+        std::vector<double> all_values;
+        this->GetValues(all_values, xi);
+
+        indices.clear();
+        values.clear();
+        for (std::size_t i = 0; i < all_values.size(); ++i)
+        {
+            if (all_values[i] != 0.0)
+            {
+                indices.push_back(i);
+                values.push_back(all_values[i]);
+            }
+        }
+    }
+
+    /// Get the local indices, values and derivatives of the nonzero basis functions at point xi
+    /// the output derivatives has the form of derivatives[active_index][dim_index]
+    virtual void GetActiveValuesAndDerivatives(std::vector<std::size_t>& indices, std::vector<double>& values,
+        std::vector<std::vector<double> >& derivatives, const std::vector<double>& xi) const
+    {
+        std::vector<double> all_values;
+        std::vector<std::vector<double> > all_derivatives;
+        this->GetValuesAndDerivatives(all_values, all_derivatives, xi);
+
+        indices.clear();
+        values.clear();
+        derivatives.clear();
+        for (std::size_t i = 0; i < all_values.size(); ++i)
+        {
+            bool is_active = (all_values[i] != 0.0);
+            for (std::size_t dim = 0; dim < all_derivatives[i].size(); ++dim)
+                is_active = is_active || (all_derivatives[i][dim] != 0.0);
+
+            if (is_active)
+            {
+                indices.push_back(i);
+                values.push_back(all_values[i]);
+                derivatives.push_back(all_derivatives[i]);
+            }
+        }
+    }
+
+    /// Get the local indices, values, first and second derivatives of the nonzero basis functions at point xi
+    /// the output derivatives has the form of derivatives[active_index][dim_index]
+    /// the output second derivatives has the form of second_derivatives[active_index][dim_index_1*TDim + dim_index_2]
+    virtual void GetActiveValuesAndDerivatives(std::vector<std::size_t>& indices, std::vector<double>& values,
+        std::vector<std::vector<double> >& derivatives, std::vector<std::vector<double> >& second_derivatives,
+        const std::vector<double>& xi) const
+    {
+        KRATOS_THROW_ERROR(std::logic_error, "Calling base class function", __FUNCTION__)
+    }
+
     /////////////////////////////////////////////////////////////////////////////////////////////////////
 
     /// Check if a point lies inside the parametric domain of the FESpace
@@ -223,15 +283,14 @@ public:
     /// Return the local id of a given global id
     std::size_t LocalId(const std::size_t& global_id) const
     {
-        std::map<std::size_t, std::size_t>::const_iterator it = mGlobalToLocal.find(global_id);
+        GlobalToLocalMap::const_iterator it = mGlobalToLocal.find(global_id);
 
         if (it == mGlobalToLocal.end())
         {
             KRATOS_WATCH(TDim)
             KRATOS_WATCH(global_id)
             std::cout << "mGlobalToLocal:";
-            for(std::map<std::size_t, std::size_t>::const_iterator it2 = mGlobalToLocal.begin(); it2 != mGlobalToLocal.end(); ++it2)
-                std::cout << " " << it2->first << "->" << it2->second;
+            mGlobalToLocal.PrintData(std::cout);
             std::cout << std::endl;
             KRATOS_THROW_ERROR(std::logic_error, "The global id does not exist in global_to_local map", "")
         }
@@ -242,10 +301,18 @@ public:
     /// Return the local ids of given global ids
     std::vector<std::size_t> LocalId(const std::vector<std::size_t>& global_ids) const
     {
-        std::vector<std::size_t> local_ids(global_ids.size());
+        std::vector<std::size_t> local_ids;
+        this->LocalIds(local_ids, global_ids);
+        return local_ids;
+    }
+
+    /// Return the local ids of given global ids
+    void LocalIds(std::vector<std::size_t>& local_ids, const std::vector<std::size_t>& global_ids) const
+    {
+        if (local_ids.size() != global_ids.size())
+            local_ids.resize(global_ids.size());
         for (std::size_t i = 0; i < global_ids.size(); ++i)
             local_ids[i] = this->LocalId(global_ids[i]);
-        return local_ids;
     }
 
     /// Check the compatibility between boundaries of two FESpacees
@@ -341,7 +408,7 @@ public:
     /////////////////////////////////////////////////////////////////////////////////////////////////////
 
     /// Create the cell manager for all the cells in the support domain of the FESpace
-    virtual cell_container_t::Pointer ConstructCellManager() const
+    virtual cell_container_t::ConstPointer ConstructCellManager() const
     {
         KRATOS_THROW_ERROR(std::logic_error, "Calling base class function", __FUNCTION__)
     }
@@ -379,13 +446,12 @@ public:
             rOStream << " " << func_indices[i];
         rOStream << std::endl;
         rOStream << " GlobalToLocal:";
-        for(std::map<std::size_t, std::size_t>::const_iterator it2 = mGlobalToLocal.begin(); it2 != mGlobalToLocal.end(); ++it2)
-            rOStream << " " << it2->first << "->" << it2->second;
+        mGlobalToLocal.PrintData(rOStream);
     }
 
 protected:
 
-    std::map<std::size_t, std::size_t> mGlobalToLocal;
+    GlobalToLocalMap mGlobalToLocal;
 
 private:
 
@@ -394,14 +460,12 @@ private:
 
     virtual void save(Serializer& rSerializer) const
     {
-//        rSerializer.save( "mFunctionsIds", mFunctionsIds ); // can't save std::vector
-//        rSerializer.save( "mGlobalToLocal", mGlobalToLocal ); // can't save std::map
+        rSerializer.save( "mGlobalToLocal", mGlobalToLocal );
     }
 
     virtual void load(Serializer& rSerializer)
     {
-//        rSerializer.load( "mFunctionsIds", mFunctionsIds );
-//        rSerializer.load( "mGlobalToLocal", mGlobalToLocal );
+        rSerializer.load( "mGlobalToLocal", mGlobalToLocal );
     }
 };
 
@@ -476,7 +540,7 @@ public:
     }
 
     /// Create the cell manager for all the cells in the support domain of the FESpace
-    virtual cell_container_t::Pointer ConstructCellManager() const
+    virtual cell_container_t::ConstPointer ConstructCellManager() const
     {
         KRATOS_THROW_ERROR(std::logic_error, "ConstructCellManager is not supported for FESpace<0>", __FUNCTION__)
     }
@@ -0,0 +1,212 @@
+//
+//   Project Name:        Kratos
+//   Last Modified by:    $Author: hbui $
+//   Date:                $Date: 18 Oct 2026 $
+//   Revision:            $Revision: 1.0 $
+//
+//
+
+#if !defined(KRATOS_ISOGEOMETRIC_APPLICATION_GLOBAL_TO_LOCAL_MAP_H_INCLUDED )
+#define  KRATOS_ISOGEOMETRIC_APPLICATION_GLOBAL_TO_LOCAL_MAP_H_INCLUDED
+
+// System includes
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <iostream>
+
+// External includes
+
+// Project includes
+#include "includes/define.h"
+#include "includes/serializer.h"
+
+namespace Kratos
+{
+
+/**
+A flat map from the global index (equation id) of the basis function to its local index in the FESpace.
+The entries are kept in a contiguous array sorted by global index, hence the lookup is O(log n). When the global
+indices form a contiguous range, which is the common case after enumeration, the lookup is O(1) by offset.
+The interface mimics std::map so that it can be iterated with it->first/it->second.
+ */
+class GlobalToLocalMap
+{
+public:
+    /// Pointer definition
+    KRATOS_CLASS_POINTER_DEFINITION(GlobalToLocalMap);
+
+    /// Type definition
+    typedef std::pair<std::size_t, std::size_t> value_type;
+    typedef std::vector<value_type> container_t;
+    typedef container_t::iterator iterator;
+    typedef container_t::const_iterator const_iterator;
+
+    /// Default constructor
+    GlobalToLocalMap() : mIsContiguous(true) {}
+
+    /// Destructor
+    virtual ~GlobalToLocalMap() {}
+
+    /// Iterators
+    iterator begin() {return mData.begin();}
+    iterator end() {return mData.end();}
+    const_iterator begin() const {return mData.begin();}
+    const_iterator end() const {return mData.end();}
+
+    /// Get the number of entries
+    std::size_t size() const {return mData.size();}
+
+    /// Check if the map is empty
+    bool empty() const {return mData.empty();}
+
+    /// Remove all the entries
+    void clear()
+    {
+        mData.clear();
+        mIsContiguous = true;
+    }
+
+    /// Build the map from the array of global indices, i.e. global_ids[i] -> i. This is O(n log n).
+    /// If a global index is repeated, the last local index is kept, as the std::map assignment would do.
+    void Assign(const std::vector<std::size_t>& global_ids)
+    {
+        mData.resize(global_ids.size());
+        for (std::size_t i = 0; i < global_ids.size(); ++i)
+            mData[i] = value_type(global_ids[i], i);
+
+        std::stable_sort(mData.begin(), mData.end(), KeyCompare());
+
+        // remove the duplicated keys and keep the last one
+        if (!mData.empty())
+        {
+            std::size_t last = 0;
+            for (std::size_t i = 1; i < mData.size(); ++i)
+            {
+                if (mData[i].first == mData[last].first)
+                    mData[last].second = mData[i].second;
+                else
+                    mData[++last] = mData[i];
+            }
+            mData.resize(last+1);
+        }
+
+        this->UpdateContiguous();
+    }
+
+    /// Insert or overwrite an entry. Appending an increasing global index is O(1), otherwise it is O(n).
+    void Insert(const std::size_t& global_id, const std::size_t& local_id)
+    {
+        if (mData.empty() || global_id > mData.back().first)
+        {
+            mData.push_back(value_type(global_id, local_id));
+        }
+        else
+        {
+            iterator it = std::lower_bound(mData.begin(), mData.end(), global_id, KeyCompare());
+            if (it != mData.end() && it->first == global_id)
+                it->second = local_id;
+            else
+                mData.insert(it, value_type(global_id, local_id));
+        }
+
+        this->UpdateContiguous();
+    }
+
+    /// Find the entry of a global index
+    const_iterator find(const std::size_t& global_id) const
+    {
+        if (mData.empty())
+            return mData.end();
+
+        if (mIsContiguous)
+        {
+            if (global_id < mData.front().first || global_id > mData.back().first)
+                return mData.end();
+            return mData.begin() + (global_id - mData.front().first);
+        }
+
+        const_iterator it = std::lower_bound(mData.begin(), mData.end(), global_id, KeyCompare());
+        if (it != mData.end() && it->first == global_id)
+            return it;
+        return mData.end();
+    }
+
+    /// Check if the global index exists in the map
+    bool has(const std::size_t& global_id) const
+    {
+        return this->find(global_id) != mData.end();
+    }
+
+    /// Information
+    void PrintInfo(std::ostream& rOStream) const
+    {
+        rOStream << "GlobalToLocalMap, size = " << this->size();
+    }
+
+    void PrintData(std::ostream& rOStream) const
+    {
+        for (const_iterator it = this->begin(); it != this->end(); ++it)
+            rOStream << " " << it->first << "->" << it->second;
+    }
+
+private:
+
+    container_t mData;
+    bool mIsContiguous;
+
+    struct KeyCompare
+    {
+        bool operator()(const value_type& a, const value_type& b) const {return a.first < b.first;}
+        bool operator()(const value_type& a, const std::size_t& b) const {return a.first < b;}
+    };
+
+    /// The keys are sorted and unique, hence they are contiguous iff the range covers exactly the size
+    void UpdateContiguous()
+    {
+        if (mData.empty())
+            mIsContiguous = true;
+        else
+            mIsContiguous = (mData.back().first - mData.front().first + 1 == mData.size());
+    }
+
+    /// Serializer
+    friend class Serializer;
+
+    virtual void save(Serializer& rSerializer) const
+    {
+        std::size_t n = mData.size();
+        rSerializer.save( "Size", n );
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            rSerializer.save( "GlobalId", mData[i].first );
+            rSerializer.save( "LocalId", mData[i].second );
+        }
+    }
+
+    virtual void load(Serializer& rSerializer)
+    {
+        std::size_t n;
+        rSerializer.load( "Size", n );
+        mData.resize(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            rSerializer.load( "GlobalId", mData[i].first );
+            rSerializer.load( "LocalId", mData[i].second );
+        }
+        this->UpdateContiguous();
+    }
+};
+
+/// output stream function
+inline std::ostream& operator <<(std::ostream& rOStream, const GlobalToLocalMap& rThis)
+{
+    rThis.PrintInfo(rOStream);
+    rOStream << std::endl;
+    rThis.PrintData(rOStream);
+    return rOStream;
+}
+
+}// namespace Kratos.
+
+#endif // KRATOS_ISOGEOMETRIC_APPLICATION_GLOBAL_TO_LOCAL_MAP_H_INCLUDED
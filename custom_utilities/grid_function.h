@@ -11,8 +11,12 @@
 
 // System includes
 #include <vector>
+#include <cmath>
+#include <algorithm>
+#include <exception>
 
 // External includes
+#include <omp.h>
 
 // Project includes
 #include "includes/define.h"
@@ -20,6 +24,7 @@
 #include "utilities/math_utils.h"
 #include "custom_utilities/fespace.h"
 #include "custom_utilities/control_grid.h"
+#include "custom_utilities/sampled_point_locator.h"
 
 namespace Kratos
 {
@@ -134,111 +139,80 @@ struct GridFunction_Helper<TDim, TDataType, std::vector<double> >
     }
 };
 
-template<int TDim, typename TDataType, typename TCoordinatesType>
-struct GridFunction_Predict_Helper
+/// Helper to assign the zero value of a data type, i.e. the value of a grid function at a point outside of all the supports
+template<typename TDataType>
+struct GridFunction_Zero_Helper
 {
-    template<class TGridFunctionType>
-    static void Execute(TGridFunctionType& rGridFunc,
-        const TDataType& v, TCoordinatesType& xi, const std::vector<int>& nsampling,
-        const TCoordinatesType& xi_min, const TCoordinatesType& xi_max)
+    static void Zero(TDataType& v)
     {
-        KRATOS_THROW_ERROR(std::logic_error, "Error calling unimplemented", __FUNCTION__)
+        v = TDataType(0.0);
     }
 };
 
 template<>
-struct GridFunction_Predict_Helper<1, array_1d<double, 3>, array_1d<double, 3> >
+struct GridFunction_Zero_Helper<array_1d<double, 3> >
 {
-    template<class TGridFunctionType>
-    static void Execute(TGridFunctionType& rGridFunc,
-        const array_1d<double, 3>& v, array_1d<double, 3>& xi, const std::vector<int>& nsampling,
-        const array_1d<double, 3>& xi_min, const array_1d<double, 3>& xi_max)
-    {
-        if (nsampling.size() < 1)
-            KRATOS_THROW_ERROR(std::logic_error, "sampling array must have dimension 1", "")
-
-        array_1d<double, 3> xi0, p;
-        xi0[1] = 0.0;
-        xi0[2] = 0.0;
-        double dist, min_dist = 1.0e99;
-        for (int i = 0; i < nsampling[0]+1; ++i)
-        {
-            xi0[0] = ((double) i) / nsampling[0];
-            noalias(p) = rGridFunc.GetValue(xi0);
-            dist = norm_2(p - v);
-            if (dist < min_dist)
-            {
-                noalias(xi) = xi0;
-                min_dist = dist;
-            }
-        }
+    static void Zero(array_1d<double, 3>& v)
+    {
+        v[0] = 0.0;
+        v[1] = 0.0;
+        v[2] = 0.0;
     }
 };
 
+/// The size of a Vector is not known from its type, hence the Vector keeps its size and is filled with zeros
 template<>
-struct GridFunction_Predict_Helper<2, array_1d<double, 3>, array_1d<double, 3> >
+struct GridFunction_Zero_Helper<Vector>
 {
-    template<class TGridFunctionType>
-    static void Execute(TGridFunctionType& rGridFunc,
-        const array_1d<double, 3>& v, array_1d<double, 3>& xi, const std::vector<int>& nsampling,
-        const array_1d<double, 3>& xi_min, const array_1d<double, 3>& xi_max)
-    {
-        if (nsampling.size() < 2)
-            KRATOS_THROW_ERROR(std::logic_error, "sampling array must have dimension 2", "")
-
-        array_1d<double, 3> xi0, p;
-        xi0[2] = 0.0;
-        double dist, min_dist = 1.0e99;
-        for (int i = 0; i < nsampling[0]+1; ++i)
-        {
-            xi0[0] = ((double) i) / nsampling[0];
-            for (int j = 0; j < nsampling[1]+1; ++j)
-            {
-                xi0[1] = ((double) j) / nsampling[1];
-                noalias(p) = rGridFunc.GetValue(xi0);
-                dist = norm_2(p - v);
-                if (dist < min_dist)
-                {
-                    noalias(xi) = xi0;
-                    min_dist = dist;
-                }
-            }
-        }
+    static void Zero(Vector& v)
+    {
+        std::fill(v.begin(), v.end(), 0.0);
+    }
+};
+
+template<typename TDataType>
+struct GridFunction_Batch_Helper
+{
+    /// Number of scalar components of the data type in the contiguous output array
+    static constexpr std::size_t NumberOfComponents()
+    {
+        return 0;
+    }
+
+    /// Accumulate f * v into the contiguous output
+    static void Add(double* out, const double& f, const TDataType& v)
+    {
+        KRATOS_THROW_ERROR(std::logic_error, "Batch evaluation is not supported for this data type", __FUNCTION__)
+    }
+};
+
+template<>
+struct GridFunction_Batch_Helper<double>
+{
+    static constexpr std::size_t NumberOfComponents()
+    {
+        return 1;
+    }
+
+    static void Add(double* out, const double& f, const double& v)
+    {
+        out[0] += f * v;
     }
 };
 
 template<>
-struct GridFunction_Predict_Helper<3, array_1d<double, 3>, array_1d<double, 3> >
+struct GridFunction_Batch_Helper<array_1d<double, 3> >
 {
-    template<class TGridFunctionType>
-    static void Execute(TGridFunctionType& rGridFunc,
-        const array_1d<double, 3>& v, array_1d<double, 3>& xi, const std::vector<int>& nsampling,
-        const array_1d<double, 3>& xi_min, const array_1d<double, 3>& xi_max)
+    static constexpr std::size_t NumberOfComponents()
     {
-        if (nsampling.size() < 3)
-            KRATOS_THROW_ERROR(std::logic_error, "sampling array must have dimension 3", "")
+        return 3;
+    }
 
-        array_1d<double, 3> xi0, p;
-        double dist, min_dist = 1.0e99;
-        for (int i = 0; i < nsampling[0]+1; ++i)
-        {
-            xi0[0] = ((double) i) / nsampling[0];
-            for (int j = 0; j < nsampling[1]+1; ++j)
-            {
-                xi0[1] = ((double) j) / nsampling[1];
-                for (int k = 0; k < nsampling[2]+1; ++k)
-                {
-                    xi0[2] = ((double) k) / nsampling[2];
-                    noalias(p) = rGridFunc.GetValue(xi0);
-                    dist = norm_2(p - v);
-                    if (dist < min_dist)
-                    {
-                        noalias(xi) = xi0;
-                        min_dist = dist;
-                    }
-                }
-            }
-        }
+    static void Add(double* out, const double& f, const array_1d<double, 3>& v)
+    {
+        out[0] += f * v[0];
+        out[1] += f * v[1];
+        out[2] += f * v[2];
     }
 };
 
@@ -257,6 +231,7 @@ public:
     typedef std::vector<TDataType> DataContainerType;
     typedef FESpace<TDim> FESpaceType;
     typedef ControlGrid<TDataType> ControlGridType;
+    typedef SampledPointLocator<TDim> LocatorType;
 
     /// Default constructor
     GridFunction(typename FESpaceType::Pointer pFESpace, typename ControlGridType::Pointer pControlGrid)
@@ -272,7 +247,7 @@ public:
     }
 
     /// Set the FESpace
-    void SetFESpace(typename FESpaceType::Pointer pNewFESpace) {mpFESpace = pNewFESpace;} // use this with care
+    void SetFESpace(typename FESpaceType::Pointer pNewFESpace) {mpFESpace = pNewFESpace; this->ClearLocator();} // use this with care
 
     /// Get the FESpace pointer
     typename FESpaceType::Pointer pFESpace() {return mpFESpace;}
@@ -282,7 +257,7 @@ public:
 
     /// Set the control grid
     /// Remarks: this function will effectively replace the underlying control grid, so use this with care
-    void SetControlGrid(typename ControlGridType::Pointer pNewControlGrid) {mpControlGrid = pNewControlGrid;}
+    void SetControlGrid(typename ControlGridType::Pointer pNewControlGrid) {mpControlGrid = pNewControlGrid; this->ClearLocator();}
 
     /// Get the control grid pointer
     typename ControlGridType::Pointer pControlGrid() {return mpControlGrid;}
@@ -309,6 +284,23 @@ public:
         return v;
     }
 
+    /// Get the value of the grid from the active basis functions evaluated beforehand, i.e. by FESpace::GetActiveValues.
+    /// This allows to evaluate the basis functions once and to interpolate several grid functions sharing the same FESpace.
+    void GetValue(TDataType& v, const std::vector<std::size_t>& indices, const std::vector<double>& f_values) const
+    {
+        const ControlGridType& rControlGrid = *pControlGrid();
+
+        if (indices.size() == 0)
+        {
+            GridFunction_Zero_Helper<TDataType>::Zero(v);
+            return;
+        }
+
+        v = f_values[0] * rControlGrid.GetData(indices[0]);
+        for (std::size_t k = 1; k < indices.size(); ++k)
+            v += f_values[k] * rControlGrid.GetData(indices[k]);
+    }
+
     /// Get the derivatives of the grid at specific local coordinates
     /// The output values has the form: [d(values(xi)) / d(xi_0), d(values(xi)) / d(xi_1), ...]
     /// The function derivatives to interpolate the grid value are provided by FESpace. Hence, the TDataType must
@@ -331,15 +323,192 @@ public:
         return dv;
     }
 
+    /// Get the values of the grid at a batch of local coordinates
+    /// The points are given as a contiguous array [xi_0(0), .., xi_0(TDim-1), xi_1(0), ...]. The values are returned in
+    /// a contiguous array of size npoints * ncomponents, where ncomponents is 1 for double and 3 for array_1d.
+    /// The evaluation is distributed over OpenMP threads; each thread keeps its own scratch buffers for the basis values.
+    /// An error raised in a thread is rethrown after the parallel region.
+    void GetValues(std::vector<double>& values, const std::vector<double>& points) const
+    {
+        typedef GridFunction_Batch_Helper<TDataType> BatchHelperType;
+        const std::size_t ncomp = BatchHelperType::NumberOfComponents();
+        const int npoints = static_cast<int>(points.size() / TDim);
+
+        // an exception must not escape the parallel region below, hence the data type and the sizes are checked here
+        if (ncomp == 0)
+            KRATOS_THROW_ERROR(std::logic_error, "Batch evaluation is not supported for this data type", __FUNCTION__)
+        this->Validate();
+
+        if (values.size() != npoints * ncomp)
+            values.resize(npoints * ncomp);
+        std::fill(values.begin(), values.end(), 0.0);
+
+        const FESpaceType& rFESpace = *pFESpace();
+        const ControlGridType& rControlGrid = *pControlGrid();
+
+        // the first error raised in the parallel region is kept and rethrown after it
+        std::exception_ptr p_error;
+
+        #pragma omp parallel
+        {
+            std::vector<double> xi(TDim);
+            std::vector<std::size_t> indices;
+            std::vector<double> f_values;
+
+            #pragma omp for
+            for (int ip = 0; ip < npoints; ++ip)
+            {
+                try
+                {
+                    std::copy(points.begin() + ip*TDim, points.begin() + (ip+1)*TDim, xi.begin());
+                    rFESpace.GetActiveValues(indices, f_values, xi);
+
+                    // the control values are read by GetData, as in GetValue, since operator[] of a weighted control grid
+                    // returns the weighted value
+                    double* out = &values[ip*ncomp];
+                    for (std::size_t k = 0; k < indices.size(); ++k)
+                        BatchHelperType::Add(out, f_values[k], rControlGrid.GetData(indices[k]));
+                }
+                catch (...)
+                {
+                    #pragma omp critical (GridFunction_GetValues)
+                    {
+                        if (!p_error)
+                            p_error = std::current_exception();
+                    }
+                }
+            }
+        }
+
+        if (p_error)
+            std::rethrow_exception(p_error);
+    }
+
+    /// Get the values and derivatives of the grid at a batch of local coordinates
+    /// The layout of points and values is the same as GetValues. The derivatives are returned in a contiguous array
+    /// of size npoints * TDim * ncomponents, i.e. derivatives[(ip*TDim + dim)*ncomponents + c] = d(values_c(xi_ip)) / d(xi_dim).
+    /// An error raised in a thread is rethrown after the parallel region.
+    void GetValuesAndDerivatives(std::vector<double>& values, std::vector<double>& derivatives, const std::vector<double>& points) const
+    {
+        typedef GridFunction_Batch_Helper<TDataType> BatchHelperType;
+        const std::size_t ncomp = BatchHelperType::NumberOfComponents();
+        const int npoints = static_cast<int>(points.size() / TDim);
+
+        // an exception must not escape the parallel region below, hence the data type and the sizes are checked here
+        if (ncomp == 0)
+            KRATOS_THROW_ERROR(std::logic_error, "Batch evaluation is not supported for this data type", __FUNCTION__)
+        this->Validate();
+
+        if (values.size() != npoints * ncomp)
+            values.resize(npoints * ncomp);
+        std::fill(values.begin(), values.end(), 0.0);
+
+        if (derivatives.size() != npoints * TDim * ncomp)
+            derivatives.resize(npoints * TDim * ncomp);
+        std::fill(derivatives.begin(), derivatives.end(), 0.0);
+
+        const FESpaceType& rFESpace = *pFESpace();
+        const ControlGridType& rControlGrid = *pControlGrid();
+
+        // the first error raised in the parallel region is kept and rethrown after it
+        std::exception_ptr p_error;
+
+        #pragma omp parallel
+        {
+            std::vector<double> xi(TDim);
+            std::vector<std::size_t> indices;
+            std::vector<double> f_values;
+            std::vector<std::vector<double> > f_derivatives;
+
+            #pragma omp for
+            for (int ip = 0; ip < npoints; ++ip)
+            {
+                try
+                {
+                    std::copy(points.begin() + ip*TDim, points.begin() + (ip+1)*TDim, xi.begin());
+                    rFESpace.GetActiveValuesAndDerivatives(indices, f_values, f_derivatives, xi);
+
+                    double* out_v = &values[ip*ncomp];
+                    double* out_d = &derivatives[ip*TDim*ncomp];
+                    for (std::size_t k = 0; k < indices.size(); ++k)
+                    {
+                        const TDataType c = rControlGrid.GetData(indices[k]);
+                        BatchHelperType::Add(out_v, f_values[k], c);
+                        for (int dim = 0; dim < TDim; ++dim)
+                            BatchHelperType::Add(out_d + dim*ncomp, f_derivatives[k][dim], c);
+                    }
+                }
+                catch (...)
+                {
+                    #pragma omp critical (GridFunction_GetValues)
+                    {
+                        if (!p_error)
+                            p_error = std::current_exception();
+                    }
+                }
+            }
+        }
+
+        if (p_error)
+            std::rethrow_exception(p_error);
+    }
+
     /// Compute a prediction for LocalCoordinates algorithm. Because LocalCoordinates uses Newton-Raphson algorithm to compute
-    /// the inversion, it requires a good initial starting point
+    /// the inversion, it requires a good initial starting point.
+    /// The grid function is sampled at (nsampling[0]+1) x (nsampling[1]+1) x ... points of [xi_min, xi_max] ([0, 1] in the direction
+    /// where xi_max <= xi_min) and the samples are kept in a kd-tree. The tree is reused for the subsequent predictions with the same
+    /// sampling and is only rebuilt when the sampling, the FESpace or the control values change (see ControlGrid::Version), hence
+    /// each prediction is O(log n) instead of O(n) evaluations.
     template<typename TCoordinatesType>
     void Predict(const TDataType& v, TCoordinatesType& xi, const std::vector<int>& nsampling,
         const TCoordinatesType& xi_min, const TCoordinatesType& xi_max) const
     {
-        GridFunction_Predict_Helper<TDim, TDataType, TCoordinatesType>::Execute(*this, v, xi, nsampling, xi_min, xi_max);
+        if (nsampling.size() < TDim)
+            KRATOS_THROW_ERROR(std::logic_error, "The sampling array must have dimension", TDim)
+
+        std::vector<int> sampling(nsampling.begin(), nsampling.begin() + TDim);
+        std::vector<double> bounds(2*TDim);
+        for (int dim = 0; dim < TDim; ++dim)
+        {
+            if (xi_max[dim] > xi_min[dim])
+            {
+                bounds[2*dim] = xi_min[dim];
+                bounds[2*dim+1] = xi_max[dim];
+            }
+            else
+            {
+                bounds[2*dim] = 0.0;
+                bounds[2*dim+1] = 1.0;
+            }
+        }
+
+        this->PredictWithLocator(*this->pGetLocator(sampling, bounds), v, xi);
     }
 
+    /// Compute a prediction for LocalCoordinates algorithm. The existing locator is used if it is up to date, otherwise
+    /// it is built by sampling the parametric domain of the FESpace with about two samples per basis function in each direction.
+    template<typename TCoordinatesType>
+    void Predict(const TDataType& v, TCoordinatesType& xi) const
+    {
+        this->PredictWithLocator(*this->pGetLocator(std::vector<int>(), std::vector<double>()), v, xi);
+    }
+
+    /// Clear the point locators used by Predict. This shall be called when the control values are changed in place
+    /// in the way that is not detected by the grid function, i.e. not through the setters of the control grid.
+    void ClearLocator() const
+    {
+        #pragma omp critical (GridFunction_CreateLocator)
+        {
+            mpLocator.reset();
+            mpSampledLocator.reset();
+            mLocatorSampling.clear();
+            mLocatorBounds.clear();
+        }
+    }
+
+    /// Get the point locator used by Predict with the default sampling
+    typename LocatorType::ConstPointer pGetLocator() const {return this->pGetLocator(std::vector<int>(), std::vector<double>());}
+
     /// Compute the local coordinate of point that has a specific interpolated values
     /// It is noted that this function only works with TDataType and TCoordinatesType as a Vector-compatible type
     /// On the output:
@@ -387,6 +556,44 @@ public:
         return 0;
     }
 
+    /// Compute the local coordinates of a batch of points. The starting point of each point is predicted by the point locator
+    /// (see Predict) and the Newton-Raphson inversions are distributed over OpenMP threads.
+    /// On the output, stats[i] is the status of the inversion of points[i] (see LocalCoordinates)
+    void LocalCoordinates(const std::vector<TDataType>& points, std::vector<array_1d<double, 3> >& xis, std::vector<int>& stats) const
+    {
+        typename LocatorType::ConstPointer pLocator = this->pGetLocator(std::vector<int>(), std::vector<double>());
+
+        const int npoints = static_cast<int>(points.size());
+        if (xis.size() != npoints)
+            xis.resize(npoints);
+        if (stats.size() != npoints)
+            stats.resize(npoints);
+
+        // an exception must not escape the parallel region, hence the first one is kept and rethrown after the loop
+        std::exception_ptr p_error;
+
+        #pragma omp parallel for
+        for (int i = 0; i < npoints; ++i)
+        {
+            try
+            {
+                this->PredictWithLocator(*pLocator, points[i], xis[i]);
+                stats[i] = this->LocalCoordinates(points[i], xis[i]);
+            }
+            catch (...)
+            {
+                #pragma omp critical (GridFunction_LocalCoordinates)
+                {
+                    if (!p_error)
+                        p_error = std::current_exception();
+                }
+            }
+        }
+
+        if (p_error)
+            std::rethrow_exception(p_error);
+    }
+
     /// Check the compatibility between the underlying control grid and fe space.
     bool Validate() const
     {
@@ -439,6 +646,170 @@ private:
     typename FESpaceType::Pointer mpFESpace;
     typename ControlGridType::Pointer mpControlGrid;
 
+    /// The state of the grid function which a point locator is built with
+    struct LocatorState
+    {
+        const FESpaceType* pFESpace;
+        const ControlGridType* pControlGrid;
+        std::size_t Version;
+        std::size_t NumberOfControlValues;
+        std::size_t NumberOfBfs;
+
+        bool operator==(const LocatorState& rOther) const
+        {
+            return (pFESpace == rOther.pFESpace) && (pControlGrid == rOther.pControlGrid) && (Version == rOther.Version)
+                && (NumberOfControlValues == rOther.NumberOfControlValues) && (NumberOfBfs == rOther.NumberOfBfs);
+        }
+    };
+
+    /// point locators for the prediction of the local coordinates, with the default sampling and with the last sampling
+    /// given to Predict, and the states they were built with. They are only accessed in the critical section
+    /// GridFunction_CreateLocator, where a new locator is published by a pointer swap; a locator in use is kept alive by
+    /// its pointer when it is replaced.
+    mutable typename LocatorType::Pointer mpLocator;
+    mutable LocatorState mLocatorState;
+    mutable typename LocatorType::Pointer mpSampledLocator;
+    mutable LocatorState mSampledLocatorState;
+    mutable std::vector<int> mLocatorSampling;
+    mutable std::vector<double> mLocatorBounds;
+
+    /// Get the current state of the grid function. It is O(1), the control values are tracked by the version of the control grid.
+    LocatorState CurrentLocatorState() const
+    {
+        LocatorState state;
+        state.pFESpace = pFESpace().get();
+        state.pControlGrid = pControlGrid().get();
+        state.Version = pControlGrid()->Version();
+        state.NumberOfControlValues = pControlGrid()->Size();
+        state.NumberOfBfs = pFESpace()->TotalNumber();
+        return state;
+    }
+
+    /// Get an up-to-date locator for the sampling, an empty sampling array stands for the default sampling. The locator
+    /// is built if it is not available. It is built outside the critical section, so that the sampling does not block
+    /// the other threads and its exceptions propagate; if another thread has published an up-to-date locator meanwhile,
+    /// that one is used.
+    typename LocatorType::ConstPointer pGetLocator(const std::vector<int>& nsampling, const std::vector<double>& bounds) const
+    {
+        if (GridFunction_Batch_Helper<TDataType>::NumberOfComponents() == 0)
+            KRATOS_THROW_ERROR(std::logic_error, "The point locator is not supported for the data type of", Info())
+
+        const LocatorState state = this->CurrentLocatorState();
+        typename LocatorType::Pointer pLocator;
+
+        #pragma omp critical (GridFunction_CreateLocator)
+        pLocator = this->FindLocator(state, nsampling, bounds);
+
+        if (pLocator != NULL)
+            return pLocator;
+
+        typename LocatorType::Pointer pNewLocator = this->CreateLocator(nsampling, bounds);
+
+        #pragma omp critical (GridFunction_CreateLocator)
+        {
+            pLocator = this->FindLocator(state, nsampling, bounds);
+            if (pLocator == NULL)
+            {
+                if (nsampling.empty())
+                {
+                    mpLocator = pNewLocator;
+                    mLocatorState = state;
+                }
+                else
+                {
+                    mpSampledLocator = pNewLocator;
+                    mSampledLocatorState = state;
+                    mLocatorSampling = nsampling;
+                    mLocatorBounds = bounds;
+                }
+                pLocator = pNewLocator;
+            }
+        }
+
+        return pLocator;
+    }
+
+    /// Get the stored locator for the sampling if it is built with the given state, otherwise a null pointer. It shall be
+    /// called in the critical section GridFunction_CreateLocator.
+    typename LocatorType::Pointer FindLocator(const LocatorState& state, const std::vector<int>& nsampling, const std::vector<double>& bounds) const
+    {
+        if (nsampling.empty())
+        {
+            if ((mpLocator != NULL) && (mLocatorState == state))
+                return mpLocator;
+        }
+        else
+        {
+            if ((mpSampledLocator != NULL) && (mSampledLocatorState == state)
+                && (nsampling == mLocatorSampling) && (bounds == mLocatorBounds))
+                return mpSampledLocator;
+        }
+        return typename LocatorType::Pointer();
+    }
+
+    /// Sample the grid function on a lattice of the parametric domain and build the locator
+    typename LocatorType::Pointer CreateLocator(const std::vector<int>& nsampling, const std::vector<double>& bounds) const
+    {
+        std::vector<int> sampling = nsampling;
+        std::vector<double> sampling_bounds = bounds;
+
+        if (sampling.empty())
+        {
+            const int n = static_cast<int>(std::ceil(std::pow(static_cast<double>(pFESpace()->TotalNumber()), 1.0/TDim)));
+            sampling.resize(TDim);
+            sampling_bounds.resize(2*TDim);
+            for (int dim = 0; dim < TDim; ++dim)
+            {
+                sampling[dim] = std::max(2*n, 2);
+                std::vector<double> pbounds = pFESpace()->ParametricBounds(dim);
+                sampling_bounds[2*dim] = pbounds[0];
+                sampling_bounds[2*dim+1] = pbounds[1];
+            }
+        }
+
+        // generate the lattice of parametric points, the first direction runs fastest
+        std::size_t npoints = 1;
+        for (int dim = 0; dim < TDim; ++dim)
+            npoints *= (sampling[dim] + 1);
+
+        std::vector<double> points(npoints * TDim);
+        std::vector<int> loc(TDim, 0);
+        for (std::size_t ip = 0; ip < npoints; ++ip)
+        {
+            for (int dim = 0; dim < TDim; ++dim)
+                points[ip*TDim + dim] = sampling_bounds[2*dim]
+                    + (sampling_bounds[2*dim+1] - sampling_bounds[2*dim]) * static_cast<double>(loc[dim]) / sampling[dim];
+
+            for (int dim = 0; dim < TDim; ++dim)
+            {
+                if (++loc[dim] <= sampling[dim])
+                    break;
+                loc[dim] = 0;
+            }
+        }
+
+        // each sample only visits the basis functions active at it (see GetValues), hence sampling about two points per basis
+        // function in each direction does not make the default locator quadratic in the number of basis functions
+        std::vector<double> values;
+        this->GetValues(values, points);
+        typename LocatorType::Pointer pLocator = typename LocatorType::Pointer(new LocatorType());
+        pLocator->Initialize(points, values, GridFunction_Batch_Helper<TDataType>::NumberOfComponents());
+        return pLocator;
+    }
+
+    /// Assign the parametric coordinates of the sample nearest to v to xi
+    template<typename TCoordinatesType>
+    void PredictWithLocator(const LocatorType& rLocator, const TDataType& v, TCoordinatesType& xi) const
+    {
+        typedef GridFunction_Batch_Helper<TDataType> BatchHelperType;
+        std::vector<double> p(BatchHelperType::NumberOfComponents(), 0.0);
+        BatchHelperType::Add(&p[0], 1.0, v);
+
+        const double* xi0 = rLocator.ParametricCoordinates(rLocator.FindNearest(&p[0]));
+        for (std::size_t dim = 0; dim < xi.size(); ++dim)
+            xi[dim] = (dim < TDim) ? xi0[dim] : 0.0;
+    }
+
 };
 
 
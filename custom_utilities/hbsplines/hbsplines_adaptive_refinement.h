@@ -0,0 +1,873 @@
+//
+//   Project Name:        Kratos
+//   Last Modified by:    $Author: hbui $
+//   Date:                $Date: 18 Oct 2026 $
+//   Revision:            $Revision: 1.0 $
+//
+//
+
+#if !defined(KRATOS_ISOGEOMETRIC_APPLICATION_HBSPLINES_ADAPTIVE_REFINEMENT_H_INCLUDED)
+#define  KRATOS_ISOGEOMETRIC_APPLICATION_HBSPLINES_ADAPTIVE_REFINEMENT_H_INCLUDED
+
+// System includes
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <algorithm>
+#include <tuple>
+
+// External includes
+
+// Project includes
+#include "includes/define.h"
+#include "includes/model_part.h"
+#include "includes/variables.h"
+#include "utilities/openmp_utils.h"
+#include "custom_utilities/iga_define.h"
+#include "custom_utilities/patch.h"
+#include "custom_utilities/multipatch_model_part.h"
+#include "custom_utilities/hbsplines/hbsplines_fespace.h"
+#include "custom_utilities/hbsplines/hbsplines_refinement_utility.h"
+
+#define ENABLE_PROFILING
+
+namespace Kratos
+{
+
+/**
+Error-driven adaptive refinement of the hierarchical B-Splines patches of a MultiPatchModelPart. The elements and the
+conditions are added through this class, which remembers the cell underneath each entity. At each step, the cells of the
+elements with large error indicator are refined and the model_part is updated incrementally:
++   the equation ids freed by the refinement are reused for the new basis functions, hence the untouched control points
+    keep their node, including its id, dofs and historical values,
++   only the nodes of the new basis functions are created, and only the nodes of the basis functions which control
+    values are changed by the refinement are updated,
++   only the cells supporting these basis functions or a renumbered one are updated, and only the elements on them
+    which anchors, weights or extraction operator are changed are re-created.
+The solution variables registered by AddTransferVariable are transferred to the refined space by the two-scale relation.
+The updated nodes keep their deformation X - X0, the new nodes are undeformed; if DISPLACEMENT is transferred, the
+deformed position of the updated nodes is X0 + DISPLACEMENT.
+The new nodes have the same dofs as the other nodes, but free; the Dirichlet conditions must be re-applied and the
+builder-and-solver must be re-initialized since the equation system is changed.
+ */
+template<int TDim>
+class HBSplinesAdaptiveRefinement : public IsogeometricEcho
+{
+public:
+    /// Pointer definition
+    KRATOS_CLASS_POINTER_DEFINITION(HBSplinesAdaptiveRefinement);
+
+    /// Type definition
+    typedef MultiPatchModelPart<TDim> MultiPatchModelPartType;
+    typedef typename MultiPatch<TDim>::patch_ptr_iterator patch_ptr_iterator;
+    typedef typename MultiPatch<TDim>::interface_iterator interface_iterator;
+    typedef typename Patch<TDim>::ControlPointType ControlPointType;
+    typedef typename HBSplinesFESpace<TDim>::bf_t bf_t;
+    typedef typename HBSplinesFESpace<TDim>::cell_t hb_cell_t;
+    typedef Element::NodeType NodeType;
+    typedef ModelPart::NodesContainerType NodesContainerType;
+    typedef ModelPart::ElementsContainerType ElementsContainerType;
+    typedef ModelPart::ConditionsContainerType ConditionsContainerType;
+
+    /// Default constructor
+    HBSplinesAdaptiveRefinement(typename MultiPatchModelPartType::Pointer pMPModelPart)
+    : mpMPModelPart(pMPModelPart), mLastElementId(0), mLastConditionId(0)
+    {
+        ModelPart::Pointer pModelPart = mpMPModelPart->pModelPart();
+
+        for (ElementsContainerType::ptr_iterator it = pModelPart->Elements().ptr_begin(); it != pModelPart->Elements().ptr_end(); ++it)
+            mLastElementId = std::max(mLastElementId, (*it)->Id());
+
+        for (ConditionsContainerType::ptr_iterator it = pModelPart->Conditions().ptr_begin(); it != pModelPart->Conditions().ptr_end(); ++it)
+            mLastConditionId = std::max(mLastConditionId, (*it)->Id());
+    }
+
+    /// Destructor
+    virtual ~HBSplinesAdaptiveRefinement() {}
+
+    /// Get the underlying multipatch model_part
+    typename MultiPatchModelPartType::Pointer pMultiPatchModelPart() {return mpMPModelPart;}
+
+    /// Create the elements on the cells of the patch and add to the model_part. The elements are updated at each refinement.
+    /// The model_part must be ready, i.e. EndModelPart is called. The cells of the patch must be up-to-date.
+    ElementsContainerType AddElements(typename Patch<TDim>::Pointer pPatch, const std::string& element_name, Properties::Pointer pProperties)
+    {
+        if (!mpMPModelPart->IsReady())
+            KRATOS_THROW_ERROR(std::logic_error, "The multipatch model_part is not ready", "")
+
+        EntityGroup group;
+        group.PatchId = pPatch->Id();
+        group.Side = -1;
+        group.Name = element_name;
+        group.pProperties = pProperties;
+
+        std::vector<std::size_t> removed_ids;
+        ElementsContainerType pNewElements;
+        UpdateGroup<Element, TDim>(group, pPatch, std::vector<std::size_t>(), removed_ids, pNewElements, mLastElementId);
+        mElementGroups.push_back(group);
+
+        ElementsContainerType& rElements = mpMPModelPart->pModelPart()->Elements();
+        for (ElementsContainerType::ptr_iterator it = pNewElements.ptr_begin(); it != pNewElements.ptr_end(); ++it)
+            rElements.push_back(*it);
+        rElements.Unique();
+
+        if (this->GetEchoLevel() > 0)
+            std::cout << __FUNCTION__ << " completed, " << pNewElements.size() << " elements of type " << element_name
+                      << " are generated for patch " << pPatch->Id() << std::endl;
+
+        return pNewElements;
+    }
+
+    /// Create the conditions on the boundary side of the patch and add to the model_part. The conditions are updated at each refinement.
+    ConditionsContainerType AddConditions(typename Patch<TDim>::Pointer pPatch, const BoundarySide& side,
+            const std::string& condition_name, Properties::Pointer pProperties)
+    {
+        if (!mpMPModelPart->IsReady())
+            KRATOS_THROW_ERROR(std::logic_error, "The multipatch model_part is not ready", "")
+
+        EntityGroup group;
+        group.PatchId = pPatch->Id();
+        group.Side = static_cast<int>(side);
+        group.Name = condition_name;
+        group.pProperties = pProperties;
+
+        std::vector<std::size_t> removed_ids;
+        ConditionsContainerType pNewConditions;
+        typename Patch<TDim-1>::Pointer pBoundaryPatch = pPatch->ConstructBoundaryPatch(side);
+        UpdateGroup<Condition, TDim-1>(group, pBoundaryPatch, std::vector<std::size_t>(), removed_ids, pNewConditions, mLastConditionId);
+        mConditionGroups.push_back(group);
+
+        ConditionsContainerType& rConditions = mpMPModelPart->pModelPart()->Conditions();
+        for (ConditionsContainerType::ptr_iterator it = pNewConditions.ptr_begin(); it != pNewConditions.ptr_end(); ++it)
+            rConditions.push_back(*it);
+        rConditions.Unique();
+
+        if (this->GetEchoLevel() > 0)
+            std::cout << __FUNCTION__ << " completed, " << pNewConditions.size() << " conditions of type " << condition_name
+                      << " are generated for side " << side << " of patch " << pPatch->Id() << std::endl;
+
+        return pNewConditions;
+    }
+
+    /// Register a nodal solution variable to be transferred to the refined space
+    void AddTransferVariable(const Variable<double>& rVariable)
+    {
+        mDoubleVariables.push_back(&rVariable);
+    }
+
+    /// Register a nodal solution variable to be transferred to the refined space
+    void AddTransferVariable(const Variable<array_1d<double, 3> >& rVariable)
+    {
+        mArray1DVariables.push_back(&rVariable);
+    }
+
+    /// Refine the cells of the elements which error indicator (the elemental value of rErrorVariable) is not smaller than
+    /// RefineFraction times the maximum error indicator, and update the model_part.
+    /// Return the number of refined basis functions; 0 means nothing can be refined.
+    std::size_t MarkAndRefine(const Variable<double>& rErrorVariable, const double& RefineFraction)
+    {
+        ModelPart::Pointer pModelPart = mpMPModelPart->pModelPart();
+
+        double max_error = 0.0;
+        for (std::size_t i = 0; i < mElementGroups.size(); ++i)
+            for (typename signature_map_t::iterator it = mElementGroups[i].Entities.begin(); it != mElementGroups[i].Entities.end(); ++it)
+                max_error = std::max(max_error, pModelPart->pGetElement(it->second)->GetValue(rErrorVariable));
+
+        std::vector<std::size_t> element_ids;
+        if (max_error > 0.0)
+        {
+            for (std::size_t i = 0; i < mElementGroups.size(); ++i)
+                for (typename signature_map_t::iterator it = mElementGroups[i].Entities.begin(); it != mElementGroups[i].Entities.end(); ++it)
+                    if (pModelPart->pGetElement(it->second)->GetValue(rErrorVariable) >= RefineFraction * max_error)
+                        element_ids.push_back(it->second);
+        }
+
+        if (this->GetEchoLevel() > 0)
+            std::cout << __FUNCTION__ << ": maximum error = " << max_error << ", " << element_ids.size() << " elements are marked" << std::endl;
+
+        return this->RefineElements(element_ids);
+    }
+
+    /// Refine the cells of the given elements, i.e. the basis functions of the finest level supported on the cells, and
+    /// update the model_part. Return the number of refined basis functions.
+    std::size_t RefineElements(const std::vector<std::size_t>& element_ids)
+    {
+        if (!mpMPModelPart->IsReady())
+            KRATOS_THROW_ERROR(std::logic_error, "The multipatch model_part is not ready", "")
+
+        #ifdef ENABLE_PROFILING
+        double start = OpenMPUtils::GetCurrentTime();
+        #endif
+
+        typename MultiPatch<TDim>::Pointer pMultiPatch = mpMPModelPart->pMultiPatch();
+
+        // collect the marked cells of each patch
+        std::set<std::size_t> marked_elements(element_ids.begin(), element_ids.end());
+        std::map<std::size_t, std::set<std::size_t> > marked_cells;
+        for (std::size_t i = 0; i < mElementGroups.size(); ++i)
+            for (typename signature_map_t::iterator it = mElementGroups[i].Entities.begin(); it != mElementGroups[i].Entities.end(); ++it)
+                if (marked_elements.find(it->second) != marked_elements.end())
+                    marked_cells[mElementGroups[i].PatchId].insert(it->first.CellId);
+
+        // collect the basis functions of the finest level on the marked cells. A basis function supported on several
+        // marked cells is collected once.
+        std::map<std::size_t, std::vector<bf_t> > marked_bfs;
+        std::set<std::size_t> marked_equation_ids;
+        std::size_t nmarked = 0;
+        for (std::map<std::size_t, std::set<std::size_t> >::iterator it_patch = marked_cells.begin(); it_patch != marked_cells.end(); ++it_patch)
+        {
+            typename HBSplinesFESpace<TDim>::Pointer pFESpace = this->pGetHBSplinesFESpace(pMultiPatch->pGetPatch(it_patch->first));
+
+            std::set<std::size_t> bf_ids;
+            for (std::set<std::size_t>::iterator it_id = it_patch->second.begin(); it_id != it_patch->second.end(); ++it_id)
+            {
+                if (!pFESpace->pCellManager()->has(*it_id))
+                    continue;
+                hb_cell_t p_cell = pFESpace->pCellManager()->get(*it_id);
+
+                std::vector<bf_t> cell_bfs;
+                std::size_t max_level = 0;
+                for (typename HBSplinesFESpace<TDim>::CellType::bf_iterator it_bf = p_cell->bf_begin(); it_bf != p_cell->bf_end(); ++it_bf)
+                {
+                    bf_t p_bf = it_bf->lock();
+                    if (p_bf == NULL) continue;
+                    cell_bfs.push_back(p_bf);
+                    max_level = std::max(max_level, p_bf->Level());
+                }
+
+                for (std::size_t i = 0; i < cell_bfs.size(); ++i)
+                {
+                    if (cell_bfs[i]->Level() == max_level && cell_bfs[i]->Level() < pFESpace->MaxLevel())
+                    {
+                        if (bf_ids.insert(cell_bfs[i]->Id()).second)
+                        {
+                            marked_bfs[it_patch->first].push_back(cell_bfs[i]);
+                            marked_equation_ids.insert(cell_bfs[i]->EquationId());
+                            ++nmarked;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (nmarked == 0)
+            return 0;
+
+        // the bfs removed by the refinement are the marked bfs and their copies on the interfaces, which have the same
+        // equation id. They are kept with their cells, since the entities on these cells must be updated.
+        std::map<std::size_t, std::vector<bf_t> > refined_bfs;
+        std::map<std::size_t, std::set<std::size_t> > refined_cell_ids;
+        for (patch_ptr_iterator it = pMultiPatch->Patches().ptr_begin(); it != pMultiPatch->Patches().ptr_end(); ++it)
+        {
+            typename HBSplinesFESpace<TDim>::Pointer pFESpace = this->pGetHBSplinesFESpace(*it);
+            for (std::set<std::size_t>::iterator it_id = marked_equation_ids.begin(); it_id != marked_equation_ids.end(); ++it_id)
+            {
+                if (!pFESpace->HasBfByEquationId(*it_id))
+                    continue;
+
+                bf_t p_bf = pFESpace->pGetBfByEquationId(*it_id);
+                refined_bfs[(*it)->Id()].push_back(p_bf);
+                for (typename HBSplinesFESpace<TDim>::BasisFunctionType::cell_iterator it_cell = p_bf->cell_begin(); it_cell != p_bf->cell_end(); ++it_cell)
+                    refined_cell_ids[(*it)->Id()].insert((*it_cell)->Id());
+            }
+        }
+
+        // transfer the solution from the nodes to the control values
+        for (std::size_t i = 0; i < mDoubleVariables.size(); ++i)
+            mpMPModelPart->SynchronizeBackward(*mDoubleVariables[i]);
+        for (std::size_t i = 0; i < mArray1DVariables.size(); ++i)
+            mpMPModelPart->SynchronizeBackward(*mArray1DVariables[i]);
+
+        // record the equation ids before the refinement
+        std::vector<std::size_t> old_ids = this->CollectEquationIds();
+        if (old_ids.empty())
+            KRATOS_THROW_ERROR(std::logic_error, "The multipatch is not enumerated, no equation id is found", "")
+        const std::size_t first = old_ids.front();
+
+        // refine the basis functions of each patch together. The bfs refined already by the refinement of the neighbor
+        // patch are skipped. The truncated patches are transformed to the HB representation once for all the patches.
+        {
+            HBSplinesTruncationGuard<TDim> guard(pMultiPatch->pGetPatch(marked_bfs.begin()->first));
+
+            for (typename std::map<std::size_t, std::vector<bf_t> >::iterator it_patch = marked_bfs.begin(); it_patch != marked_bfs.end(); ++it_patch)
+            {
+                typename Patch<TDim>::Pointer pPatch = pMultiPatch->pGetPatch(it_patch->first);
+                typename HBSplinesFESpace<TDim>::Pointer pFESpace = this->pGetHBSplinesFESpace(pPatch);
+
+                std::vector<bf_t> bfs;
+                for (std::size_t i = 0; i < it_patch->second.size(); ++i)
+                    if (pFESpace->HasBf(it_patch->second[i]))
+                        bfs.push_back(it_patch->second[i]);
+
+                HBSplinesRefinementUtility::Refine<TDim>(pPatch, bfs, this->GetEchoLevel() > 1 ? this->GetEchoLevel() : 0);
+            }
+        }
+
+        #ifdef ENABLE_PROFILING
+        if (this->GetEchoLevel() > 0)
+            std::cout << "  ++ refine " << nmarked << " basis functions: " << OpenMPUtils::GetCurrentTime() - start << " s" << std::endl;
+        start = OpenMPUtils::GetCurrentTime();
+        #endif
+
+        // share the equation ids of the new basis functions on the interfaces
+        this->EnumerateInterfaces();
+
+        // renumber the equation ids. The surviving basis functions keep their equation id, the new basis functions take
+        // the freed ids. Only when the number of basis functions decreases, the survivors beyond the range are moved.
+        std::vector<std::size_t> current_ids = this->CollectEquationIds();
+        const std::size_t last = first + current_ids.size();
+
+        std::vector<std::size_t> survivors, new_ids;
+        for (std::size_t i = 0; i < current_ids.size(); ++i)
+        {
+            if (std::binary_search(old_ids.begin(), old_ids.end(), current_ids[i]))
+                survivors.push_back(current_ids[i]);
+            else
+                new_ids.push_back(current_ids[i]);
+        }
+
+        std::vector<std::size_t> holes;
+        std::size_t i_survivor = 0;
+        for (std::size_t id = first; id < last; ++id)
+        {
+            while (i_survivor < survivors.size() && survivors[i_survivor] < id) ++i_survivor;
+            if (i_survivor == survivors.size() || survivors[i_survivor] != id)
+                holes.push_back(id);
+        }
+
+        std::vector<std::size_t> movers;
+        std::map<std::size_t, std::size_t> moved_survivors; // old equation id to new equation id
+        for (std::size_t i = 0; i < survivors.size(); ++i)
+            if (survivors[i] >= last)
+                movers.push_back(survivors[i]);
+        movers.insert(movers.end(), new_ids.begin(), new_ids.end());
+
+        if (movers.size() != holes.size())
+            KRATOS_THROW_ERROR(std::logic_error, "The number of free equation ids is not consistent", "")
+
+        std::map<std::size_t, std::size_t> new_indices;
+        for (std::size_t i = 0; i < current_ids.size(); ++i)
+            new_indices[current_ids[i]] = current_ids[i];
+        for (std::size_t i = 0; i < movers.size(); ++i)
+        {
+            new_indices[movers[i]] = holes[i];
+            if (std::binary_search(old_ids.begin(), old_ids.end(), movers[i]))
+                moved_survivors[movers[i]] = holes[i];
+        }
+
+        for (patch_ptr_iterator it = pMultiPatch->Patches().ptr_begin(); it != pMultiPatch->Patches().ptr_end(); ++it)
+            (*it)->pFESpace()->UpdateFunctionIndices(new_indices);
+
+        // the ids are consecutive now, this only rebuilds the equation id to patch map
+        pMultiPatch->Enumerate(first);
+
+        // the ids which are given to a different control point
+        std::vector<std::size_t> reassigned_ids = holes;
+
+        // the cells supporting the children of the removed bfs or a bf with a reassigned id are updated, and the nodes of
+        // the bfs on these cells. They include the children, which control values are changed by the two-scale relation,
+        // and for a truncated patch the other descendants of the removed bfs, which truncated control values change.
+        std::map<std::size_t, std::map<std::size_t, hb_cell_t> > updated_cells; // patch id to the cells, by their Id
+        std::map<std::size_t, std::pair<std::size_t, std::size_t> > updated_nodes; // equation id to the patch id and the local id
+        std::size_t ncells = 0;
+        for (patch_ptr_iterator it = pMultiPatch->Patches().ptr_begin(); it != pMultiPatch->Patches().ptr_end(); ++it)
+        {
+            typename HBSplinesFESpace<TDim>::Pointer pFESpace = this->pGetHBSplinesFESpace(*it);
+
+            std::vector<bf_t> updated_bfs;
+            typename std::map<std::size_t, std::vector<bf_t> >::iterator it_refined = refined_bfs.find((*it)->Id());
+            if (it_refined != refined_bfs.end())
+            {
+                for (std::size_t i = 0; i < it_refined->second.size(); ++i)
+                {
+                    const bf_t& p_bf = it_refined->second[i];
+                    if (pFESpace->HasBf(p_bf))
+                        continue;
+                    for (typename HBSplinesFESpace<TDim>::BasisFunctionType::bf_iterator it_child = p_bf->bf_begin(); it_child != p_bf->bf_end(); ++it_child)
+                        if (pFESpace->HasBf(*it_child))
+                            updated_bfs.push_back(*it_child);
+                }
+            }
+
+            for (std::size_t i = 0; i < reassigned_ids.size(); ++i)
+                if (pFESpace->HasBfByEquationId(reassigned_ids[i]))
+                    updated_bfs.push_back(pFESpace->pGetBfByEquationId(reassigned_ids[i]));
+
+            if (updated_bfs.empty() && it_refined == refined_bfs.end())
+                continue;
+
+            std::map<std::size_t, hb_cell_t>& rCells = updated_cells[(*it)->Id()];
+            for (std::size_t i = 0; i < updated_bfs.size(); ++i)
+                for (typename HBSplinesFESpace<TDim>::BasisFunctionType::cell_iterator it_cell = updated_bfs[i]->cell_begin(); it_cell != updated_bfs[i]->cell_end(); ++it_cell)
+                    rCells[(*it_cell)->Id()] = *it_cell;
+
+            std::vector<hb_cell_t> cells;
+            for (typename std::map<std::size_t, hb_cell_t>::iterator it_cell = rCells.begin(); it_cell != rCells.end(); ++it_cell)
+            {
+                cells.push_back(it_cell->second);
+                for (typename HBSplinesFESpace<TDim>::CellType::bf_iterator it_bf = it_cell->second->bf_begin(); it_bf != it_cell->second->bf_end(); ++it_bf)
+                {
+                    bf_t p_bf = it_bf->lock();
+                    if (p_bf == NULL) continue;
+                    const std::size_t equation_id = p_bf->EquationId();
+                    if (updated_nodes.find(equation_id) == updated_nodes.end())
+                        updated_nodes[equation_id] = std::make_pair((*it)->Id(), pFESpace->LocalId(equation_id));
+                }
+            }
+            pFESpace->UpdateCells(cells);
+            ncells += cells.size();
+        }
+
+        #ifdef ENABLE_PROFILING
+        if (this->GetEchoLevel() > 0)
+            std::cout << "  ++ renumber and update " << ncells << " cells of " << updated_cells.size() << " patches: " << OpenMPUtils::GetCurrentTime() - start << " s" << std::endl;
+        start = OpenMPUtils::GetCurrentTime();
+        #endif
+
+        // update the nodes
+        std::vector<std::size_t> removed_ids;
+        std::set_difference(old_ids.begin(), old_ids.end(), survivors.begin(), survivors.end(), std::back_inserter(removed_ids));
+        this->UpdateNodes(removed_ids, moved_survivors, new_ids, new_indices, updated_nodes);
+
+        #ifdef ENABLE_PROFILING
+        if (this->GetEchoLevel() > 0)
+            std::cout << "  ++ update the nodes, " << removed_ids.size() << " nodes are removed, " << new_ids.size()
+                      << " nodes are added, " << updated_nodes.size() << " nodes are updated: " << OpenMPUtils::GetCurrentTime() - start << " s" << std::endl;
+        start = OpenMPUtils::GetCurrentTime();
+        #endif
+
+        // update the entities on the changed cells
+        std::vector<std::size_t> removed_elements, removed_conditions;
+        ElementsContainerType pNewElements;
+        ConditionsContainerType pNewConditions;
+
+        for (std::size_t i = 0; i < mElementGroups.size(); ++i)
+        {
+            typename std::map<std::size_t, std::map<std::size_t, hb_cell_t> >::iterator it_cells = updated_cells.find(mElementGroups[i].PatchId);
+            if (it_cells == updated_cells.end())
+                continue;
+
+            // the cells which are updated and the cells of the removed bfs, which may not exist anymore
+            std::set<std::size_t> cell_ids = refined_cell_ids[mElementGroups[i].PatchId];
+            for (typename std::map<std::size_t, hb_cell_t>::iterator it_cell = it_cells->second.begin(); it_cell != it_cells->second.end(); ++it_cell)
+                cell_ids.insert(it_cell->first);
+
+            typename Patch<TDim>::Pointer pPatch = pMultiPatch->pGetPatch(mElementGroups[i].PatchId);
+            UpdateElementGroup(mElementGroups[i], pPatch, cell_ids, reassigned_ids, removed_elements, pNewElements);
+        }
+
+        // the boundary patches are re-created, hence the conditions of the updated patches are checked on all the cells of the boundary
+        for (std::size_t i = 0; i < mConditionGroups.size(); ++i)
+        {
+            if (updated_cells.find(mConditionGroups[i].PatchId) == updated_cells.end())
+                continue;
+
+            typename Patch<TDim>::Pointer pPatch = pMultiPatch->pGetPatch(mConditionGroups[i].PatchId);
+            typename Patch<TDim-1>::Pointer pBoundaryPatch = pPatch->ConstructBoundaryPatch(static_cast<BoundarySide>(mConditionGroups[i].Side));
+            UpdateGroup<Condition, TDim-1>(mConditionGroups[i], pBoundaryPatch, reassigned_ids, removed_conditions, pNewConditions, mLastConditionId);
+        }
+
+        this->ReplaceEntities(mpMPModelPart->pModelPart()->Elements(), removed_elements, pNewElements);
+        this->ReplaceEntities(mpMPModelPart->pModelPart()->Conditions(), removed_conditions, pNewConditions);
+
+        if (this->GetEchoLevel() > 0)
+        {
+            #ifdef ENABLE_PROFILING
+            std::cout << "  ++ update the entities: " << OpenMPUtils::GetCurrentTime() - start << " s" << std::endl;
+            #endif
+            std::cout << __FUNCTION__ << " completed, " << nmarked << " basis functions are refined, "
+                      << removed_elements.size() << " elements are replaced by " << pNewElements.size() << ", "
+                      << removed_conditions.size() << " conditions are replaced by " << pNewConditions.size()
+                      << ", number of equations = " << pMultiPatch->EquationSystemSize() << std::endl;
+        }
+
+        return nmarked;
+    }
+
+    /// Information
+    virtual void PrintInfo(std::ostream& rOStream) const
+    {
+        rOStream << "HBSplinesAdaptiveRefinement" << TDim << "D";
+    }
+
+    virtual void PrintData(std::ostream& rOStream) const
+    {
+        rOStream << " Number of element groups: " << mElementGroups.size() << std::endl;
+        rOStream << " Number of condition groups: " << mConditionGroups.size() << std::endl;
+        rOStream << " Number of transfer variables: " << mDoubleVariables.size() + mArray1DVariables.size() << std::endl;
+    }
+
+private:
+
+    /// The data of a cell which determines the entity created on it
+    struct EntitySignature
+    {
+        std::size_t CellId; // only for the elements; the cells of the boundary patch are re-created at each update
+        std::vector<std::size_t> Anchors;
+        std::vector<double> Weights;
+        std::vector<std::size_t> CrowPointers;
+        std::vector<std::size_t> CrowIndices;
+        std::vector<double> CrowValues;
+
+        bool operator<(const EntitySignature& rOther) const
+        {
+            if (CellId != rOther.CellId) return CellId < rOther.CellId;
+            if (Anchors != rOther.Anchors) return Anchors < rOther.Anchors;
+            if (Weights != rOther.Weights) return Weights < rOther.Weights;
+            if (CrowPointers != rOther.CrowPointers) return CrowPointers < rOther.CrowPointers;
+            if (CrowIndices != rOther.CrowIndices) return CrowIndices < rOther.CrowIndices;
+            return CrowValues < rOther.CrowValues;
+        }
+    };
+
+    typedef std::multimap<EntitySignature, std::size_t> signature_map_t;
+
+    /// The entities created on a patch (elements) or on a boundary side of a patch (conditions)
+    struct EntityGroup
+    {
+        std::size_t PatchId;
+        int Side; // -1 for the elements
+        std::string Name;
+        Properties::Pointer pProperties;
+        signature_map_t Entities; // the signature of the cell and the id of the entity
+    };
+
+    typename MultiPatchModelPartType::Pointer mpMPModelPart;
+    std::vector<EntityGroup> mElementGroups;
+    std::vector<EntityGroup> mConditionGroups;
+    std::size_t mLastElementId;
+    std::size_t mLastConditionId;
+    std::vector<const Variable<double>*> mDoubleVariables;
+    std::vector<const Variable<array_1d<double, 3> >*> mArray1DVariables;
+
+    /// Extract the hierarchical B-Splines space of a patch
+    typename HBSplinesFESpace<TDim>::Pointer pGetHBSplinesFESpace(typename Patch<TDim>::Pointer pPatch) const
+    {
+        typename HBSplinesFESpace<TDim>::Pointer pFESpace = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatch->pFESpace());
+        if (pFESpace == NULL)
+            KRATOS_THROW_ERROR(std::runtime_error, "The cast to HBSplinesFESpace is failed for patch", pPatch->Id())
+        return pFESpace;
+    }
+
+    /// Collect the equation ids of all the patches, sorted
+    std::vector<std::size_t> CollectEquationIds() const
+    {
+        std::set<std::size_t> all_indices;
+        typename MultiPatch<TDim>::Pointer pMultiPatch = mpMPModelPart->pMultiPatch();
+        for (patch_ptr_iterator it = pMultiPatch->Patches().ptr_begin(); it != pMultiPatch->Patches().ptr_end(); ++it)
+        {
+            std::vector<std::size_t> func_indices = (*it)->pFESpace()->FunctionIndices();
+            all_indices.insert(func_indices.begin(), func_indices.end());
+        }
+        return std::vector<std::size_t>(all_indices.begin(), all_indices.end());
+    }
+
+    /// Assign the equation ids on the interfaces, the same as MultiPatch::Enumerate but without renumbering
+    void EnumerateInterfaces()
+    {
+        typename MultiPatch<TDim>::Pointer pMultiPatch = mpMPModelPart->pMultiPatch();
+
+        for (patch_ptr_iterator it = pMultiPatch->Patches().ptr_begin(); it != pMultiPatch->Patches().ptr_end(); ++it)
+            if ((*it)->IsPrimary() == true)
+                for (interface_iterator it2 = (*it)->InterfaceBegin(); it2 != (*it)->InterfaceEnd(); ++it2)
+                    (*it2)->Enumerate();
+
+        for (patch_ptr_iterator it = pMultiPatch->Patches().ptr_begin(); it != pMultiPatch->Patches().ptr_end(); ++it)
+            if ((*it)->IsPrimary() == false)
+                (*it)->Enumerate();
+    }
+
+    /// Remove the nodes of the refined basis functions, relabel the moved survivors, create the nodes of the new basis
+    /// functions and update the given nodes, i.e. the equation id to the patch id and the local id, from the control values
+    void UpdateNodes(const std::vector<std::size_t>& removed_ids, const std::map<std::size_t, std::size_t>& moved_survivors,
+            const std::vector<std::size_t>& new_ids, const std::map<std::size_t, std::size_t>& new_indices,
+            const std::map<std::size_t, std::pair<std::size_t, std::size_t> >& updated_nodes)
+    {
+        ModelPart::Pointer pModelPart = mpMPModelPart->pModelPart();
+        typename MultiPatch<TDim>::Pointer pMultiPatch = mpMPModelPart->pMultiPatch();
+        NodesContainerType& rNodes = pModelPart->Nodes();
+
+        // the patches of the new nodes, which need a reference node to copy the dofs from
+        std::vector<std::size_t> new_patches(new_ids.size());
+        std::map<std::size_t, NodeType::Pointer> ref_nodes; // patch id to a surviving node of the patch
+        for (std::size_t i = 0; i < new_ids.size(); ++i)
+        {
+            new_patches[i] = std::get<0>(pMultiPatch->EquationIdLocation(new_indices.find(new_ids[i])->second));
+            ref_nodes[new_patches[i]] = NodeType::Pointer();
+        }
+        std::size_t nmissing = ref_nodes.size();
+
+        NodesContainerType NewNodes;
+        NewNodes.reserve(rNodes.size() - removed_ids.size() + new_ids.size());
+        NodeType::Pointer pRefNode;
+        for (NodesContainerType::ptr_iterator it = rNodes.ptr_begin(); it != rNodes.ptr_end(); ++it)
+        {
+            const std::size_t global_id = CONVERT_INDEX_KRATOS_TO_IGA((*it)->Id());
+            if (std::binary_search(removed_ids.begin(), removed_ids.end(), global_id))
+                continue;
+
+            std::map<std::size_t, std::size_t>::const_iterator it_moved = moved_survivors.find(global_id);
+            if (it_moved != moved_survivors.end())
+                (*it)->SetId(CONVERT_INDEX_IGA_TO_KRATOS(it_moved->second));
+
+            if (pRefNode == NULL)
+                pRefNode = *it;
+
+            if (nmissing != 0)
+            {
+                const std::size_t patch_id = std::get<0>(pMultiPatch->EquationIdLocation(CONVERT_INDEX_KRATOS_TO_IGA((*it)->Id())));
+                std::map<std::size_t, NodeType::Pointer>::iterator it_ref = ref_nodes.find(patch_id);
+                if (it_ref != ref_nodes.end() && it_ref->second == NULL)
+                {
+                    it_ref->second = *it;
+                    --nmissing;
+                }
+            }
+
+            NewNodes.push_back(*it);
+        }
+
+        // the new nodes take the dofs of a node of the same patch, or of any node if all the basis functions of the patch
+        // are refined. The coordinates and the values are assigned below.
+        for (std::size_t i = 0; i < new_ids.size(); ++i)
+        {
+            const std::size_t global_id = new_indices.find(new_ids[i])->second;
+            NodeType::Pointer pNewNode = boost::make_shared<NodeType>(CONVERT_INDEX_IGA_TO_KRATOS(global_id), 0.0, 0.0, 0.0);
+            pNewNode->SetSolutionStepVariablesList(&pModelPart->GetNodalSolutionStepVariablesList());
+            pNewNode->SetBufferSize(pModelPart->GetBufferSize());
+
+            NodeType::Pointer pPatchRefNode = ref_nodes[new_patches[i]];
+            if (pPatchRefNode == NULL)
+                pPatchRefNode = pRefNode;
+
+            if (pPatchRefNode != NULL)
+            {
+                for (NodeType::DofsContainerType::iterator it_dof = pPatchRefNode->GetDofs().begin(); it_dof != pPatchRefNode->GetDofs().end(); ++it_dof)
+                    pNewNode->pAddDof(*it_dof)->FreeDof();
+            }
+
+            NewNodes.push_back(pNewNode);
+        }
+
+        NewNodes.Unique();
+        rNodes.swap(NewNodes);
+
+        bool is_displacement_transferred = false;
+        for (std::size_t j = 0; j < mArray1DVariables.size(); ++j)
+            if (*mArray1DVariables[j] == DISPLACEMENT)
+                is_displacement_transferred = true;
+
+        // the control values of the children of the refined basis functions are changed by the two-scale relation
+        for (std::map<std::size_t, std::pair<std::size_t, std::size_t> >::const_iterator it = updated_nodes.begin(); it != updated_nodes.end(); ++it)
+        {
+            typename Patch<TDim>::Pointer pPatch = pMultiPatch->pGetPatch(it->second.first);
+            const std::size_t& i = it->second.second;
+            NodeType& rNode = *(MultiPatchUtility::FindKey(rNodes, CONVERT_INDEX_IGA_TO_KRATOS(it->first), "Node"));
+
+            array_1d<double, 3> deformation;
+            deformation[0] = rNode.X() - rNode.X0();
+            deformation[1] = rNode.Y() - rNode.Y0();
+            deformation[2] = rNode.Z() - rNode.Z0();
+
+            const ControlPointType point = pPatch->pControlPointGridFunction()->pControlGrid()->GetData(i);
+            rNode.X0() = point.X();
+            rNode.Y0() = point.Y();
+            rNode.Z0() = point.Z();
+            rNode.SetValue(NURBS_WEIGHT, point.W());
+
+            for (std::size_t j = 0; j < mDoubleVariables.size(); ++j)
+                rNode.GetSolutionStepValue(*mDoubleVariables[j]) = pPatch->pGetGridFunction(*mDoubleVariables[j])->pControlGrid()->GetData(i);
+
+            for (std::size_t j = 0; j < mArray1DVariables.size(); ++j)
+                rNode.GetSolutionStepValue(*mArray1DVariables[j]) = pPatch->pGetGridFunction(*mArray1DVariables[j])->pControlGrid()->GetData(i);
+
+            if (is_displacement_transferred)
+                noalias(deformation) = rNode.GetSolutionStepValue(DISPLACEMENT);
+
+            rNode.X() = rNode.X0() + deformation[0];
+            rNode.Y() = rNode.Y0() + deformation[1];
+            rNode.Z() = rNode.Z0() + deformation[2];
+        }
+    }
+
+    /// Compute the signature of a cell of the FESpace
+    template<int TFESpaceDim>
+    static void ComputeSignature(EntitySignature& rSignature, const Cell& rCell, const FESpace<TFESpaceDim>& rFESpace,
+            const ControlGrid<ControlPointType>& rControlGrid, const bool& with_cell_id)
+    {
+        rSignature.CellId = with_cell_id ? rCell.Id() : 0;
+        rSignature.Anchors = rCell.GetSupportedAnchors();
+
+        std::vector<std::size_t> local_ids;
+        rFESpace.LocalIds(local_ids, rSignature.Anchors);
+        rSignature.Weights.resize(local_ids.size());
+        for (std::size_t i = 0; i < local_ids.size(); ++i)
+            rSignature.Weights[i] = rControlGrid.GetData(local_ids[i]).W();
+
+        rSignature.CrowPointers = rCell.GetCrowPointers();
+        rSignature.CrowIndices = rCell.GetCrowIndices();
+        rSignature.CrowValues = rCell.GetCrowValues();
+    }
+
+    /// Update the entities of a group on the current cells of the (boundary) patch. The entities which cell signature
+    /// is unchanged and which anchors are not reassigned are kept; the others are removed and re-created.
+    template<class TEntityType, int TFESpaceDim>
+    void UpdateGroup(EntityGroup& rGroup, typename Patch<TFESpaceDim>::Pointer pPatch, const std::vector<std::size_t>& reassigned_ids,
+            std::vector<std::size_t>& rRemovedIds, PointerVectorSet<TEntityType, IndexedObject>& rNewEntities, std::size_t& rLastId)
+    {
+        typedef typename FESpace<TFESpaceDim>::cell_container_t cell_container_t;
+        typedef typename cell_container_t::cell_t cell_t;
+
+        typename cell_container_t::ConstPointer pCellManager = pPatch->pFESpace()->ConstructCellManager();
+        typename ControlGrid<ControlPointType>::Pointer pControlGrid = pPatch->pControlPointGridFunction()->pControlGrid();
+
+        signature_map_t entities;
+        std::vector<cell_t> new_cells;
+        std::vector<EntitySignature> new_signatures;
+        EntitySignature signature;
+        for (typename cell_container_t::const_iterator it_cell = pCellManager->begin(); it_cell != pCellManager->end(); ++it_cell)
+        {
+            ComputeSignature<TFESpaceDim>(signature, **it_cell, *(pPatch->pFESpace()), *pControlGrid, rGroup.Side == -1);
+
+            typename signature_map_t::iterator it = rGroup.Entities.find(signature);
+
+            if (it != rGroup.Entities.end() && !IsReassigned(signature, reassigned_ids))
+            {
+                entities.insert(*it);
+                rGroup.Entities.erase(it);
+            }
+            else
+            {
+                new_cells.push_back(*it_cell);
+                new_signatures.push_back(signature);
+            }
+        }
+
+        for (typename signature_map_t::iterator it = rGroup.Entities.begin(); it != rGroup.Entities.end(); ++it)
+            rRemovedIds.push_back(it->second);
+
+        if (new_cells.size() > 0)
+        {
+            PointerVectorSet<TEntityType, IndexedObject> pNewEntities = MultiPatchModelPartType::template CreateEntitiesFromCells<TEntityType, FESpace<TFESpaceDim>, ControlGrid<ControlPointType>, NodesContainerType>(
+                    pPatch->pFESpace(), new_cells, pControlGrid, mpMPModelPart->pModelPart()->Nodes(), rGroup.Name, rLastId + 1, rGroup.pProperties, this->GetEchoLevel());
+
+            for (std::size_t i = 0; i < new_signatures.size(); ++i)
+                entities.insert(std::make_pair(new_signatures[i], rLastId + 1 + i));
+            rLastId += new_cells.size();
+
+            for (typename PointerVectorSet<TEntityType, IndexedObject>::ptr_iterator it = pNewEntities.ptr_begin(); it != pNewEntities.ptr_end(); ++it)
+                rNewEntities.push_back(*it);
+        }
+
+        rGroup.Entities.swap(entities);
+    }
+
+    /// Update the elements of a group on the given cells of the patch only, see UpdateGroup. The cells which do not exist
+    /// anymore lose their elements.
+    void UpdateElementGroup(EntityGroup& rGroup, typename Patch<TDim>::Pointer pPatch, const std::set<std::size_t>& cell_ids,
+            const std::vector<std::size_t>& reassigned_ids, std::vector<std::size_t>& rRemovedIds, ElementsContainerType& rNewEntities)
+    {
+        typedef typename FESpace<TDim>::cell_container_t::cell_t cell_t;
+
+        typename HBSplinesFESpace<TDim>::Pointer pFESpace = this->pGetHBSplinesFESpace(pPatch);
+        typename ControlGrid<ControlPointType>::Pointer pControlGrid = pPatch->pControlPointGridFunction()->pControlGrid();
+
+        signature_map_t entities;
+        std::vector<cell_t> new_cells;
+        std::vector<EntitySignature> new_signatures;
+        EntitySignature signature, first;
+        for (std::set<std::size_t>::const_iterator it_id = cell_ids.begin(); it_id != cell_ids.end(); ++it_id)
+        {
+            // the signatures are ordered by the cell id first, hence the elements of the cell are consecutive
+            first.CellId = *it_id;
+            typename signature_map_t::iterator it_begin = rGroup.Entities.lower_bound(first);
+            typename signature_map_t::iterator it_end = it_begin;
+            while (it_end != rGroup.Entities.end() && it_end->first.CellId == *it_id)
+                ++it_end;
+
+            typename signature_map_t::iterator it_kept = it_end;
+            if (pFESpace->pCellManager()->has(*it_id))
+            {
+                hb_cell_t p_cell = pFESpace->pCellManager()->get(*it_id);
+                ComputeSignature<TDim>(signature, *p_cell, *pFESpace, *pControlGrid, true);
+
+                typename signature_map_t::iterator it = rGroup.Entities.find(signature);
+                if (it != rGroup.Entities.end() && !IsReassigned(signature, reassigned_ids))
+                {
+                    entities.insert(*it);
+                    it_kept = it;
+                }
+                else
+                {
+                    new_cells.push_back(p_cell.get());
+                    new_signatures.push_back(signature);
+                }
+            }
+
+            for (typename signature_map_t::iterator it = it_begin; it != it_end; ++it)
+                if (it != it_kept)
+                    rRemovedIds.push_back(it->second);
+            rGroup.Entities.erase(it_begin, it_end);
+        }
+
+        if (new_cells.size() > 0)
+        {
+            ElementsContainerType pNewEntities = MultiPatchModelPartType::template CreateEntitiesFromCells<Element, FESpace<TDim>, ControlGrid<ControlPointType>, NodesContainerType>(
+                    pPatch->pFESpace(), new_cells, pControlGrid, mpMPModelPart->pModelPart()->Nodes(), rGroup.Name, mLastElementId + 1, rGroup.pProperties, this->GetEchoLevel());
+
+            for (std::size_t i = 0; i < new_signatures.size(); ++i)
+                entities.insert(std::make_pair(new_signatures[i], mLastElementId + 1 + i));
+            mLastElementId += new_cells.size();
+
+            for (ElementsContainerType::ptr_iterator it = pNewEntities.ptr_begin(); it != pNewEntities.ptr_end(); ++it)
+                rNewEntities.push_back(*it);
+        }
+
+        rGroup.Entities.insert(entities.begin(), entities.end());
+    }
+
+    /// Check if one of the anchors of the signature is given to a different control point
+    static bool IsReassigned(const EntitySignature& rSignature, const std::vector<std::size_t>& reassigned_ids)
+    {
+        for (std::size_t i = 0; i < rSignature.Anchors.size(); ++i)
+            if (std::binary_search(reassigned_ids.begin(), reassigned_ids.end(), rSignature.Anchors[i]))
+                return true;
+        return false;
+    }
+
+    /// Remove the entities with the given ids from the container and add the new entities
+    template<class TContainerType>
+    static void ReplaceEntities(TContainerType& rEntities, std::vector<std::size_t>& removed_ids, TContainerType& rNewEntities)
+    {
+        std::sort(removed_ids.begin(), removed_ids.end());
+
+        TContainerType Entities;
+        Entities.reserve(rEntities.size() - removed_ids.size() + rNewEntities.size());
+        for (typename TContainerType::ptr_iterator it = rEntities.ptr_begin(); it != rEntities.ptr_end(); ++it)
+            if (!std::binary_search(removed_ids.begin(), removed_ids.end(), (*it)->Id()))
+                Entities.push_back(*it);
+
+        for (typename TContainerType::ptr_iterator it = rNewEntities.ptr_begin(); it != rNewEntities.ptr_end(); ++it)
+            Entities.push_back(*it);
+
+        Entities.Unique();
+        rEntities.swap(Entities);
+    }
+};
+
+/// output stream function
+template<int TDim>
+inline std::ostream& operator <<(std::ostream& rOStream, const HBSplinesAdaptiveRefinement<TDim>& rThis)
+{
+    rThis.PrintInfo(rOStream);
+    rOStream << std::endl;
+    rThis.PrintData(rOStream);
+    return rOStream;
+}
+
+} // namespace Kratos.
+
+#undef ENABLE_PROFILING
+
+#endif // KRATOS_ISOGEOMETRIC_APPLICATION_HBSPLINES_ADAPTIVE_REFINEMENT_H_INCLUDED
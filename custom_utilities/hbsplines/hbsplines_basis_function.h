@@ -19,6 +19,8 @@
 #include <fstream>
 #include <set>
 #include <list>
+#include <utility>
+#include <algorithm>
 
 // External includes
 #include <omp.h>
@@ -71,6 +73,11 @@ public:
     typedef typename cell_container_t::iterator cell_iterator;
     typedef typename cell_container_t::const_iterator cell_const_iterator;
 
+    /// The refined coefficients are kept in a contiguous array of (child id, coefficient) sorted by the child id
+    typedef std::pair<std::size_t, double> refined_coefficient_t;
+    typedef std::vector<refined_coefficient_t> refined_coefficient_container_t;
+    typedef typename refined_coefficient_container_t::const_iterator refined_coefficient_const_iterator;
+
     /// Empty constructor for serialization
     HBSplinesBasisFunction() : BaseType(), mLevel(0)
     {}
@@ -136,7 +143,22 @@ public:
     void AddChild(bf_t p_bf, const double& RefinedCoefficient)
     {
         mpChilds.push_back(p_bf);
-        mRefinedCoefficients[p_bf->Id()] = RefinedCoefficient;
+
+        // the children are usually added in the order of their Id, hence appending is the common case
+        const std::size_t& child_id = p_bf->Id();
+        if (mRefinedCoefficients.empty() || child_id > mRefinedCoefficients.back().first)
+        {
+            mRefinedCoefficients.push_back(refined_coefficient_t(child_id, RefinedCoefficient));
+        }
+        else
+        {
+            typename refined_coefficient_container_t::iterator it = std::lower_bound(mRefinedCoefficients.begin(),
+                    mRefinedCoefficients.end(), child_id, RefinedCoefficientCompare());
+            if (it != mRefinedCoefficients.end() && it->first == child_id)
+                it->second = RefinedCoefficient;
+            else
+                mRefinedCoefficients.insert(it, refined_coefficient_t(child_id, RefinedCoefficient));
+        }
     }
 
     /// Remove the child from the list
@@ -147,12 +169,22 @@ public:
             if(*it == p_bf)
             {
                 mpChilds.erase(it);
-                mRefinedCoefficients.erase(p_bf->Id());
+                typename refined_coefficient_container_t::iterator it_coeff = std::lower_bound(mRefinedCoefficients.begin(),
+                        mRefinedCoefficients.end(), p_bf->Id(), RefinedCoefficientCompare());
+                if (it_coeff != mRefinedCoefficients.end() && it_coeff->first == p_bf->Id())
+                    mRefinedCoefficients.erase(it_coeff);
                 break;
             }
         }
     }
 
+    /// Remove all the children and their refined coefficients
+    void ClearChildren()
+    {
+        mpChilds.clear();
+        mRefinedCoefficients.clear();
+    }
+
     /**************************************************************************
                             ACCESS SUBROUTINES
     **************************************************************************/
@@ -173,11 +205,16 @@ public:
     void SetLevel(const std::size_t& Level) {mLevel = Level;}
     const std::size_t& Level() const {return mLevel;}
 
-    /// Get the refined coefficient of a child
-    double GetRefinedCoefficient(const int& child_id) const
+    /// Iterators to the refined coefficients, in the order of the child Id
+    refined_coefficient_const_iterator refined_coefficient_begin() const {return mRefinedCoefficients.begin();}
+    refined_coefficient_const_iterator refined_coefficient_end() const {return mRefinedCoefficients.end();}
+
+    /// Get the refined coefficient of a child. This is O(log k) with k the number of children.
+    double GetRefinedCoefficient(const std::size_t& child_id) const
     {
-        std::map<int, double>::const_iterator it = mRefinedCoefficients.find(child_id);
-        if(it != mRefinedCoefficients.end())
+        refined_coefficient_const_iterator it = std::lower_bound(mRefinedCoefficients.begin(),
+                mRefinedCoefficients.end(), child_id, RefinedCoefficientCompare());
+        if(it != mRefinedCoefficients.end() && it->first == child_id)
             return it->second;
         else
         {
@@ -317,10 +354,7 @@ public:
         rOStream << " List of children:";
         std::size_t cnt = 0;
         for(bf_const_iterator it = bf_begin(); it != bf_end(); ++it)
-        {
-            std::map<int, double>::const_iterator it_coeff = mRefinedCoefficients.find((*it)->Id());
-            rOStream << "  " << ++cnt << ": (" << (*it)->Id() << "," << it_coeff->second << ")";
-        }
+            rOStream << "  " << ++cnt << ": (" << (*it)->Id() << "," << this->GetRefinedCoefficient((*it)->Id()) << ")";
         if(bf_end() == bf_begin())
             rOStream << " none";
         rOStream << std::endl;
@@ -331,7 +365,42 @@ private:
     std::size_t mLevel;
     bf_container_t mpParents; // list of refined basis functions that this basis function is composed from
     bf_container_t mpChilds; // list of refined basis functions that composes this basis function
-    std::map<int, double> mRefinedCoefficients; // store the coefficient of refined basis functions
+    refined_coefficient_container_t mRefinedCoefficients; // store the coefficient of refined basis functions, sorted by the child Id
+
+    struct RefinedCoefficientCompare
+    {
+        bool operator()(const refined_coefficient_t& a, const std::size_t& b) const {return a.first < b;}
+    };
+
+    /// Serializer
+    friend class Serializer;
+
+    virtual void save(Serializer& rSerializer) const
+    {
+        BaseType::save(rSerializer);
+        rSerializer.save( "Level", mLevel );
+        std::size_t n = mRefinedCoefficients.size();
+        rSerializer.save( "Size", n );
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            rSerializer.save( "ChildId", mRefinedCoefficients[i].first );
+            rSerializer.save( "RefinedCoefficient", mRefinedCoefficients[i].second );
+        }
+    }
+
+    virtual void load(Serializer& rSerializer)
+    {
+        BaseType::load(rSerializer);
+        rSerializer.load( "Level", mLevel );
+        std::size_t n;
+        rSerializer.load( "Size", n );
+        mRefinedCoefficients.resize(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            rSerializer.load( "ChildId", mRefinedCoefficients[i].first );
+            rSerializer.load( "RefinedCoefficient", mRefinedCoefficients[i].second );
+        }
+    }
 
 };
 
@@ -10,7 +10,9 @@
 #define  KRATOS_ISOGEOMETRIC_APPLICATION_HBSPLINES_FESPACE_H_INCLUDED
 
 // System includes
+#include <cmath>
 #include <vector>
+#include <map>
 
 // External includes
 #include <boost/array.hpp>
@@ -22,11 +24,9 @@
 #include "custom_utilities/bspline_utils.h"
 #include "custom_utilities/nurbs/bcell_manager.h"
 #include "custom_utilities/nurbs/pbbsplines_fespace.h"
-#include "custom_utilities/nurbs/domain_manager.h"
-#include "custom_utilities/nurbs/domain_manager_2d.h"
-#include "custom_utilities/nurbs/domain_manager_3d.h"
 #include "custom_utilities/hbsplines/hb_cell.h"
 #include "custom_utilities/hbsplines/hbsplines_basis_function.h"
+#include "custom_utilities/hbsplines/hbsplines_two_scale_relation_cache.h"
 
 #define DEBUG_GEN_CELL
 
@@ -58,14 +58,18 @@ public:
     typedef typename BaseType::cell_container_t cell_container_t;
     typedef typename BaseType::cell_t cell_t;
 
-    typedef DomainManager::Pointer domain_t;
-    typedef std::map<std::size_t, domain_t> domain_container_t;
-
     typedef typename BaseType::function_map_t function_map_t;
 
+    typedef std::map<std::size_t, bf_t> refined_bf_container_t;
+    typedef typename refined_bf_container_t::iterator refined_bf_iterator;
+    typedef typename refined_bf_container_t::const_iterator refined_bf_const_iterator;
+
     /// Default constructor
-    HBSplinesFESpace() : BaseType(), mLastLevel(1), mMaxLevel(10)
-    {}
+    HBSplinesFESpace() : BaseType(), mLastLevel(1), mMaxLevel(10), mIsTruncated(false), mIsCoarseningEnabled(false)
+    {
+        for (int dim = 0; dim < TDim; ++dim)
+            mDefaultRefinementRatios[dim].assign(1, 0.5);
+    }
 
     /// Destructor
     virtual ~HBSplinesFESpace()
@@ -91,7 +95,7 @@ public:
                 return *it;
 
         // create the new bf and add the knot
-        bf_t p_bf = bf_t(new BasisFunctionType(Id, Level));
+        bf_t p_bf = MemoryPool::Create<BasisFunctionType>(BaseType::mpMemoryPool, Id, Level);
         for (int dim = 0; dim < TDim; ++dim)
         {
             p_bf->SetLocalKnotVectors(dim, rpKnots[dim]);
@@ -99,14 +103,83 @@ public:
         }
         BaseType::mpBasisFuncs.insert(p_bf);
         BaseType::m_function_map_is_created = false;
+        BaseType::m_bf_index_is_created = false;
 
         return p_bf;
     }
 
+    /// Create the bfs for a list of local knot vectors, in the order of the list. It is the same as calling CreateBf for
+    /// each item with Id = LastId + 1 and increasing LastId when a new bf is created, but the existing bfs are indexed once
+    /// by their local knots instead of being searched for each item.
+    std::vector<bf_t> CreateBfs(std::size_t& LastId, const std::size_t& Level, const std::vector<std::vector<std::vector<knot_t> > >& rpKnots)
+    {
+        typedef std::map<std::vector<std::vector<knot_t> >, bf_t> knot_index_t;
+
+        knot_index_t existing_bfs;
+        for(bf_iterator it = BaseType::bf_begin(); it != BaseType::bf_end(); ++it)
+        {
+            std::vector<std::vector<knot_t> > key(TDim);
+            for (int dim = 0; dim < TDim; ++dim)
+                key[dim] = (*it)->LocalKnots(dim);
+            existing_bfs.insert(typename knot_index_t::value_type(key, *it));
+        }
+
+        std::vector<bf_t> p_bfs(rpKnots.size());
+        for (std::size_t i = 0; i < rpKnots.size(); ++i)
+        {
+            std::vector<std::vector<knot_t> > key(rpKnots[i].begin(), rpKnots[i].begin() + TDim);
+            typename knot_index_t::iterator it = existing_bfs.find(key);
+            if (it != existing_bfs.end())
+            {
+                p_bfs[i] = it->second;
+                continue;
+            }
+
+            bf_t p_bf = MemoryPool::Create<BasisFunctionType>(BaseType::mpMemoryPool, ++LastId, Level);
+            for (int dim = 0; dim < TDim; ++dim)
+            {
+                p_bf->SetLocalKnotVectors(dim, rpKnots[i][dim]);
+                p_bf->SetInfo(dim, this->Order(dim));
+            }
+            BaseType::mpBasisFuncs.insert(p_bf);
+            existing_bfs.insert(typename knot_index_t::value_type(key, p_bf));
+            p_bfs[i] = p_bf;
+        }
+
+        if (rpKnots.size() > 0)
+        {
+            BaseType::m_function_map_is_created = false;
+            BaseType::m_bf_index_is_created = false;
+        }
+
+        return p_bfs;
+    }
+
     /// EtaMaxdate the basis functions for all cells. This function must be called before any operation on cell is required.
+    /// If the space is truncated, the extraction operators are the ones of the truncated basis functions, and a basis
+    /// function is not an anchor of the cells where its truncation vanishes.
     virtual void UpdateCells()
     {
         this->ResetCells();
+        BaseType::m_bf_index_is_created = false;
+
+        if (mIsTruncated)
+        {
+            // the bfs are visited in the order of their Id, which is also the order of the bfs of each cell
+            TruncationData data(mLastLevel, BaseType::mpCellManager->GetTolerance());
+            this->InitializeTruncationData(data);
+            std::vector<std::pair<cell_t, Vector> > rows;
+            std::vector<std::pair<bf_t, double> > absorbed_bfs;
+            for(bf_iterator it_bf = BaseType::bf_begin(); it_bf != BaseType::bf_end(); ++it_bf)
+            {
+                rows.clear();
+                absorbed_bfs.clear();
+                this->ComputeTruncation(data, *it_bf, &rows, NULL, absorbed_bfs);
+                for(std::size_t i = 0; i < rows.size(); ++i)
+                    rows[i].first->AddAnchor((*it_bf)->EquationId(), (*it_bf)->GetValue(CONTROL_POINT).W(), rows[i].second);
+            }
+            return;
+        }
 
         // for each cell compute the extraction operator and add to the anchor
         Vector Crow;
@@ -121,6 +194,64 @@ public:
         }
     }
 
+    /// Update the basis functions of the given cells only, e.g. the cells in the support of the basis functions changed
+    /// by a refinement. If the space is truncated, all the cells are updated, since the truncated basis functions are
+    /// computed function by function.
+    void UpdateCells(const std::vector<cell_t>& p_cells)
+    {
+        if (mIsTruncated)
+        {
+            this->UpdateCells();
+            return;
+        }
+
+        BaseType::m_bf_index_is_created = false;
+
+        Vector Crow;
+        for(std::size_t i = 0; i < p_cells.size(); ++i)
+        {
+            p_cells[i]->Reset();
+            for(typename CellType::bf_iterator it_bf = p_cells[i]->bf_begin(); it_bf != p_cells[i]->bf_end(); ++it_bf)
+            {
+                BasisFunctionType& bf = *(it_bf->lock());
+                bf.ComputeExtractionOperator(Crow, p_cells[i]);
+                p_cells[i]->AddAnchor(bf.EquationId(), bf.GetValue(CONTROL_POINT).W(), Crow);
+            }
+        }
+    }
+
+    /// Check if the basis functions are truncated, i.e. the space is a truncated hierarchical B-Splines (THB) space
+    const bool& IsTruncated() const {return mIsTruncated;}
+
+    /// Enable/disable the truncation of the basis functions. It only switches the basis; the control values of the basis
+    /// functions are not transformed, see HBSplinesRefinementUtility::SetTruncation. If the space is truncated, GetValue,
+    /// GetValues, GetActiveValues and the derivatives evaluate the truncated basis functions.
+    void SetTruncated(const bool& IsTruncated)
+    {
+        mIsTruncated = IsTruncated;
+        BaseType::m_bf_index_is_created = false;
+    }
+
+    /// Compute the relation between the hierarchical and the truncated hierarchical basis functions. The truncation of
+    /// a bf b removes its part represented by the finer levels, i.e. b = trunc(b) + sum a_f * f over some finer bfs f.
+    /// rCoefficients[Id of f] lists the pairs (b, a_f). Hence a function sum c_b * b has the coefficients
+    /// c'_f = c_f + sum a_f * c'_b in the truncated basis, which are computed from the coarsest level to the finest one.
+    void ComputeTruncationCoefficients(std::map<std::size_t, std::vector<std::pair<bf_t, double> > >& rCoefficients) const
+    {
+        rCoefficients.clear();
+
+        TruncationData data(mLastLevel, BaseType::mpCellManager->GetTolerance());
+        this->InitializeTruncationData(data);
+        std::vector<std::pair<bf_t, double> > absorbed_bfs;
+        for(bf_const_iterator it_bf = BaseType::bf_begin(); it_bf != BaseType::bf_end(); ++it_bf)
+        {
+            absorbed_bfs.clear();
+            this->ComputeTruncation(data, *it_bf, NULL, NULL, absorbed_bfs);
+            for(std::size_t i = 0; i < absorbed_bfs.size(); ++i)
+                rCoefficients[absorbed_bfs[i].first->Id()].push_back(std::make_pair(*it_bf, absorbed_bfs[i].second));
+        }
+    }
+
     /// Get the knot vector in i-direction, i=0..Dim
     /// User must be careful to use this function because it can modify the internal knot vectors
     knot_container_t& KnotVector(const std::size_t& i) {return mKnotVectors[i];}
@@ -140,6 +271,70 @@ public:
     /// Set the maximum level allowed in the hierarchical mesh
     void SetMaxLevel(const std::size_t& MaxLevel) {mMaxLevel = MaxLevel;}
 
+    /// Set the relative positions in (0, 1) of the knots inserted in each nonzero knot span of the bfs of a level in
+    /// direction dim, when they are refined. The default is {0.5}, i.e. the bisection. An empty list leaves the direction
+    /// unrefined (anisotropic refinement). The positions of a level cannot be changed once the level is refined, since
+    /// the children of a level must share the same knot vectors.
+    void SetRefinementRatios(const std::size_t& Level, const int& dim, const std::vector<double>& ratios)
+    {
+        if (Level < mLastLevel)
+            KRATOS_THROW_ERROR(std::logic_error, "The refinement ratios cannot be changed since this level is already refined:", Level)
+
+        typename std::map<std::size_t, boost::array<std::vector<double>, TDim> >::iterator it = mRefinementRatios.find(Level);
+        if (it == mRefinementRatios.end())
+            it = mRefinementRatios.insert(std::make_pair(Level, mDefaultRefinementRatios)).first;
+
+        CheckRefinementRatios(ratios);
+        it->second[dim] = ratios;
+        CheckRefinementRatios(it->second);
+    }
+
+    /// Set the relative positions of the inserted knots for all the levels which are not refined yet and have no own positions
+    void SetRefinementRatios(const int& dim, const std::vector<double>& ratios)
+    {
+        // the refined levels keep their positions
+        for (std::size_t level = 1; level < mLastLevel; ++level)
+            if (mRefinementRatios.find(level) == mRefinementRatios.end())
+                mRefinementRatios[level] = mDefaultRefinementRatios;
+
+        CheckRefinementRatios(ratios);
+        boost::array<std::vector<double>, TDim> default_ratios = mDefaultRefinementRatios;
+        default_ratios[dim] = ratios;
+        CheckRefinementRatios(default_ratios);
+        mDefaultRefinementRatios = default_ratios;
+    }
+
+    /// Insert n uniformly distributed knots in each nonzero knot span of the bfs of a level in direction dim
+    void SetNumberOfInsertedKnots(const std::size_t& Level, const int& dim, const std::size_t& n)
+    {
+        std::vector<double> ratios;
+        for (std::size_t i = 1; i <= n; ++i)
+            ratios.push_back(static_cast<double>(i) / (n + 1));
+        SetRefinementRatios(Level, dim, ratios);
+    }
+
+    /// Get the relative positions of the knots inserted in the knot spans of the bfs of a level in direction dim
+    const std::vector<double>& RefinementRatios(const std::size_t& Level, const int& dim) const
+    {
+        typename std::map<std::size_t, boost::array<std::vector<double>, TDim> >::const_iterator it = mRefinementRatios.find(Level);
+        if (it != mRefinementRatios.end())
+            return it->second[dim];
+        return mDefaultRefinementRatios[dim];
+    }
+
+    /// Get the cache of the univariate two-scale relations of the B-Splines of this space, which is shared by the
+    /// refinement and the truncation
+    TwoScaleRelationCache& TwoScaleRelations() {return mTwoScaleRelations;}
+    const TwoScaleRelationCache& TwoScaleRelations() const {return mTwoScaleRelations;}
+
+    /// Compute the knots inserted in the knot span [Left, Right] of a bf of a level in direction dim
+    void ComputeInsertedKnots(const std::size_t& Level, const int& dim, const double& Left, const double& Right, std::vector<double>& rKnots) const
+    {
+        const std::vector<double>& ratios = RefinementRatios(Level, dim);
+        for (std::size_t i = 0; i < ratios.size(); ++i)
+            rKnots.push_back(Left + ratios[i] * (Right - Left));
+    }
+
     /// Get the string representing the type of the patch
     virtual std::string Type() const
     {
@@ -195,27 +390,64 @@ public:
     /// Add the bf's id to the refinement history
     void RecordRefinementHistory(const std::size_t& Id) {mRefinementHistory.push_back(Id);}
 
-    /// Clear the support domain container
-    void ClearSupportDomain() {mSupportDomains.clear();}
+    /// Check if the bfs removed by the refinement are kept for the coarsening
+    const bool& IsCoarseningEnabled() const {return mIsCoarseningEnabled;}
 
-    /// Get the domain manager for support domain for level k. In the case that does not exist, create the new one.
-    domain_t GetSupportDomain(const std::size_t& Level)
+    /// Enable/disable the coarsening. If it is disabled (the default), the bfs removed by the refinement are released,
+    /// hence the refinement done in the meantime cannot be reverted. Disabling it releases the refined bfs kept so far.
+    void SetCoarseningEnabled(const bool& IsCoarseningEnabled)
     {
-        domain_container_t::iterator it = mSupportDomains.find(Level);
-        if(it != mSupportDomains.end())
-            return it->second;
-        else
-        {
-            domain_t p_domain;
-            if(TDim == 2)
-                p_domain = domain_t(new DomainManager2D(Level));
-            else if(TDim == 3)
-                p_domain = domain_t(new DomainManager3D(Level));
-            mSupportDomains[Level] = p_domain;
-            return p_domain;
-        }
+        mIsCoarseningEnabled = IsCoarseningEnabled;
+        if (!mIsCoarseningEnabled)
+            this->ClearRefinedBfs();
+    }
+
+    /// Keep a bf removed by the refinement, together with its children and refined coefficients, so that it can be
+    /// restored by the coarsening. Its cells are released since they are rebuilt at the restoration. The bf is only
+    /// kept if the coarsening is enabled, otherwise the refined bfs would accumulate over the refinement steps.
+    void AddRefinedBf(bf_t p_bf)
+    {
+        std::vector<cell_t> p_cells(p_bf->cell_begin(), p_bf->cell_end());
+        for (std::size_t i = 0; i < p_cells.size(); ++i)
+            p_bf->RemoveCell(p_cells[i]);
+        if (mIsCoarseningEnabled)
+            mpRefinedBfs[p_bf->Id()] = p_bf;
     }
 
+    /// Put a refined bf back to the space and forget its children. The cells and the equation id of the bf must be set by the caller.
+    void RestoreBf(bf_t p_bf)
+    {
+        mpRefinedBfs.erase(p_bf->Id());
+        p_bf->ClearChildren();
+        BaseType::mpBasisFuncs.insert(p_bf);
+        BaseType::m_function_map_is_created = false;
+        BaseType::m_bf_index_is_created = false;
+    }
+
+    /// Check if a bf with the given Id was refined and can be restored
+    bool HasRefinedBf(const std::size_t& Id) const {return mpRefinedBfs.find(Id) != mpRefinedBfs.end();}
+
+    /// Get the refined bf with the given Id
+    bf_t pGetRefinedBf(const std::size_t& Id)
+    {
+        refined_bf_iterator it = mpRefinedBfs.find(Id);
+        if (it == mpRefinedBfs.end())
+            KRATOS_THROW_ERROR(std::runtime_error, "The refined bf is not found (is the coarsening enabled?):", Id)
+        return it->second;
+    }
+
+    /// Get the number of refined bfs
+    std::size_t NumberOfRefinedBfs() const {return mpRefinedBfs.size();}
+
+    /// Iterators to the refined bfs, in the order of their Id
+    refined_bf_iterator refined_bf_begin() {return mpRefinedBfs.begin();}
+    refined_bf_const_iterator refined_bf_begin() const {return mpRefinedBfs.begin();}
+    refined_bf_iterator refined_bf_end() {return mpRefinedBfs.end();}
+    refined_bf_const_iterator refined_bf_end() const {return mpRefinedBfs.end();}
+
+    /// Release the refined bfs. The refinement done so far cannot be reverted by the coarsening afterwards.
+    void ClearRefinedBfs() {mpRefinedBfs.clear();}
+
     /// Construct the boundary FESpace based on side
     virtual typename FESpace<TDim-1>::Pointer ConstructBoundaryFESpace(const BoundarySide& side) const
     {
@@ -402,6 +634,10 @@ public:
     {
         BaseType::PrintInfo(rOStream);
         rOStream << "Number of levels = " << mLastLevel << std::endl;
+        if (mIsTruncated)
+            rOStream << "The basis functions are truncated" << std::endl;
+        if (mpRefinedBfs.size() > 0)
+            rOStream << "Number of refined basis functions = " << mpRefinedBfs.size() << std::endl;
 
         rOStream << "###############Begin knot vectors################" << std::endl;
         for (int dim = 0; dim < TDim; ++dim)
@@ -432,16 +668,436 @@ public:
         }
     }
 
+protected:
+
+    /// Get the value of the bf with local index i at point xi. If the space is truncated, it is the truncated bf, which
+    /// is evaluated on the first of its cells containing xi.
+    virtual double GetBfValue(const std::size_t& i, const std::vector<double>& xi) const
+    {
+        if (!mIsTruncated)
+            return BaseType::GetBfValue(i, xi);
+
+        const double tol = BaseType::mpCellManager->GetTolerance();
+        const truncated_bf_t& rPieces = mTruncatedBfs[i];
+        for (std::size_t k = 0; k < rPieces.size(); ++k)
+        {
+            if (!IsInCell(*rPieces[k].first, xi, tol)) continue;
+
+            double v = 0.0;
+            for (std::size_t j = 0; j < rPieces[k].second.size(); ++j)
+            {
+                double b = rPieces[k].second[j].second;
+                for (int dim = 0; dim < TDim; ++dim)
+                    b *= BSplineUtils::CoxDeBoor3(xi[dim], 0, this->Order(dim), rPieces[k].second[j].first[dim]);
+                v += b;
+            }
+            return v;
+        }
+
+        return 0.0;
+    }
+
+    /// Get the derivatives of the bf with local index i at point xi. If the space is truncated, they are the derivatives
+    /// of the truncated bf on the first of its cells containing xi, as in GetBfValue.
+    virtual void GetBfDerivative(std::vector<double>& values, const std::size_t& i, const std::vector<double>& xi) const
+    {
+        if (!mIsTruncated)
+        {
+            BaseType::GetBfDerivative(values, i, xi);
+            return;
+        }
+
+        if (values.size() != TDim)
+            values.resize(TDim);
+        std::fill(values.begin(), values.end(), 0.0);
+
+        const double tol = BaseType::mpCellManager->GetTolerance();
+        const truncated_bf_t& rPieces = mTruncatedBfs[i];
+        std::vector<double> b(TDim), db(TDim);
+        for (std::size_t k = 0; k < rPieces.size(); ++k)
+        {
+            if (!IsInCell(*rPieces[k].first, xi, tol)) continue;
+
+            for (std::size_t j = 0; j < rPieces[k].second.size(); ++j)
+            {
+                for (int dim = 0; dim < TDim; ++dim)
+                    BSplineUtils::CoxDeBoor3Der(b[dim], db[dim], xi[dim], this->Order(dim), rPieces[k].second[j].first[dim]);
+
+                for (int dim = 0; dim < TDim; ++dim)
+                {
+                    double d = rPieces[k].second[j].second * db[dim];
+                    for (int dim2 = 0; dim2 < TDim; ++dim2)
+                        if (dim2 != dim)
+                            d *= b[dim2];
+                    values[dim] += d;
+                }
+            }
+            return;
+        }
+    }
+
+    /// Compute the truncated bfs in the order of local index, if the space is truncated
+    virtual void CreateBfIndexData() const
+    {
+        mTruncatedBfs.clear();
+        if (!mIsTruncated)
+            return;
+
+        TruncationData data(mLastLevel, BaseType::mpCellManager->GetTolerance());
+        this->InitializeTruncationData(data);
+        mTruncatedBfs.resize(BaseType::mBfArray.size());
+        std::vector<std::pair<bf_t, double> > absorbed_bfs;
+        for (std::size_t i = 0; i < BaseType::mBfArray.size(); ++i)
+        {
+            absorbed_bfs.clear();
+            this->ComputeTruncation(data, BaseType::mBfArray[i], NULL, &mTruncatedBfs[i], absorbed_bfs);
+        }
+    }
+
 private:
 
+    /// Check that the relative positions of the inserted knots are increasing and inside (0, 1)
+    static void CheckRefinementRatios(const std::vector<double>& ratios)
+    {
+        for (std::size_t i = 0; i < ratios.size(); ++i)
+        {
+            if (ratios[i] <= 0.0 || ratios[i] >= 1.0)
+                KRATOS_THROW_ERROR(std::invalid_argument, "The refinement ratio must be in (0, 1):", ratios[i])
+            if (i > 0 && ratios[i] <= ratios[i-1])
+                KRATOS_THROW_ERROR(std::invalid_argument, "The refinement ratios must be increasing:", ratios[i])
+        }
+    }
+
+    /// Check that at least one direction of a level is refined
+    static void CheckRefinementRatios(const boost::array<std::vector<double>, TDim>& ratios)
+    {
+        for (int dim = 0; dim < TDim; ++dim)
+            if (ratios[dim].size() > 0)
+                return;
+        KRATOS_THROW_ERROR(std::invalid_argument, "At least one direction must be refined", "")
+    }
+
+    /// Local knot vectors of a B-Splines of any level
+    typedef std::vector<std::vector<double> > local_knots_t;
+
+    /// Compare the local knot vectors lexicographically. The knots which are equal within the tolerance are the same.
+    struct local_knots_compare
+    {
+        local_knots_compare(const double& Tol) : mTol(Tol) {}
+        bool operator() (const local_knots_t& lhs, const local_knots_t& rhs) const
+        {
+            for (std::size_t dim = 0; dim < lhs.size(); ++dim)
+            {
+                for (std::size_t i = 0; i < lhs[dim].size(); ++i)
+                {
+                    if (lhs[dim][i] < rhs[dim][i] - mTol) return true;
+                    if (lhs[dim][i] > rhs[dim][i] + mTol) return false;
+                }
+            }
+            return false;
+        }
+        double mTol;
+    };
+
+    /// Linear combination of B-Splines of the same level
+    typedef std::map<local_knots_t, double, local_knots_compare> combination_t;
+    typedef std::vector<std::pair<local_knots_t, double> > children_t;
+
+    /// Data shared by the truncation of all the bfs
+    struct TruncationData
+    {
+        TruncationData(const std::size_t& LastLevel, const double& Tol)
+        : Tol(Tol), ActiveBfs(LastLevel + 1, std::map<local_knots_t, bf_t, local_knots_compare>(local_knots_compare(Tol))),
+          IsRepresented(LastLevel + 1, std::map<local_knots_t, bool, local_knots_compare>(local_knots_compare(Tol))),
+          Children(LastLevel + 1, std::map<local_knots_t, children_t, local_knots_compare>(local_knots_compare(Tol)))
+        {}
+
+        double Tol;
+        std::vector<std::map<local_knots_t, bf_t, local_knots_compare> > ActiveBfs; // the bfs of each level
+        std::vector<std::map<local_knots_t, bool, local_knots_compare> > IsRepresented; // see IsRepresented
+        std::vector<std::map<local_knots_t, children_t, local_knots_compare> > Children; // the two-scale relation of the B-Splines of each level
+    };
+
+    /// Index the bfs of each level by their local knot vectors
+    void InitializeTruncationData(TruncationData& rData) const
+    {
+        for(bf_const_iterator it_bf = BaseType::bf_begin(); it_bf != BaseType::bf_end(); ++it_bf)
+        {
+            if((*it_bf)->Level() > mLastLevel) continue;
+            local_knots_t local_knots(TDim);
+            for (int dim = 0; dim < TDim; ++dim)
+                (*it_bf)->LocalKnots(dim, local_knots[dim]);
+            rData.ActiveBfs[(*it_bf)->Level()][local_knots] = *it_bf;
+        }
+    }
+
+    /// Get the children of a B-Splines of a level and its refinement coefficients. The children are the B-Splines of
+    /// the next level obtained by inserting the knots of the level in each nonzero knot span (see SetRefinementRatios),
+    /// which is the same two-scale relation as in the refinement.
+    const children_t& GetChildren(TruncationData& rData, const local_knots_t& rLocalKnots, const std::size_t& Level) const
+    {
+        typename std::map<local_knots_t, children_t, local_knots_compare>::iterator it = rData.Children[Level].find(rLocalKnots);
+        if (it != rData.Children[Level].end())
+            return it->second;
+
+        children_t& rChildren = rData.Children[Level].insert(std::make_pair(rLocalKnots, children_t())).first->second;
+
+        std::vector<std::vector<double> > new_local_knots(TDim);
+        std::vector<const Vector*> coefficients(TDim);
+        for (int dim = 0; dim < TDim; ++dim)
+        {
+            const std::vector<double>& local_knots = rLocalKnots[dim];
+            std::vector<double> ins_knots;
+            for (std::size_t i = 0; i < local_knots.size(); ++i)
+            {
+                new_local_knots[dim].push_back(local_knots[i]);
+                if (i + 1 < local_knots.size() && fabs(local_knots[i+1] - local_knots[i]) > rData.Tol)
+                {
+                    std::size_t n = ins_knots.size();
+                    this->ComputeInsertedKnots(Level, dim, local_knots[i], local_knots[i+1], ins_knots);
+                    new_local_knots[dim].insert(new_local_knots[dim].end(), ins_knots.begin() + n, ins_knots.end());
+                }
+            }
+
+            coefficients[dim] = &(mTwoScaleRelations.Get(this->Order(dim), local_knots, ins_knots));
+        }
+
+        // the children are the tensor products of the children in each direction
+        std::vector<std::size_t> index(TDim, 0);
+        while (true)
+        {
+            local_knots_t child(TDim);
+            double coefficient = 1.0;
+            for (int dim = 0; dim < TDim; ++dim)
+            {
+                child[dim].assign(new_local_knots[dim].begin() + index[dim], new_local_knots[dim].begin() + index[dim] + this->Order(dim) + 2);
+                coefficient *= (*coefficients[dim])[index[dim]];
+            }
+            rChildren.push_back(std::make_pair(child, coefficient));
+
+            int dim = 0;
+            while (dim < TDim)
+            {
+                if (++index[dim] < coefficients[dim]->size())
+                    break;
+                index[dim] = 0;
+                ++dim;
+            }
+            if (dim == TDim)
+                break;
+        }
+
+        return rChildren;
+    }
+
+    /// Check if a B-Splines of a level is represented by the hierarchy, i.e. it is a bf of this level or all of its
+    /// children are represented in the next level, e.g. it was refined. These B-Splines are removed by the truncation.
+    bool IsRepresented(TruncationData& rData, const local_knots_t& rLocalKnots, const std::size_t& Level) const
+    {
+        if (rData.ActiveBfs[Level].find(rLocalKnots) != rData.ActiveBfs[Level].end())
+            return true;
+
+        if (Level >= mLastLevel)
+            return false;
+
+        typename std::map<local_knots_t, bool, local_knots_compare>::iterator it = rData.IsRepresented[Level].find(rLocalKnots);
+        if (it != rData.IsRepresented[Level].end())
+            return it->second;
+
+        bool is_represented = true;
+        const children_t& rChildren = this->GetChildren(rData, rLocalKnots, Level);
+        for (std::size_t i = 0; i < rChildren.size(); ++i)
+        {
+            if (!this->IsRepresented(rData, rChildren[i].first, Level + 1))
+            {
+                is_represented = false;
+                break;
+            }
+        }
+
+        rData.IsRepresented[Level][rLocalKnots] = is_represented;
+        return is_represented;
+    }
+
+    /// Check if the support of a B-Splines overlaps with the interior of a cell
+    static bool IsOverlapping(const local_knots_t& rLocalKnots, const CellType& r_cell, const double& Tol)
+    {
+        if (rLocalKnots[0].front() > r_cell.XiMaxValue() - Tol || rLocalKnots[0].back() < r_cell.XiMinValue() + Tol)
+            return false;
+        if (TDim > 1)
+            if (rLocalKnots[1].front() > r_cell.EtaMaxValue() - Tol || rLocalKnots[1].back() < r_cell.EtaMinValue() + Tol)
+                return false;
+        if (TDim > 2)
+            if (rLocalKnots[2].front() > r_cell.ZetaMaxValue() - Tol || rLocalKnots[2].back() < r_cell.ZetaMinValue() + Tol)
+                return false;
+        return true;
+    }
+
+    /// Check if the point xi lies in the cell, within the tolerance
+    static bool IsInCell(const CellType& r_cell, const std::vector<double>& xi, const double& Tol)
+    {
+        if (xi[0] < r_cell.XiMinValue() - Tol || xi[0] > r_cell.XiMaxValue() + Tol)
+            return false;
+        if (TDim > 1)
+            if (xi[1] < r_cell.EtaMinValue() - Tol || xi[1] > r_cell.EtaMaxValue() + Tol)
+                return false;
+        if (TDim > 2)
+            if (xi[2] < r_cell.ZetaMinValue() - Tol || xi[2] > r_cell.ZetaMaxValue() + Tol)
+                return false;
+        return true;
+    }
+
+    /// Compute the truncation of a bf level by level. The bf is expressed in the B-Splines of the next level by the
+    /// two-scale relation, and the represented ones are removed; they are distributed to the bfs of the finer levels
+    /// in rAbsorbedBfs. Only the B-Splines overlapping with the cells of the bf of the finer levels are kept. If pRows
+    /// is given, it contains the extraction operator of the truncated bf on each cell of the bf where it does not vanish.
+    /// If pPieces is given, it contains the truncated bf on the same cells as a linear combination of the B-Splines of
+    /// the level of the cell.
+    void ComputeTruncation(TruncationData& rData, const bf_t& p_bf, std::vector<std::pair<cell_t, Vector> >* pRows,
+            std::vector<std::pair<cell_t, children_t> >* pPieces, std::vector<std::pair<bf_t, double> >& rAbsorbedBfs) const
+    {
+        std::vector<std::size_t> orders(TDim);
+        local_knots_t local_knots(TDim);
+        for (int dim = 0; dim < TDim; ++dim)
+        {
+            orders[dim] = this->Order(dim);
+            p_bf->LocalKnots(dim, local_knots[dim]);
+        }
+
+        std::vector<cell_t> cells(p_bf->cell_begin(), p_bf->cell_end());
+        std::size_t max_level = p_bf->Level();
+        for (std::size_t i = 0; i < cells.size(); ++i)
+            if (cells[i]->Level() > max_level)
+                max_level = cells[i]->Level();
+
+        combination_t current(local_knots_compare(rData.Tol)), removed(local_knots_compare(rData.Tol));
+        current[local_knots] = 1.0;
+
+        Vector Crow, row;
+        children_t piece;
+        std::vector<cell_t> finer_cells;
+        for (std::size_t level = p_bf->Level(); ; ++level)
+        {
+            // extraction operator and B-Splines on the cells of this level
+            if (pRows != NULL || pPieces != NULL)
+            {
+                for (std::size_t i = 0; i < cells.size(); ++i)
+                {
+                    if (cells[i]->Level() != level) continue;
+
+                    bool is_nonzero = false;
+                    piece.clear();
+                    for (typename combination_t::iterator it = current.begin(); it != current.end(); ++it)
+                    {
+                        if (!IsOverlapping(it->first, *cells[i], rData.Tol)) continue;
+
+                        if (pRows != NULL)
+                        {
+                            PBBSplinesBasisFunction_Helper<TDim>::ComputeExtractionOperator(Crow, orders, it->first, *cells[i]);
+                            if (!is_nonzero)
+                                row = it->second * Crow;
+                            else
+                                noalias(row) += it->second * Crow;
+                        }
+
+                        if (pPieces != NULL)
+                            piece.push_back(*it);
+
+                        is_nonzero = true;
+                    }
+
+                    if (is_nonzero)
+                    {
+                        if (pRows != NULL)
+                            pRows->push_back(std::make_pair(cells[i], row));
+                        if (pPieces != NULL)
+                            pPieces->push_back(std::make_pair(cells[i], piece));
+                    }
+                }
+            }
+
+            if ((level >= max_level && removed.empty()) || level >= mLastLevel)
+                break;
+
+            finer_cells.clear();
+            for (std::size_t i = 0; i < cells.size(); ++i)
+                if (cells[i]->Level() > level)
+                    finer_cells.push_back(cells[i]);
+
+            // express in the B-Splines of the next level
+            combination_t next(local_knots_compare(rData.Tol)), next_removed(local_knots_compare(rData.Tol));
+            for (typename combination_t::iterator it = current.begin(); it != current.end(); ++it)
+            {
+                const children_t& rChildren = this->GetChildren(rData, it->first, level);
+                for (std::size_t i = 0; i < rChildren.size(); ++i)
+                {
+                    for (std::size_t j = 0; j < finer_cells.size(); ++j)
+                    {
+                        if (IsOverlapping(rChildren[i].first, *finer_cells[j], rData.Tol))
+                        {
+                            next[rChildren[i].first] += it->second * rChildren[i].second;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            for (typename combination_t::iterator it = removed.begin(); it != removed.end(); ++it)
+            {
+                const children_t& rChildren = this->GetChildren(rData, it->first, level);
+                for (std::size_t i = 0; i < rChildren.size(); ++i)
+                    next_removed[rChildren[i].first] += it->second * rChildren[i].second;
+            }
+
+            // truncate
+            for (typename combination_t::iterator it = next.begin(); it != next.end();)
+            {
+                if (this->IsRepresented(rData, it->first, level + 1))
+                {
+                    next_removed[it->first] += it->second;
+                    next.erase(it++);
+                }
+                else
+                    ++it;
+            }
+
+            // the removed part is absorbed by the bfs of the next level, or expressed in the following levels
+            for (typename combination_t::iterator it = next_removed.begin(); it != next_removed.end();)
+            {
+                typename std::map<local_knots_t, bf_t, local_knots_compare>::iterator it_bf = rData.ActiveBfs[level + 1].find(it->first);
+                if (it_bf != rData.ActiveBfs[level + 1].end())
+                {
+                    rAbsorbedBfs.push_back(std::make_pair(it_bf->second, it->second));
+                    next_removed.erase(it++);
+                }
+                else
+                    ++it;
+            }
+
+            current.swap(next);
+            removed.swap(next_removed);
+        }
+    }
+
     std::size_t mLastLevel;
     std::size_t mMaxLevel;
+    bool mIsTruncated;
+    bool mIsCoarseningEnabled;
+
+    boost::array<std::vector<double>, TDim> mDefaultRefinementRatios; // see SetRefinementRatios
+    std::map<std::size_t, boost::array<std::vector<double>, TDim> > mRefinementRatios; // the positions of the levels which differ from the default
+    mutable TwoScaleRelationCache mTwoScaleRelations; // see TwoScaleRelations. It is filled by the const truncation, which is safe since its lookups are thread-safe
+
+    /// The truncated bf on each cell where it does not vanish, as a linear combination of the B-Splines of the level of the cell
+    typedef std::vector<std::pair<cell_t, children_t> > truncated_bf_t;
+    mutable std::vector<truncated_bf_t> mTruncatedBfs; // in the order of local index; it is built with the support index of the bfs
 
     boost::array<knot_container_t, TDim> mKnotVectors;
 
-    domain_container_t mSupportDomains; // this domain manager manages the support of all bfs in each level
 
     std::vector<std::size_t> mRefinementHistory;
+
+    refined_bf_container_t mpRefinedBfs; // the bfs removed by the refinement, which can be restored by the coarsening
 };
 
 /**
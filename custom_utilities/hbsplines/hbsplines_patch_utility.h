@@ -386,21 +386,21 @@ Patch<3>::Pointer HBSplinesPatchUtility_Helper<3>::CreatePatchFromBSplines(typen
     {
         // create and fill the local knot vector
         std::vector<knot_t> pLocalKnots3;
-        for(std::size_t k = 0; k < pFESpace->KnotVector(2).size() + 2; ++k)
+        for(std::size_t k = 0; k < pFESpace->Order(2) + 2; ++k)
             pLocalKnots3.push_back(pFESpace->KnotVector(2).pKnotAt(l + k));
 
         for(std::size_t j = 0; j < number_2; ++j)
         {
             // create and fill the local knot vector
             std::vector<knot_t> pLocalKnots2;
-            for(std::size_t k = 0; k < pFESpace->KnotVector(1).size() + 2; ++k)
+            for(std::size_t k = 0; k < pFESpace->Order(1) + 2; ++k)
                 pLocalKnots2.push_back(pFESpace->KnotVector(1).pKnotAt(j + k));
 
             for(std::size_t i = 0; i < number_1; ++i)
             {
                 // create and fill the local knot vector
                 std::vector<knot_t> pLocalKnots1;
-                for(std::size_t k = 0; k < pFESpace->KnotVector(0).size() + 2; ++k)
+                for(std::size_t k = 0; k < pFESpace->Order(0) + 2; ++k)
                     pLocalKnots1.push_back(pFESpace->KnotVector(0).pKnotAt(i + k));
 
                 // create the basis function object
@@ -450,6 +450,32 @@ Patch<3>::Pointer HBSplinesPatchUtility_Helper<3>::CreatePatchFromBSplines(typen
                         }
                     }
                 }
+
+                // transfer the control point
+                ControlPointType c = pPatch->pControlPointGridFunction()->pControlGrid()->GetData(i_func);
+                p_bf->SetValue(CONTROL_POINT, c);
+
+                // transfer other data
+                for (std::size_t i = 0; i < double_var_list.size(); ++i)
+                {
+                    GridFunction<3, double>::Pointer pGridFunction = pPatch->pGetGridFunction<Variable<double> >(*double_var_list[i]);
+                    const double& v = pGridFunction->pControlGrid()->GetData(i_func);
+                    p_bf->SetValue(*double_var_list[i], v);
+                }
+
+                for (std::size_t i = 0; i < array1d_var_list.size(); ++i)
+                {
+                    GridFunction<3, array_1d<double, 3> >::Pointer pGridFunction = pPatch->pGetGridFunction<Variable<array_1d<double, 3> > >(*array1d_var_list[i]);
+                    const array_1d<double, 3>& v = pGridFunction->pControlGrid()->GetData(i_func);
+                    p_bf->SetValue(*array1d_var_list[i], v);
+                }
+
+                for (std::size_t i = 0; i < vector_var_list.size(); ++i)
+                {
+                    GridFunction<3, Vector>::Pointer pGridFunction = pPatch->pGetGridFunction<Variable<Vector> >(*vector_var_list[i]);
+                    const Vector& v = pGridFunction->pControlGrid()->GetData(i_func);
+                    p_bf->SetValue(*vector_var_list[i], v);
+                }
             }
         }
     }
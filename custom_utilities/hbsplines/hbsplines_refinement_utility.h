@@ -12,6 +12,9 @@
 // System includes
 #include <vector>
 #include <iomanip>
+#include <map>
+#include <set>
+#include <algorithm>
 
 // External includes
 #include <boost/array.hpp>
@@ -28,12 +31,47 @@
 #include "custom_utilities/hbsplines/hbsplines_fespace.h"
 
 #define ENABLE_PROFILING
-#define CHECK_REFINEMENT_COEFFICIENTS
+// #define CHECK_REFINEMENT_COEFFICIENTS
 
 namespace Kratos
 {
 
 
+/// Access the components of a control value, which are projected separately by the coarsening
+template<typename TDataType>
+struct HBSplinesRefinementUtility_Value_Helper
+{
+    static std::size_t Size(const TDataType& rValue) {return rValue.size();}
+    static void Resize(TDataType& rValue, const std::size_t& n) {}
+    static double& Component(TDataType& rValue, const std::size_t& i) {return rValue[i];}
+};
+
+template<>
+struct HBSplinesRefinementUtility_Value_Helper<double>
+{
+    static std::size_t Size(const double& rValue) {return 1;}
+    static void Resize(double& rValue, const std::size_t& n) {}
+    static double& Component(double& rValue, const std::size_t& i) {return rValue;}
+};
+
+template<>
+struct HBSplinesRefinementUtility_Value_Helper<Vector>
+{
+    static std::size_t Size(const Vector& rValue) {return rValue.size();}
+    static void Resize(Vector& rValue, const std::size_t& n) {if (rValue.size() != n) rValue.resize(n, false);}
+    static double& Component(Vector& rValue, const std::size_t& i) {return rValue[i];}
+};
+
+/// The homogeneous components WX, WY, WZ, W of the control point
+template<>
+struct HBSplinesRefinementUtility_Value_Helper<ControlPoint<double> >
+{
+    static std::size_t Size(const ControlPoint<double>& rValue) {return 4;}
+    static void Resize(ControlPoint<double>& rValue, const std::size_t& n) {}
+    static double& Component(ControlPoint<double>& rValue, const std::size_t& i) {return rValue[static_cast<int>(i)];}
+};
+
+
 template<int TDim>
 struct HBSplinesRefinementUtility_Helper
 {
@@ -49,9 +87,121 @@ struct HBSplinesRefinementUtility_Helper
     static std::pair<std::vector<std::size_t>, std::vector<bf_t> > Refine(typename Patch<TDim>::Pointer pPatch,
             typename HBSplinesFESpace<TDim>::bf_t p_bf, std::set<std::size_t>& refined_patches, const int& echo_level);
 
+    static void Refine(typename Patch<TDim>::Pointer pPatch, const std::vector<bf_t>& bfs, const int& echo_level);
+
+    static void Refine(typename Patch<TDim>::Pointer pPatch, const std::vector<bf_t>& bfs,
+            std::set<std::size_t>& refined_patches, const int& echo_level);
+
     static void RefineWindow(typename Patch<TDim>::Pointer pPatch, const std::vector<std::vector<double> >& window, const int& echo_level);
 
+    static double RefinedCoefficient(const boost::array<const Vector*, TDim>& rFactors, std::size_t i_func);
+
+    /// The layout of the control values transferred by the refinement. The homogeneous control point and the
+    /// components of the double, array_1d and Vector variables of a bf are packed contiguously in this order.
+    struct ValueLayout
+    {
+        std::vector<Variable<double>*> DoubleVariables;
+        std::vector<Variable<array_1d<double, 3> >*> Array1DVariables;
+        std::vector<Variable<Vector>*> VectorVariables;
+        std::vector<std::size_t> VectorSizes;
+        std::size_t Size;
+    };
+
+    static void CreateValueLayout(ValueLayout& rLayout, const BasisFunctionType& r_bf,
+            const std::vector<Variable<double>*>& double_variables,
+            const std::vector<Variable<array_1d<double, 3> >*>& array_1d_variables,
+            const std::vector<Variable<Vector>*>& vector_variables);
+
+    static void CheckValueLayout(const ValueLayout& rLayout, const BasisFunctionType& r_bf);
+
+    static void PackValues(const ValueLayout& rLayout, const BasisFunctionType& r_bf, double* pValues);
+
+    static void AddValues(const ValueLayout& rLayout, BasisFunctionType& r_bf, const double* pValues);
+
+    /// The two-scale relation between the coarsened bfs and their children. Each row lists the (index of the parent,
+    /// refined coefficient) of a child.
+    struct TwoScaleRelation
+    {
+        typedef std::vector<std::vector<std::pair<std::size_t, double> > > matrix_t;
+
+        std::vector<bf_t> Parents;
+        std::vector<bf_t> RemovedChildren;
+        std::vector<bf_t> KeptChildren;
+        matrix_t RemovedRows;
+        matrix_t KeptRows;
+        matrix_t Normal; // the normal matrix of the least-squares projection to the parents, in rows
+    };
+
+    static void Coarsen(typename Patch<TDim>::Pointer pPatch, const std::vector<std::size_t>& Ids, const int& echo_level);
+
+    static void Coarsen(typename Patch<TDim>::Pointer pPatch, const std::vector<bf_t>& bfs, const int& echo_level);
+
+    static void Coarsen(typename Patch<TDim>::Pointer pPatch, const std::vector<bf_t>& bfs,
+            std::set<std::size_t>& coarsened_patches, const int& echo_level);
+
+    static void CoarsenWindow(typename Patch<TDim>::Pointer pPatch, const std::vector<std::vector<double> >& window, const int& echo_level);
+
+    template<class TVariableType>
+    static void CoarsenValues(const TwoScaleRelation& rRelation, const TVariableType& rVariable);
+
+    static void SolveNormalEquations(const typename TwoScaleRelation::matrix_t& rNormal, const std::vector<double>& rRhs, std::vector<double>& rX);
+
     static void LinearDependencyRefine(typename Patch<TDim>::Pointer pPatch, const std::size_t& refine_cycle, const int& echo_level);
+
+    static void SetTruncation(typename Patch<TDim>::Pointer pPatch, const bool& IsTruncated);
+
+    static void SuspendTruncation(typename Patch<TDim>::Pointer pPatch, std::vector<typename Patch<TDim>::Pointer>& pTruncatedPatches);
+
+    static void ResumeTruncation(const std::vector<typename Patch<TDim>::Pointer>& pPatches);
+};
+
+/**
+Transform the truncated patches of the multipatch of a patch to the HB representation for the lifetime of the object and
+back to the THB representation on destruction, also when the refinement throws. Holding one object over a batch of
+refinements transforms the patches only once, which also limits the round-off of the transformation. The objects can be
+nested, since the inner one finds no truncated patch.
+ */
+template<int TDim>
+class HBSplinesTruncationGuard
+{
+public:
+    /// Pointer definition
+    KRATOS_CLASS_POINTER_DEFINITION(HBSplinesTruncationGuard);
+
+    /// Constructor
+    HBSplinesTruncationGuard(typename Patch<TDim>::Pointer pPatch)
+    {
+        try
+        {
+            HBSplinesRefinementUtility_Helper<TDim>::SuspendTruncation(pPatch, mpTruncatedPatches);
+        }
+        catch (...)
+        {
+            HBSplinesRefinementUtility_Helper<TDim>::ResumeTruncation(mpTruncatedPatches);
+            throw;
+        }
+    }
+
+    /// Destructor
+    ~HBSplinesTruncationGuard()
+    {
+        try
+        {
+            HBSplinesRefinementUtility_Helper<TDim>::ResumeTruncation(mpTruncatedPatches);
+        }
+        catch (std::exception& e)
+        {
+            std::cout << "WARNING!!! The truncation of the patches can't be resumed: " << e.what() << std::endl;
+        }
+    }
+
+private:
+
+    std::vector<typename Patch<TDim>::Pointer> mpTruncatedPatches;
+
+    /// Copy is not allowed, since the patches would be resumed twice
+    HBSplinesTruncationGuard(const HBSplinesTruncationGuard& rOther);
+    HBSplinesTruncationGuard& operator=(const HBSplinesTruncationGuard& rOther);
 };
 
 
@@ -74,6 +224,7 @@ public:
     template<int TDim>
     static void Refine(typename Patch<TDim>::Pointer pPatch, const std::size_t& Id, const int& echo_level)
     {
+        HBSplinesTruncationGuard<TDim> guard(pPatch);
         HBSplinesRefinementUtility_Helper<TDim>::Refine(pPatch, Id, echo_level);
     }
 
@@ -81,24 +232,73 @@ public:
     template<int TDim>
     static void Refine(typename Patch<TDim>::Pointer pPatch, typename HBSplinesFESpace<TDim>::bf_t p_bf, const int& echo_level)
     {
+        HBSplinesTruncationGuard<TDim> guard(pPatch);
         HBSplinesRefinementUtility_Helper<TDim>::Refine(pPatch, p_bf, echo_level);
     }
 
+    /// Refine a set of B-Splines basis functions together. The children and the cells shared by the basis functions are
+    /// created only once and the refinement coefficients are computed once for each local knot configuration.
+    template<int TDim>
+    static void Refine(typename Patch<TDim>::Pointer pPatch, const std::vector<typename HBSplinesFESpace<TDim>::bf_t>& bfs, const int& echo_level)
+    {
+        HBSplinesTruncationGuard<TDim> guard(pPatch);
+        HBSplinesRefinementUtility_Helper<TDim>::Refine(pPatch, bfs, echo_level);
+    }
+
     /// Refine all basis functions in a region
     template<int TDim>
     static void RefineWindow(typename Patch<TDim>::Pointer pPatch, const std::vector<std::vector<double> >& window, const int& echo_level)
     {
+        HBSplinesTruncationGuard<TDim> guard(pPatch);
         HBSplinesRefinementUtility_Helper<TDim>::RefineWindow(pPatch, window, echo_level);
     }
 
+    /// Coarsen a set of refined B-Splines basis functions, i.e. restore them and remove their children which are not
+    /// needed by the other refined basis functions. The basis functions are given by their Id, see HBSplinesFESpace::HasRefinedBf.
+    /// The equation ids of the restored basis functions are new, hence the multipatch must be enumerated afterwards.
+    /// The refined basis functions are only kept if the coarsening was enabled before the refinement, see
+    /// HBSplinesFESpace::SetCoarseningEnabled.
+    template<int TDim>
+    static void Coarsen(typename Patch<TDim>::Pointer pPatch, const std::vector<std::size_t>& Ids, const int& echo_level)
+    {
+        HBSplinesTruncationGuard<TDim> guard(pPatch);
+        HBSplinesRefinementUtility_Helper<TDim>::Coarsen(pPatch, Ids, echo_level);
+    }
+
+    /// Coarsen a set of refined B-Splines basis functions
+    template<int TDim>
+    static void Coarsen(typename Patch<TDim>::Pointer pPatch, const std::vector<typename HBSplinesFESpace<TDim>::bf_t>& bfs, const int& echo_level)
+    {
+        HBSplinesTruncationGuard<TDim> guard(pPatch);
+        HBSplinesRefinementUtility_Helper<TDim>::Coarsen(pPatch, bfs, echo_level);
+    }
+
+    /// Coarsen all refined basis functions in a region
+    template<int TDim>
+    static void CoarsenWindow(typename Patch<TDim>::Pointer pPatch, const std::vector<std::vector<double> >& window, const int& echo_level)
+    {
+        HBSplinesTruncationGuard<TDim> guard(pPatch);
+        HBSplinesRefinementUtility_Helper<TDim>::CoarsenWindow(pPatch, window, echo_level);
+    }
+
     /// Perform additional refinement to ensure linear independence
-    /// In this algorithm, every bf in each level will be checked. If the support domain of a bf contained in the domain_manager of that level, this bf will be refined. According to the paper of Vuong et al, this will produce a linear independent bases.
+    /// In this algorithm, every bf in each level will be checked. If the support domain of a bf is contained in the union of the supports of the bfs of the finer levels, this bf will be refined. According to the paper of Vuong et al, this will produce a linear independent bases.
     template<int TDim>
     static void LinearDependencyRefine(typename Patch<TDim>::Pointer pPatch, const std::size_t& refine_cycle, const int& echo_level)
     {
+        HBSplinesTruncationGuard<TDim> guard(pPatch);
         HBSplinesRefinementUtility_Helper<TDim>::LinearDependencyRefine(pPatch, refine_cycle, echo_level);
     }
 
+    /// Switch the patch between the hierarchical (HB) and the truncated hierarchical (THB) B-Splines basis. The control
+    /// values of the basis functions are transformed, hence the patch and its grid functions remain the same functions.
+    /// The refinement of a truncated patch is performed in the HB representation, see HBSplinesTruncationGuard.
+    template<int TDim>
+    static void SetTruncation(typename Patch<TDim>::Pointer pPatch, const bool& IsTruncated)
+    {
+        HBSplinesRefinementUtility_Helper<TDim>::SetTruncation(pPatch, IsTruncated);
+    }
+
     /// Information
     virtual void PrintInfo(std::ostream& rOStream) const
     {
@@ -258,48 +458,49 @@ std::pair<std::vector<std::size_t>, std::vector<typename HBSplinesFESpace<TDim>:
             {
                 if(fabs((*it2)->Value() - (*it)->Value()) > cell_tol)
                 {
-                    // now we just add the middle one, but in general we can add arbitrary values
-                    // TODO find the way to generalize this or parameterize this
-                    double ins_knot = 0.5 * ((*it)->Value() + (*it2)->Value());
-                    knot_t pnew_knot;
-                    pnew_knot = pFESpace->KnotVector(dim).pCreateUniqueKnot(ins_knot, cell_tol);
-                    pnew_local_knots[dim].push_back(pnew_knot);
-                    ins_knots[dim].push_back(pnew_knot->Value());
+                    // insert the knots of this level, see HBSplinesFESpace::SetRefinementRatios
+                    std::vector<double> span_knots;
+                    pFESpace->ComputeInsertedKnots(p_bf->Level(), dim, (*it)->Value(), (*it2)->Value(), span_knots);
+                    for (std::size_t i = 0; i < span_knots.size(); ++i)
+                    {
+                        knot_t pnew_knot = pFESpace->KnotVector(dim).pCreateUniqueKnot(span_knots[i], cell_tol);
+                        pnew_local_knots[dim].push_back(pnew_knot);
+                        ins_knots[dim].push_back(pnew_knot->Value());
+                    }
                 }
             }
         }
     }
 
-    /* compute the refinement coefficients */
-    Vector RefinedCoeffs;
+    /* compute the refinement coefficients from the univariate two-scale relations, which are cached in the space */
     std::vector<std::vector<double> > local_knots(TDim);
     for(std::size_t dim = 0; dim < TDim; ++dim)
         p_bf->LocalKnots(dim, local_knots[dim]);
 
-    std::vector<std::vector<double> > new_knots(TDim);
-    if (TDim == 2)
-    {
-        BSplineUtils::ComputeBsplinesKnotInsertionCoefficients2DLocal(RefinedCoeffs,
-            new_knots[0], new_knots[1],
-            pFESpace->Order(0), pFESpace->Order(1),
-            local_knots[0], local_knots[1],
-            ins_knots[0], ins_knots[1]);
-    }
-    else if (TDim == 3)
+    boost::array<const Vector*, TDim> factors;
+    std::size_t nchildren = 1;
+    for(std::size_t dim = 0; dim < TDim; ++dim)
     {
-        BSplineUtils::ComputeBsplinesKnotInsertionCoefficients3DLocal(RefinedCoeffs,
-            new_knots[0], new_knots[1], new_knots[2],
-            pFESpace->Order(0), pFESpace->Order(1), pFESpace->Order(2),
-            local_knots[0], local_knots[1], local_knots[2],
-            ins_knots[0], ins_knots[1], ins_knots[2]);
+        factors[dim] = &(pFESpace->TwoScaleRelations().Get(pFESpace->Order(dim), local_knots[dim], ins_knots[dim]));
+        nchildren *= factors[dim]->size();
     }
 
+    Vector RefinedCoeffs(nchildren);
+    for(std::size_t i_func = 0; i_func < nchildren; ++i_func)
+        RefinedCoeffs[i_func] = RefinedCoefficient(factors, i_func);
+
     if (echo_refinement)
     {
 //        std::cout << std::fixed << std::setprecision(15);
         KRATOS_WATCH(RefinedCoeffs)
     }
 
+    // pack the control values of p_bf contiguously, so that all the grid functions are transferred in one pass
+    ValueLayout layout;
+    CreateValueLayout(layout, *p_bf, double_variables, array_1d_variables, vector_variables);
+    std::vector<double> parent_values(layout.Size), child_values(layout.Size);
+    PackValues(layout, *p_bf, &parent_values[0]);
+
     #ifdef ENABLE_PROFILING
     double time_1 = OpenMPUtils::GetCurrentTime() - start;
     start = OpenMPUtils::GetCurrentTime();
@@ -409,49 +610,10 @@ std::pair<std::vector<std::size_t>, std::vector<typename HBSplinesFESpace<TDim>:
                 if (echo_refinement)
                     std::cout << "new bf " << pnew_bf->Id() << " is assigned eq_id = " << pnew_bf->EquationId() << std::endl;
 
-                // transfer the control point information
-                const ControlPointType& oldC = p_bf->GetValue(CONTROL_POINT);
-                ControlPointType& newC = pnew_bf->GetValue(CONTROL_POINT);
-                newC += RefinedCoeffs[i_func] * oldC;
-                // pnew_bf->SetValue(CONTROL_POINT, newC);
-
-                // transfer other control values from p_bf to pnew_bf
-                for (std::size_t i = 0; i < double_variables.size(); ++i)
-                {
-                    if (echo_refinement_detail)
-                        std::cout << "Transfer double variable " << double_variables[i]->Name();
-                    const double& old_value = p_bf->GetValue(*double_variables[i]);
-                    double& new_value = pnew_bf->GetValue(*double_variables[i]);
-                    new_value += RefinedCoeffs[i_func] * old_value;
-                    // pnew_bf->SetValue(*double_variables[i], new_value);
-                    if (echo_refinement_detail)
-                        std::cout << " completed" << std::endl;
-                }
-
-                for (std::size_t i = 0; i < array_1d_variables.size(); ++i)
-                {
-                    if (*(array_1d_variables[i]) == CONTROL_POINT_COORDINATES) continue;
-                    if (echo_refinement_detail)
-                        std::cout << "Transfer array_1d variable " << array_1d_variables[i]->Name();
-                    const array_1d<double, 3>& old_value = p_bf->GetValue(*array_1d_variables[i]);
-                    array_1d<double, 3>& new_value = pnew_bf->GetValue(*array_1d_variables[i]);
-                    noalias(new_value) += RefinedCoeffs[i_func] * old_value;
-                    // pnew_bf->SetValue(*array_1d_variables[i], new_value);
-                    if (echo_refinement_detail)
-                        std::cout << " completed" << std::endl;
-                }
-
-                for (std::size_t i = 0; i < vector_variables.size(); ++i)
-                {
-                    if (echo_refinement_detail)
-                        std::cout << "Transfer vector variable " << vector_variables[i]->Name();
-                    const Vector& old_value = p_bf->GetValue(*vector_variables[i]);
-                    Vector& new_value = pnew_bf->GetValue(*vector_variables[i]);
-                    noalias(new_value) += RefinedCoeffs[i_func] * old_value;
-                    // pnew_bf->SetValue(*vector_variables[i], new_value);
-                    if (echo_refinement_detail)
-                        std::cout << " completed" << std::endl;
-                }
+                // transfer the control point information and other control values from p_bf to pnew_bf
+                for (std::size_t k = 0; k < layout.Size; ++k)
+                    child_values[k] = RefinedCoeffs[i_func] * parent_values[k];
+                AddValues(layout, *pnew_bf, &child_values[0]);
 
                 // create the cells for the basis function
                 for(std::size_t i1 = 0; i1 < pFESpace->Order(0) + 1; ++i1)
@@ -561,37 +723,10 @@ std::pair<std::vector<std::size_t>, std::vector<typename HBSplinesFESpace<TDim>:
                     if (echo_refinement)
                         std::cout << "new bf " << pnew_bf->Id() << " is assigned eq_id = " << pnew_bf->EquationId() << std::endl;
 
-                    // transfer the control point information
-                    const ControlPointType& oldC = p_bf->GetValue(CONTROL_POINT);
-                    const double& weight = oldC.W();
-                    ControlPointType& newC = pnew_bf->GetValue(CONTROL_POINT);
-                    newC += RefinedCoeffs[i_func] * oldC;
-                    // pnew_bf->SetValue(CONTROL_POINT, newC);
-
-                    // transfer other control values from p_bf to pnew_bf
-                    for (std::size_t i = 0; i < double_variables.size(); ++i)
-                    {
-                        const double& old_value = p_bf->GetValue(*double_variables[i]);
-                        double& new_value = pnew_bf->GetValue(*double_variables[i]);
-                        new_value += RefinedCoeffs[i_func] * old_value;
-                        // pnew_bf->SetValue(*double_variables[i], new_value);
-                    }
-
-                    for (std::size_t i = 0; i < array_1d_variables.size(); ++i)
-                    {
-                        const array_1d<double, 3>& old_value = p_bf->GetValue(*array_1d_variables[i]);
-                        array_1d<double, 3>& new_value = pnew_bf->GetValue(*array_1d_variables[i]);
-                        noalias(new_value) += RefinedCoeffs[i_func] * old_value;
-                        // pnew_bf->SetValue(*array_1d_variables[i], new_value);
-                    }
-
-                    for (std::size_t i = 0; i < vector_variables.size(); ++i)
-                    {
-                        const Vector& old_value = p_bf->GetValue(*vector_variables[i]);
-                        Vector& new_value = pnew_bf->GetValue(*vector_variables[i]);
-                        noalias(new_value) += RefinedCoeffs[i_func] * old_value;
-                        // pnew_bf->SetValue(*vector_variables[i], new_value);
-                    }
+                    // transfer the control point information and other control values from p_bf to pnew_bf
+                    for (std::size_t k = 0; k < layout.Size; ++k)
+                        child_values[k] = RefinedCoeffs[i_func] * parent_values[k];
+                    AddValues(layout, *pnew_bf, &child_values[0]);
 
                     // create the cells for the basis function
                     for(std::size_t i1 = 0; i1 < pFESpace->Order(0) + 1; ++i1)
@@ -723,8 +858,11 @@ std::pair<std::vector<std::size_t>, std::vector<typename HBSplinesFESpace<TDim>:
     for(typename cell_container_t::iterator it_cell = pFESpace->pCellManager()->begin(); it_cell != pFESpace->pCellManager()->end(); ++it_cell)
         (*it_cell)->RemoveBf(p_bf);
 
-    /* remove the old basis function */
+    /* remove the old basis function, and keep it with its two-scale relation for the coarsening */
+    for(std::size_t i = 0; i < pnew_bfs.size(); ++i)
+        p_bf->AddChild(pnew_bfs[i], RefinedCoeffs[i]);
     pFESpace->RemoveBf(p_bf);
+    pFESpace->AddRefinedBf(p_bf);
 
     // TODO check if pFESpace->pCellManager()->CollapseCells() can help to further remove the overlapping cells
 
@@ -846,208 +984,1698 @@ std::pair<std::vector<std::size_t>, std::vector<typename HBSplinesFESpace<TDim>:
 }
 
 template<int TDim>
-inline void HBSplinesRefinementUtility_Helper<TDim>::RefineWindow(typename Patch<TDim>::Pointer pPatch,
-        const std::vector<std::vector<double> >& window, const int& echo_level)
+inline void HBSplinesRefinementUtility_Helper<TDim>::Refine(typename Patch<TDim>::Pointer pPatch,
+        const std::vector<bf_t>& bfs, const int& echo_level)
 {
     if (pPatch->pFESpace()->Type() != HBSplinesFESpace<TDim>::StaticType())
         KRATOS_THROW_ERROR(std::logic_error, __FUNCTION__, "only support the hierarchical B-Splines patch")
 
-    // Type definitions
-    typedef typename HBSplinesFESpace<TDim>::bf_t bf_t;
-    typedef typename HBSplinesFESpace<TDim>::bf_container_t bf_container_t;
-    typedef typename HBSplinesFESpace<TDim>::CellType CellType;
-    typedef typename HBSplinesFESpace<TDim>::cell_t cell_t;
-    typedef typename HBSplinesFESpace<TDim>::cell_container_t cell_container_t;
-    typedef typename Patch<TDim>::ControlPointType ControlPointType;
-
-    // extract the hierarchical B-Splines space
-    typename HBSplinesFESpace<TDim>::Pointer pFESpace = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatch->pFESpace());
-    if (pFESpace == NULL)
-        KRATOS_THROW_ERROR(std::runtime_error, "The cast to HBSplinesFESpace is failed.", "")
+    // refine the patch
+    std::set<std::size_t> refined_patches;
+    Refine(pPatch, bfs, refined_patches, echo_level);
+}
 
-    std::cout << "window:";
-    for (std::size_t i = 0; i < window.size(); ++i)
+/// Compute the refinement coefficient of a child from the univariate two-scale relations of its parent in each
+/// direction. The first direction runs fastest in the index of the child.
+template<int TDim>
+inline double HBSplinesRefinementUtility_Helper<TDim>::RefinedCoefficient(const boost::array<const Vector*, TDim>& rFactors,
+        std::size_t i_func)
+{
+    double c = 1.0;
+    for (int dim = 0; dim < TDim; ++dim)
     {
-        std::cout << " [";
-        for (std::size_t j = 0; j < window[i].size(); ++j)
-            std::cout << " " << window[i][j];
-        std::cout << "]";
+        const std::size_t n = rFactors[dim]->size();
+        c *= (*rFactors[dim])[i_func % n];
+        i_func /= n;
     }
-    std::cout << std::endl;
+    return c;
+}
 
-    // search and mark all basis functions need to refine on all level (starting from the last level) which support is contained in the refining domain
-    std::vector<std::size_t> bf_list;
-    for(typename bf_container_t::iterator it_bf = pFESpace->bf_begin(); it_bf != pFESpace->bf_end(); ++it_bf)
+/// Create the layout of the control values of the refinement. The sizes of the Vector values are taken from a
+/// reference bf; the control point coordinates are not transferred, since they follow the control point.
+template<int TDim>
+inline void HBSplinesRefinementUtility_Helper<TDim>::CreateValueLayout(ValueLayout& rLayout, const BasisFunctionType& r_bf,
+        const std::vector<Variable<double>*>& double_variables,
+        const std::vector<Variable<array_1d<double, 3> >*>& array_1d_variables,
+        const std::vector<Variable<Vector>*>& vector_variables)
+{
+    rLayout.DoubleVariables = double_variables;
+
+    rLayout.Array1DVariables.clear();
+    for (std::size_t i = 0; i < array_1d_variables.size(); ++i)
+        if (!(*(array_1d_variables[i]) == CONTROL_POINT_COORDINATES))
+            rLayout.Array1DVariables.push_back(array_1d_variables[i]);
+
+    rLayout.VectorVariables = vector_variables;
+    rLayout.VectorSizes.resize(vector_variables.size());
+    for (std::size_t i = 0; i < vector_variables.size(); ++i)
+        rLayout.VectorSizes[i] = r_bf.GetValue(*vector_variables[i]).size();
+
+    rLayout.Size = 4 + rLayout.DoubleVariables.size() + 3*rLayout.Array1DVariables.size();
+    for (std::size_t i = 0; i < rLayout.VectorSizes.size(); ++i)
+        rLayout.Size += rLayout.VectorSizes[i];
+}
+
+/// Check that the Vector values of a bf have the sizes of the layout
+template<int TDim>
+inline void HBSplinesRefinementUtility_Helper<TDim>::CheckValueLayout(const ValueLayout& rLayout, const BasisFunctionType& r_bf)
+{
+    for (std::size_t i = 0; i < rLayout.VectorVariables.size(); ++i)
+        if (r_bf.GetValue(*rLayout.VectorVariables[i]).size() != rLayout.VectorSizes[i])
+            KRATOS_THROW_ERROR(std::logic_error, "The values of the refined basis functions have different sizes for variable", rLayout.VectorVariables[i]->Name())
+}
+
+/// Copy the control values of a bf to the contiguous array of the layout. The bf is only read. It does not throw,
+/// hence it can be called in a parallel region; the sizes of the Vector values must be checked by CheckValueLayout.
+template<int TDim>
+inline void HBSplinesRefinementUtility_Helper<TDim>::PackValues(const ValueLayout& rLayout, const BasisFunctionType& r_bf, double* pValues)
+{
+    const ControlPoint<double>& rPoint = r_bf.GetValue(CONTROL_POINT);
+    for (int k = 0; k < 4; ++k)
+        *(pValues++) = rPoint[k];
+
+    for (std::size_t i = 0; i < rLayout.DoubleVariables.size(); ++i)
+        *(pValues++) = r_bf.GetValue(*rLayout.DoubleVariables[i]);
+
+    for (std::size_t i = 0; i < rLayout.Array1DVariables.size(); ++i)
     {
-        // get the bounding box (support domain of the basis function)
-        std::vector<double> bounding_box = (*it_bf)->GetBoundingBox();
+        const array_1d<double, 3>& rValue = r_bf.GetValue(*rLayout.Array1DVariables[i]);
+        for (std::size_t k = 0; k < 3; ++k)
+            *(pValues++) = rValue[k];
+    }
 
-        // check if the bounding box lie in the refined domain
-        // Remarks: this can be changed by a refinement indicator (i.e from error estimator)
-        if( PBBSplinesBasisFunction_Helper<TDim>::CheckBoundingBox(bounding_box, window) )
-        {
-            bf_list.push_back((*it_bf)->Id());
-        }
+    for (std::size_t i = 0; i < rLayout.VectorVariables.size(); ++i)
+    {
+        const Vector& rValue = r_bf.GetValue(*rLayout.VectorVariables[i]);
+        for (std::size_t k = 0; k < rValue.size(); ++k)
+            *(pValues++) = rValue[k];
     }
+}
+
+/// Add the contiguous array of the layout to the control values of a bf, which must be initialized
+template<int TDim>
+inline void HBSplinesRefinementUtility_Helper<TDim>::AddValues(const ValueLayout& rLayout, BasisFunctionType& r_bf, const double* pValues)
+{
+    ControlPoint<double>& rPoint = r_bf.GetValue(CONTROL_POINT);
+    for (int k = 0; k < 4; ++k)
+        rPoint[k] += *(pValues++);
 
-    // refine
-    for(std::size_t i = 0; i < bf_list.size(); ++i)
+    for (std::size_t i = 0; i < rLayout.DoubleVariables.size(); ++i)
+        r_bf.GetValue(*rLayout.DoubleVariables[i]) += *(pValues++);
+
+    for (std::size_t i = 0; i < rLayout.Array1DVariables.size(); ++i)
     {
-        Refine(pPatch, bf_list[i], echo_level);
+        array_1d<double, 3>& rValue = r_bf.GetValue(*rLayout.Array1DVariables[i]);
+        for (std::size_t k = 0; k < 3; ++k)
+            rValue[k] += *(pValues++);
     }
 
-    pPatch->pParentMultiPatch()->Enumerate();
+    for (std::size_t i = 0; i < rLayout.VectorVariables.size(); ++i)
+    {
+        Vector& rValue = r_bf.GetValue(*rLayout.VectorVariables[i]);
+        for (std::size_t k = 0; k < rLayout.VectorSizes[i]; ++k)
+            rValue[k] += *(pValues++);
+    }
 }
 
 template<int TDim>
-inline void HBSplinesRefinementUtility_Helper<TDim>::LinearDependencyRefine(typename Patch<TDim>::Pointer pPatch, const std::size_t& refine_cycle, const int& echo_level)
+void HBSplinesRefinementUtility_Helper<TDim>::Refine(typename Patch<TDim>::Pointer pPatch,
+        const std::vector<bf_t>& bfs, std::set<std::size_t>& refined_patches, const int& echo_level)
 {
-    if (pPatch->pFESpace()->Type() != HBSplinesFESpace<TDim>::StaticType())
-        KRATOS_THROW_ERROR(std::logic_error, __FUNCTION__, "only support the hierarchical B-Splines patch")
-
     // Type definitions
-    typedef typename HBSplinesFESpace<TDim>::bf_t bf_t;
     typedef typename HBSplinesFESpace<TDim>::bf_container_t bf_container_t;
     typedef typename HBSplinesFESpace<TDim>::CellType CellType;
     typedef typename HBSplinesFESpace<TDim>::cell_t cell_t;
     typedef typename HBSplinesFESpace<TDim>::cell_container_t cell_container_t;
-    typedef typename HBSplinesFESpace<TDim>::domain_t domain_t;
     typedef typename Patch<TDim>::ControlPointType ControlPointType;
 
+    if (refined_patches.find(pPatch->Id()) != refined_patches.end())
+        return;
+    refined_patches.insert(pPatch->Id());
+
+    #ifdef ENABLE_PROFILING
+    double start = OpenMPUtils::GetCurrentTime();
+    double time_1 = 0.0, time_2 = 0.0, time_3 = 0.0;
+    #endif
+
+    bool echo_refinement = IsogeometricEcho::Has(echo_level, ECHO_REFINEMENT);
+
     // extract the hierarchical B-Splines space
     typename HBSplinesFESpace<TDim>::Pointer pFESpace = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatch->pFESpace());
     if (pFESpace == NULL)
         KRATOS_THROW_ERROR(std::runtime_error, "The cast to HBSplinesFESpace is failed.", "")
 
-    if(pFESpace->LastLevel() < 1) return;
+    // group the basis functions by level. The coarse levels are refined first, since their children may be refined in the next level.
+    // The duplicates and the basis functions not in the space (e.g. already refined) are skipped.
+    std::map<std::size_t, std::vector<bf_t> > level_bfs;
+    std::set<std::size_t> equation_ids;
+    std::set<bf_t> unique_bfs;
+    for (std::size_t i = 0; i < bfs.size(); ++i)
+    {
+        if (!unique_bfs.insert(bfs[i]).second)
+            continue;
 
-    #ifdef ENABLE_PROFILING
-    double start = OpenMPUtils::GetCurrentTime();
-    #endif
+        if (!pFESpace->HasBf(bfs[i]))
+        {
+            if (echo_refinement)
+                std::cout << "Basis function " << bfs[i]->Id() << " is not in patch " << pPatch->Id() << ", it is skipped." << std::endl;
+            continue;
+        }
 
-    bool echo_refinement = IsogeometricEcho::Has(echo_level, ECHO_REFINEMENT);
+        if(bfs[i]->Level() >= pFESpace->MaxLevel())
+        {
+            std::cout << "Maximum level is reached, basis function " << bfs[i]->Id() << " of patch " << pPatch->Id() << " is skipped." << std::endl;
+            continue;
+        }
+
+        level_bfs[bfs[i]->Level()].push_back(bfs[i]);
+        equation_ids.insert(bfs[i]->EquationId());
+    }
+
+    if (level_bfs.size() == 0)
+        return;
+
+    // get the list of variables in the patch
+    std::vector<Variable<double>*> double_variables = pPatch->template ExtractVariables<Variable<double> >();
+    std::vector<Variable<array_1d<double, 3> >*> array_1d_variables = pPatch->template ExtractVariables<Variable<array_1d<double, 3> > >();
+    std::vector<Variable<Vector>*> vector_variables = pPatch->template ExtractVariables<Variable<Vector> >();
+
+    double cell_tol = pFESpace->pCellManager()->GetTolerance();
+    std::size_t last_id = pFESpace->LastId();
 
-    // rebuild support domain
-    pFESpace->ClearSupportDomain();
-    for(std::size_t level = 1; level <= pFESpace->LastLevel(); ++level)
+    // start to enumerate from the last equation id in the multipatch
+    std::size_t starting_id;
+    if (pPatch->pParentMultiPatch() != NULL)
+    {
+        starting_id = pPatch->pParentMultiPatch()->GetLastEquationId();
+    }
+    else
+    {
+        starting_id = pPatch->pFESpace()->GetLastEquationId();
+    }
+
+    for (typename std::map<std::size_t, std::vector<bf_t> >::iterator it_level = level_bfs.begin(); it_level != level_bfs.end(); ++it_level)
     {
-        domain_t p_domain = pFESpace->GetSupportDomain(level);
+        const std::size_t level = it_level->first;
+        const std::vector<bf_t>& parent_bfs = it_level->second;
+
+        unsigned int next_level = level + 1;
+        if(next_level > pFESpace->LastLevel()) pFESpace->SetLastLevel(next_level);
+
+        if (echo_refinement)
+            std::cout << parent_bfs.size() << " basis functions (lvl: " << level << ") of patch " << pPatch->Id() << " will be refined" << std::endl;
+
+        const std::size_t nparents = parent_bfs.size();
+
+        #ifdef ENABLE_PROFILING
+        start = OpenMPUtils::GetCurrentTime();
+        #endif
 
-        // add the knots to the domain manager
-        for(std::size_t next_level = level; next_level <= pFESpace->LastLevel(); ++next_level)
+        /* create the lists of new knots of each basis function. The knot vectors of the space are modified here, hence
+           it is done sequentially. */
+        std::vector<std::vector<std::vector<knot_t> > > pnew_local_knots(nparents, std::vector<std::vector<knot_t> >(TDim));
+        std::vector<std::vector<std::vector<double> > > local_knots(nparents, std::vector<std::vector<double> >(TDim));
+        std::vector<std::vector<std::vector<double> > > ins_knots(nparents, std::vector<std::vector<double> >(TDim));
+
+        /* the refinement coefficients of each basis function, in the factored form, i.e. the univariate two-scale
+           relations of each direction, which are looked up in the cache of the space. The relations which are not
+           cached are computed once for each knot configuration. */
+        TwoScaleRelationCache& rRelations = pFESpace->TwoScaleRelations();
+        std::vector<boost::array<const Vector*, TDim> > factors(nparents);
+        std::map<TwoScaleRelationCache::key_t, std::size_t> missing_keys;
+        std::vector<std::pair<std::size_t, std::size_t> > missing_relations; // (parent, direction) of the first basis function having each missing relation
+        std::vector<std::pair<std::size_t, std::size_t> > missing_factors; // (parent * TDim + direction, missing relation)
+
+        for (std::size_t i_bf = 0; i_bf < nparents; ++i_bf)
         {
-            for(typename bf_container_t::iterator it_bf = pFESpace->bf_begin(); it_bf != pFESpace->bf_end(); ++it_bf)
+            const bf_t& p_bf = parent_bfs[i_bf];
+
+            for(unsigned int dim = 0; dim < TDim; ++dim)
             {
-                if((*it_bf)->Level() == next_level)
+                const std::vector<knot_t>& pLocalKnots = p_bf->LocalKnots(dim);
+                p_bf->LocalKnots(dim, local_knots[i_bf][dim]);
+
+                for(std::vector<knot_t>::const_iterator it = pLocalKnots.begin(); it != pLocalKnots.end(); ++it)
                 {
-                    for(typename HBSplinesFESpace<TDim>::BasisFunctionType::cell_iterator it_cell = (*it_bf)->cell_begin(); it_cell != (*it_bf)->cell_end(); ++it_cell)
+                    pnew_local_knots[i_bf][dim].push_back(*it);
+
+                    std::vector<knot_t>::const_iterator it2 = it + 1;
+                    if(it2 != pLocalKnots.end())
                     {
-                        if(TDim == 1)
-                        {
-                            p_domain->AddXcoord((*it_cell)->XiMinValue());
-                            p_domain->AddXcoord((*it_cell)->XiMaxValue());
-                        }
-                        else if(TDim == 2)
-                        {
-                            p_domain->AddXcoord((*it_cell)->XiMinValue());
-                            p_domain->AddXcoord((*it_cell)->XiMaxValue());
-                            p_domain->AddYcoord((*it_cell)->EtaMinValue());
-                            p_domain->AddYcoord((*it_cell)->EtaMaxValue());
-                        }
-                        else if(TDim == 3)
+                        if(fabs((*it2)->Value() - (*it)->Value()) > cell_tol)
                         {
-                            p_domain->AddXcoord((*it_cell)->XiMinValue());
-                            p_domain->AddXcoord((*it_cell)->XiMaxValue());
-                            p_domain->AddYcoord((*it_cell)->EtaMinValue());
-                            p_domain->AddYcoord((*it_cell)->EtaMaxValue());
-                            p_domain->AddZcoord((*it_cell)->ZetaMinValue());
-                            p_domain->AddZcoord((*it_cell)->ZetaMaxValue());
+                            std::vector<double> span_knots;
+                            pFESpace->ComputeInsertedKnots(level, dim, (*it)->Value(), (*it2)->Value(), span_knots);
+                            for (std::size_t i = 0; i < span_knots.size(); ++i)
+                            {
+                                knot_t pnew_knot = pFESpace->KnotVector(dim).pCreateUniqueKnot(span_knots[i], cell_tol);
+                                pnew_local_knots[i_bf][dim].push_back(pnew_knot);
+                                ins_knots[i_bf][dim].push_back(pnew_knot->Value());
+                            }
                         }
                     }
                 }
-            }
-        }
 
-        // add the cells to the domain manager
-        for(std::size_t next_level = level; next_level <= pFESpace->LastLevel(); ++next_level)
-        {
-            for(typename bf_container_t::iterator it_bf = pFESpace->bf_begin(); it_bf != pFESpace->bf_end(); ++it_bf)
-            {
-                if((*it_bf)->Level() == next_level)
+                TwoScaleRelationCache::key_t key = rRelations.Key(pFESpace->Order(dim), local_knots[i_bf][dim], ins_knots[i_bf][dim]);
+                factors[i_bf][dim] = rRelations.Find(key);
+                if (factors[i_bf][dim] == NULL)
                 {
-                    for(typename HBSplinesFESpace<TDim>::BasisFunctionType::cell_iterator it_cell = (*it_bf)->cell_begin(); it_cell != (*it_bf)->cell_end(); ++it_cell)
+                    std::map<TwoScaleRelationCache::key_t, std::size_t>::iterator it_key = missing_keys.find(key);
+                    if (it_key == missing_keys.end())
                     {
-                        if(TDim == 1)
-                        {
-                            std::vector<double> box = {(*it_cell)->XiMinValue(), (*it_cell)->XiMaxValue()};
-                            p_domain->AddCell(box);
-                        }
-                        else if(TDim == 2)
-                        {
-                            std::vector<double> box = {(*it_cell)->XiMinValue(), (*it_cell)->XiMaxValue(), (*it_cell)->EtaMinValue(), (*it_cell)->EtaMaxValue()};
-                            p_domain->AddCell(box);
-                        }
-                        else if(TDim == 3)
-                        {
-                            std::vector<double> box = {(*it_cell)->XiMinValue(), (*it_cell)->XiMaxValue(), (*it_cell)->EtaMinValue(), (*it_cell)->EtaMaxValue(), (*it_cell)->ZetaMinValue(), (*it_cell)->ZetaMaxValue()};
-                            p_domain->AddCell(box);
-                        }
+                        it_key = missing_keys.insert(std::make_pair(key, missing_relations.size())).first;
+                        missing_relations.push_back(std::make_pair(i_bf, dim));
                     }
+                    missing_factors.push_back(std::make_pair(i_bf * TDim + dim, it_key->second));
                 }
             }
         }
 
-//            std::cout << "support domain level " << level << *p_domain << std::endl;
-    }
+        /* compute the missing relations in parallel, and add them to the cache */
+        std::vector<Vector> relations(missing_relations.size());
+        const int nrelations = static_cast<int>(missing_relations.size());
 
-    // refine based on the rule that if a bf has support domain contained in next level, it must be refined
-    for(std::size_t level = 1; level <= pFESpace->LastLevel() - 1; ++level)
-    {
-        std::vector<std::size_t> refined_bfs;
-        for(typename bf_container_t::iterator it_bf = pFESpace->bf_begin(); it_bf != pFESpace->bf_end(); ++it_bf)
+        #pragma omp parallel for
+        for (int i = 0; i < nrelations; ++i)
         {
-            // extract the support domain of the next level
-            if((*it_bf)->Level() != level) continue;
-            domain_t p_domain = pFESpace->GetSupportDomain(level + 1);
+            const std::size_t i_bf = missing_relations[i].first;
+            const std::size_t dim = missing_relations[i].second;
+            TwoScaleRelationCache::Compute(relations[i], pFESpace->Order(dim), local_knots[i_bf][dim], ins_knots[i_bf][dim]);
+        }
 
-            // get the support domain of the bf
-            std::vector<double> bounding_box = (*it_bf)->GetBoundingBox();
+        std::vector<const Vector*> pRelations(missing_relations.size());
+        for (std::map<TwoScaleRelationCache::key_t, std::size_t>::iterator it = missing_keys.begin(); it != missing_keys.end(); ++it)
+            pRelations[it->second] = &(rRelations.Insert(it->first, relations[it->second]));
 
-            // check if the bf support domain contained in the refined domain managed by the domain manager
-            bool is_inside = p_domain->IsInside(bounding_box);
+        for (std::size_t i = 0; i < missing_factors.size(); ++i)
+            factors[missing_factors[i].first / TDim][missing_factors[i].first % TDim] = pRelations[missing_factors[i].second];
 
-            if(is_inside)
-                refined_bfs.push_back((*it_bf)->Id());
-        }
+        #ifdef ENABLE_PROFILING
+        time_1 += OpenMPUtils::GetCurrentTime() - start;
+        start = OpenMPUtils::GetCurrentTime();
+        #endif
+
+        /* collect the basis functions in the next level representing each basis function. A child shared by several
+           parents is collected once, with its contributions in the order of the parents. */
+        std::map<std::vector<knot_t>, std::size_t> children;
+        std::vector<std::vector<std::vector<knot_t> > > child_knots;
+        std::vector<std::vector<std::pair<std::size_t, std::size_t> > > child_contributions; // (parent, index of the child in the parent)
+        std::vector<std::vector<std::size_t> > parent_children(nparents);
 
-        if(refined_bfs.size() > 0)
+        for (std::size_t i_bf = 0; i_bf < nparents; ++i_bf)
         {
-            if(echo_refinement)
+            std::vector<std::size_t> numbers(TDim);
+            std::size_t nfuncs = 1;
+            for (std::size_t dim = 0; dim < TDim; ++dim)
             {
-                std::cout << "Additional Bf of patch " << pPatch->Id() << ":";
-                for(std::size_t i = 0; i < refined_bfs.size(); ++i)
-                    std::cout << " " << refined_bfs[i];
-                std::cout << " of level " << level << " will be refined to maintain the linear independence ..." << std::endl;
+                numbers[dim] = pnew_local_knots[i_bf][dim].size() - pFESpace->Order(dim) - 1;
+                nfuncs *= numbers[dim];
             }
 
+            parent_children[i_bf].resize(nfuncs);
+            std::vector<std::size_t> index(TDim);
+            for (std::size_t i_func = 0; i_func < nfuncs; ++i_func)
+            {
+                // the index of the child in each direction; the first direction runs fastest, as in the refinement coefficients
+                std::size_t aux = i_func;
+                for (std::size_t dim = 0; dim < TDim; ++dim)
+                {
+                    index[dim] = aux % numbers[dim];
+                    aux /= numbers[dim];
+                }
+
+                // create and fill the local knot vectors
+                std::vector<std::vector<knot_t> > pLocalKnots(TDim);
+                std::vector<knot_t> child_key;
+                for (std::size_t dim = 0; dim < TDim; ++dim)
+                {
+                    for(std::size_t k = 0; k < pFESpace->Order(dim) + 2; ++k)
+                        pLocalKnots[dim].push_back(pnew_local_knots[i_bf][dim][index[dim] + k]);
+                    child_key.insert(child_key.end(), pLocalKnots[dim].begin(), pLocalKnots[dim].end());
+                }
+
+                typename std::map<std::vector<knot_t>, std::size_t>::iterator it_child = children.find(child_key);
+                if (it_child == children.end())
+                {
+                    it_child = children.insert(std::make_pair(child_key, child_knots.size())).first;
+                    child_knots.push_back(pLocalKnots);
+                    child_contributions.push_back(std::vector<std::pair<std::size_t, std::size_t> >());
+                }
+                child_contributions[it_child->second].push_back(std::make_pair(i_bf, i_func));
+                parent_children[i_bf][i_func] = it_child->second;
+            }
+        }
+
+        /* create the basis function objects and assign the new equation ids, sequentially in the order of the children */
+        std::vector<bf_t> pnew_bfs = pFESpace->CreateBfs(last_id, next_level, child_knots);
+        const std::size_t nchildren = pnew_bfs.size();
+        for (std::size_t i_child = 0; i_child < nchildren; ++i_child)
+        {
+            pnew_bfs[i_child]->SetEquationId(++starting_id);
+            if (echo_refinement)
+                std::cout << "new bf " << pnew_bfs[i_child]->Id() << " is assigned eq_id = " << pnew_bfs[i_child]->EquationId() << std::endl;
+        }
+
+        /* pack the control values of the parents contiguously, so that all the grid functions are transferred in one pass */
+        ValueLayout layout;
+        CreateValueLayout(layout, *parent_bfs[0], double_variables, array_1d_variables, vector_variables);
+        std::vector<double> parent_values(nparents * layout.Size);
+        const int nparents_int = static_cast<int>(nparents);
+
+        // an exception must not escape the parallel region below, hence the sizes are checked here
+        for (std::size_t i_bf = 0; i_bf < nparents; ++i_bf)
+            CheckValueLayout(layout, *parent_bfs[i_bf]);
+
+        #pragma omp parallel for
+        for (int i_bf = 0; i_bf < nparents_int; ++i_bf)
+            PackValues(layout, *parent_bfs[i_bf], &parent_values[i_bf * layout.Size]);
+
+        /* initialize the children and transfer the control values from their parents, in parallel. Each child is processed
+           by one thread and sums its contributions in the order of the parents, hence the result does not depend on the
+           number of threads. The parents are only read. */
+        std::vector<std::vector<std::vector<knot_t> > > child_cells(nchildren); // the knots of the cells of each child
+        const int nchildren_int = static_cast<int>(nchildren);
+
+        #pragma omp parallel for
+        for (int i_child = 0; i_child < nchildren_int; ++i_child)
+        {
+            BasisFunctionType& r_new_bf = *pnew_bfs[i_child];
+            const std::vector<std::vector<knot_t> >& pLocalKnots = child_knots[i_child];
+            const std::vector<std::pair<std::size_t, std::size_t> >& contributions = child_contributions[i_child];
+
+            // initialize its value
+            for (std::size_t i = 0; i < double_variables.size(); ++i)
+                PBSplinesBasisFunction_InitializeValue_Helper<BasisFunctionType, Variable<double> >::Initialize(r_new_bf, *double_variables[i]);
+            for (std::size_t i = 0; i < array_1d_variables.size(); ++i)
+                PBSplinesBasisFunction_InitializeValue_Helper<BasisFunctionType, Variable<array_1d<double, 3> > >::Initialize(r_new_bf, *array_1d_variables[i]);
+            for (std::size_t i = 0; i < vector_variables.size(); ++i)
+                PBSplinesBasisFunction_InitializeValue_Helper<BasisFunctionType, Variable<Vector> >::Initialize(r_new_bf, *vector_variables[i], parent_bfs[contributions[0].first]);
+
+            // set the boundary information
+            if (knot_container_t::IsOnLeft(pLocalKnots[0], pFESpace->Order(0))) r_new_bf.AddBoundary(BOUNDARY_FLAG(_BLEFT_));
+            if (knot_container_t::IsOnRight(pLocalKnots[0], pFESpace->Order(0))) r_new_bf.AddBoundary(BOUNDARY_FLAG(_BRIGHT_));
+            if (TDim == 2)
+            {
+                if (knot_container_t::IsOnLeft(pLocalKnots[1], pFESpace->Order(1))) r_new_bf.AddBoundary(BOUNDARY_FLAG(_BBOTTOM_));
+                if (knot_container_t::IsOnRight(pLocalKnots[1], pFESpace->Order(1))) r_new_bf.AddBoundary(BOUNDARY_FLAG(_BTOP_));
+            }
+            else if (TDim == 3)
+            {
+                if (knot_container_t::IsOnLeft(pLocalKnots[1], pFESpace->Order(1))) r_new_bf.AddBoundary(BOUNDARY_FLAG(_BFRONT_));
+                if (knot_container_t::IsOnRight(pLocalKnots[1], pFESpace->Order(1))) r_new_bf.AddBoundary(BOUNDARY_FLAG(_BBACK_));
+                if (knot_container_t::IsOnLeft(pLocalKnots[2], pFESpace->Order(2))) r_new_bf.AddBoundary(BOUNDARY_FLAG(_BBOTTOM_));
+                if (knot_container_t::IsOnRight(pLocalKnots[2], pFESpace->Order(2))) r_new_bf.AddBoundary(BOUNDARY_FLAG(_BTOP_));
+            }
+
+            // transfer the control point information and other control values from the parents
+            std::vector<double> child_values(layout.Size, 0.0);
+            for (std::size_t i_con = 0; i_con < contributions.size(); ++i_con)
+            {
+                const double c = RefinedCoefficient(factors[contributions[i_con].first], contributions[i_con].second);
+                const double* old_values = &parent_values[contributions[i_con].first * layout.Size];
+                for (std::size_t k = 0; k < layout.Size; ++k)
+                    child_values[k] += c * old_values[k];
+            }
+            AddValues(layout, r_new_bf, &child_values[0]);
+
+            // collect the cells of the basis function which have nonzero area/volume
+            std::size_t ncells = 1;
+            for (std::size_t dim = 0; dim < TDim; ++dim)
+                ncells *= pFESpace->Order(dim) + 1;
+
+            std::vector<std::size_t> cell_index(TDim);
+            for (std::size_t i_cell = 0; i_cell < ncells; ++i_cell)
+            {
+                std::size_t aux = i_cell;
+                for (std::size_t dim = 0; dim < TDim; ++dim)
+                {
+                    cell_index[dim] = aux % (pFESpace->Order(dim) + 1);
+                    aux /= pFESpace->Order(dim) + 1;
+                }
+
+                std::vector<knot_t> pKnots;
+                double measure = 1.0;
+                for (std::size_t dim = 0; dim < TDim; ++dim)
+                {
+                    knot_t pMin = pLocalKnots[dim][cell_index[dim]];
+                    knot_t pMax = pLocalKnots[dim][cell_index[dim] + 1];
+                    pKnots.push_back(pMin);
+                    pKnots.push_back(pMax);
+                    measure *= pMax->Value() - pMin->Value();
+                }
+
+                if(pow(fabs(measure), 1.0/TDim) > cell_tol)
+                    child_cells[i_child].push_back(pKnots);
+            }
+        }
+
+        /* create the cells for the new basis functions, sequentially in the order of the children */
+        typename cell_container_t::Pointer pnew_cells = typename cell_container_t::Pointer(new BCellManager<TDim, CellType>());
+        for (std::size_t i_child = 0; i_child < nchildren; ++i_child)
+        {
+            for (std::size_t i = 0; i < child_cells[i_child].size(); ++i)
+            {
+                cell_t pnew_cell = pFESpace->pCellManager()->CreateCell(child_cells[i_child][i]);
+                pnew_cell->SetLevel(next_level);
+                pnew_bfs[i_child]->AddCell(pnew_cell);
+                pnew_cell->AddBf(pnew_bfs[i_child]);
+                pnew_cells->insert(pnew_cell);
+            }
+        }
+
+        #ifdef CHECK_REFINEMENT_COEFFICIENTS
+        // check the refinement coefficients
+        if (TDim == 2)
+        {
+            for (std::size_t i_bf = 0; i_bf < nparents; ++i_bf)
+            {
+                std::vector<double> xi(TDim);
+                const std::size_t nsampling = 100;
+                double error = 0.0;
+                for (std::size_t i = 0; i < nsampling; ++i)
+                {
+                    xi[0] = ((double)i) / (nsampling-1);
+                    for (std::size_t j = 0; j < nsampling; ++j)
+                    {
+                        xi[1] = ((double)j) / (nsampling-1);
+                        double f = parent_bfs[i_bf]->GetValueAt(xi);
+
+                        double fs = 0.0;
+                        for (std::size_t k = 0; k < parent_children[i_bf].size(); ++k)
+                            fs += RefinedCoefficient(factors[i_bf], k) * pnew_bfs[parent_children[i_bf][k]]->GetValueAt(xi);
+
+                        error += std::pow(f - fs, 2);
+                    }
+                }
+                std::cout << "Error of computed refinement based on function evaluation: " << std::sqrt(error) << std::endl;
+            }
+        }
+        #endif
+
+        #ifdef ENABLE_PROFILING
+        time_2 += OpenMPUtils::GetCurrentTime() - start;
+        start = OpenMPUtils::GetCurrentTime();
+        #endif
+
+        /* remove the cells of the old basis functions (remove only the cells in the current level) */
+        std::set<bf_t> parents(parent_bfs.begin(), parent_bfs.end());
+        std::set<cell_t> cells_to_remove;
+
+        // firstly, the sub-cells of each cell of the old basis functions in the current level include all bfs of that cell.
+        // The cell is shared by several old basis functions, but is processed once.
+        std::vector<cell_t> old_cells;
+        for (std::size_t i_bf = 0; i_bf < nparents; ++i_bf)
+            for(typename BasisFunctionType::cell_iterator it_cell = parent_bfs[i_bf]->cell_begin(); it_cell != parent_bfs[i_bf]->cell_end(); ++it_cell)
+                if((*it_cell)->Level() == level && cells_to_remove.insert(*it_cell).second)
+                    old_cells.push_back(*it_cell);
+
+        std::vector<std::vector<cell_t> > p_subcells;
+        pnew_cells->GetCells(p_subcells, old_cells);
+        for (std::size_t i_cell = 0; i_cell < old_cells.size(); ++i_cell)
+        {
+            for(std::size_t i = 0; i < p_subcells[i_cell].size(); ++i)
+            {
+                for(typename CellType::bf_iterator it_bf = old_cells[i_cell]->bf_begin(); it_bf != old_cells[i_cell]->bf_end(); ++it_bf)
+                {
+                    p_subcells[i_cell][i]->AddBf(it_bf->lock());
+                    it_bf->lock()->AddCell(p_subcells[i_cell][i]);
+                }
+            }
+        }
+
+        // secondly, a new cell may cover several existing cells. In this case it must be removed, and its bfs will be transferred to sub-cells.
+        std::vector<cell_t> new_cells(pnew_cells->begin(), pnew_cells->end());
+        std::vector<std::vector<cell_t> > p_covered_cells;
+        pFESpace->pCellManager()->GetCells(p_covered_cells, new_cells);
+        for (std::size_t i_cell = 0; i_cell < new_cells.size(); ++i_cell)
+        {
+            const std::vector<cell_t>& p_cells = p_covered_cells[i_cell];
+            if(p_cells.size() > 0)
+            {
+                if(echo_refinement)
+                {
+                    std::cout << "cell " << new_cells[i_cell]->Id() << " is detected to contain some smaller cells:";
+                    for(std::size_t i = 0; i < p_cells.size(); ++i)
+                        std::cout << " " << p_cells[i]->Id();
+                    std::cout << std::endl;
+                }
+
+                cells_to_remove.insert(new_cells[i_cell]);
+                for(std::size_t i = 0; i < p_cells.size(); ++i)
+                {
+                    for(typename CellType::bf_iterator it_bf = new_cells[i_cell]->bf_begin(); it_bf != new_cells[i_cell]->bf_end(); ++it_bf)
+                    {
+                        p_cells[i]->AddBf(it_bf->lock());
+                        it_bf->lock()->AddCell(p_cells[i]);
+                    }
+                }
+            }
+        }
+
+        /* remove the cells from the previous steps, in one pass over the basis functions. Each basis function is only
+           modified by one thread. */
+        for(typename std::set<cell_t>::iterator it_cell = cells_to_remove.begin(); it_cell != cells_to_remove.end(); ++it_cell)
+            pFESpace->pCellManager()->erase(*it_cell);
+
+        std::vector<bf_t> all_bfs(pFESpace->bf_begin(), pFESpace->bf_end());
+        const int nbfs = static_cast<int>(all_bfs.size());
+
+        #pragma omp parallel for
+        for (int i_bf = 0; i_bf < nbfs; ++i_bf)
+        {
+            std::vector<cell_t> p_cells;
+            for(typename BasisFunctionType::cell_iterator it_cell = all_bfs[i_bf]->cell_begin(); it_cell != all_bfs[i_bf]->cell_end(); ++it_cell)
+                if(cells_to_remove.find(*it_cell) != cells_to_remove.end())
+                    p_cells.push_back(*it_cell);
+
+            for(std::size_t i = 0; i < p_cells.size(); ++i)
+                all_bfs[i_bf]->RemoveCell(p_cells[i]);
+        }
+
+        /* remove the old basis functions from all the cells, in one pass over the cells. Each cell is only modified by one thread. */
+        std::vector<cell_t> all_cells(pFESpace->pCellManager()->begin(), pFESpace->pCellManager()->end());
+        const int ncells = static_cast<int>(all_cells.size());
+
+        #pragma omp parallel for
+        for (int i_cell = 0; i_cell < ncells; ++i_cell)
+        {
+            std::vector<bf_t> p_bfs;
+            for(typename CellType::bf_iterator it_bf = all_cells[i_cell]->bf_begin(); it_bf != all_cells[i_cell]->bf_end(); ++it_bf)
+                if(parents.find(it_bf->lock()) != parents.end())
+                    p_bfs.push_back(it_bf->lock());
+
+            for(std::size_t i = 0; i < p_bfs.size(); ++i)
+                all_cells[i_cell]->RemoveBf(p_bfs[i]);
+        }
+
+        /* remove the old basis functions and record the refinement history. The old basis functions are kept with
+           their two-scale relation for the coarsening. */
+        for (std::size_t i_bf = 0; i_bf < nparents; ++i_bf)
+        {
+            for (std::size_t i_func = 0; i_func < parent_children[i_bf].size(); ++i_func)
+                parent_bfs[i_bf]->AddChild(pnew_bfs[parent_children[i_bf][i_func]], RefinedCoefficient(factors[i_bf], i_func));
+
+            pFESpace->RemoveBf(parent_bfs[i_bf]);
+            pFESpace->AddRefinedBf(parent_bfs[i_bf]);
+            pFESpace->RecordRefinementHistory(parent_bfs[i_bf]->Id());
+        }
+
+        #ifdef ENABLE_PROFILING
+        time_3 += OpenMPUtils::GetCurrentTime() - start;
+        #endif
+
+        if (echo_refinement)
+            std::cout << "Refine " << nparents << " basis functions (lvl: " << level << ") of patch " << pPatch->Id()
+                      << " completed, " << nchildren << " children, " << relations.size() << " new two-scale relations ("
+                      << rRelations.size() << " cached)" << std::endl;
+    }
+
+    // update the weight information for all the grid functions (except the control point grid function)
+    std::vector<double> Weights = pFESpace->GetWeights();
+
+    typename Patch<TDim>::DoubleGridFunctionContainerType DoubleGridFunctions_ = pPatch->DoubleGridFunctions();
+    for (typename Patch<TDim>::DoubleGridFunctionContainerType::iterator it = DoubleGridFunctions_.begin();
+            it != DoubleGridFunctions_.end(); ++it)
+    {
+        typename WeightedFESpace<TDim>::Pointer pThisFESpace = boost::dynamic_pointer_cast<WeightedFESpace<TDim> >((*it)->pFESpace());
+        if (pThisFESpace == NULL)
+            KRATOS_THROW_ERROR(std::runtime_error, "The cast to WeightedFESpace is failed.", "")
+        pThisFESpace->SetWeights(Weights);
+    }
+
+    typename Patch<TDim>::Array1DGridFunctionContainerType Array1DGridFunctions_ = pPatch->Array1DGridFunctions();
+    for (typename Patch<TDim>::Array1DGridFunctionContainerType::iterator it = Array1DGridFunctions_.begin();
+            it != Array1DGridFunctions_.end(); ++it)
+    {
+        typename WeightedFESpace<TDim>::Pointer pThisFESpace = boost::dynamic_pointer_cast<WeightedFESpace<TDim> >((*it)->pFESpace());
+        if (pThisFESpace == NULL)
+            KRATOS_THROW_ERROR(std::runtime_error, "The cast to WeightedFESpace is failed.", "")
+        pThisFESpace->SetWeights(Weights);
+    }
+
+    typename Patch<TDim>::VectorGridFunctionContainerType VectorGridFunctions_ = pPatch->VectorGridFunctions();
+    for (typename Patch<TDim>::VectorGridFunctionContainerType::iterator it = VectorGridFunctions_.begin();
+            it != VectorGridFunctions_.end(); ++it)
+    {
+        typename WeightedFESpace<TDim>::Pointer pThisFESpace = boost::dynamic_pointer_cast<WeightedFESpace<TDim> >((*it)->pFESpace());
+        if (pThisFESpace == NULL)
+            KRATOS_THROW_ERROR(std::runtime_error, "The cast to WeightedFESpace is failed.", "")
+        pThisFESpace->SetWeights(Weights);
+    }
+
+    if(echo_refinement)
+    {
+        std::cout << "Refine patch " << pPatch->Id() << ", " << bfs.size() << " bfs completed" << std::endl;
+        #ifdef ENABLE_PROFILING
+        std::cout << " Time to compute the refinement coefficients: " << time_1 << " s" << std::endl;
+        std::cout << " Time to create new cells and new bfs: " << time_2 << " s" << std::endl;
+        std::cout << " Time to clean up: " << time_3 << " s" << std::endl;
+        #endif
+    }
+
+    // refine also the matching basis functions of the neighbor patches
+    for (std::size_t i = 0; i < pPatch->NumberOfInterfaces(); ++i)
+    {
+        typename PatchInterface<TDim>::Pointer pInterface = pPatch->pInterface(i);
+
+        typename Patch<TDim>::Pointer pNeighborPatch = pInterface->pPatch2();
+
+        // extract the hierarchical B-Splines space
+        typename HBSplinesFESpace<TDim>::Pointer pNeighborFESpace = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pNeighborPatch->pFESpace());
+        if (pNeighborFESpace == NULL)
+            KRATOS_THROW_ERROR(std::runtime_error, "The cast to HBSplinesFESpace is failed.", "")
+
+        std::vector<bf_t> neighbor_bfs;
+        for(typename bf_container_t::iterator it = pNeighborFESpace->bf_begin(); it != pNeighborFESpace->bf_end(); ++it)
+            if (equation_ids.find((*it)->EquationId()) != equation_ids.end())
+                neighbor_bfs.push_back(*it);
+
+        if (neighbor_bfs.size() > 0)
+        {
+            if(echo_refinement)
+                std::cout << "Neighbor patch " << pNeighborPatch->Id() << " of patch " << pPatch->Id() << " will be refined" << std::endl;
+
+            Refine(pNeighborPatch, neighbor_bfs, refined_patches, echo_level);
+        }
+    }
+}
+
+template<int TDim>
+inline void HBSplinesRefinementUtility_Helper<TDim>::RefineWindow(typename Patch<TDim>::Pointer pPatch,
+        const std::vector<std::vector<double> >& window, const int& echo_level)
+{
+    if (pPatch->pFESpace()->Type() != HBSplinesFESpace<TDim>::StaticType())
+        KRATOS_THROW_ERROR(std::logic_error, __FUNCTION__, "only support the hierarchical B-Splines patch")
+
+    // Type definitions
+    typedef typename HBSplinesFESpace<TDim>::bf_t bf_t;
+    typedef typename HBSplinesFESpace<TDim>::bf_container_t bf_container_t;
+    typedef typename HBSplinesFESpace<TDim>::CellType CellType;
+    typedef typename HBSplinesFESpace<TDim>::cell_t cell_t;
+    typedef typename HBSplinesFESpace<TDim>::cell_container_t cell_container_t;
+    typedef typename Patch<TDim>::ControlPointType ControlPointType;
+
+    // extract the hierarchical B-Splines space
+    typename HBSplinesFESpace<TDim>::Pointer pFESpace = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatch->pFESpace());
+    if (pFESpace == NULL)
+        KRATOS_THROW_ERROR(std::runtime_error, "The cast to HBSplinesFESpace is failed.", "")
+
+    std::cout << "window:";
+    for (std::size_t i = 0; i < window.size(); ++i)
+    {
+        std::cout << " [";
+        for (std::size_t j = 0; j < window[i].size(); ++j)
+            std::cout << " " << window[i][j];
+        std::cout << "]";
+    }
+    std::cout << std::endl;
+
+    // search and mark all basis functions need to refine on all level which support is contained in the refining domain
+    std::vector<bf_t> bf_list;
+    for(typename bf_container_t::iterator it_bf = pFESpace->bf_begin(); it_bf != pFESpace->bf_end(); ++it_bf)
+    {
+        // get the bounding box (support domain of the basis function)
+        std::vector<double> bounding_box = (*it_bf)->GetBoundingBox();
+
+        // check if the bounding box lie in the refined domain
+        // Remarks: this can be changed by a refinement indicator (i.e from error estimator)
+        if( PBBSplinesBasisFunction_Helper<TDim>::CheckBoundingBox(bounding_box, window) )
+        {
+            bf_list.push_back(*it_bf);
+        }
+    }
+
+    // refine all the marked basis functions at once
+    Refine(pPatch, bf_list, echo_level);
+
+    pPatch->pParentMultiPatch()->Enumerate();
+}
+
+template<int TDim>
+inline void HBSplinesRefinementUtility_Helper<TDim>::Coarsen(typename Patch<TDim>::Pointer pPatch,
+        const std::vector<std::size_t>& Ids, const int& echo_level)
+{
+    // extract the hierarchical B-Splines space
+    typename HBSplinesFESpace<TDim>::Pointer pFESpace = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatch->pFESpace());
+    if (pFESpace == NULL)
+        KRATOS_THROW_ERROR(std::runtime_error, "The cast to HBSplinesFESpace is failed.", "")
+
+    bool echo_refinement = IsogeometricEcho::Has(echo_level, ECHO_REFINEMENT);
+
+    std::vector<bf_t> bfs;
+    for (std::size_t i = 0; i < Ids.size(); ++i)
+    {
+        if (!pFESpace->HasRefinedBf(Ids[i]))
+        {
+            if (echo_refinement)
+                std::cout << "Basis function " << Ids[i] << " of patch " << pPatch->Id() << " is not refined, it is skipped." << std::endl;
+            continue;
+        }
+
+        bfs.push_back(pFESpace->pGetRefinedBf(Ids[i]));
+    }
+
+    Coarsen(pPatch, bfs, echo_level);
+}
+
+template<int TDim>
+inline void HBSplinesRefinementUtility_Helper<TDim>::Coarsen(typename Patch<TDim>::Pointer pPatch,
+        const std::vector<bf_t>& bfs, const int& echo_level)
+{
+    if (pPatch->pFESpace()->Type() != HBSplinesFESpace<TDim>::StaticType())
+        KRATOS_THROW_ERROR(std::logic_error, __FUNCTION__, "only support the hierarchical B-Splines patch")
+
+    // group the basis functions by level. The fine levels are coarsened first, since the children of a basis function
+    // must be active to restore it.
+    std::map<std::size_t, std::vector<bf_t> > level_bfs;
+    for (std::size_t i = 0; i < bfs.size(); ++i)
+        level_bfs[bfs[i]->Level()].push_back(bfs[i]);
+
+    for (typename std::map<std::size_t, std::vector<bf_t> >::reverse_iterator it = level_bfs.rbegin(); it != level_bfs.rend(); ++it)
+    {
+        std::set<std::size_t> coarsened_patches;
+        Coarsen(pPatch, it->second, coarsened_patches, echo_level);
+    }
+}
+
+/// Coarsen the refined basis functions of one level. A refined basis function is restored if all its children are
+/// active, and it is the only parent of at least one of its children. The children whose refined parents are all
+/// restored are removed; the other children are kept. The control values of the restored basis functions are the
+/// least-squares projection of the values of the removed children, and the remainder is kept on the kept children.
+/// Hence the coarsening is the exact inverse of the refinement if the control values were not modified in between.
+template<int TDim>
+void HBSplinesRefinementUtility_Helper<TDim>::Coarsen(typename Patch<TDim>::Pointer pPatch,
+        const std::vector<bf_t>& bfs, std::set<std::size_t>& coarsened_patches, const int& echo_level)
+{
+    // Type definitions
+    typedef typename HBSplinesFESpace<TDim>::bf_container_t bf_container_t;
+    typedef typename HBSplinesFESpace<TDim>::CellType CellType;
+    typedef typename HBSplinesFESpace<TDim>::cell_t cell_t;
+    typedef typename HBSplinesFESpace<TDim>::refined_bf_iterator refined_bf_iterator;
+    typedef typename TwoScaleRelation::matrix_t matrix_t;
+
+    if (coarsened_patches.find(pPatch->Id()) != coarsened_patches.end())
+        return;
+    coarsened_patches.insert(pPatch->Id());
+
+    if (bfs.size() == 0)
+        return;
+
+    #ifdef ENABLE_PROFILING
+    double start = OpenMPUtils::GetCurrentTime();
+    double time_1 = 0.0, time_2 = 0.0;
+    #endif
+
+    bool echo_refinement = IsogeometricEcho::Has(echo_level, ECHO_REFINEMENT);
+
+    // extract the hierarchical B-Splines space
+    typename HBSplinesFESpace<TDim>::Pointer pFESpace = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatch->pFESpace());
+    if (pFESpace == NULL)
+        KRATOS_THROW_ERROR(std::runtime_error, "The cast to HBSplinesFESpace is failed.", "")
+
+    const std::size_t level = bfs[0]->Level();
+    double cell_tol = pFESpace->pCellManager()->GetTolerance();
+
+    /* select the basis functions which can be restored. Their children must be active, and no active basis function
+       of the same level has the same local knots, e.g. one created by the refinement of a coarser basis function. */
+    std::set<bf_t> active_bfs(pFESpace->bf_begin(), pFESpace->bf_end());
+    std::set<std::vector<knot_t> > active_knots;
+    for(typename bf_container_t::iterator it = pFESpace->bf_begin(); it != pFESpace->bf_end(); ++it)
+    {
+        if ((*it)->Level() != level) continue;
+        std::vector<knot_t> key;
+        for (std::size_t dim = 0; dim < TDim; ++dim)
+            key.insert(key.end(), (*it)->LocalKnots(dim).begin(), (*it)->LocalKnots(dim).end());
+        active_knots.insert(key);
+    }
+
+    std::map<std::size_t, bf_t> parents;
+    for (std::size_t i = 0; i < bfs.size(); ++i)
+    {
+        const bf_t& p_bf = bfs[i];
+        if (p_bf->Level() != level || !pFESpace->HasRefinedBf(p_bf->Id()) || pFESpace->pGetRefinedBf(p_bf->Id()) != p_bf)
+        {
+            if (echo_refinement)
+                std::cout << "Basis function " << p_bf->Id() << " of patch " << pPatch->Id() << " is not refined, it is skipped." << std::endl;
+            continue;
+        }
+
+        bool is_leaf = true;
+        for (typename BasisFunctionType::bf_iterator it = p_bf->bf_begin(); it != p_bf->bf_end(); ++it)
+        {
+            if (active_bfs.find(*it) == active_bfs.end())
+            {
+                is_leaf = false;
+                break;
+            }
+        }
+
+        if (!is_leaf)
+        {
+            if (echo_refinement)
+                std::cout << "Basis function " << p_bf->Id() << " of patch " << pPatch->Id() << " has refined children, it is skipped." << std::endl;
+            continue;
+        }
+
+        std::vector<knot_t> key;
+        for (std::size_t dim = 0; dim < TDim; ++dim)
+            key.insert(key.end(), p_bf->LocalKnots(dim).begin(), p_bf->LocalKnots(dim).end());
+        if (active_knots.find(key) != active_knots.end())
+        {
+            if (echo_refinement)
+                std::cout << "Basis function " << p_bf->Id() << " of patch " << pPatch->Id() << " is duplicated by an active basis function, it is skipped." << std::endl;
+            continue;
+        }
+
+        parents[p_bf->Id()] = p_bf;
+    }
+
+    /* the refined parents of each child in this level. A child is removed if all its refined parents are restored. A
+       basis function which would not remove any of its children is not restored, since it would be linearly dependent
+       on its children. */
+    std::map<std::size_t, std::vector<std::size_t> > child_parents;
+    for (refined_bf_iterator it = pFESpace->refined_bf_begin(); it != pFESpace->refined_bf_end(); ++it)
+        if (it->second->Level() == level)
+            for (typename BasisFunctionType::bf_iterator it_child = it->second->bf_begin(); it_child != it->second->bf_end(); ++it_child)
+                child_parents[(*it_child)->Id()].push_back(it->first);
+
+    bool is_changed = true;
+    while (is_changed)
+    {
+        is_changed = false;
+        for (typename std::map<std::size_t, bf_t>::iterator it = parents.begin(); it != parents.end();)
+        {
+            bool has_removed_child = false;
+            for (typename BasisFunctionType::bf_iterator it_child = it->second->bf_begin(); it_child != it->second->bf_end() && !has_removed_child; ++it_child)
+            {
+                const std::vector<std::size_t>& ids = child_parents[(*it_child)->Id()];
+                has_removed_child = true;
+                for (std::size_t i = 0; i < ids.size(); ++i)
+                {
+                    if (parents.find(ids[i]) == parents.end())
+                    {
+                        has_removed_child = false;
+                        break;
+                    }
+                }
+            }
+
+            if (!has_removed_child)
+            {
+                if (echo_refinement)
+                    std::cout << "Basis function " << it->first << " of patch " << pPatch->Id() << " does not remove any children, it is skipped." << std::endl;
+                parents.erase(it++);
+                is_changed = true;
+            }
+            else
+                ++it;
+        }
+    }
+
+    if (parents.size() == 0)
+        return;
+
+    if (echo_refinement)
+        std::cout << parents.size() << " basis functions (lvl: " << level << ") of patch " << pPatch->Id() << " will be coarsened" << std::endl;
+
+    /* build the two-scale relation between the parents and their children */
+    TwoScaleRelation relation;
+    std::map<std::size_t, std::size_t> removed_index, kept_index;
+    std::set<std::size_t> removed_equation_ids;
+    for (typename std::map<std::size_t, bf_t>::iterator it = parents.begin(); it != parents.end(); ++it)
+    {
+        const std::size_t i_parent = relation.Parents.size();
+        relation.Parents.push_back(it->second);
+
+        for (typename BasisFunctionType::bf_iterator it_child = it->second->bf_begin(); it_child != it->second->bf_end(); ++it_child)
+        {
+            const std::vector<std::size_t>& ids = child_parents[(*it_child)->Id()];
+            bool is_removed = true;
+            for (std::size_t i = 0; i < ids.size(); ++i)
+                if (parents.find(ids[i]) == parents.end())
+                    is_removed = false;
+
+            std::map<std::size_t, std::size_t>& index = is_removed ? removed_index : kept_index;
+            std::vector<bf_t>& children = is_removed ? relation.RemovedChildren : relation.KeptChildren;
+            matrix_t& rows = is_removed ? relation.RemovedRows : relation.KeptRows;
+
+            std::map<std::size_t, std::size_t>::iterator it_index = index.find((*it_child)->Id());
+            if (it_index == index.end())
+            {
+                it_index = index.insert(std::make_pair((*it_child)->Id(), children.size())).first;
+                children.push_back(*it_child);
+                rows.push_back(std::vector<std::pair<std::size_t, double> >());
+                if (is_removed)
+                    removed_equation_ids.insert((*it_child)->EquationId());
+            }
+            rows[it_index->second].push_back(std::make_pair(i_parent, it->second->GetRefinedCoefficient((*it_child)->Id())));
+        }
+    }
+
+    std::vector<std::map<std::size_t, double> > normal(relation.Parents.size());
+    for (std::size_t i = 0; i < relation.RemovedRows.size(); ++i)
+        for (std::size_t j = 0; j < relation.RemovedRows[i].size(); ++j)
+            for (std::size_t k = 0; k < relation.RemovedRows[i].size(); ++k)
+                normal[relation.RemovedRows[i][j].first][relation.RemovedRows[i][k].first] += relation.RemovedRows[i][j].second * relation.RemovedRows[i][k].second;
+
+    relation.Normal.resize(normal.size());
+    for (std::size_t i = 0; i < normal.size(); ++i)
+        relation.Normal[i].assign(normal[i].begin(), normal[i].end());
+
+    /* project the control values to the parents */
+    std::vector<Variable<double>*> double_variables = pPatch->template ExtractVariables<Variable<double> >();
+    std::vector<Variable<array_1d<double, 3> >*> array_1d_variables = pPatch->template ExtractVariables<Variable<array_1d<double, 3> > >();
+    std::vector<Variable<Vector>*> vector_variables = pPatch->template ExtractVariables<Variable<Vector> >();
+
+    CoarsenValues(relation, CONTROL_POINT);
+
+    for (std::size_t i = 0; i < double_variables.size(); ++i)
+        CoarsenValues(relation, *double_variables[i]);
+
+    for (std::size_t i = 0; i < array_1d_variables.size(); ++i)
+    {
+        if (*(array_1d_variables[i]) == CONTROL_POINT_COORDINATES) continue;
+        CoarsenValues(relation, *array_1d_variables[i]);
+    }
+
+    for (std::size_t i = 0; i < vector_variables.size(); ++i)
+        CoarsenValues(relation, *vector_variables[i]);
+
+    #ifdef ENABLE_PROFILING
+    time_1 += OpenMPUtils::GetCurrentTime() - start;
+    start = OpenMPUtils::GetCurrentTime();
+    #endif
+
+    /* the knot spans of the parents, which become the cells of this level again, unless they are still covered by the
+       support of a refined basis function of this level which is not restored */
+    std::map<std::vector<long long>, std::vector<knot_t> > spans;
+    for (std::size_t i_bf = 0; i_bf < relation.Parents.size(); ++i_bf)
+    {
+        const bf_t& p_bf = relation.Parents[i_bf];
+
+        std::size_t ncells = 1;
+        for (std::size_t dim = 0; dim < TDim; ++dim)
+            ncells *= pFESpace->Order(dim) + 1;
+
+        std::vector<std::size_t> cell_index(TDim);
+        for (std::size_t i_cell = 0; i_cell < ncells; ++i_cell)
+        {
+            std::size_t aux = i_cell;
+            for (std::size_t dim = 0; dim < TDim; ++dim)
+            {
+                cell_index[dim] = aux % (pFESpace->Order(dim) + 1);
+                aux /= pFESpace->Order(dim) + 1;
+            }
+
+            std::vector<knot_t> pKnots;
+            std::vector<long long> key;
+            double measure = 1.0;
+            for (std::size_t dim = 0; dim < TDim; ++dim)
+            {
+                knot_t pMin = p_bf->LocalKnots(dim)[cell_index[dim]];
+                knot_t pMax = p_bf->LocalKnots(dim)[cell_index[dim] + 1];
+                pKnots.push_back(pMin);
+                pKnots.push_back(pMax);
+                key.push_back(static_cast<long long>(std::floor(pMin->Value() / cell_tol + 0.5)));
+                key.push_back(static_cast<long long>(std::floor(pMax->Value() / cell_tol + 0.5)));
+                measure *= pMax->Value() - pMin->Value();
+            }
+
+            if(pow(fabs(measure), 1.0/TDim) > cell_tol)
+                spans.insert(std::make_pair(key, pKnots));
+        }
+    }
+
+    std::vector<std::vector<double> > refined_boxes;
+    for (refined_bf_iterator it = pFESpace->refined_bf_begin(); it != pFESpace->refined_bf_end(); ++it)
+    {
+        if (it->second->Level() != level || parents.find(it->first) != parents.end()) continue;
+
+        std::vector<double> box;
+        for (std::size_t dim = 0; dim < TDim; ++dim)
+        {
+            box.push_back(it->second->LocalKnots(dim).front()->Value());
+            box.push_back(it->second->LocalKnots(dim).back()->Value());
+        }
+        refined_boxes.push_back(box);
+    }
+
+    std::vector<cell_t> new_cells;
+    for (typename std::map<std::vector<long long>, std::vector<knot_t> >::iterator it = spans.begin(); it != spans.end(); ++it)
+    {
+        const std::vector<knot_t>& pKnots = it->second;
+
+        bool is_covered = false;
+        for (std::size_t i = 0; i < refined_boxes.size() && !is_covered; ++i)
+        {
+            is_covered = true;
+            for (std::size_t dim = 0; dim < TDim; ++dim)
+            {
+                if (pKnots[2*dim]->Value() < refined_boxes[i][2*dim] - cell_tol || pKnots[2*dim+1]->Value() > refined_boxes[i][2*dim+1] + cell_tol)
+                {
+                    is_covered = false;
+                    break;
+                }
+            }
+        }
+
+        if (!is_covered)
+        {
+            cell_t pnew_cell = pFESpace->pCellManager()->CreateCell(pKnots);
+            pnew_cell->SetLevel(level);
+            new_cells.push_back(pnew_cell);
+        }
+    }
+
+    /* the new cells replace the finer cells which they cover. The bfs of the finer cells which are not removed are
+       transferred to the new cells. */
+    std::set<bf_t> removed_bfs(relation.RemovedChildren.begin(), relation.RemovedChildren.end());
+    std::set<cell_t> cells_to_remove;
+
+    std::vector<std::vector<cell_t> > p_subcells;
+    pFESpace->pCellManager()->GetCells(p_subcells, new_cells);
+    for (std::size_t i_cell = 0; i_cell < new_cells.size(); ++i_cell)
+    {
+        for (std::size_t i = 0; i < p_subcells[i_cell].size(); ++i)
+        {
+            for(typename CellType::bf_iterator it_bf = p_subcells[i_cell][i]->bf_begin(); it_bf != p_subcells[i_cell][i]->bf_end(); ++it_bf)
+            {
+                bf_t p_bf = it_bf->lock();
+                if (removed_bfs.find(p_bf) != removed_bfs.end()) continue;
+                new_cells[i_cell]->AddBf(p_bf);
+                p_bf->AddCell(new_cells[i_cell]);
+            }
+            cells_to_remove.insert(p_subcells[i_cell][i]);
+        }
+    }
+
+    for(typename std::set<cell_t>::iterator it_cell = cells_to_remove.begin(); it_cell != cells_to_remove.end(); ++it_cell)
+        pFESpace->pCellManager()->erase(*it_cell);
+
+    std::vector<bf_t> all_bfs(pFESpace->bf_begin(), pFESpace->bf_end());
+    const int nbfs = static_cast<int>(all_bfs.size());
+
+    #pragma omp parallel for
+    for (int i_bf = 0; i_bf < nbfs; ++i_bf)
+    {
+        std::vector<cell_t> p_cells;
+        for(typename BasisFunctionType::cell_iterator it_cell = all_bfs[i_bf]->cell_begin(); it_cell != all_bfs[i_bf]->cell_end(); ++it_cell)
+            if(cells_to_remove.find(*it_cell) != cells_to_remove.end())
+                p_cells.push_back(*it_cell);
+
+        for(std::size_t i = 0; i < p_cells.size(); ++i)
+            all_bfs[i_bf]->RemoveCell(p_cells[i]);
+    }
+
+    /* remove the children which are not needed anymore */
+    for (std::size_t i = 0; i < relation.RemovedChildren.size(); ++i)
+    {
+        const bf_t& p_bf = relation.RemovedChildren[i];
+        std::vector<cell_t> p_cells(p_bf->cell_begin(), p_bf->cell_end());
+        for (std::size_t j = 0; j < p_cells.size(); ++j)
+        {
+            p_cells[j]->RemoveBf(p_bf);
+            p_bf->RemoveCell(p_cells[j]);
+        }
+
+        pFESpace->RemoveBf(p_bf);
+    }
+
+    /* restore the parents, with new equation ids, and assign them to the cells in their support */
+    std::size_t starting_id;
+    if (pPatch->pParentMultiPatch() != NULL)
+    {
+        starting_id = pPatch->pParentMultiPatch()->GetLastEquationId();
+    }
+    else
+    {
+        starting_id = pPatch->pFESpace()->GetLastEquationId();
+    }
+
+    // the support boxes are temporary; they are allocated in the pool of the cells of the space
+    MemoryPool::Pointer pCellPool = pFESpace->pCellManager()->pMemoryPool();
+    std::vector<cell_t> supports;
+    for (std::size_t i_bf = 0; i_bf < relation.Parents.size(); ++i_bf)
+    {
+        const bf_t& p_bf = relation.Parents[i_bf];
+        pFESpace->RestoreBf(p_bf);
+        p_bf->SetEquationId(++starting_id);
+        if (echo_refinement)
+            std::cout << "restored bf " << p_bf->Id() << " is assigned eq_id = " << p_bf->EquationId() << std::endl;
+
+        if (TDim == 2)
+            supports.push_back(MemoryPool::Create<CellType>(pCellPool, 0, p_bf->LocalKnots(0).front(), p_bf->LocalKnots(0).back(),
+                p_bf->LocalKnots(1).front(), p_bf->LocalKnots(1).back()));
+        else if (TDim == 3)
+            supports.push_back(MemoryPool::Create<CellType>(pCellPool, 0, p_bf->LocalKnots(0).front(), p_bf->LocalKnots(0).back(),
+                p_bf->LocalKnots(1).front(), p_bf->LocalKnots(1).back(), p_bf->LocalKnots(2).front(), p_bf->LocalKnots(2).back()));
+    }
+
+    std::vector<std::vector<cell_t> > p_support_cells;
+    pFESpace->pCellManager()->GetCells(p_support_cells, supports);
+    for (std::size_t i_bf = 0; i_bf < relation.Parents.size(); ++i_bf)
+    {
+        for (std::size_t i = 0; i < p_support_cells[i_bf].size(); ++i)
+        {
+            p_support_cells[i_bf][i]->AddBf(relation.Parents[i_bf]);
+            relation.Parents[i_bf]->AddCell(p_support_cells[i_bf][i]);
+        }
+    }
+
+    // the last level is the finest level of the remaining basis functions
+    std::size_t last_level = 1;
+    for(typename bf_container_t::iterator it = pFESpace->bf_begin(); it != pFESpace->bf_end(); ++it)
+        last_level = std::max(last_level, (*it)->Level());
+    pFESpace->SetLastLevel(last_level);
+
+    #ifdef ENABLE_PROFILING
+    time_2 += OpenMPUtils::GetCurrentTime() - start;
+    #endif
+
+    // update the weight information for all the grid functions (except the control point grid function)
+    std::vector<double> Weights = pFESpace->GetWeights();
+
+    typename Patch<TDim>::DoubleGridFunctionContainerType DoubleGridFunctions_ = pPatch->DoubleGridFunctions();
+    for (typename Patch<TDim>::DoubleGridFunctionContainerType::iterator it = DoubleGridFunctions_.begin();
+            it != DoubleGridFunctions_.end(); ++it)
+    {
+        typename WeightedFESpace<TDim>::Pointer pThisFESpace = boost::dynamic_pointer_cast<WeightedFESpace<TDim> >((*it)->pFESpace());
+        if (pThisFESpace == NULL)
+            KRATOS_THROW_ERROR(std::runtime_error, "The cast to WeightedFESpace is failed.", "")
+        pThisFESpace->SetWeights(Weights);
+    }
+
+    typename Patch<TDim>::Array1DGridFunctionContainerType Array1DGridFunctions_ = pPatch->Array1DGridFunctions();
+    for (typename Patch<TDim>::Array1DGridFunctionContainerType::iterator it = Array1DGridFunctions_.begin();
+            it != Array1DGridFunctions_.end(); ++it)
+    {
+        typename WeightedFESpace<TDim>::Pointer pThisFESpace = boost::dynamic_pointer_cast<WeightedFESpace<TDim> >((*it)->pFESpace());
+        if (pThisFESpace == NULL)
+            KRATOS_THROW_ERROR(std::runtime_error, "The cast to WeightedFESpace is failed.", "")
+        pThisFESpace->SetWeights(Weights);
+    }
+
+    typename Patch<TDim>::VectorGridFunctionContainerType VectorGridFunctions_ = pPatch->VectorGridFunctions();
+    for (typename Patch<TDim>::VectorGridFunctionContainerType::iterator it = VectorGridFunctions_.begin();
+            it != VectorGridFunctions_.end(); ++it)
+    {
+        typename WeightedFESpace<TDim>::Pointer pThisFESpace = boost::dynamic_pointer_cast<WeightedFESpace<TDim> >((*it)->pFESpace());
+        if (pThisFESpace == NULL)
+            KRATOS_THROW_ERROR(std::runtime_error, "The cast to WeightedFESpace is failed.", "")
+        pThisFESpace->SetWeights(Weights);
+    }
+
+    if(echo_refinement)
+    {
+        std::cout << "Coarsen " << relation.Parents.size() << " basis functions (lvl: " << level << ") of patch " << pPatch->Id()
+                  << " completed, " << relation.RemovedChildren.size() << " children are removed, "
+                  << relation.KeptChildren.size() << " children are kept" << std::endl;
+        #ifdef ENABLE_PROFILING
+        std::cout << " Time to project the control values: " << time_1 << " s" << std::endl;
+        std::cout << " Time to rebuild the cells: " << time_2 << " s" << std::endl;
+        #endif
+    }
+
+    // coarsen also the matching basis functions of the neighbor patches
+    for (std::size_t i = 0; i < pPatch->NumberOfInterfaces(); ++i)
+    {
+        typename PatchInterface<TDim>::Pointer pInterface = pPatch->pInterface(i);
+
+        typename Patch<TDim>::Pointer pNeighborPatch = pInterface->pPatch2();
+
+        // extract the hierarchical B-Splines space
+        typename HBSplinesFESpace<TDim>::Pointer pNeighborFESpace = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pNeighborPatch->pFESpace());
+        if (pNeighborFESpace == NULL)
+            KRATOS_THROW_ERROR(std::runtime_error, "The cast to HBSplinesFESpace is failed.", "")
+
+        // the refined basis functions which share a removed child on the interface
+        std::vector<bf_t> neighbor_bfs;
+        for (refined_bf_iterator it = pNeighborFESpace->refined_bf_begin(); it != pNeighborFESpace->refined_bf_end(); ++it)
+        {
+            if (it->second->Level() != level) continue;
+            for (typename BasisFunctionType::bf_iterator it_child = it->second->bf_begin(); it_child != it->second->bf_end(); ++it_child)
+            {
+                if (removed_equation_ids.find((*it_child)->EquationId()) != removed_equation_ids.end())
+                {
+                    neighbor_bfs.push_back(it->second);
+                    break;
+                }
+            }
+        }
+
+        if (neighbor_bfs.size() > 0)
+        {
+            if(echo_refinement)
+                std::cout << "Neighbor patch " << pNeighborPatch->Id() << " of patch " << pPatch->Id() << " will be coarsened" << std::endl;
+
+            Coarsen(pNeighborPatch, neighbor_bfs, coarsened_patches, echo_level);
+        }
+    }
+}
+
+template<int TDim>
+inline void HBSplinesRefinementUtility_Helper<TDim>::CoarsenWindow(typename Patch<TDim>::Pointer pPatch,
+        const std::vector<std::vector<double> >& window, const int& echo_level)
+{
+    if (pPatch->pFESpace()->Type() != HBSplinesFESpace<TDim>::StaticType())
+        KRATOS_THROW_ERROR(std::logic_error, __FUNCTION__, "only support the hierarchical B-Splines patch")
+
+    // Type definitions
+    typedef typename HBSplinesFESpace<TDim>::refined_bf_iterator refined_bf_iterator;
+
+    // extract the hierarchical B-Splines space
+    typename HBSplinesFESpace<TDim>::Pointer pFESpace = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatch->pFESpace());
+    if (pFESpace == NULL)
+        KRATOS_THROW_ERROR(std::runtime_error, "The cast to HBSplinesFESpace is failed.", "")
+
+    if (IsogeometricEcho::Has(echo_level, ECHO_REFINEMENT))
+    {
+        std::cout << "coarsen window:";
+        for (std::size_t i = 0; i < window.size(); ++i)
+        {
+            std::cout << " [";
+            for (std::size_t j = 0; j < window[i].size(); ++j)
+                std::cout << " " << window[i][j];
+            std::cout << "]";
+        }
+        std::cout << std::endl;
+    }
+
+    // search all refined basis functions on all level which support is contained in the coarsening domain
+    std::vector<bf_t> bf_list;
+    for (refined_bf_iterator it = pFESpace->refined_bf_begin(); it != pFESpace->refined_bf_end(); ++it)
+    {
+        std::vector<double> bounding_box;
+        for (std::size_t dim = 0; dim < TDim; ++dim)
+        {
+            bounding_box.push_back(it->second->LocalKnots(dim).front()->Value());
+            bounding_box.push_back(it->second->LocalKnots(dim).back()->Value());
+        }
+
+        if( PBBSplinesBasisFunction_Helper<TDim>::CheckBoundingBox(bounding_box, window) )
+            bf_list.push_back(it->second);
+    }
+
+    // coarsen all the found basis functions, from the finest level
+    Coarsen(pPatch, bf_list, echo_level);
+
+    if (pPatch->pParentMultiPatch() != NULL)
+        pPatch->pParentMultiPatch()->Enumerate();
+}
+
+/// Project the values of a variable on the removed children to the parents, in the least-squares sense, and keep the
+/// remainder on the kept children. The components are projected separately.
+template<int TDim>
+template<class TVariableType>
+inline void HBSplinesRefinementUtility_Helper<TDim>::CoarsenValues(const TwoScaleRelation& rRelation, const TVariableType& rVariable)
+{
+    typedef typename TVariableType::Type DataType;
+    typedef HBSplinesRefinementUtility_Value_Helper<DataType> ValueHelper;
+
+    if (rRelation.RemovedChildren.size() == 0)
+        return;
+
+    const std::size_t nparents = rRelation.Parents.size();
+    const std::size_t ncomponents = ValueHelper::Size(rRelation.RemovedChildren[0]->GetValue(rVariable));
+    for (std::size_t i = 0; i < nparents; ++i)
+        ValueHelper::Resize(rRelation.Parents[i]->GetValue(rVariable), ncomponents);
+
+    std::vector<double> rhs(nparents), x(nparents);
+    for (std::size_t k = 0; k < ncomponents; ++k)
+    {
+        std::fill(rhs.begin(), rhs.end(), 0.0);
+        for (std::size_t i = 0; i < rRelation.RemovedChildren.size(); ++i)
+        {
+            const double v = ValueHelper::Component(rRelation.RemovedChildren[i]->GetValue(rVariable), k);
+            for (std::size_t j = 0; j < rRelation.RemovedRows[i].size(); ++j)
+                rhs[rRelation.RemovedRows[i][j].first] += rRelation.RemovedRows[i][j].second * v;
+        }
+
+        SolveNormalEquations(rRelation.Normal, rhs, x);
+
+        for (std::size_t i = 0; i < nparents; ++i)
+            ValueHelper::Component(rRelation.Parents[i]->GetValue(rVariable), k) = x[i];
+
+        for (std::size_t i = 0; i < rRelation.KeptChildren.size(); ++i)
+        {
+            double& v = ValueHelper::Component(rRelation.KeptChildren[i]->GetValue(rVariable), k);
+            for (std::size_t j = 0; j < rRelation.KeptRows[i].size(); ++j)
+                v -= rRelation.KeptRows[i][j].second * x[rRelation.KeptRows[i][j].first];
+        }
+    }
+}
+
+/// Solve the normal equations of the projection by the Jacobi preconditioned conjugate gradient. The matrix is symmetric
+/// positive definite, since every parent has at least one removed child.
+template<int TDim>
+inline void HBSplinesRefinementUtility_Helper<TDim>::SolveNormalEquations(const typename TwoScaleRelation::matrix_t& rNormal,
+        const std::vector<double>& rRhs, std::vector<double>& rX)
+{
+    const std::size_t n = rRhs.size();
+    rX.assign(n, 0.0);
+
+    double norm_b = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+        norm_b += rRhs[i] * rRhs[i];
+    norm_b = std::sqrt(norm_b);
+    if (norm_b == 0.0)
+        return;
+
+    std::vector<double> d(n, 1.0), r(rRhs), z(n), p(n), q(n);
+    for (std::size_t i = 0; i < n; ++i)
+        for (std::size_t j = 0; j < rNormal[i].size(); ++j)
+            if (rNormal[i][j].first == i)
+                d[i] = rNormal[i][j].second;
+
+    double rz = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        z[i] = r[i] / d[i];
+        p[i] = z[i];
+        rz += r[i] * z[i];
+    }
+
+    const std::size_t max_iterations = 10*n + 100;
+    for (std::size_t it = 0; it < max_iterations; ++it)
+    {
+        double pq = 0.0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            q[i] = 0.0;
+            for (std::size_t j = 0; j < rNormal[i].size(); ++j)
+                q[i] += rNormal[i][j].second * p[rNormal[i][j].first];
+            pq += p[i] * q[i];
+        }
+
+        const double alpha = rz / pq;
+        double norm_r = 0.0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            rX[i] += alpha * p[i];
+            r[i] -= alpha * q[i];
+            norm_r += r[i] * r[i];
+        }
+
+        if (std::sqrt(norm_r) < 1.0e-14 * norm_b)
+            break;
+
+        double rz_new = 0.0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            z[i] = r[i] / d[i];
+            rz_new += r[i] * z[i];
+        }
+
+        const double beta = rz_new / rz;
+        rz = rz_new;
+        for (std::size_t i = 0; i < n; ++i)
+            p[i] = z[i] + beta * p[i];
+    }
+}
+
+template<int TDim>
+inline void HBSplinesRefinementUtility_Helper<TDim>::LinearDependencyRefine(typename Patch<TDim>::Pointer pPatch, const std::size_t& refine_cycle, const int& echo_level)
+{
+    if (pPatch->pFESpace()->Type() != HBSplinesFESpace<TDim>::StaticType())
+        KRATOS_THROW_ERROR(std::logic_error, __FUNCTION__, "only support the hierarchical B-Splines patch")
+
+    // Type definitions
+    typedef typename HBSplinesFESpace<TDim>::bf_t bf_t;
+    typedef typename HBSplinesFESpace<TDim>::bf_container_t bf_container_t;
+    typedef typename HBSplinesFESpace<TDim>::CellType CellType;
+    typedef typename HBSplinesFESpace<TDim>::cell_t cell_t;
+    typedef typename HBSplinesFESpace<TDim>::cell_container_t cell_container_t;
+    typedef typename Patch<TDim>::ControlPointType ControlPointType;
+
+    // extract the hierarchical B-Splines space
+    typename HBSplinesFESpace<TDim>::Pointer pFESpace = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatch->pFESpace());
+    if (pFESpace == NULL)
+        KRATOS_THROW_ERROR(std::runtime_error, "The cast to HBSplinesFESpace is failed.", "")
+
+    if(pFESpace->LastLevel() < 1) return;
+
+    #ifdef ENABLE_PROFILING
+    double start = OpenMPUtils::GetCurrentTime();
+    #endif
+
+    bool echo_refinement = IsogeometricEcho::Has(echo_level, ECHO_REFINEMENT);
+
+    // A bf of level l is refined if its support is contained in the union of the supports of the bfs of the finer levels.
+    // The cells of a bf partition its support and the cells do not overlap, hence this is the case if and only if each cell
+    // of the bf is of a finer level and is in the support of a bf of a finer level. The cell-bf incidence is maintained
+    // by the refinement, hence the check is local to the bf.
+    //
+    // The refinement of the bfs of a level l does not change the union of the supports of the levels up to l, since the
+    // children of a bf cover its support. Hence the levels are checked from the coarsest one. After the bfs of level l are
+    // refined, only the bfs of level l sharing a cell with the new bfs may become covered, and only those are checked again.
+    // The bfs are grouped by level once; the new bfs are the ones with Id larger than the last Id before the refinement.
+    std::size_t cycle = refine_cycle;
+    const std::size_t last_level = pFESpace->LastLevel();
+
+    std::map<std::size_t, bf_container_t> level_bfs;
+    for(typename bf_container_t::iterator it_bf = pFESpace->bf_begin(); it_bf != pFESpace->bf_end(); ++it_bf)
+        level_bfs[(*it_bf)->Level()].insert(*it_bf);
+
+    for(std::size_t level = 1; level < last_level; ++level)
+    {
+        bf_container_t candidates = level_bfs[level];
+
+        while(candidates.size() != 0)
+        {
+            // refine based on the rule that if a bf has support domain contained in next level, it must be refined
+            std::vector<bf_t> refined_bfs;
+            for(typename bf_container_t::iterator it_bf = candidates.begin(); it_bf != candidates.end(); ++it_bf)
+            {
+                bool is_covered = true;
+                for(typename HBSplinesFESpace<TDim>::BasisFunctionType::cell_iterator it_cell = (*it_bf)->cell_begin();
+                        it_cell != (*it_bf)->cell_end() && is_covered; ++it_cell)
+                {
+                    if((*it_cell)->Level() <= level)
+                    {
+                        is_covered = false;
+                        break;
+                    }
+
+                    is_covered = false;
+                    for(typename CellType::bf_iterator it_cell_bf = (*it_cell)->bf_begin(); it_cell_bf != (*it_cell)->bf_end(); ++it_cell_bf)
+                    {
+                        // the bfs removed by a previous refinement are skipped
+                        bf_t p_cell_bf = it_cell_bf->lock();
+                        if(p_cell_bf == NULL)
+                            continue;
+
+                        const std::size_t cell_bf_level = p_cell_bf->Level();
+                        if(cell_bf_level > level && cell_bf_level <= last_level)
+                        {
+                            is_covered = true;
+                            break;
+                        }
+                    }
+                }
+
+                if(is_covered)
+                    refined_bfs.push_back(*it_bf);
+            }
+
+            candidates.clear();
+
+            if(refined_bfs.size() == 0)
+                break;
+
+            if(echo_refinement)
+            {
+                std::cout << "Additional Bf of patch " << pPatch->Id() << ":";
+                for(std::size_t i = 0; i < refined_bfs.size(); ++i)
+                    std::cout << " " << refined_bfs[i]->Id();
+                std::cout << " of level " << level << " will be refined to maintain the linear independence ..." << std::endl;
+            }
+
+            const std::size_t last_id = pFESpace->LastId();
+            Refine(pPatch, refined_bfs, echo_level);
+            pPatch->pParentMultiPatch()->Enumerate();
+
             for(std::size_t i = 0; i < refined_bfs.size(); ++i)
+                level_bfs[level].erase(refined_bfs[i]);
+
+            // index the new bfs, which are at the end of the container, and collect the bfs of this level sharing a cell with them
+            typename bf_container_t::iterator it_bf = pFESpace->bf_end();
+            while(it_bf != pFESpace->bf_begin())
             {
-                Refine(pPatch, refined_bfs[i], echo_level);
-                pPatch->pParentMultiPatch()->Enumerate();
+                --it_bf;
+                if((*it_bf)->Id() <= last_id)
+                    break;
+
+                level_bfs[(*it_bf)->Level()].insert(*it_bf);
+
+                for(typename HBSplinesFESpace<TDim>::BasisFunctionType::cell_iterator it_cell = (*it_bf)->cell_begin(); it_cell != (*it_bf)->cell_end(); ++it_cell)
+                {
+                    for(typename CellType::bf_iterator it_cell_bf = (*it_cell)->bf_begin(); it_cell_bf != (*it_cell)->bf_end(); ++it_cell_bf)
+                    {
+                        bf_t p_cell_bf = it_cell_bf->lock();
+                        if(p_cell_bf != NULL && p_cell_bf->Level() == level)
+                            candidates.insert(p_cell_bf);
+                    }
+                }
             }
 
-            // perform another round to make sure all bfs has support domain in the domain manager of each level
-            LinearDependencyRefine(pPatch, refine_cycle + 1, echo_level);
+            #ifdef ENABLE_PROFILING
+            std::cout << "LinearDependencyRefine cycle " << cycle << " completed: " << OpenMPUtils::GetCurrentTime() - start << " s" << std::endl;
+            start = OpenMPUtils::GetCurrentTime();
+            #else
+            std::cout << "LinearDependencyRefine cycle " << cycle << " completed" << std::endl;
+            #endif
+            ++cycle;
         }
     }
 
     #ifdef ENABLE_PROFILING
-    std::cout << "LinearDependencyRefine cycle " << refine_cycle << " completed: " << OpenMPUtils::GetCurrentTime() - start << " s" << std::endl;
+    std::cout << "LinearDependencyRefine cycle " << cycle << " completed: " << OpenMPUtils::GetCurrentTime() - start << " s" << std::endl;
     #else
-    std::cout << "LinearDependencyRefine cycle " << refine_cycle << " completed" << std::endl;
+    std::cout << "LinearDependencyRefine cycle " << cycle << " completed" << std::endl;
     #endif
 }
 
+template<int TDim>
+inline void HBSplinesRefinementUtility_Helper<TDim>::SetTruncation(typename Patch<TDim>::Pointer pPatch, const bool& IsTruncated)
+{
+    if (pPatch->pFESpace()->Type() != HBSplinesFESpace<TDim>::StaticType())
+        KRATOS_THROW_ERROR(std::logic_error, __FUNCTION__, "only support the hierarchical B-Splines patch")
+
+    // Type definitions
+    typedef typename HBSplinesFESpace<TDim>::bf_t bf_t;
+    typedef typename HBSplinesFESpace<TDim>::bf_container_t bf_container_t;
+    typedef typename Patch<TDim>::ControlPointType ControlPointType;
+
+    // extract the hierarchical B-Splines space
+    typename HBSplinesFESpace<TDim>::Pointer pFESpace = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatch->pFESpace());
+    if (pFESpace == NULL)
+        KRATOS_THROW_ERROR(std::runtime_error, "The cast to HBSplinesFESpace is failed.", "")
+
+    if (pFESpace->IsTruncated() == IsTruncated) return;
+
+    std::map<std::size_t, std::vector<std::pair<bf_t, double> > > coefficients;
+    pFESpace->ComputeTruncationCoefficients(coefficients);
+
+    // get the list of variables in the patch
+    std::vector<Variable<double>*> double_variables = pPatch->template ExtractVariables<Variable<double> >();
+    std::vector<Variable<array_1d<double, 3> >*> array_1d_variables = pPatch->template ExtractVariables<Variable<array_1d<double, 3> > >();
+    std::vector<Variable<Vector>*> vector_variables = pPatch->template ExtractVariables<Variable<Vector> >();
+
+    std::vector<std::vector<bf_t> > level_bfs(pFESpace->LastLevel() + 1);
+    for(typename bf_container_t::iterator it_bf = pFESpace->bf_begin(); it_bf != pFESpace->bf_end(); ++it_bf)
+        if((*it_bf)->Level() <= pFESpace->LastLevel())
+            level_bfs[(*it_bf)->Level()].push_back(*it_bf);
+
+    // c'_f = c_f + sum a_f * c'_b, where b are the coarser bfs. The THB coefficients are computed from the coarsest level,
+    // the HB ones from the finest level, so that c'_b is available when it is used.
+    const double sign = IsTruncated ? 1.0 : -1.0;
+    for(std::size_t i = 0; i < level_bfs.size(); ++i)
+    {
+        const std::size_t level = IsTruncated ? i : level_bfs.size() - 1 - i;
+        for(std::size_t i_bf = 0; i_bf < level_bfs[level].size(); ++i_bf)
+        {
+            const bf_t& p_bf = level_bfs[level][i_bf];
+
+            typename std::map<std::size_t, std::vector<std::pair<bf_t, double> > >::iterator it_coeff = coefficients.find(p_bf->Id());
+            if (it_coeff == coefficients.end()) continue;
+
+            for(std::size_t j = 0; j < it_coeff->second.size(); ++j)
+            {
+                const bf_t& p_coarse_bf = it_coeff->second[j].first;
+                const double a = sign * it_coeff->second[j].second;
+
+                ControlPointType& rC = p_bf->GetValue(CONTROL_POINT);
+                rC += a * p_coarse_bf->GetValue(CONTROL_POINT);
+
+                for (std::size_t k = 0; k < double_variables.size(); ++k)
+                    p_bf->GetValue(*double_variables[k]) += a * p_coarse_bf->GetValue(*double_variables[k]);
+
+                for (std::size_t k = 0; k < array_1d_variables.size(); ++k)
+                {
+                    if (*(array_1d_variables[k]) == CONTROL_POINT_COORDINATES) continue;
+                    noalias(p_bf->GetValue(*array_1d_variables[k])) += a * p_coarse_bf->GetValue(*array_1d_variables[k]);
+                }
+
+                for (std::size_t k = 0; k < vector_variables.size(); ++k)
+                    noalias(p_bf->GetValue(*vector_variables[k])) += a * p_coarse_bf->GetValue(*vector_variables[k]);
+            }
+        }
+    }
+
+    pFESpace->SetTruncated(IsTruncated);
+
+    // update the weight information for all the grid functions (except the control point grid function)
+    std::vector<double> Weights = pFESpace->GetWeights();
+
+    typename Patch<TDim>::DoubleGridFunctionContainerType DoubleGridFunctions_ = pPatch->DoubleGridFunctions();
+    for (typename Patch<TDim>::DoubleGridFunctionContainerType::iterator it = DoubleGridFunctions_.begin();
+            it != DoubleGridFunctions_.end(); ++it)
+    {
+        typename WeightedFESpace<TDim>::Pointer pThisFESpace = boost::dynamic_pointer_cast<WeightedFESpace<TDim> >((*it)->pFESpace());
+        if (pThisFESpace == NULL)
+            KRATOS_THROW_ERROR(std::runtime_error, "The cast to WeightedFESpace is failed.", "")
+        pThisFESpace->SetWeights(Weights);
+    }
+
+    typename Patch<TDim>::Array1DGridFunctionContainerType Array1DGridFunctions_ = pPatch->Array1DGridFunctions();
+    for (typename Patch<TDim>::Array1DGridFunctionContainerType::iterator it = Array1DGridFunctions_.begin();
+            it != Array1DGridFunctions_.end(); ++it)
+    {
+        typename WeightedFESpace<TDim>::Pointer pThisFESpace = boost::dynamic_pointer_cast<WeightedFESpace<TDim> >((*it)->pFESpace());
+        if (pThisFESpace == NULL)
+            KRATOS_THROW_ERROR(std::runtime_error, "The cast to WeightedFESpace is failed.", "")
+        pThisFESpace->SetWeights(Weights);
+    }
+
+    typename Patch<TDim>::VectorGridFunctionContainerType VectorGridFunctions_ = pPatch->VectorGridFunctions();
+    for (typename Patch<TDim>::VectorGridFunctionContainerType::iterator it = VectorGridFunctions_.begin();
+            it != VectorGridFunctions_.end(); ++it)
+    {
+        typename WeightedFESpace<TDim>::Pointer pThisFESpace = boost::dynamic_pointer_cast<WeightedFESpace<TDim> >((*it)->pFESpace());
+        if (pThisFESpace == NULL)
+            KRATOS_THROW_ERROR(std::runtime_error, "The cast to WeightedFESpace is failed.", "")
+        pThisFESpace->SetWeights(Weights);
+    }
+}
+
+/// Transform the truncated patches which can be refined together with pPatch, i.e. the patches of the same multipatch,
+/// to the HB representation, since the refinement transfers the control values by the HB two-scale relation
+/// The transformed patches are appended one by one, hence they can be transformed back if a transformation fails.
+template<int TDim>
+inline void HBSplinesRefinementUtility_Helper<TDim>::SuspendTruncation(typename Patch<TDim>::Pointer pPatch,
+        std::vector<typename Patch<TDim>::Pointer>& pTruncatedPatches)
+{
+    std::vector<typename Patch<TDim>::Pointer> pPatches;
+    typename MultiPatch<TDim>::Pointer pMultiPatch = pPatch->pParentMultiPatch();
+    if (pMultiPatch != NULL)
+    {
+        for (typename MultiPatch<TDim>::patch_ptr_iterator it = pMultiPatch->Patches().ptr_begin(); it != pMultiPatch->Patches().ptr_end(); ++it)
+            pPatches.push_back(*it);
+    }
+    else
+        pPatches.push_back(pPatch);
+
+    for (std::size_t i = 0; i < pPatches.size(); ++i)
+    {
+        if (pPatches[i]->pFESpace()->Type() != HBSplinesFESpace<TDim>::StaticType()) continue;
+
+        typename HBSplinesFESpace<TDim>::Pointer pFESpace = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatches[i]->pFESpace());
+        if (pFESpace->IsTruncated())
+        {
+            SetTruncation(pPatches[i], false);
+            pTruncatedPatches.push_back(pPatches[i]);
+        }
+    }
+}
+
+/// Transform the patches back to the THB representation after the refinement
+template<int TDim>
+inline void HBSplinesRefinementUtility_Helper<TDim>::ResumeTruncation(const std::vector<typename Patch<TDim>::Pointer>& pPatches)
+{
+    for (std::size_t i = 0; i < pPatches.size(); ++i)
+        SetTruncation(pPatches[i], true);
+}
+
 } // namespace Kratos.
 
 #undef ENABLE_PROFILING
@@ -0,0 +1,200 @@
+//
+//   Project Name:        Kratos
+//   Last Modified by:    $Author: hbui $
+//   Date:                $Date: 18 Oct 2026 $
+//   Revision:            $Revision: 1.0 $
+//
+//
+
+#if !defined(KRATOS_ISOGEOMETRIC_APPLICATION_HBSPLINES_TWO_SCALE_RELATION_CACHE_H_INCLUDED )
+#define  KRATOS_ISOGEOMETRIC_APPLICATION_HBSPLINES_TWO_SCALE_RELATION_CACHE_H_INCLUDED
+
+// System includes
+#include <cmath>
+#include <map>
+#include <vector>
+#include <atomic>
+#include <iostream>
+
+// External includes
+
+// Project includes
+#include "includes/define.h"
+#include "custom_utilities/bspline_utils.h"
+
+namespace Kratos
+{
+
+/**
+Cache of the univariate two-scale relations of the B-Splines, i.e. the coefficients of the children of a B-Splines
+obtained by inserting knots in its local knot vector. The coefficients are invariant to the translation and the
+scaling of the knots, hence a relation is identified by the order and the local and inserted knots normalized to
+[0, 1]. In a hierarchical mesh only a few such patterns exist in each direction. The relation of a multivariate
+B-Splines is the tensor product of the relations of each direction; it is kept in this factored form and the
+coefficient of a child is the product of the factors of its indices.
+The lookups (Find, Insert, Get) may be called concurrently: the container is guarded by a named critical section and the
+counters are atomic. A relation is computed outside of the critical section, hence two threads may compute the same
+relation, and the first inserted one is kept. SetTolerance, clear and the assignment must not run concurrently with a lookup.
+ */
+class TwoScaleRelationCache
+{
+public:
+    /// Pointer definition
+    KRATOS_CLASS_POINTER_DEFINITION(TwoScaleRelationCache);
+
+    /// Type definitions
+    typedef std::vector<long long> key_t;
+    typedef std::map<key_t, Vector> relation_container_t;
+
+    /// Default constructor
+    TwoScaleRelationCache() : mTol(1.0e-10), mNumberOfHits(0), mNumberOfMisses(0)
+    {}
+
+    /// Copy constructor
+    TwoScaleRelationCache(const TwoScaleRelationCache& rOther)
+    : mTol(rOther.mTol), mRelations(rOther.mRelations), mNumberOfHits(rOther.NumberOfHits()), mNumberOfMisses(rOther.NumberOfMisses())
+    {}
+
+    /// Destructor
+    virtual ~TwoScaleRelationCache()
+    {}
+
+    /// Assignment operator
+    TwoScaleRelationCache& operator=(const TwoScaleRelationCache& rOther)
+    {
+        mTol = rOther.mTol;
+        mRelations = rOther.mRelations;
+        mNumberOfHits = rOther.NumberOfHits();
+        mNumberOfMisses = rOther.NumberOfMisses();
+        return *this;
+    }
+
+    /// Set the tolerance to identify the normalized knots. The cached relations are released.
+    void SetTolerance(const double& Tol)
+    {
+        mTol = Tol;
+        this->clear();
+    }
+
+    /// Get the tolerance to identify the normalized knots
+    const double& GetTolerance() const {return mTol;}
+
+    /// Compute the key of the relation of a B-Splines of the given order
+    key_t Key(const std::size_t& Order, const std::vector<double>& rLocalKnots, const std::vector<double>& rInsKnots) const
+    {
+        const double kmin = rLocalKnots.front();
+        double span = rLocalKnots.back() - kmin;
+        if (span < mTol) span = 1.0;
+
+        key_t key;
+        key.reserve(rLocalKnots.size() + rInsKnots.size() + 3);
+        key.push_back(Order);
+        key.push_back(rLocalKnots.size());
+        for (std::size_t i = 0; i < rLocalKnots.size(); ++i)
+            key.push_back(static_cast<long long>(std::floor((rLocalKnots[i] - kmin) / span / mTol + 0.5)));
+        key.push_back(rInsKnots.size());
+        for (std::size_t i = 0; i < rInsKnots.size(); ++i)
+            key.push_back(static_cast<long long>(std::floor((rInsKnots[i] - kmin) / span / mTol + 0.5)));
+        return key;
+    }
+
+    /// Find a cached relation. Return NULL if it is not cached.
+    const Vector* Find(const key_t& key)
+    {
+        const Vector* pCoefficients = NULL;
+
+        #pragma omp critical (TwoScaleRelationCache)
+        {
+            relation_container_t::const_iterator it = mRelations.find(key);
+            if (it != mRelations.end())
+                pCoefficients = &(it->second);
+        }
+
+        if (pCoefficients == NULL)
+            mNumberOfMisses.fetch_add(1, std::memory_order_relaxed);
+        else
+            mNumberOfHits.fetch_add(1, std::memory_order_relaxed);
+
+        return pCoefficients;
+    }
+
+    /// Add a relation computed outside, e.g. in parallel. If the relation is already cached, the cached one is kept.
+    /// The returned reference stays valid until the cache is cleared.
+    const Vector& Insert(const key_t& key, const Vector& rCoefficients)
+    {
+        const Vector* pCoefficients;
+
+        #pragma omp critical (TwoScaleRelationCache)
+        pCoefficients = &(mRelations.insert(std::make_pair(key, rCoefficients)).first->second);
+
+        return *pCoefficients;
+    }
+
+    /// Get the relation of a B-Splines, which is computed if it is not cached
+    const Vector& Get(const std::size_t& Order, const std::vector<double>& rLocalKnots, const std::vector<double>& rInsKnots)
+    {
+        key_t key = this->Key(Order, rLocalKnots, rInsKnots);
+        const Vector* pCoefficients = this->Find(key);
+        if (pCoefficients != NULL)
+            return *pCoefficients;
+
+        Vector Coefficients;
+        Compute(Coefficients, Order, rLocalKnots, rInsKnots);
+        return this->Insert(key, Coefficients);
+    }
+
+    /// Compute the relation of a B-Splines, i.e. the coefficients of its children in the order of the knots
+    static void Compute(Vector& rCoefficients, const std::size_t& Order, const std::vector<double>& rLocalKnots, const std::vector<double>& rInsKnots)
+    {
+        std::vector<double> new_knots;
+        BSplineUtils::ComputeBsplinesKnotInsertionCoefficients1DLocal(rCoefficients, new_knots, Order, rLocalKnots, rInsKnots);
+    }
+
+    /// Get the number of cached relations. It must not be called concurrently with a lookup.
+    std::size_t size() const {return mRelations.size();}
+
+    /// Release the cached relations
+    void clear()
+    {
+        mRelations.clear();
+        mNumberOfHits = 0;
+        mNumberOfMisses = 0;
+    }
+
+    /// Get the number of lookups which found a cached relation
+    std::size_t NumberOfHits() const {return mNumberOfHits.load(std::memory_order_relaxed);}
+
+    /// Get the number of lookups which did not find a cached relation
+    std::size_t NumberOfMisses() const {return mNumberOfMisses.load(std::memory_order_relaxed);}
+
+    /// Information
+    virtual void PrintInfo(std::ostream& rOStream) const
+    {
+        rOStream << "TwoScaleRelationCache";
+    }
+
+    virtual void PrintData(std::ostream& rOStream) const
+    {
+        rOStream << " Number of relations: " << mRelations.size() << ", hits: " << this->NumberOfHits() << ", misses: " << this->NumberOfMisses();
+    }
+
+private:
+
+    double mTol;
+    relation_container_t mRelations;
+    std::atomic<std::size_t> mNumberOfHits;
+    std::atomic<std::size_t> mNumberOfMisses;
+};
+
+/// output stream function
+inline std::ostream& operator <<(std::ostream& rOStream, const TwoScaleRelationCache& rThis)
+{
+    rThis.PrintInfo(rOStream);
+    rOStream << std::endl;
+    rThis.PrintData(rOStream);
+    return rOStream;
+}
+
+} // namespace Kratos.
+
+#endif // KRATOS_ISOGEOMETRIC_APPLICATION_HBSPLINES_TWO_SCALE_RELATION_CACHE_H_INCLUDED defined
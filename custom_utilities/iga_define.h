@@ -203,6 +203,12 @@ enum PostElementType
     _HEXAHEDRA_ = 3
 };
 
+enum CellSearchMethod
+{
+    _CELL_SEARCH_BRUTE_FORCE_ = 0,
+    _CELL_SEARCH_SPATIAL_INDEX_ = 1
+};
+
 /**
  * Helper struct to extract the pointer type
  * One case use typename Isogeometric_Pointer_Helper<TType>::Pointer as replacement for typename TType::Pointer
@@ -12,6 +12,7 @@
 // System includes
 #include <string>
 #include <vector>
+#include <map>
 #include <tuple>
 #include <iostream>
 
@@ -161,6 +162,14 @@ public:
         typedef typename TPatchType::DoubleGridFunctionContainerType DoubleGridFunctionContainerType;
         typedef typename TPatchType::Array1DGridFunctionContainerType Array1DGridFunctionContainerType;
         typedef typename TPatchType::VectorGridFunctionContainerType VectorGridFunctionContainerType;
+        typedef typename TPatchType::FESpaceType FESpaceType;
+
+        std::vector<double> xi(TPatchType::FESpaceType::Dim());
+        for (std::size_t dim = 0; dim < xi.size(); ++dim)
+            xi[dim] = p_ref[dim];
+
+        // each grid function is evaluated with its own FESpace, the basis functions are evaluated once per FESpace
+        std::map<const FESpaceType*, ActiveBasisValuesType> basis_values;
 
         // transfer the control values
         DoubleGridFunctionContainerType DoubleGridFunctions_ = rPatch.DoubleGridFunctions();
@@ -173,7 +182,9 @@ public:
             if (KratosComponents<VariableData>::Has(var_name))
             {
                 VariableType* pVariable = dynamic_cast<VariableType*>(&KratosComponents<VariableData>::Get(var_name));
-                DataType value = (*it_gf)->GetValue(p_ref);
+                const ActiveBasisValuesType& f = GetActiveBasisValues(basis_values, *(*it_gf)->pFESpace(), xi);
+                DataType value;
+                (*it_gf)->GetValue(value, f.first, f.second);
                 if (rNode.SolutionStepsDataHas(*pVariable))
                     rNode.GetSolutionStepValue(*pVariable) = value;
             }
@@ -190,7 +201,9 @@ public:
             if (KratosComponents<VariableData>::Has(var_name))
             {
                 VariableType* pVariable = dynamic_cast<VariableType*>(&KratosComponents<VariableData>::Get(var_name));
-                DataType value = (*it_gf)->GetValue(p_ref);
+                const ActiveBasisValuesType& f = GetActiveBasisValues(basis_values, *(*it_gf)->pFESpace(), xi);
+                DataType value;
+                (*it_gf)->GetValue(value, f.first, f.second);
                 if (rNode.SolutionStepsDataHas(*pVariable))
                     rNode.GetSolutionStepValue(*pVariable) = value;
             }
@@ -206,7 +219,9 @@ public:
             if (KratosComponents<VariableData>::Has(var_name))
             {
                 VariableType* pVariable = dynamic_cast<VariableType*>(&KratosComponents<VariableData>::Get(var_name));
-                DataType value = (*it_gf)->GetValue(p_ref);
+                const ActiveBasisValuesType& f = GetActiveBasisValues(basis_values, *(*it_gf)->pFESpace(), xi);
+                DataType value;
+                (*it_gf)->GetValue(value, f.first, f.second);
                 if (rNode.SolutionStepsDataHas(*pVariable))
                     rNode.GetSolutionStepValue(*pVariable) = value;
             }
@@ -1084,6 +1099,23 @@ private:
     ///@name Private Operations
     ///@{
 
+    /// The indices and the values of the active basis functions at a point
+    typedef std::pair<std::vector<std::size_t>, std::vector<double> > ActiveBasisValuesType;
+
+    /// Get the active basis functions of the FESpace at xi. They are only evaluated at the first request for the FESpace.
+    template<class TFESpaceType>
+    static const ActiveBasisValuesType& GetActiveBasisValues(std::map<const TFESpaceType*, ActiveBasisValuesType>& rCache,
+        const TFESpaceType& rFESpace, const std::vector<double>& xi)
+    {
+        typename std::map<const TFESpaceType*, ActiveBasisValuesType>::iterator it = rCache.find(&rFESpace);
+        if (it == rCache.end())
+        {
+            it = rCache.insert(std::make_pair(&rFESpace, ActiveBasisValuesType())).first;
+            rFESpace.GetActiveValues(it->second.first, it->second.second, xi);
+        }
+        return it->second;
+    }
+
     ///@}
     ///@name Un accessible methods
     ///@{
@@ -0,0 +1,271 @@
+//
+//   Project Name:        Kratos
+//   Last Modified by:    $Author: hbui $
+//   Date:                $Date: 18 Oct 2026 $
+//   Revision:            $Revision: 1.0 $
+//
+//
+
+#if !defined(KRATOS_ISOGEOMETRIC_APPLICATION_MEMORY_POOL_H_INCLUDED )
+#define  KRATOS_ISOGEOMETRIC_APPLICATION_MEMORY_POOL_H_INCLUDED
+
+// System includes
+#include <new>
+#include <vector>
+#include <limits>
+#include <utility>
+#include <iostream>
+
+// External includes
+#include <omp.h>
+#include <boost/make_shared.hpp>
+
+// Project includes
+#include "includes/define.h"
+
+namespace Kratos
+{
+
+/**
+A pool of memory blocks for the small objects of a space (cells, knots, basis functions, ...). The blocks of the same size
+are taken from large chunks and recycled through a free list, hence creating and destroying many small objects does not
+go to the system heap. The chunks are released all together when the pool is destroyed. The pool is thread-safe.
+The objects are usually created by MemoryPool::Create, which puts the object and its reference count in one block; the
+allocator in the reference count keeps the pool alive until the last object is destroyed.
+ */
+class MemoryPool
+{
+public:
+    /// Pointer definition
+    KRATOS_CLASS_POINTER_DEFINITION(MemoryPool);
+
+    /// Default constructor
+    MemoryPool() : mNumberOfAllocations(0), mNumberOfDeallocations(0), mMemoryUsage(0)
+    {
+        omp_init_lock(&mLock);
+    }
+
+    /// Destructor
+    virtual ~MemoryPool()
+    {
+        for (std::size_t i = 0; i < mChunks.size(); ++i)
+            ::operator delete(mChunks[i]);
+        omp_destroy_lock(&mLock);
+    }
+
+    /// Allocate a block of the given size
+    void* Allocate(const std::size_t& size)
+    {
+        const std::size_t block_size = BlockSize(size);
+        if (block_size > MaxBlockSize)
+            return ::operator new(size);
+
+        omp_set_lock(&mLock);
+
+        SizeClass& rClass = this->GetSizeClass(block_size);
+        if (rClass.pFreeList == NULL)
+            this->AddChunk(rClass);
+
+        void* p = rClass.pFreeList;
+        rClass.pFreeList = *static_cast<void**>(p);
+        ++mNumberOfAllocations;
+
+        omp_unset_lock(&mLock);
+
+        return p;
+    }
+
+    /// Return a block of the given size to the pool
+    void Deallocate(void* p, const std::size_t& size)
+    {
+        const std::size_t block_size = BlockSize(size);
+        if (block_size > MaxBlockSize)
+        {
+            ::operator delete(p);
+            return;
+        }
+
+        omp_set_lock(&mLock);
+
+        SizeClass& rClass = this->GetSizeClass(block_size);
+        *static_cast<void**>(p) = rClass.pFreeList;
+        rClass.pFreeList = p;
+        ++mNumberOfDeallocations;
+
+        omp_unset_lock(&mLock);
+    }
+
+    /// Create an object in the pool. If the pool is null, the object is created on the heap.
+    template<class T, typename... TArgs>
+    static boost::shared_ptr<T> Create(const MemoryPool::Pointer& pPool, TArgs&&... args);
+
+    /// Get the number of blocks taken from the pool
+    std::size_t NumberOfAllocations() const {return mNumberOfAllocations;}
+
+    /// Get the number of blocks returned to the pool
+    std::size_t NumberOfDeallocations() const {return mNumberOfDeallocations;}
+
+    /// Get the number of chunks allocated from the system heap
+    std::size_t NumberOfChunks() const {return mChunks.size();}
+
+    /// Get the memory allocated from the system heap, in bytes
+    std::size_t MemoryUsage() const {return mMemoryUsage;}
+
+    /// Information
+    void PrintInfo(std::ostream& rOStream) const
+    {
+        rOStream << "MemoryPool, allocations = " << mNumberOfAllocations << ", deallocations = " << mNumberOfDeallocations
+                 << ", chunks = " << mChunks.size() << ", memory = " << mMemoryUsage << " bytes";
+    }
+
+    void PrintData(std::ostream& rOStream) const
+    {
+    }
+
+private:
+
+    static const std::size_t Alignment = 16;
+    static const std::size_t MaxBlockSize = 1024;
+    static const std::size_t MinBlocksPerChunk = 16;
+    static const std::size_t MaxBlocksPerChunk = 4096;
+
+    struct SizeClass
+    {
+        std::size_t BlockSize;
+        std::size_t BlocksPerChunk;
+        void* pFreeList;
+    };
+
+    omp_lock_t mLock;
+    std::vector<SizeClass> mSizeClasses;
+    std::vector<void*> mChunks;
+    std::size_t mNumberOfAllocations;
+    std::size_t mNumberOfDeallocations;
+    std::size_t mMemoryUsage;
+
+    static std::size_t BlockSize(const std::size_t& size)
+    {
+        std::size_t block_size = ((size + Alignment - 1) / Alignment) * Alignment;
+        return (block_size == 0) ? Alignment : block_size;
+    }
+
+    /// Get the size class of the block size. There are only a few object types per pool, hence a linear search is enough.
+    SizeClass& GetSizeClass(const std::size_t& block_size)
+    {
+        for (std::size_t i = 0; i < mSizeClasses.size(); ++i)
+            if (mSizeClasses[i].BlockSize == block_size)
+                return mSizeClasses[i];
+
+        SizeClass new_class;
+        new_class.BlockSize = block_size;
+        new_class.BlocksPerChunk = MinBlocksPerChunk;
+        new_class.pFreeList = NULL;
+        mSizeClasses.push_back(new_class);
+        return mSizeClasses.back();
+    }
+
+    /// Allocate a new chunk and thread its blocks into the free list. The chunk size grows geometrically.
+    void AddChunk(SizeClass& rClass)
+    {
+        const std::size_t nblocks = rClass.BlocksPerChunk;
+        char* chunk = static_cast<char*>(::operator new(nblocks * rClass.BlockSize));
+        mChunks.push_back(chunk);
+        mMemoryUsage += nblocks * rClass.BlockSize;
+
+        for (std::size_t i = 0; i < nblocks; ++i)
+        {
+            void* p = chunk + i * rClass.BlockSize;
+            *static_cast<void**>(p) = rClass.pFreeList;
+            rClass.pFreeList = p;
+        }
+
+        if (rClass.BlocksPerChunk < MaxBlocksPerChunk)
+            rClass.BlocksPerChunk *= 2;
+    }
+};
+
+/**
+Standard allocator which takes the memory from a MemoryPool
+ */
+template<class T>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template<class U>
+    struct rebind
+    {
+        typedef PoolAllocator<U> other;
+    };
+
+    /// Constructor with the pool
+    PoolAllocator(const MemoryPool::Pointer& pPool) : mpPool(pPool) {}
+
+    /// Copy constructor
+    template<class U>
+    PoolAllocator(const PoolAllocator<U>& rOther) : mpPool(rOther.pPool()) {}
+
+    pointer allocate(size_type n, const void* hint = 0)
+    {
+        return static_cast<pointer>(mpPool->Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        mpPool->Deallocate(p, n * sizeof(T));
+    }
+
+    template<class U, typename... TArgs>
+    void construct(U* p, TArgs&&... args)
+    {
+        ::new((void*)p) U(std::forward<TArgs>(args)...);
+    }
+
+    template<class U>
+    void destroy(U* p)
+    {
+        p->~U();
+    }
+
+    size_type max_size() const {return std::numeric_limits<size_type>::max() / sizeof(T);}
+
+    const MemoryPool::Pointer& pPool() const {return mpPool;}
+
+    template<class U>
+    bool operator==(const PoolAllocator<U>& rOther) const {return mpPool == rOther.pPool();}
+
+    template<class U>
+    bool operator!=(const PoolAllocator<U>& rOther) const {return mpPool != rOther.pPool();}
+
+private:
+
+    MemoryPool::Pointer mpPool;
+};
+
+template<class T, typename... TArgs>
+inline boost::shared_ptr<T> MemoryPool::Create(const MemoryPool::Pointer& pPool, TArgs&&... args)
+{
+    if (pPool == NULL)
+        return boost::shared_ptr<T>(new T(std::forward<TArgs>(args)...));
+    return boost::allocate_shared<T>(PoolAllocator<T>(pPool), std::forward<TArgs>(args)...);
+}
+
+/// output stream function
+inline std::ostream& operator <<(std::ostream& rOStream, const MemoryPool& rThis)
+{
+    rThis.PrintInfo(rOStream);
+    rOStream << std::endl;
+    rThis.PrintData(rOStream);
+    return rOStream;
+}
+
+}// namespace Kratos.
+
+#endif // KRATOS_ISOGEOMETRIC_APPLICATION_MEMORY_POOL_H_INCLUDED
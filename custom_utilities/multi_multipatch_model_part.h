@@ -416,7 +416,7 @@ private:
         // construct the cell manager out from the FESpaces
         typedef typename TFESpace::cell_container_t cell_container_t;
 
-        std::vector<typename cell_container_t::Pointer> pCellManagers;
+        std::vector<typename cell_container_t::ConstPointer> pCellManagers;
         for (std::size_t ip = 0; ip < pFESpaces.size(); ++ip)
             pCellManagers.push_back(pFESpaces[ip]->ConstructCellManager());
 
@@ -453,19 +453,20 @@ private:
         typename TEntityType::NodesArrayType temp_element_nodes;
         std::size_t cnt = starting_id;
         Vector dummy;
+        std::vector<std::size_t> local_ids;
         int max_integration_method = 1;
         if (p_temp_properties->Has(NUM_IGA_INTEGRATION_METHOD))
             max_integration_method = (*p_temp_properties)[NUM_IGA_INTEGRATION_METHOD];
 
         std::size_t ic = 0; // this is to mark the location of the iterator
-        for (typename cell_container_t::iterator it_dummy = pCellManagers[0]->begin(); it_dummy != pCellManagers[0]->end(); ++it_dummy)
+        for (typename cell_container_t::const_iterator it_dummy = pCellManagers[0]->begin(); it_dummy != pCellManagers[0]->end(); ++it_dummy)
         {
             std::vector<Element::GeometryType::Pointer> p_temp_geometries;
 
             // fill the vector of geometries
             for (std::size_t ip = 0; ip < pFESpaces.size(); ++ip)
             {
-                typename cell_container_t::iterator it_cell = pCellManagers[ip]->begin();
+                typename cell_container_t::const_iterator it_cell = pCellManagers[ip]->begin();
                 std::advance(it_cell, ic);
                 typename cell_container_t::cell_t pcell = *it_cell;
                 // KRATOS_WATCH(*pcell)
@@ -474,11 +475,12 @@ private:
                 temp_element_nodes.clear();
 
                 const std::vector<std::size_t>& anchors = pcell->GetSupportedAnchors();
+                pFESpaces[ip]->LocalIds(local_ids, anchors);
                 Vector weights(anchors.size());
                 for (std::size_t i = 0; i < anchors.size(); ++i)
                 {
                     temp_element_nodes.push_back(( *(MultiPatchUtility::FindKey(rNodes, CONVERT_INDEX_IGA_TO_KRATOS(anchors[i]), "Node").base())));
-                    weights[i] = pControlGrids[ip]->GetData(pFESpaces[ip]->LocalId(anchors[i])).W();
+                    weights[i] = pControlGrids[ip]->GetData(local_ids[i]).W();
                 }
 
                 if (echo_level > 1)
@@ -506,7 +508,7 @@ private:
                                                     dummy,
                                                     weights,
                                                     // pcell->GetExtractionOperator(),
-                                                    pcell->GetCompressedExtractionOperator(),
+                                                    pcell->pGetCompressedExtractionOperator(),
                                                     static_cast<int>(pFESpaces[ip]->Order(0)),
                                                     static_cast<int>(pFESpaces[ip]->Order(1)),
                                                     static_cast<int>(pFESpaces[ip]->Order(2)),
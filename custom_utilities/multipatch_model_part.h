@@ -366,16 +366,39 @@ public:
 
         // construct the cell manager out from the FESpace
         typedef typename TFESpace::cell_container_t cell_container_t;
-        typename cell_container_t::Pointer pCellManager = pFESpace->ConstructCellManager();
+        typename cell_container_t::ConstPointer pCellManager = pFESpace->ConstructCellManager();
 
         if (echo_level > 0)
         {
             #ifdef ENABLE_PROFILING
             std::cout << "  ++ ConstructCellManager: " << OpenMPUtils::GetCurrentTime()-start << " s" << std::endl;
-            start = OpenMPUtils::GetCurrentTime();
             #endif
         }
 
+        std::vector<typename cell_container_t::cell_t> cells(pCellManager->begin(), pCellManager->end());
+
+        return CreateEntitiesFromCells<TEntityType, TFESpace, TControlGridType, TNodeContainerType>(pFESpace, cells,
+                pControlPointGrid, rNodes, element_name, starting_id, p_temp_properties, echo_level);
+    }
+
+    /// Create entities (elements/conditions) from a list of cells of the FESpace, e.g. the cells changed by a refinement
+    /// @param pFESpace the finite element space which the cells belong to
+    /// @param cells the cells to create the entities; the anchors and extraction operators must be up-to-date
+    /// The other parameters are the same as CreateEntitiesFromFESpace. The entities are created in the order of the cells.
+    template<class TEntityType, class TFESpace, class TControlGridType, class TNodeContainerType>
+    static PointerVectorSet<TEntityType, IndexedObject> CreateEntitiesFromCells(typename TFESpace::ConstPointer pFESpace,
+        const std::vector<typename TFESpace::cell_container_t::cell_t>& cells,
+        typename TControlGridType::ConstPointer pControlPointGrid,
+        TNodeContainerType& rNodes, const std::string& element_name,
+        const std::size_t& starting_id, Properties::Pointer p_temp_properties,
+        const int& echo_level)
+    {
+        #ifdef ENABLE_PROFILING
+        double start = OpenMPUtils::GetCurrentTime();
+        #endif
+
+        typedef typename TFESpace::cell_container_t::cell_t cell_t;
+
         // container for newly created elements
         PointerVectorSet<TEntityType, IndexedObject> pNewElements;
 
@@ -395,22 +418,24 @@ public:
         typename IsogeometricGeometryType::Pointer p_temp_geometry;
         std::size_t cnt = starting_id;
         Vector dummy;
+        std::vector<std::size_t> local_ids;
         int max_integration_method = 1;
         if (p_temp_properties->Has(NUM_IGA_INTEGRATION_METHOD))
             max_integration_method = (*p_temp_properties)[NUM_IGA_INTEGRATION_METHOD];
 
-        for (typename cell_container_t::iterator it_cell = pCellManager->begin(); it_cell != pCellManager->end(); ++it_cell)
+        for (typename std::vector<cell_t>::const_iterator it_cell = cells.begin(); it_cell != cells.end(); ++it_cell)
         {
             // KRATOS_WATCH(*(*it_cell))
             // get new nodes
             temp_element_nodes.clear();
 
             const std::vector<std::size_t>& anchors = (*it_cell)->GetSupportedAnchors();
+            pFESpace->LocalIds(local_ids, anchors);
             Vector weights(anchors.size());
             for (std::size_t i = 0; i < anchors.size(); ++i)
             {
                 temp_element_nodes.push_back(( *(MultiPatchUtility::FindKey(rNodes, CONVERT_INDEX_IGA_TO_KRATOS(anchors[i]), "Node").base())));
-                weights[i] = pControlPointGrid->GetData(pFESpace->LocalId(anchors[i])).W();
+                weights[i] = pControlPointGrid->GetData(local_ids[i]).W();
             }
 
             if (echo_level > 1)
@@ -437,7 +462,7 @@ public:
                                                 dummy,
                                                 weights,
                                                 // (*it_cell)->GetExtractionOperator(),
-                                                (*it_cell)->GetCompressedExtractionOperator(),
+                                                (*it_cell)->pGetCompressedExtractionOperator(),
                                                 static_cast<int>(pFESpace->Order(0)),
                                                 static_cast<int>(pFESpace->Order(1)),
                                                 static_cast<int>(pFESpace->Order(2)),
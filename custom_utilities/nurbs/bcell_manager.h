@@ -12,30 +12,28 @@
 // System includes
 #include <string>
 #include <vector>
+#include <array>
 #include <set>
 #include <map>
+#include <atomic>
+#include <algorithm>
 #include <iostream>
 
 // External includes
 
 // Project includes
 #include "includes/define.h"
+#include "custom_utilities/iga_define.h"
 #include "custom_utilities/nurbs/knot.h"
 #include "custom_utilities/cell_container.h"
+#include "custom_utilities/memory_pool.h"
 
-// #define USE_BRUTE_FORCE_TO_SEARCH_FOR_CELLS
-#define USE_R_TREE_TO_SEARCH_FOR_CELLS
-
-#ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-#include "custom_external_libraries/RTree.h"
-#endif
+#include "custom_utilities/packed_rtree.h"
 
 
 namespace Kratos
 {
 
-bool BCellManager_RtreeSearchCallback(std::size_t id, void* arg);
-
 struct BCellManager_Helper
 {
     template<typename knot_t>
@@ -89,7 +87,7 @@ public:
     typedef typename cell_container_t::const_iterator const_iterator;
 
     /// Default constructor
-    BaseBCellManager() : mTol(1.0e-10), mLastId(0)
+    BaseBCellManager() : mLastId(0), mpMemoryPool(new MemoryPool()), mTol(1.0e-10), mSearchMethod(_CELL_SEARCH_SPATIAL_INDEX_), m_spatial_index_is_updated(true)
     {}
 
     /// Destructor
@@ -106,6 +104,15 @@ public:
     /// Get the tolerance for the internal searching algorithm
     const double& GetTolerance() const {return mTol;}
 
+    /// Get the memory pool where the cells created by this manager are allocated
+    MemoryPool::Pointer pMemoryPool() const {return mpMemoryPool;}
+
+    /// Set the algorithm to search for the cells in GetCells, either _CELL_SEARCH_SPATIAL_INDEX_ (default) or _CELL_SEARCH_BRUTE_FORCE_
+    void SetSearchMethod(const int& method) {mSearchMethod = method;}
+
+    /// Get the algorithm to search for the cells
+    const int& GetSearchMethod() const {return mSearchMethod;}
+
     /// Check if the cell exists in the list; otherwise create new cell and return
     virtual cell_t CreateCell(const std::vector<knot_t>& pKnots)
     {
@@ -136,11 +143,7 @@ public:
     /// Get a cell based on its Id
     cell_t get(const std::size_t& Id)
     {
-        // create the index map if it's not created yet
-        if(!cell_map_is_created)
-            this->CreateCellsMap();
-
-        // return the bf if its Id exist in the list
+        // return the cell if its Id exist in the list
         typename map_t::iterator it = mCellsMap.find(Id);
         if(it != mCellsMap.end())
             return it->second;
@@ -148,6 +151,12 @@ public:
             KRATOS_THROW_ERROR(std::runtime_error, "Access index is not found:", Id)
     }
 
+    /// Check if a cell with the Id exists
+    bool has(const std::size_t& Id) const
+    {
+        return mCellsMap.find(Id) != mCellsMap.end();
+    }
+
     /// Overload operator[]
     cell_t operator[](const std::size_t& Id)
     {
@@ -155,13 +164,13 @@ public:
     }
 
     /// Overload comparison operator
-    bool operator==(const BaseBCellManager<TCellType>& rOther)
+    bool operator==(const BaseBCellManager<TCellType>& rOther) const
     {
         if (this->size() != rOther.size())
             return false;
 
-        iterator it_this = this->begin();
-        iterator it_other = rOther.begin();
+        const_iterator it_this = this->begin();
+        const_iterator it_other = rOther.begin();
 
         while ((it_this != this->end()) && (it_other != rOther.end()))
         {
@@ -175,7 +184,7 @@ public:
     }
 
     /// Overload comparison operator
-    bool operator!=(const BaseBCellManager<TCellType>& rOther)
+    bool operator!=(const BaseBCellManager<TCellType>& rOther) const
     {
         return !(*this == rOther);
     }
@@ -186,20 +195,106 @@ public:
         KRATOS_THROW_ERROR(std::logic_error, "Calling the virtual function", __FUNCTION__)
     }
 
-    /// Collapse the overlapping cells
+    /// Search the cells covered in each cell of a list, i.e. cells[i] are all the cells covered by p_cells[i]. The
+    /// queries are run in parallel. The first query is done alone, since it brings the spatial index up to date; the
+    /// other queries do not modify the container.
+    void GetCells(std::vector<std::vector<cell_t> >& cells, const std::vector<cell_t>& p_cells)
+    {
+        cells.resize(p_cells.size());
+        if (p_cells.size() == 0)
+            return;
+
+        cells[0] = this->GetCells(p_cells[0]);
+
+        const int nqueries = static_cast<int>(p_cells.size());
+        #pragma omp parallel for
+        for (int i = 1; i < nqueries; ++i)
+            cells[i] = this->GetCells(p_cells[i]);
+    }
+
+    /// Search the cells containing the parametric point xi, sorted by Id. A point on the boundary between cells, within
+    /// the tolerance, is contained in all of them. An empty list is returned if xi lies outside of all the cells.
+    std::vector<cell_t> FindCells(const std::vector<double>& xi)
+    {
+        std::vector<cell_t> p_cells;
+
+        if (this->GetSearchMethod() == _CELL_SEARCH_BRUTE_FORCE_)
+        {
+            for(iterator it = mpCells.begin(); it != mpCells.end(); ++it)
+                if(this->IsInside(*it, xi))
+                    p_cells.push_back(*it);
+        }
+        else
+        {
+            double cmin[3], cmax[3];
+            for (std::size_t i = 0; i < 3; ++i)
+            {
+                const double v = (i < xi.size()) ? xi[i] : 0.0;
+                cmin[i] = v - mTol;
+                cmax[i] = v + mTol;
+            }
+            this->SearchOverlappingCells(cmin, cmax, p_cells);
+            std::sort(p_cells.begin(), p_cells.end(), cell_compare());
+        }
+
+        return p_cells;
+    }
+
+    /// Search the cells containing each point of a list, i.e. cells[i] are the cells containing points[i]. The points
+    /// shall be sorted (e.g. lexicographically, or along a line) so that the consecutive points fall in the same cell:
+    /// the cell found for a point is checked first for the next one, and the search is only repeated when the point is
+    /// not strictly inside that cell. It assumes that the cells do not overlap, e.g. after CollapseCells.
+    void FindCells(std::vector<std::vector<cell_t> >& cells, const std::vector<std::vector<double> >& points)
+    {
+        cells.resize(points.size());
+
+        cell_t p_last_cell;
+        for (std::size_t i = 0; i < points.size(); ++i)
+        {
+            if (p_last_cell != NULL && this->IsInterior(p_last_cell, points[i]))
+            {
+                cells[i].assign(1, p_last_cell);
+                continue;
+            }
+
+            cells[i] = this->FindCells(points[i]);
+            p_last_cell = (cells[i].size() == 1) ? cells[i][0] : cell_t();
+        }
+    }
+
+    /// Collapse the overlapping cells. The cells are visited once in the order of their Id; a cell which covers other
+    /// remaining cells is absorbed into them and then removed. The removals are done in bulk after the sweep. The result
+    /// is the same as repeatedly absorbing the first found overlapping cell and restarting the search, because the cells
+    /// visited before do not cover any remaining cell and removing cells cannot create new overlaps.
     void CollapseCells()
     {
-        bool hit;
-        do
+        std::set<std::size_t> collapsed_ids;
+        std::vector<cell_t> collapsed_cells;
+
+        for(iterator it_cell = this->begin(); it_cell != this->end(); ++it_cell)
         {
-            iterator it_cell = this->begin();
-            hit = this->CollapseCells(it_cell, this->end());
+            std::vector<cell_t> inner_cells = this->GetCells(*it_cell);
+
+            bool hit = false;
+            for (std::size_t i = 0; i < inner_cells.size(); ++i)
+            {
+                if (collapsed_ids.find(inner_cells[i]->Id()) != collapsed_ids.end())
+                    continue;
+
+                inner_cells[i]->Absorb(*it_cell);
+                hit = true;
+            }
+
             if (hit)
             {
                 (*it_cell)->ClearTrace();
-                this->erase(*it_cell);
+                collapsed_ids.insert((*it_cell)->Id());
+                collapsed_cells.push_back(*it_cell);
             }
-        } while (hit);
+        }
+
+        for (std::size_t i = 0; i < collapsed_cells.size(); ++i)
+            this->erase(collapsed_cells[i]);
     }
 
     /// Reset all the Id of all the basis functions. Remarks: use it with care, you have to be responsible to the old indexing data of the basis functions before calling this function
@@ -224,44 +319,167 @@ public:
 
 protected:
 
+    /// Key of a cell, i.e. the addresses of its knots [xi_min, xi_max, eta_min, eta_max, zeta_min, zeta_max]. The knots of the
+    /// unused directions (e.g. eta and zeta in 1D) are null. Two cells are the same only if they are spanned by the same knots,
+    /// hence the key does not depend on the knot values nor on the tolerance.
+    typedef typename CellType::KnotType KnotType;
+    typedef std::array<const KnotType*, 6> cell_key_t;
+    typedef std::multimap<cell_key_t, cell_t> index_t;
+
+    /// Data kept with a cell when it is added, so that it can be removed also when its knot values changed in between
+    struct CellRecord
+    {
+        typename index_t::iterator IndexPosition; // position of the cell in mCellsIndex
+        double Min[3]; // bounds of the cell in the spatial index
+        double Max[3];
+    };
+    typedef std::map<std::size_t, CellRecord> record_map_t;
+
     cell_container_t mpCells;
-    mutable map_t mCellsMap; // map from cell id to the basis function. It's mainly used to search for the cell quickly. But it needs to be re-initialized whenever new cell is added to the set
-    bool cell_map_is_created;
+    map_t mCellsMap; // map from cell id to the cell. It is updated whenever a cell is added to or removed from the set
+    index_t mCellsIndex; // map from the knots to the cell. It is used to search for the cell with the same knots quickly
+    record_map_t mCellRecords; // map from cell id to the data kept at its insertion
     std::size_t mLastId;
+    MemoryPool::Pointer mpMemoryPool; // the cells created by CreateCell are allocated here
 
-private:
+    /// Compute the key from the knots spanning a cell
+    cell_key_t CellKey(const std::vector<knot_t>& pKnots) const
+    {
+        cell_key_t key;
+        key.fill(NULL);
+        for(std::size_t i = 0; i < pKnots.size() && i < 6; ++i)
+            key[i] = &(*pKnots[i]);
+        return key;
+    }
 
-    double mTol;
+    /// Compute the key of a cell spanned by nknots knots, i.e. 2, 4 or 6 in 1D, 2D or 3D
+    cell_key_t CellKey(const cell_t& p_cell, const std::size_t& nknots) const
+    {
+        const KnotType* knots[] = {&(*p_cell->XiMin()), &(*p_cell->XiMax()), &(*p_cell->EtaMin()), &(*p_cell->EtaMax()),
+            &(*p_cell->ZetaMin()), &(*p_cell->ZetaMax())};
+        cell_key_t key;
+        key.fill(NULL);
+        for(std::size_t i = 0; i < nknots && i < 6; ++i)
+            key[i] = knots[i];
+        return key;
+    }
 
-    void CreateCellsMap()
+    /// Find the cell spanned by the given knots. Return a null pointer if the cell does not exist.
+    cell_t FindCell(const std::vector<knot_t>& pKnots) const
     {
-        mCellsMap.clear();
-        for(iterator it = mpCells.begin(); it != mpCells.end(); ++it)
-            mCellsMap[(*it)->Id()] = *it;
-        cell_map_is_created = true;
+        typename index_t::const_iterator it = mCellsIndex.find(this->CellKey(pKnots));
+        if(it != mCellsIndex.end())
+            return it->second;
+        return cell_t();
     }
 
-    /// Collapse the first found overlapping cells
-    bool CollapseCells(iterator& it_cell, const_iterator cell_end)
+    /// Find a cell in the container. Return end() if the cell does not exist.
+    iterator FindCell(const cell_t& p_cell)
     {
-        do
-        {
-            std::vector<cell_t> inner_cells = this->GetCells(*it_cell);
+        iterator it = mpCells.find(p_cell);
+        if(it != mpCells.end() && *it == p_cell)
+            return it;
+        return mpCells.end();
+    }
+
+    /// Add a cell spanned by nknots knots to the container and update the maps. The cell must not exist in the container.
+    /// On the output, cmin and cmax are the bounds of the cell, which are kept to remove it from the spatial index later.
+    iterator AddCell(const cell_t& p_cell, const std::size_t& nknots, double* cmin, double* cmax)
+    {
+        iterator it = mpCells.insert(p_cell).first;
+        BaseType::insert(&(*p_cell));
+        mCellsMap[p_cell->Id()] = p_cell;
+
+        CellRecord& r_record = mCellRecords[p_cell->Id()];
+        r_record.IndexPosition = mCellsIndex.insert(typename index_t::value_type(this->CellKey(p_cell, nknots), p_cell));
+        r_record.Min[0] = p_cell->XiMinValue();
+        r_record.Min[1] = p_cell->EtaMinValue();
+        r_record.Min[2] = p_cell->ZetaMinValue();
+        r_record.Max[0] = p_cell->XiMaxValue();
+        r_record.Max[1] = p_cell->EtaMaxValue();
+        r_record.Max[2] = p_cell->ZetaMaxValue();
+        std::copy(r_record.Min, r_record.Min + 3, cmin);
+        std::copy(r_record.Max, r_record.Max + 3, cmax);
+
+        return it;
+    }
+
+    /// Search the spatial index for the cells overlapping with the box [cmin, cmax]. The box always has three components.
+    virtual void SearchOverlappingCells(const double* cmin, const double* cmax, std::vector<cell_t>& results)
+    {
+        KRATOS_THROW_ERROR(std::logic_error, "Calling the virtual function", __FUNCTION__)
+    }
+
+    /// Check if the point xi lies in the cell, within the tolerance
+    bool IsInside(const cell_t& p_cell, const std::vector<double>& xi) const
+    {
+        const double bounds[] = {p_cell->XiMinValue(), p_cell->XiMaxValue(), p_cell->EtaMinValue(), p_cell->EtaMaxValue(),
+            p_cell->ZetaMinValue(), p_cell->ZetaMaxValue()};
+        for (std::size_t i = 0; i < xi.size() && i < 3; ++i)
+            if (xi[i] < bounds[2*i] - mTol || xi[i] > bounds[2*i+1] + mTol)
+                return false;
+        return true;
+    }
+
+    /// Check if the point xi lies strictly inside the cell, i.e. not on its boundary within the tolerance
+    bool IsInterior(const cell_t& p_cell, const std::vector<double>& xi) const
+    {
+        const double bounds[] = {p_cell->XiMinValue(), p_cell->XiMaxValue(), p_cell->EtaMinValue(), p_cell->EtaMaxValue(),
+            p_cell->ZetaMinValue(), p_cell->ZetaMaxValue()};
+        for (std::size_t i = 0; i < xi.size() && i < 3; ++i)
+            if (xi[i] <= bounds[2*i] + mTol || xi[i] >= bounds[2*i+1] - mTol)
+                return false;
+        return true;
+    }
+
+    /// Remove a cell from the container and update the maps. The cell is removed by the data kept at its insertion,
+    /// not by its current knots. On the output, cmin and cmax are the bounds of the cell when it was added.
+    void RemoveCell(iterator it, double* cmin, double* cmax)
+    {
+        cell_t p_cell = *it;
+
+        typename record_map_t::iterator it_record = mCellRecords.find(p_cell->Id());
+        mCellsIndex.erase(it_record->second.IndexPosition);
+        std::copy(it_record->second.Min, it_record->second.Min + 3, cmin);
+        std::copy(it_record->second.Max, it_record->second.Max + 3, cmax);
+        mCellRecords.erase(it_record);
+
+        mCellsMap.erase(p_cell->Id());
+        BaseType::erase(&(*p_cell));
+        mpCells.erase(it);
+    }
 
-            if (inner_cells.size() != 0)
+    /// Mark the spatial index as modified; it is re-packed, if needed, before the next search
+    void SpatialIndexModified()
+    {
+        m_spatial_index_is_updated.store(false, std::memory_order_relaxed);
+    }
+
+    /// Re-pack the spatial index, if needed, before a search. The searches may run concurrently, e.g. IsInside of the FESpace
+    /// from a parallel evaluation, hence the update is done once under a named critical section and published by an atomic
+    /// flag, and the searches only read the index. The cells must not be modified concurrently with a search.
+    template<class TSpatialIndexType>
+    void UpdateSpatialIndex(TSpatialIndexType& rSpatialIndex)
+    {
+        // the acquire load pairs with the release store below, so that a thread seeing the flag also sees the packed index
+        if (!m_spatial_index_is_updated.load(std::memory_order_acquire))
+        {
+            #pragma omp critical (BCellManager_UpdateSpatialIndex)
             {
-                for (std::size_t i = 0; i < inner_cells.size(); ++i)
+                if (!m_spatial_index_is_updated.load(std::memory_order_relaxed))
                 {
-                    inner_cells[i]->Absorb(*it_cell);
+                    rSpatialIndex.Update();
+                    m_spatial_index_is_updated.store(true, std::memory_order_release);
                 }
-                return true;
             }
-            else
-                ++it_cell;
-        } while (it_cell != cell_end);
-
-        return false;
+        }
     }
+
+private:
+
+    double mTol;
+    int mSearchMethod;
+    std::atomic<bool> m_spatial_index_is_updated;
 };
 
 
@@ -310,27 +528,19 @@ public:
     {
         assert(pKnots.size() == 2);
 
-        // search in the list of cell if any cell has the same knot span
-        // Currently I use the brute-force approach. I know it is not efficient. I will improve it in the future.
-        for(iterator it = BaseType::mpCells.begin(); it != BaseType::mpCells.end(); ++it)
-        {
-            if( (*it)->XiMin() == pKnots[0] // left
-             && (*it)->XiMax() == pKnots[1] ) // right
-                return *it;
-        }
+        // search in the index if any cell has the same knot span
+        cell_t p_existing_cell = BaseType::FindCell(pKnots);
+        if(p_existing_cell != NULL)
+            return p_existing_cell;
 
         // otherwise create new cell
-        cell_t p_cell = cell_t(new TCellType(++BaseType::mLastId, pKnots[0], pKnots[1]));
-        BaseType::mpCells.insert(p_cell);
-        SuperType::insert(&(*p_cell));
-        BaseType::cell_map_is_created = false;
-
-        #ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-        // update the r-tree
-        double cmin[] = {BCellManager_Helper::GetKnotValue(pKnots[0])};
-        double cmax[] = {BCellManager_Helper::GetKnotValue(pKnots[1])};
-        rtree_cells.Insert(cmin, cmax, p_cell->Id());
-        #endif
+        cell_t p_cell = MemoryPool::Create<TCellType>(BaseType::mpMemoryPool, ++BaseType::mLastId, pKnots[0], pKnots[1]);
+        double cmin[3], cmax[3];
+        BaseType::AddCell(p_cell, 2, cmin, cmax);
+
+        // update the spatial index
+        mSpatialIndex.Insert(cmin, cmax, p_cell);
+        BaseType::SpatialIndexModified();
 
         return p_cell;
     }
@@ -338,23 +548,18 @@ public:
     /// Insert a cell to the container. If the cell is existed in the container, the iterator of the existed one will be returned.
     virtual iterator insert(cell_t p_cell)
     {
-        // search in the list of cell if any cell has the same knot span
-        // Currently I use the brute-force approach. I know it is not efficient. I will improve it in the future. TODO
-        for(iterator it = BaseType::mpCells.begin(); it != BaseType::mpCells.end(); ++it)
-            if(*it == p_cell)
-                return it;
+        // search in the container if the cell is already inserted
+        iterator it_existing = BaseType::FindCell(p_cell);
+        if(it_existing != BaseType::mpCells.end())
+            return it_existing;
 
         // otherwise insert new cell
-        iterator it = BaseType::mpCells.insert(p_cell).first;
-        SuperType::insert(&(*p_cell));
-        BaseType::cell_map_is_created = false;
-
-        #ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-        // update the r-tree
-        double cmin[] = {p_cell->XiMinValue()};
-        double cmax[] = {p_cell->XiMaxValue()};
-        rtree_cells.Insert(cmin, cmax, p_cell->Id());
-        #endif
+        double cmin[3], cmax[3];
+        iterator it = BaseType::AddCell(p_cell, 2, cmin, cmax);
+
+        // update the spatial index
+        mSpatialIndex.Insert(cmin, cmax, p_cell);
+        BaseType::SpatialIndexModified();
 
         return it;
     }
@@ -362,55 +567,50 @@ public:
     /// Remove a cell by its Id from the set
     virtual void erase(cell_t p_cell)
     {
-        for(iterator it = BaseType::mpCells.begin(); it != BaseType::mpCells.end(); ++it)
+        iterator it = BaseType::FindCell(p_cell);
+        if(it != BaseType::mpCells.end())
         {
-            if(*it == p_cell)
-            {
-                BaseType::mpCells.erase(it);
-                SuperType::erase(&(**it));
-
-                #ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-                // update the r-tree
-                double cmin[] = {p_cell->XiMinValue()};
-                double cmax[] = {p_cell->XiMaxValue()};
-                rtree_cells.Remove(cmin, cmax, p_cell->Id());
-                #endif
+            double cmin[3], cmax[3];
+            BaseType::RemoveCell(it, cmin, cmax);
 
-                break;
-            }
+            // update the spatial index, by the bounds of the cell when it was added
+            mSpatialIndex.Remove(cmin, cmax, p_cell);
+            BaseType::SpatialIndexModified();
         }
     }
 
+    /// Search the cells covered in each cell of a list, see BaseBCellManager
+    using BaseType::GetCells;
+
     /// Search the cells covered in another cell. In return p_cell covers all the cells of std::vector<cell_t>
     virtual std::vector<cell_t> GetCells(cell_t p_cell)
     {
         std::vector<cell_t> p_cells;
 
-        #ifdef USE_BRUTE_FORCE_TO_SEARCH_FOR_CELLS
-        // Currently I use the brute-force approach. I know it is not efficient. I will improve it in the future. TODO
-        for(iterator it = BaseType::mpCells.begin(); it != BaseType::mpCells.end(); ++it)
-            if(*it != p_cell)
-                if((*it)->template IsCovered<1>(p_cell))
-                    p_cells.push_back(*it);
-        #endif
-
-        #ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-        // determine the overlapping cells; for now, this only works in 3D
-        std::vector<std::size_t> OverlappingCells;
-        double cmin[] = {p_cell->XiMinValue()};
-        double cmax[] = {p_cell->XiMaxValue()};
-        int nhits = rtree_cells.Search(cmin, cmax, BCellManager_RtreeSearchCallback, (void*)(&OverlappingCells));
-//        printf("Search resulted in %d hits\n", nhits);
-
-        // check within overlapping cells the one covered in p_cell
-        for(std::size_t i = 0; i < OverlappingCells.size(); ++i)
+        if (BaseType::GetSearchMethod() == _CELL_SEARCH_BRUTE_FORCE_)
         {
-            cell_t pthis_cell = this->get(OverlappingCells[i]);
-            if(pthis_cell != p_cell)
-                if(pthis_cell->template IsCovered<1>(p_cell))
-                    p_cells.push_back(pthis_cell);
+            for(iterator it = BaseType::mpCells.begin(); it != BaseType::mpCells.end(); ++it)
+                if(*it != p_cell)
+                    if((*it)->template IsCovered<1>(p_cell))
+                        p_cells.push_back(*it);
+        }
+        else
+        {
+            // determine the overlapping cells
+            std::vector<cell_t> OverlappingCells;
+            double cmin[] = {p_cell->XiMinValue()};
+            double cmax[] = {p_cell->XiMaxValue()};
+            BaseType::UpdateSpatialIndex(mSpatialIndex);
+            mSpatialIndex.Search(cmin, cmax, OverlappingCells);
+
+            // check within overlapping cells the one covered in p_cell
+            for(std::size_t i = 0; i < OverlappingCells.size(); ++i)
+            {
+                if(OverlappingCells[i] != p_cell)
+                    if(OverlappingCells[i]->template IsCovered<1>(p_cell))
+                        p_cells.push_back(OverlappingCells[i]);
+            }
         }
-        #endif
 
         return p_cells;
     }
@@ -425,11 +625,18 @@ public:
     {
     }
 
+protected:
+
+    /// Search the spatial index for the cells overlapping with the box [cmin, cmax]
+    virtual void SearchOverlappingCells(const double* cmin, const double* cmax, std::vector<cell_t>& results)
+    {
+        BaseType::UpdateSpatialIndex(mSpatialIndex);
+        mSpatialIndex.Search(cmin, cmax, results);
+    }
+
 private:
 
-    #ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-    RTree<std::size_t, double, 1, double> rtree_cells;
-    #endif
+    PackedRTree<1, cell_t> mSpatialIndex;
 };
 
 
@@ -467,29 +674,19 @@ public:
     {
         assert(pKnots.size() == 4);
 
-        // search in the list of cell if any cell has the same knot span
-        // Currently I use the brute-force approach. I know it is not efficient. I will improve it in the future.
-        for(iterator it = BaseType::mpCells.begin(); it != BaseType::mpCells.end(); ++it)
-        {
-            if( (*it)->XiMin()  == pKnots[0] // left
-             && (*it)->XiMax()  == pKnots[1] // right
-             && (*it)->EtaMin() == pKnots[2] // down
-             && (*it)->EtaMax() == pKnots[3] ) // up
-                return *it;
-        }
+        // search in the index if any cell has the same knot span
+        cell_t p_existing_cell = BaseType::FindCell(pKnots);
+        if(p_existing_cell != NULL)
+            return p_existing_cell;
 
         // otherwise create new cell
-        cell_t p_cell = cell_t(new TCellType(++BaseType::mLastId, pKnots[0], pKnots[1], pKnots[2], pKnots[3]));
-        BaseType::mpCells.insert(p_cell);
-        SuperType::insert(&(*p_cell));
-        BaseType::cell_map_is_created = false;
-
-        #ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-        // update the r-tree
-        double cmin[] = {BCellManager_Helper::GetKnotValue(pKnots[0]), BCellManager_Helper::GetKnotValue(pKnots[2])};
-        double cmax[] = {BCellManager_Helper::GetKnotValue(pKnots[1]), BCellManager_Helper::GetKnotValue(pKnots[3])};
-        rtree_cells.Insert(cmin, cmax, p_cell->Id());
-        #endif
+        cell_t p_cell = MemoryPool::Create<TCellType>(BaseType::mpMemoryPool, ++BaseType::mLastId, pKnots[0], pKnots[1], pKnots[2], pKnots[3]);
+        double cmin[3], cmax[3];
+        BaseType::AddCell(p_cell, 4, cmin, cmax);
+
+        // update the spatial index
+        mSpatialIndex.Insert(cmin, cmax, p_cell);
+        BaseType::SpatialIndexModified();
 
         return p_cell;
     }
@@ -497,23 +694,18 @@ public:
     /// Insert a cell to the container. If the cell is existed in the container, the iterator of the existed one will be returned.
     virtual iterator insert(cell_t p_cell)
     {
-        // search in the list of cell if any cell has the same knot span
-        // Currently I use the brute-force approach. I know it is not efficient. I will improve it in the future. TODO
-        for(iterator it = BaseType::mpCells.begin(); it != BaseType::mpCells.end(); ++it)
-            if(*it == p_cell)
-                return it;
+        // search in the container if the cell is already inserted
+        iterator it_existing = BaseType::FindCell(p_cell);
+        if(it_existing != BaseType::mpCells.end())
+            return it_existing;
 
         // otherwise insert new cell
-        iterator it = BaseType::mpCells.insert(p_cell).first;
-        SuperType::insert(&(*p_cell));
-        BaseType::cell_map_is_created = false;
-
-        #ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-        // update the r-tree
-        double cmin[] = {p_cell->XiMinValue(), p_cell->EtaMinValue()};
-        double cmax[] = {p_cell->XiMaxValue(), p_cell->EtaMaxValue()};
-        rtree_cells.Insert(cmin, cmax, p_cell->Id());
-        #endif
+        double cmin[3], cmax[3];
+        iterator it = BaseType::AddCell(p_cell, 4, cmin, cmax);
+
+        // update the spatial index
+        mSpatialIndex.Insert(cmin, cmax, p_cell);
+        BaseType::SpatialIndexModified();
 
         return it;
     }
@@ -521,55 +713,50 @@ public:
     /// Remove a cell by its Id from the set
     virtual void erase(cell_t p_cell)
     {
-        for(iterator it = BaseType::mpCells.begin(); it != BaseType::mpCells.end(); ++it)
+        iterator it = BaseType::FindCell(p_cell);
+        if(it != BaseType::mpCells.end())
         {
-            if(*it == p_cell)
-            {
-                BaseType::mpCells.erase(it);
-                SuperType::erase(&(**it));
+            double cmin[3], cmax[3];
+            BaseType::RemoveCell(it, cmin, cmax);
 
-                #ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-                // update the r-tree
-                double cmin[] = {p_cell->XiMinValue(), p_cell->EtaMinValue(), p_cell->ZetaMinValue()};
-                double cmax[] = {p_cell->XiMaxValue(), p_cell->EtaMaxValue(), p_cell->ZetaMaxValue()};
-                rtree_cells.Remove(cmin, cmax, p_cell->Id());
-                #endif
-
-                break;
-            }
+            // update the spatial index, by the bounds of the cell when it was added
+            mSpatialIndex.Remove(cmin, cmax, p_cell);
+            BaseType::SpatialIndexModified();
         }
     }
 
+    /// Search the cells covered in each cell of a list, see BaseBCellManager
+    using BaseType::GetCells;
+
     /// Search the cells covered in another cell. In return p_cell covers all the cells of std::vector<cell_t>
     virtual std::vector<cell_t> GetCells(cell_t p_cell)
     {
         std::vector<cell_t> p_cells;
 
-        #ifdef USE_BRUTE_FORCE_TO_SEARCH_FOR_CELLS
-        // Currently I use the brute-force approach. I know it is not efficient. I will improve it in the future. TODO
-        for(iterator it = BaseType::mpCells.begin(); it != BaseType::mpCells.end(); ++it)
-            if(*it != p_cell)
-                if((*it)->template IsCovered<2>(p_cell))
-                    p_cells.push_back(*it);
-        #endif
-
-        #ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-        // determine the overlapping cells; for now, this only works in 3D
-        std::vector<std::size_t> OverlappingCells;
-        double cmin[] = {p_cell->XiMinValue(), p_cell->EtaMinValue()};
-        double cmax[] = {p_cell->XiMaxValue(), p_cell->EtaMaxValue()};
-        int nhits = rtree_cells.Search(cmin, cmax, BCellManager_RtreeSearchCallback, (void*)(&OverlappingCells));
-//        printf("Search resulted in %d hits\n", nhits);
-
-        // check within overlapping cells the one covered in p_cell
-        for(std::size_t i = 0; i < OverlappingCells.size(); ++i)
+        if (BaseType::GetSearchMethod() == _CELL_SEARCH_BRUTE_FORCE_)
         {
-            cell_t pthis_cell = this->get(OverlappingCells[i]);
-            if(pthis_cell != p_cell)
-                if(pthis_cell->template IsCovered<2>(p_cell))
-                    p_cells.push_back(pthis_cell);
+            for(iterator it = BaseType::mpCells.begin(); it != BaseType::mpCells.end(); ++it)
+                if(*it != p_cell)
+                    if((*it)->template IsCovered<2>(p_cell))
+                        p_cells.push_back(*it);
+        }
+        else
+        {
+            // determine the overlapping cells
+            std::vector<cell_t> OverlappingCells;
+            double cmin[] = {p_cell->XiMinValue(), p_cell->EtaMinValue()};
+            double cmax[] = {p_cell->XiMaxValue(), p_cell->EtaMaxValue()};
+            BaseType::UpdateSpatialIndex(mSpatialIndex);
+            mSpatialIndex.Search(cmin, cmax, OverlappingCells);
+
+            // check within overlapping cells the one covered in p_cell
+            for(std::size_t i = 0; i < OverlappingCells.size(); ++i)
+            {
+                if(OverlappingCells[i] != p_cell)
+                    if(OverlappingCells[i]->template IsCovered<2>(p_cell))
+                        p_cells.push_back(OverlappingCells[i]);
+            }
         }
-        #endif
 
         return p_cells;
     }
@@ -584,11 +771,18 @@ public:
     {
     }
 
+protected:
+
+    /// Search the spatial index for the cells overlapping with the box [cmin, cmax]
+    virtual void SearchOverlappingCells(const double* cmin, const double* cmax, std::vector<cell_t>& results)
+    {
+        BaseType::UpdateSpatialIndex(mSpatialIndex);
+        mSpatialIndex.Search(cmin, cmax, results);
+    }
+
 private:
 
-    #ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-    RTree<std::size_t, double, 2, double> rtree_cells;
-    #endif
+    PackedRTree<2, cell_t> mSpatialIndex;
 };
 
 
@@ -626,31 +820,19 @@ public:
     {
         assert(pKnots.size() == 6);
 
-        // search in the list of cell if any cell has the same knot span
-        // Currently I use the brute-force approach. I know it is not efficient. I will improve it in the future.
-        for(iterator it = BaseType::mpCells.begin(); it != BaseType::mpCells.end(); ++it)
-        {
-            if( (*it)->XiMin()  == pKnots[0] // left
-             && (*it)->XiMax()  == pKnots[1] // right
-             && (*it)->EtaMin() == pKnots[2] // down
-             && (*it)->EtaMax() == pKnots[3] // up
-             && (*it)->ZetaMin() == pKnots[4] // below
-             && (*it)->ZetaMax() == pKnots[5] ) // above
-                return *it;
-        }
+        // search in the index if any cell has the same knot span
+        cell_t p_existing_cell = BaseType::FindCell(pKnots);
+        if(p_existing_cell != NULL)
+            return p_existing_cell;
 
         // otherwise create new cell
-        cell_t p_cell = cell_t(new TCellType(++BaseType::mLastId, pKnots[0], pKnots[1], pKnots[2], pKnots[3], pKnots[4], pKnots[5]));
-        BaseType::mpCells.insert(p_cell);
-        SuperType::insert(&(*p_cell));
-        BaseType::cell_map_is_created = false;
-
-        #ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-        // update the r-tree
-        double cmin[] = {BCellManager_Helper::GetKnotValue(pKnots[0]), BCellManager_Helper::GetKnotValue(pKnots[2]), BCellManager_Helper::GetKnotValue(pKnots[4])};
-        double cmax[] = {BCellManager_Helper::GetKnotValue(pKnots[1]), BCellManager_Helper::GetKnotValue(pKnots[3]), BCellManager_Helper::GetKnotValue(pKnots[5])};
-        rtree_cells.Insert(cmin, cmax, p_cell->Id());
-        #endif
+        cell_t p_cell = MemoryPool::Create<TCellType>(BaseType::mpMemoryPool, ++BaseType::mLastId, pKnots[0], pKnots[1], pKnots[2], pKnots[3], pKnots[4], pKnots[5]);
+        double cmin[3], cmax[3];
+        BaseType::AddCell(p_cell, 6, cmin, cmax);
+
+        // update the spatial index
+        mSpatialIndex.Insert(cmin, cmax, p_cell);
+        BaseType::SpatialIndexModified();
 
         return p_cell;
     }
@@ -658,23 +840,18 @@ public:
     /// Insert a cell to the container. If the cell is existed in the container, the iterator of the existed one will be returned.
     virtual iterator insert(cell_t p_cell)
     {
-        // search in the list of cell if any cell has the same knot span
-        // Currently I use the brute-force approach. I know it is not efficient. I will improve it in the future. TODO
-        for(iterator it = BaseType::mpCells.begin(); it != BaseType::mpCells.end(); ++it)
-            if(*it == p_cell)
-                return it;
+        // search in the container if the cell is already inserted
+        iterator it_existing = BaseType::FindCell(p_cell);
+        if(it_existing != BaseType::mpCells.end())
+            return it_existing;
 
         // otherwise insert new cell
-        iterator it = BaseType::mpCells.insert(p_cell).first;
-        SuperType::insert(&(*p_cell));
-        BaseType::cell_map_is_created = false;
-
-        #ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-        // update the r-tree
-        double cmin[] = {p_cell->XiMinValue(), p_cell->EtaMinValue(), p_cell->ZetaMinValue()};
-        double cmax[] = {p_cell->XiMaxValue(), p_cell->EtaMaxValue(), p_cell->ZetaMaxValue()};
-        rtree_cells.Insert(cmin, cmax, p_cell->Id());
-        #endif
+        double cmin[3], cmax[3];
+        iterator it = BaseType::AddCell(p_cell, 6, cmin, cmax);
+
+        // update the spatial index
+        mSpatialIndex.Insert(cmin, cmax, p_cell);
+        BaseType::SpatialIndexModified();
 
         return it;
     }
@@ -682,55 +859,50 @@ public:
     /// Remove a cell by its Id from the set
     virtual void erase(cell_t p_cell)
     {
-        for(iterator it = BaseType::mpCells.begin(); it != BaseType::mpCells.end(); ++it)
+        iterator it = BaseType::FindCell(p_cell);
+        if(it != BaseType::mpCells.end())
         {
-            if(*it == p_cell)
-            {
-                BaseType::mpCells.erase(it);
-                SuperType::erase(&(**it));
+            double cmin[3], cmax[3];
+            BaseType::RemoveCell(it, cmin, cmax);
 
-                #ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-                // update the r-tree
-                double cmin[] = {p_cell->XiMinValue(), p_cell->EtaMinValue(), p_cell->ZetaMinValue()};
-                double cmax[] = {p_cell->XiMaxValue(), p_cell->EtaMaxValue(), p_cell->ZetaMaxValue()};
-                rtree_cells.Remove(cmin, cmax, p_cell->Id());
-                #endif
-
-                break;
-            }
+            // update the spatial index, by the bounds of the cell when it was added
+            mSpatialIndex.Remove(cmin, cmax, p_cell);
+            BaseType::SpatialIndexModified();
         }
     }
 
+    /// Search the cells covered in each cell of a list, see BaseBCellManager
+    using BaseType::GetCells;
+
     /// Search the cells coverred in another cell. In return p_cell covers all the cells of std::vector<cell_t>
     virtual std::vector<cell_t> GetCells(cell_t p_cell)
     {
         std::vector<cell_t> p_cells;
 
-        #ifdef USE_BRUTE_FORCE_TO_SEARCH_FOR_CELLS
-        // Currently I use the brute-force approach. I know it is not efficient. I will improve it in the future. TODO
-        for(iterator it = BaseType::mpCells.begin(); it != BaseType::mpCells.end(); ++it)
-            if(*it != p_cell)
-                if((*it)->template IsCovered<3>(p_cell))
-                    p_cells.push_back(*it);
-        #endif
-
-        #ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-        // determine the overlapping cells; for now, this's only working in 3D
-        std::vector<std::size_t> OverlappingCells;
-        double cmin[] = {p_cell->XiMinValue(), p_cell->EtaMinValue(), p_cell->ZetaMinValue()};
-        double cmax[] = {p_cell->XiMaxValue(), p_cell->EtaMaxValue(), p_cell->ZetaMaxValue()};
-        int nhits = rtree_cells.Search(cmin, cmax, BCellManager_RtreeSearchCallback, (void*)(&OverlappingCells));
-//        printf("Search resulted in %d hits\n", nhits);
-
-        // check within overlapping cells the one covered in p_cell
-        for(std::size_t i = 0; i < OverlappingCells.size(); ++i)
+        if (BaseType::GetSearchMethod() == _CELL_SEARCH_BRUTE_FORCE_)
         {
-            cell_t pthis_cell = this->get(OverlappingCells[i]);
-            if(pthis_cell != p_cell)
-                if(pthis_cell->template IsCovered<3>(p_cell))
-                    p_cells.push_back(pthis_cell);
+            for(iterator it = BaseType::mpCells.begin(); it != BaseType::mpCells.end(); ++it)
+                if(*it != p_cell)
+                    if((*it)->template IsCovered<3>(p_cell))
+                        p_cells.push_back(*it);
+        }
+        else
+        {
+            // determine the overlapping cells
+            std::vector<cell_t> OverlappingCells;
+            double cmin[] = {p_cell->XiMinValue(), p_cell->EtaMinValue(), p_cell->ZetaMinValue()};
+            double cmax[] = {p_cell->XiMaxValue(), p_cell->EtaMaxValue(), p_cell->ZetaMaxValue()};
+            BaseType::UpdateSpatialIndex(mSpatialIndex);
+            mSpatialIndex.Search(cmin, cmax, OverlappingCells);
+
+            // check within overlapping cells the one covered in p_cell
+            for(std::size_t i = 0; i < OverlappingCells.size(); ++i)
+            {
+                if(OverlappingCells[i] != p_cell)
+                    if(OverlappingCells[i]->template IsCovered<3>(p_cell))
+                        p_cells.push_back(OverlappingCells[i]);
+            }
         }
-        #endif
 
         return p_cells;
     }
@@ -745,10 +917,17 @@ public:
     {
     }
 
+protected:
+
+    /// Search the spatial index for the cells overlapping with the box [cmin, cmax]
+    virtual void SearchOverlappingCells(const double* cmin, const double* cmax, std::vector<cell_t>& results)
+    {
+        BaseType::UpdateSpatialIndex(mSpatialIndex);
+        mSpatialIndex.Search(cmin, cmax, results);
+    }
+
 private:
-    #ifdef USE_R_TREE_TO_SEARCH_FOR_CELLS
-    RTree<std::size_t, double, 3, double> rtree_cells;
-    #endif
+    PackedRTree<3, cell_t> mSpatialIndex;
 };
 
 
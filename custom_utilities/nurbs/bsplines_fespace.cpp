@@ -8,6 +8,7 @@
 
 // System includes
 #include <vector>
+#include <algorithm>
 
 // External includes
 
@@ -359,5 +360,131 @@ void BSplinesFESpace_Helper<3>::GetValuesAndDerivatives(const BSplinesFESpace<3>
     }
 }
 
+template<int TDim>
+void BSplinesFESpace_Helper<TDim>::GetActiveValuesAndDerivatives(const BSplinesFESpace<TDim>& rFESpace,
+    std::vector<std::size_t>& indices, std::vector<double>& values,
+    std::vector<std::vector<double> >& derivatives, std::vector<std::vector<double> >& second_derivatives,
+    const std::vector<double>& xi, const int& nders)
+{
+    indices.clear();
+    values.clear();
+
+    // locate the knot span
+    int Span[TDim], Start[TDim], Size[TDim];
+    std::size_t Stride[TDim];
+    std::size_t NumberOfActiveFunctions = 1;
+    for (int dim = 0; dim < TDim; ++dim)
+    {
+        Span[dim] = BSplineUtils::FindSpan(rFESpace.Number(dim), rFESpace.Order(dim), xi[dim], rFESpace.KnotVector(dim));
+
+        if ((Span[dim] >= rFESpace.Number(dim) + rFESpace.Order(dim)) || (Span[dim] == 0))
+        {
+            derivatives.clear();
+            second_derivatives.clear();
+            return;
+        }
+
+        Start[dim] = Span[dim] - rFESpace.Order(dim);
+        Size[dim] = rFESpace.Order(dim) + 1;
+        Stride[dim] = (dim == 0) ? 1 : Stride[dim-1] * rFESpace.Number(dim-1);
+        NumberOfActiveFunctions *= Size[dim];
+    }
+
+    // compute the non-zero univariate shape function values and derivatives
+    int NumberOfDerivatives[TDim];
+    std::vector<std::vector<double> > ShapeFunctionsValuesAndDerivatives[TDim];
+    for (int dim = 0; dim < TDim; ++dim)
+    {
+        NumberOfDerivatives[dim] = std::min(nders, static_cast<int>(rFESpace.Order(dim)));
+        BSplineUtils::BasisFunsDer(ShapeFunctionsValuesAndDerivatives[dim], Span[dim], xi[dim], rFESpace.Order(dim),
+            rFESpace.KnotVector(dim), NumberOfDerivatives[dim], BSplineUtils::StdVector2DOp<double>());
+    }
+
+    indices.resize(NumberOfActiveFunctions);
+    values.resize(NumberOfActiveFunctions);
+    if ((nders > 0) && (derivatives.size() != NumberOfActiveFunctions))
+        derivatives.resize(NumberOfActiveFunctions);
+    if ((nders > 1) && (second_derivatives.size() != NumberOfActiveFunctions))
+        second_derivatives.resize(NumberOfActiveFunctions);
+
+    // tensor product of the univariate values, the index runs fastest in the first direction (see Index2D/Index3D)
+    int loc[TDim];
+    for (int dim = 0; dim < TDim; ++dim)
+        loc[dim] = 0;
+
+    for (std::size_t a = 0; a < NumberOfActiveFunctions; ++a)
+    {
+        std::size_t Index = 0;
+        double N = 1.0;
+        for (int dim = 0; dim < TDim; ++dim)
+        {
+            Index += (Start[dim] + loc[dim]) * Stride[dim];
+            N *= ShapeFunctionsValuesAndDerivatives[dim][0][loc[dim]];
+        }
+        indices[a] = Index;
+        values[a] = N;
+
+        if (nders > 0)
+        {
+            if (derivatives[a].size() != TDim)
+                derivatives[a].resize(TDim);
+
+            for (int i = 0; i < TDim; ++i)
+            {
+                double dN = 1.0;
+                for (int dim = 0; dim < TDim; ++dim)
+                {
+                    const int r = (dim == i) ? 1 : 0;
+                    dN *= (r <= NumberOfDerivatives[dim]) ? ShapeFunctionsValuesAndDerivatives[dim][r][loc[dim]] : 0.0;
+                }
+                derivatives[a][i] = dN;
+            }
+        }
+
+        if (nders > 1)
+        {
+            if (second_derivatives[a].size() != TDim*TDim)
+                second_derivatives[a].resize(TDim*TDim);
+
+            for (int i = 0; i < TDim; ++i)
+            {
+                for (int j = 0; j < TDim; ++j)
+                {
+                    double d2N = 1.0;
+                    for (int dim = 0; dim < TDim; ++dim)
+                    {
+                        const int r = ((dim == i) ? 1 : 0) + ((dim == j) ? 1 : 0);
+                        d2N *= (r <= NumberOfDerivatives[dim]) ? ShapeFunctionsValuesAndDerivatives[dim][r][loc[dim]] : 0.0;
+                    }
+                    second_derivatives[a][i*TDim + j] = d2N;
+                }
+            }
+        }
+
+        // advance the local multi-index
+        for (int dim = 0; dim < TDim; ++dim)
+        {
+            if (++loc[dim] < Size[dim])
+                break;
+            loc[dim] = 0;
+        }
+    }
+}
+
+template void BSplinesFESpace_Helper<1>::GetActiveValuesAndDerivatives(const BSplinesFESpace<1>& rFESpace,
+    std::vector<std::size_t>& indices, std::vector<double>& values,
+    std::vector<std::vector<double> >& derivatives, std::vector<std::vector<double> >& second_derivatives,
+    const std::vector<double>& xi, const int& nders);
+
+template void BSplinesFESpace_Helper<2>::GetActiveValuesAndDerivatives(const BSplinesFESpace<2>& rFESpace,
+    std::vector<std::size_t>& indices, std::vector<double>& values,
+    std::vector<std::vector<double> >& derivatives, std::vector<std::vector<double> >& second_derivatives,
+    const std::vector<double>& xi, const int& nders);
+
+template void BSplinesFESpace_Helper<3>::GetActiveValuesAndDerivatives(const BSplinesFESpace<3>& rFESpace,
+    std::vector<std::size_t>& indices, std::vector<double>& values,
+    std::vector<std::vector<double> >& derivatives, std::vector<std::vector<double> >& second_derivatives,
+    const std::vector<double>& xi, const int& nders);
+
 } // namespace Kratos.
 
@@ -11,6 +11,7 @@
 
 // System includes
 #include <vector>
+#include <atomic>
 #include <algorithm>
 
 // External includes
@@ -46,6 +47,14 @@ struct BSplinesFESpace_Helper
     /// the output derivatives has the form of values[func_index][dim_index]
     static void GetValuesAndDerivatives(const BSplinesFESpace<TDim>& rFESpace,
         std::vector<double>& values, std::vector<std::vector<double> >& derivatives, const std::vector<double>& xi);
+
+    /// Get the local indices, values and derivatives up to order nders (0, 1 or 2) of the nonzero basis functions at point xi
+    /// the output derivatives has the form of derivatives[active_index][dim_index]
+    /// the output second derivatives has the form of second_derivatives[active_index][dim_index_1*TDim + dim_index_2]
+    static void GetActiveValuesAndDerivatives(const BSplinesFESpace<TDim>& rFESpace,
+        std::vector<std::size_t>& indices, std::vector<double>& values,
+        std::vector<std::vector<double> >& derivatives, std::vector<std::vector<double> >& second_derivatives,
+        const std::vector<double>& xi, const int& nders);
 };
 
 /**
@@ -65,7 +74,7 @@ public:
     typedef BCellManager<TDim, BCell> cell_container_t;
 
     /// Default constructor
-    BSplinesFESpace() : BaseType() {}
+    BSplinesFESpace() : BaseType(), m_cell_manager_is_created(false) {}
 
     /// Destructor
     virtual ~BSplinesFESpace()
@@ -136,6 +145,7 @@ public:
     void SetKnotVector(const std::size_t& idir, const knot_container_t& p_knot_vector)
     {
         mKnotVectors[idir] = p_knot_vector;
+        this->ClearCellManager();
     }
 
     /// Create and set the knot vector in direction i.
@@ -150,6 +160,7 @@ public:
             mKnotVectors[idir].clear();
             for (std::size_t j = 0; j < values.size(); ++j)
                 mKnotVectors[idir].pCreateKnot(values[j]);
+            this->ClearCellManager();
         }
     }
 
@@ -166,11 +177,9 @@ public:
         BSplinesIndexingUtility::Reverse<TDim, std::vector<std::size_t>, std::vector<std::size_t> >(mFunctionsIds, this->Numbers(), idir);
 
         // and the global to local map
-        BaseType::mGlobalToLocal.clear();
-        for (std::size_t i = 0; i < mFunctionsIds.size(); ++i)
-        {
-            BaseType::mGlobalToLocal[mFunctionsIds[i]] = i;
-        }
+        BaseType::mGlobalToLocal.Assign(mFunctionsIds);
+
+        this->ClearCellManager();
     }
 
     /// Set the BSplines information in the direction i
@@ -178,6 +187,7 @@ public:
     {
         mOrders[idir] = Order;
         mNumbers[idir] = Number;
+        this->ClearCellManager();
     }
 
     /// Validate the BSplinesFESpace
@@ -198,10 +208,19 @@ public:
     /// Get the values of the basis function i at point xi
     void GetValue(double& v, const std::size_t& i, const std::vector<double>& xi) const final
     {
-        // TODO the current approach is expensive (all is computed). We have to find the way to optimize it.
+        std::vector<std::size_t> indices;
         std::vector<double> values;
-        this->GetValues(values, xi);
-        v = values[i];
+        this->GetActiveValues(indices, values, xi);
+
+        v = 0.0;
+        for (std::size_t k = 0; k < indices.size(); ++k)
+        {
+            if (indices[k] == i)
+            {
+                v = values[k];
+                break;
+            }
+        }
     }
 
     /// Get the values of the basis functions at point xi
@@ -233,6 +252,29 @@ public:
         BSplinesFESpace_Helper<TDim>::GetValuesAndDerivatives(*this, values, derivatives, xi);
     }
 
+    /// Get the local indices and values of the nonzero basis functions at point xi
+    void GetActiveValues(std::vector<std::size_t>& indices, std::vector<double>& values, const std::vector<double>& xi) const final
+    {
+        std::vector<std::vector<double> > dummy1, dummy2;
+        BSplinesFESpace_Helper<TDim>::GetActiveValuesAndDerivatives(*this, indices, values, dummy1, dummy2, xi, 0);
+    }
+
+    /// Get the local indices, values and derivatives of the nonzero basis functions at point xi
+    void GetActiveValuesAndDerivatives(std::vector<std::size_t>& indices, std::vector<double>& values,
+        std::vector<std::vector<double> >& derivatives, const std::vector<double>& xi) const final
+    {
+        std::vector<std::vector<double> > dummy;
+        BSplinesFESpace_Helper<TDim>::GetActiveValuesAndDerivatives(*this, indices, values, derivatives, dummy, xi, 1);
+    }
+
+    /// Get the local indices, values, first and second derivatives of the nonzero basis functions at point xi
+    void GetActiveValuesAndDerivatives(std::vector<std::size_t>& indices, std::vector<double>& values,
+        std::vector<std::vector<double> >& derivatives, std::vector<std::vector<double> >& second_derivatives,
+        const std::vector<double>& xi) const final
+    {
+        BSplinesFESpace_Helper<TDim>::GetActiveValuesAndDerivatives(*this, indices, values, derivatives, second_derivatives, xi, 2);
+    }
+
     /// Check if a point lies inside the parametric domain of the BSplinesFESpace
     bool IsInside(const std::vector<double>& xi) const final
     {
@@ -279,6 +321,7 @@ public:
         if (mFunctionsIds.size() != this->TotalNumber())
             mFunctionsIds.resize(this->TotalNumber());
         std::fill(mFunctionsIds.begin(), mFunctionsIds.end(), -1);
+        this->ClearCellManager();
     }
 
     /// Reset the function indices to a given values.
@@ -296,24 +339,21 @@ public:
         }
         if (mFunctionsIds.size() != this->TotalNumber())
             mFunctionsIds.resize(this->TotalNumber());
-        // std::copy(func_indices.begin(), func_indices.end(), mFunctionsIds.begin());
-        for (std::size_t i = 0; i < func_indices.size(); ++i)
-        {
-            mFunctionsIds[i] = func_indices[i];
-            BaseType::mGlobalToLocal[mFunctionsIds[i]] = i;
-        }
+        std::copy(func_indices.begin(), func_indices.end(), mFunctionsIds.begin());
+        BaseType::mGlobalToLocal.Assign(mFunctionsIds);
+        this->ClearCellManager();
     }
 
     /// Enumerate the dofs of each grid function. The enumeration algorithm is pretty straightforward.
     /// If the dof does not have pre-existing value, which assume it is -1, it will be assigned the incremental value.
     std::size_t& Enumerate(std::size_t& start) final
     {
-        BaseType::mGlobalToLocal.clear();
         for (std::size_t i = 0; i < mFunctionsIds.size(); ++i)
         {
             if (mFunctionsIds[i] == -1) mFunctionsIds[i] = start++;
-            BaseType::mGlobalToLocal[mFunctionsIds[i]] = i;
         }
+        BaseType::mGlobalToLocal.Assign(mFunctionsIds);
+        this->ClearCellManager();
 
         return start;
     }
@@ -340,11 +380,8 @@ public:
             mFunctionsIds[i] = it->second;
         }
 
-        BaseType::mGlobalToLocal.clear();
-        for (std::size_t i = 0; i < mFunctionsIds.size(); ++i)
-        {
-            BaseType::mGlobalToLocal[mFunctionsIds[i]] = i;
-        }
+        BaseType::mGlobalToLocal.Assign(mFunctionsIds);
+        this->ClearCellManager();
     }
 
     /// Get the first equation_id in this space
@@ -812,6 +849,8 @@ public:
                 }
             }
         }
+
+        this->ClearCellManager();
     }
 
     /// Construct the boundary patch based on side
@@ -929,8 +968,36 @@ public:
         return pBFESpace;
     }
 
-    /// Create the cell manager for all the cells in the support domain of the BSplinesFESpace
-    typename BaseType::cell_container_t::Pointer ConstructCellManager() const final
+    /// Get the cell manager for all the cells in the support domain of the BSplinesFESpace.
+    /// The cell manager is created at the first call and shared by the subsequent calls, until the knot vectors,
+    /// the orders or the function indices change. Use CreateCellManager to obtain a cell manager that can be modified.
+    typename BaseType::cell_container_t::ConstPointer ConstructCellManager() const final
+    {
+        // the acquire load pairs with the release store below, so that a thread seeing the flag also sees the cell manager
+        if (!m_cell_manager_is_created.load(std::memory_order_acquire))
+        {
+            #pragma omp critical (BSplinesFESpace_ConstructCellManager)
+            {
+                if (!m_cell_manager_is_created.load(std::memory_order_relaxed))
+                {
+                    mpCellManager = this->CreateCellManager();
+                    m_cell_manager_is_created.store(true, std::memory_order_release);
+                }
+            }
+        }
+
+        return mpCellManager;
+    }
+
+    /// Discard the cached cell manager; it is re-created at the next call of ConstructCellManager
+    void ClearCellManager()
+    {
+        m_cell_manager_is_created = false;
+        mpCellManager = typename BaseType::cell_container_t::ConstPointer();
+    }
+
+    /// Create a new cell manager for all the cells in the support domain of the BSplinesFESpace
+    typename BaseType::cell_container_t::Pointer CreateCellManager() const
     {
         typename cell_container_t::Pointer pCellManager;
 
@@ -1159,6 +1226,7 @@ public:
         }
         this->mFunctionsIds = rOther.mFunctionsIds;
         BaseType::operator=(rOther);
+        this->ClearCellManager();
         return *this;
     }
 
@@ -1237,6 +1305,12 @@ private:
      * data for grid function interpolation
      */
     std::vector<std::size_t> mFunctionsIds; // this is to store a unique number of the shape function over the forest of FESpace(s).
+
+    /**
+     * cached cell manager. It is only read after the flag is seen set, since the first query may come from several threads.
+     */
+    mutable typename BaseType::cell_container_t::ConstPointer mpCellManager;
+    mutable std::atomic<bool> m_cell_manager_is_created;
 };
 
 /**
@@ -128,6 +128,18 @@ public:
         KRATOS_THROW_ERROR(std::logic_error, "Calling the virtual function", __FUNCTION__)
     }
 
+    /// Search the cells containing the parametric point xi. A point on the boundary between cells is contained in all of them.
+    virtual std::vector<cell_t> FindCells(const std::vector<double>& xi)
+    {
+        KRATOS_THROW_ERROR(std::logic_error, "Calling the virtual function", __FUNCTION__)
+    }
+
+    /// Search the cells containing each point of a sorted list, i.e. cells[i] are the cells containing points[i]
+    virtual void FindCells(std::vector<std::vector<cell_t> >& cells, const std::vector<std::vector<double> >& points)
+    {
+        KRATOS_THROW_ERROR(std::logic_error, "Calling the virtual function", __FUNCTION__)
+    }
+
     /// Reset all the Id of all the basis functions. Remarks: use it with care, you have to be responsible to the old indexing data of the basis functions before calling this function
     /// Disable this function for temporary
 //    std::size_t ReIndexing()
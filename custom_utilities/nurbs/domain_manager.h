@@ -14,6 +14,7 @@
 #include <set>
 #include <map>
 #include <iterator>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 
@@ -34,7 +35,7 @@ public:
     KRATOS_CLASS_POINTER_DEFINITION(DomainManager);
 
     /// Type definition
-    typedef std::set<double> coords_container_t;
+    typedef std::vector<double> coords_container_t; // sorted and unique
 
     /// Default constructor
     DomainManager(const std::size_t& Id) : mId(Id) {}
@@ -49,9 +50,9 @@ public:
     void SetId(const std::size_t& Id) {mId = Id;}
 
     /// Fill the internal array of X & Y-coordinates. It must be done before cells are added to this container.
-    virtual void AddXcoord(const double& X) {mXcoords.insert(X);}
-    virtual void AddYcoord(const double& Y) {mYcoords.insert(Y);}
-    virtual void AddZcoord(const double& Z) {mZcoords.insert(Z);}
+    virtual void AddXcoord(const double& X) {AddCoord(mXcoords, X);}
+    virtual void AddYcoord(const double& Y) {AddCoord(mYcoords, Y);}
+    virtual void AddZcoord(const double& Z) {AddCoord(mZcoords, Z);}
 
     /// Add the cell to the set
     virtual void AddCell(const std::vector<double>& box)
@@ -65,6 +66,12 @@ public:
         KRATOS_THROW_ERROR(std::logic_error, "Calling base class function", __FUNCTION__)
     }
 
+    /// Get the memory used by the domain, in bytes
+    virtual std::size_t MemoryUsage() const
+    {
+        return (mXcoords.capacity() + mYcoords.capacity() + mZcoords.capacity()) * sizeof(double);
+    }
+
     /// Export the domain to Matlab for visualization
     virtual void ExportDomain(const std::string& fn, const std::string& color, const double& distance) const
     {
@@ -81,6 +88,43 @@ protected:
     coords_container_t mYcoords;
     coords_container_t mZcoords;
 
+    /// Insert a coordinate to the sorted array, if it does not exist
+    static void AddCoord(coords_container_t& coords, const double& v)
+    {
+        coords_container_t::iterator it = std::lower_bound(coords.begin(), coords.end(), v);
+        if (it == coords.end() || *it != v)
+            coords.insert(it, v);
+    }
+
+    /// Get the index of a coordinate in the sorted array. Return the size of the array if it does not exist.
+    static std::size_t FindCoord(const coords_container_t& coords, const double& v)
+    {
+        coords_container_t::const_iterator it = std::lower_bound(coords.begin(), coords.end(), v);
+        if (it == coords.end() || *it != v)
+            return coords.size();
+        return it - coords.begin();
+    }
+
+    /// Find the range of grid cells [i1, i2) which covers the interval [vmin, vmax] within the tolerance.
+    /// Return false if the interval is not inside the range of the coordinates.
+    static bool FindCellRange(const coords_container_t& coords, const double& vmin, const double& vmax, const double& tol,
+            std::size_t& i1, std::size_t& i2)
+    {
+        // the number of coordinates smaller than vmin (within tolerance)
+        i1 = std::lower_bound(coords.begin(), coords.end(), vmin + tol) - coords.begin();
+        if(i1 == 0 || i1 == coords.size())
+            return false;
+        else
+            --i1;
+
+        // the number of coordinates smaller than vmax (within tolerance)
+        i2 = std::lower_bound(coords.begin(), coords.end(), vmax - tol) - coords.begin();
+        if(i2 == 0 || i2 == coords.size())
+            return false;
+
+        return true;
+    }
+
 private:
 
     std::size_t mId;
@@ -19,6 +19,7 @@
 
 // Project includes
 #include "includes/define.h"
+#include "custom_utilities/region_tree.h"
 #include "custom_utilities/nurbs/domain_manager.h"
 
 namespace Kratos
@@ -26,6 +27,7 @@ namespace Kratos
 
 /**
     This class represents a union of domains (rectangle) in the parameter space of NURBS in 2D. THis is useful to manage the refinement domain in the hierarchical NURBS mesh
+    The active cells of the grid spanned by the coordinates are stored in a quadtree (RegionTree), hence adding a cell and checking a bounding box only visit the nodes along the box boundary, i.e. O(perimeter * log n) with n the number of coordinates, instead of O(area).
  */
 class DomainManager2D : public DomainManager
 {
@@ -33,9 +35,7 @@ class DomainManager2D : public DomainManager
 public:
     /// Type definition
     typedef DomainManager BaseType;
-    typedef std::size_t key_t;
-    typedef std::set<std::size_t> index_container_t;
-    typedef std::map<key_t, index_container_t> map_t;
+    typedef RegionTree<2> tree_t;
 
     /// Pointer definition
     KRATOS_CLASS_POINTER_DEFINITION(DomainManager2D);
@@ -52,6 +52,9 @@ public:
     /// Check if a Cuboid if it is contained in the Cuboid set.
     virtual bool IsInside(const std::vector<double>& bounding_box) const;
 
+    /// Get the memory used by the domain, in bytes
+    virtual std::size_t MemoryUsage() const;
+
     /// Export the domain to Matlab for visualization
     virtual void ExportDomain(const std::string& fn, const std::string& color, const double& distance) const;
 
@@ -61,7 +64,7 @@ public:
 
 private:
 
-    map_t mActiveCells;
+    tree_t mActiveCells;
 };
 
 /// output stream function
@@ -5,7 +5,7 @@ namespace Kratos
 
     void DomainManager3D::PrintInfo(std::ostream& rOStream) const
     {
-        rOStream << "DomainManager in 3D";
+        rOStream << "DomainManager in 3D, memory = " << this->MemoryUsage() << " bytes";
     }
 
     void DomainManager3D::PrintData(std::ostream& rOStream) const
@@ -26,13 +26,25 @@ namespace Kratos
         rOStream << std::endl;
 
         rOStream << "Cells:" << std::endl;
-        for(map_t::const_iterator it1 = mActiveCells.begin(); it1 != mActiveCells.end(); ++it1)
+        std::vector<tree_t::index_t> cells;
+        mActiveCells.GetCells(cells);
+        for(std::size_t c = 0; c < cells.size(); ++c)
         {
-            rOStream << " face " << it1->first.first << "," << it1->first.second << ":";
-            for(std::set<std::size_t>::const_iterator it2 = it1->second.begin(); it2 != it1->second.end(); ++it2)
-                rOStream << " " << *it2;
-            rOStream << std::endl;
+            if(c == 0 || cells[c][0] != cells[c-1][0] || cells[c][1] != cells[c-1][1])
+            {
+                if(c != 0)
+                    rOStream << std::endl;
+                rOStream << " face " << cells[c][0] << "," << cells[c][1] << ":";
+            }
+            rOStream << " " << cells[c][2];
         }
+        if(cells.size() != 0)
+            rOStream << std::endl;
+    }
+
+    std::size_t DomainManager3D::MemoryUsage() const
+    {
+        return BaseType::MemoryUsage() + mActiveCells.MemoryUsage();
     }
 
     std::size_t DomainManager3D::GetIndex(std::size_t X, std::size_t Y, std::size_t Z, std::size_t numX, std::size_t numY, std::size_t numZ) const
@@ -42,40 +54,25 @@ namespace Kratos
 
     void DomainManager3D::AddCell(const std::vector<double>& box)
     {
-        coords_container_t::iterator it_x1 = BaseType::mXcoords.find(box[0]);
-        coords_container_t::iterator it_x2 = BaseType::mXcoords.find(box[1]);
-        coords_container_t::iterator it_y1 = BaseType::mYcoords.find(box[2]);
-        coords_container_t::iterator it_y2 = BaseType::mYcoords.find(box[3]);
-        coords_container_t::iterator it_z1 = BaseType::mZcoords.find(box[4]);
-        coords_container_t::iterator it_z2 = BaseType::mZcoords.find(box[5]);
-
-        if(it_x1 == BaseType::mXcoords.end() || it_x2 == BaseType::mXcoords.end())
+        std::size_t i1 = BaseType::FindCoord(BaseType::mXcoords, box[0]);
+        std::size_t i2 = BaseType::FindCoord(BaseType::mXcoords, box[1]);
+        std::size_t j1 = BaseType::FindCoord(BaseType::mYcoords, box[2]);
+        std::size_t j2 = BaseType::FindCoord(BaseType::mYcoords, box[3]);
+        std::size_t k1 = BaseType::FindCoord(BaseType::mZcoords, box[4]);
+        std::size_t k2 = BaseType::FindCoord(BaseType::mZcoords, box[5]);
+
+        if(i1 == BaseType::mXcoords.size() || i2 == BaseType::mXcoords.size())
             KRATOS_THROW_ERROR(std::runtime_error, "Cell does not align with x-coordinates", "")
 
-        if(it_y1 == BaseType::mYcoords.end() || it_y2 == BaseType::mYcoords.end())
+        if(j1 == BaseType::mYcoords.size() || j2 == BaseType::mYcoords.size())
             KRATOS_THROW_ERROR(std::runtime_error, "Cell does not align with y-coordinates", "")
 
-        if(it_z1 == BaseType::mZcoords.end() || it_z2 == BaseType::mZcoords.end())
+        if(k1 == BaseType::mZcoords.size() || k2 == BaseType::mZcoords.size())
             KRATOS_THROW_ERROR(std::runtime_error, "Cell does not align with z-coordinates", "")
 
-        std::size_t i1 = std::distance(BaseType::mXcoords.begin(), it_x1);
-        std::size_t i2 = std::distance(BaseType::mXcoords.begin(), it_x2);
-        std::size_t j1 = std::distance(BaseType::mYcoords.begin(), it_y1);
-        std::size_t j2 = std::distance(BaseType::mYcoords.begin(), it_y2);
-        std::size_t k1 = std::distance(BaseType::mZcoords.begin(), it_z1);
-        std::size_t k2 = std::distance(BaseType::mZcoords.begin(), it_z2);
-
-        for(std::size_t i = i1; i < i2; ++i)
-        {
-            for(std::size_t j = j1; j < j2; ++j)
-            {
-                for(std::size_t k = k1; k < k2; ++k)
-                {
-                    key_t key(i, j);
-                    mActiveCells[key].insert(k);
-                }
-            }
-        }
+        tree_t::index_t lo = {i1, j1, k1};
+        tree_t::index_t hi = {i2, j2, k2};
+        mActiveCells.Insert(lo, hi);
     }
 
     bool DomainManager3D::IsInside(const std::vector<double>& bounding_box) const
@@ -83,77 +80,24 @@ namespace Kratos
         double tol = 1.0e-10;
 
         // find the lower bound for the Xmin and upper bound for Xmax
-        std::size_t i1 = 0, i2 = 0;
-        for(coords_container_t::iterator it = BaseType::mXcoords.begin(); it != BaseType::mXcoords.end(); ++it)
-            if(bounding_box[0] > *it - tol)
-                ++i1;
-        if(i1 == 0 || i1 == BaseType::mXcoords.size())
-            return false;
-        else
-            --i1;
-
-        //
-        for(coords_container_t::iterator it = BaseType::mXcoords.begin(); it != BaseType::mXcoords.end(); ++it)
-            if(bounding_box[1] > *it + tol)
-                ++i2;
-        if(i2 == 0 || i2 == BaseType::mXcoords.size())
+        std::size_t i1, i2;
+        if(!BaseType::FindCellRange(BaseType::mXcoords, bounding_box[0], bounding_box[1], tol, i1, i2))
             return false;
 
         // find the lower bound for the Ymin and upper bound for Ymax
-        std::size_t j1 = 0, j2 = 0;
-        for(coords_container_t::iterator it = BaseType::mYcoords.begin(); it != BaseType::mYcoords.end(); ++it)
-            if(bounding_box[2] > *it - tol)
-                ++j1;
-        if(j1 == 0 || j1 == BaseType::mYcoords.size())
-            return false;
-        else
-            --j1;
-
-        //
-        for(coords_container_t::iterator it = BaseType::mYcoords.begin(); it != BaseType::mYcoords.end(); ++it)
-            if(bounding_box[3] > *it + tol)
-                ++j2;
-        if(j2 == 0 || j2 == BaseType::mYcoords.size())
+        std::size_t j1, j2;
+        if(!BaseType::FindCellRange(BaseType::mYcoords, bounding_box[2], bounding_box[3], tol, j1, j2))
             return false;
 
         // find the lower bound for the Zmin and upper bound for Zmax
-        std::size_t k1 = 0, k2 = 0;
-        for(coords_container_t::iterator it = BaseType::mZcoords.begin(); it != BaseType::mZcoords.end(); ++it)
-            if(bounding_box[4] > *it - tol)
-                ++k1;
-        if(k1 == 0 || k1 == BaseType::mZcoords.size())
+        std::size_t k1, k2;
+        if(!BaseType::FindCellRange(BaseType::mZcoords, bounding_box[4], bounding_box[5], tol, k1, k2))
             return false;
-        else
-            --k1;
-
-        //
-        for(coords_container_t::iterator it = BaseType::mZcoords.begin(); it != BaseType::mZcoords.end(); ++it)
-            if(bounding_box[5] > *it + tol)
-                ++k2;
-        if(k2 == 0 || k2 == BaseType::mZcoords.size())
-            return false;
-
 
         // check if in the bound if all the cells are active
-        for(std::size_t i = i1; i < i2; ++i)
-        {
-            for(std::size_t j = j1; j < j2; ++j)
-            {
-                key_t key(i, j);
-                map_t::const_iterator it1 = mActiveCells.find(key);
-                if(it1 == mActiveCells.end())
-                    return false;
-
-                for(std::size_t k = k1; k < k2; ++k)
-                {
-                    index_container_t::iterator it2 = it1->second.find(k);
-                    if(it2 == it1->second.end())
-                        return false;
-                }
-            }
-        }
-
-        return true;
+        tree_t::index_t lo = {i1, j1, k1};
+        tree_t::index_t hi = {i2, j2, k2};
+        return mActiveCells.Contains(lo, hi);
     }
 
     void DomainManager3D::ExportDomain(const std::string& fn, const std::string& color, const double& distance) const
@@ -186,30 +130,29 @@ namespace Kratos
 
 //        this->PrintData(std::cout);
 
-        std::size_t Xi, Yi, Zi, start;
+        std::size_t Xi, Yi, Zi;
+        std::vector<tree_t::index_t> cells;
+        mActiveCells.GetCells(cells);
         outfile << "faces = [";
-        for(map_t::const_iterator it = mActiveCells.begin(); it != mActiveCells.end(); ++it)
+        for(std::size_t c = 0; c < cells.size(); ++c)
         {
-            Xi = it->first.first;
-            Yi = it->first.second;
-            for(index_container_t::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+            Xi = cells[c][0];
+            Yi = cells[c][1];
+            Zi = cells[c][2];
+            std::size_t faces[][4][3] = {
+                        { {Xi, Yi, Zi}, {Xi+1, Yi, Zi}, {Xi+1, Yi+1, Zi}, {Xi, Yi+1, Zi} },
+                        { {Xi, Yi, Zi+1}, {Xi+1, Yi, Zi+1}, {Xi+1, Yi+1, Zi+1}, {Xi, Yi+1, Zi+1} },
+                        { {Xi, Yi, Zi}, {Xi+1, Yi, Zi}, {Xi+1, Yi, Zi+1}, {Xi, Yi, Zi+1} },
+                        { {Xi+1, Yi, Zi}, {Xi+1, Yi+1, Zi}, {Xi+1, Yi+1, Zi+1}, {Xi+1, Yi, Zi+1} },
+                        { {Xi+1, Yi+1, Zi}, {Xi, Yi+1, Zi}, {Xi, Yi+1, Zi+1}, {Xi+1, Yi+1, Zi+1} },
+                        { {Xi, Yi+1, Zi}, {Xi, Yi, Zi}, {Xi, Yi, Zi+1}, {Xi, Yi+1, Zi+1} }
+                        };
+
+            for(unsigned int i = 0; i < 6; ++i)
             {
-                Zi = *it2;
-                std::size_t faces[][4][3] = {
-                            { {Xi, Yi, Zi}, {Xi+1, Yi, Zi}, {Xi+1, Yi+1, Zi}, {Xi, Yi+1, Zi} },
-                            { {Xi, Yi, Zi+1}, {Xi+1, Yi, Zi+1}, {Xi+1, Yi+1, Zi+1}, {Xi, Yi+1, Zi+1} },
-                            { {Xi, Yi, Zi}, {Xi+1, Yi, Zi}, {Xi+1, Yi, Zi+1}, {Xi, Yi, Zi+1} },
-                            { {Xi+1, Yi, Zi}, {Xi+1, Yi+1, Zi}, {Xi+1, Yi+1, Zi+1}, {Xi+1, Yi, Zi+1} },
-                            { {Xi+1, Yi+1, Zi}, {Xi, Yi+1, Zi}, {Xi, Yi+1, Zi+1}, {Xi+1, Yi+1, Zi+1} },
-                            { {Xi, Yi+1, Zi}, {Xi, Yi, Zi}, {Xi, Yi, Zi+1}, {Xi, Yi+1, Zi+1} }
-                            };
-
-                for(unsigned int i = 0; i < 6; ++i)
-                {
-                    for(unsigned int j = 0; j < 4; ++j)
-                        outfile << " " << GetIndex(faces[i][j][0], faces[i][j][1], faces[i][j][2], num_X_coords, num_Y_coords, num_Z_coords) + 1;
-                    outfile << ";\n";
-                }
+                for(unsigned int j = 0; j < 4; ++j)
+                    outfile << " " << GetIndex(faces[i][j][0], faces[i][j][1], faces[i][j][2], num_X_coords, num_Y_coords, num_Z_coords) + 1;
+                outfile << ";\n";
             }
         }
         outfile << "];\n";
@@ -19,6 +19,7 @@
 
 // Project includes
 #include "includes/define.h"
+#include "custom_utilities/region_tree.h"
 #include "custom_utilities/nurbs/domain_manager.h"
 
 namespace Kratos
@@ -26,6 +27,7 @@ namespace Kratos
 
 /**
     This class represents a union of domains (cuboid) in the parameter space of NURBS in 3D. THis is useful to manage the refinement domain in the hierarchical NURBS mesh
+    The active cells of the grid spanned by the coordinates are stored in an octree (RegionTree), hence adding a cell and checking a bounding box only visit the nodes along the box boundary, i.e. O(perimeter * log n) with n the number of coordinates, instead of O(area).
  */
 class DomainManager3D : public DomainManager
 {
@@ -33,9 +35,7 @@ class DomainManager3D : public DomainManager
 public:
     /// Type definition
     typedef DomainManager BaseType;
-    typedef std::pair<std::size_t, std::size_t> key_t;
-    typedef std::set<std::size_t> index_container_t;
-    typedef std::map<key_t, index_container_t> map_t;
+    typedef RegionTree<3> tree_t;
 
     /// Pointer definition
     KRATOS_CLASS_POINTER_DEFINITION(DomainManager3D);
@@ -52,6 +52,9 @@ public:
     /// Check if a Cuboid if it is contained in the Cuboid set.
     virtual bool IsInside(const std::vector<double>& bounding_box) const;
 
+    /// Get the memory used by the domain, in bytes
+    virtual std::size_t MemoryUsage() const;
+
     /// Export the domain to Matlab for visualization
     virtual void ExportDomain(const std::string& fn, const std::string& color, const double& distance) const;
 
@@ -60,7 +63,7 @@ public:
     virtual void PrintData(std::ostream& rOStream) const;
 
 private:
-    map_t mActiveCells;
+    tree_t mActiveCells;
 
     /// Get the index of entry in array. The array is filled in the sequence Z->Y->X
     std::size_t GetIndex(std::size_t X, std::size_t Y, std::size_t Z, std::size_t numX, std::size_t numY, std::size_t numZ) const;
@@ -35,13 +35,17 @@ public:
     KRATOS_CLASS_POINTER_DEFINITION(Knot);
 
     /// Default constructor
-    Knot(const TDataType& Value) : mValue(Value), mIndex(-1), mIsActive(true)
+    Knot(const TDataType& Value) : mValue(Value), mIndex(-1), mHandle(-1), mIsActive(true)
     {}
 
     /// Get and Set for knot index
     const std::size_t& Index() const {return mIndex;}
     void UpdateIndex(const std::size_t& Index) {mIndex = Index;}
 
+    /// Get and Set for knot handle, i.e. the creation order of the knot in the knot vector. Unlike the index, it does not change if new knots are added.
+    const std::size_t& Handle() const {return mHandle;}
+    void SetHandle(const std::size_t& Handle) {mHandle = Handle;}
+
     /// Get the knot value
     TDataType& Value() {return mValue;}
     const TDataType& Value() const {return mValue;}
@@ -58,6 +62,7 @@ public:
 
 private:
     std::size_t mIndex;
+    std::size_t mHandle;
     TDataType mValue;
     bool mIsActive;
 };
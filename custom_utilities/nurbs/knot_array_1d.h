@@ -10,8 +10,10 @@
 #define  KRATOS_ISOGEOMETRIC_APPLICATION_KNOT_ARRAY_1D_H_INCLUDED
 
 // System includes
-#include <deque>
+#include <vector>
 #include <string>
+#include <cmath>
+#include <algorithm>
 #include <iostream>
 
 
@@ -22,6 +24,7 @@
 #include "includes/define.h"
 #include "custom_utilities/iga_define.h"
 #include "custom_utilities/nurbs/knot.h"
+#include "custom_utilities/memory_pool.h"
 
 namespace Kratos
 {
@@ -32,7 +35,12 @@ This container manages the knot array in 1D. It allows for easy insertion, extra
 Short description:
 +   mpKnots is always sorted ascending.
 +   the index of knot starts from 0.
-+   this container stores the array of pointers to the knot, not the knot value itself.
++   this container stores the array of pointers to the knot, not the knot value itself. The pointers are stored
+    contiguously and the knots are allocated in the memory pool of the array, hence traversing the knots is cache-friendly.
++   each knot has an integer handle, i.e. its creation order, which remains valid when other knots are inserted, while
+    the knot index is updated to the sorted position. pKnotByHandle retrieves the knot in O(1).
++   the searches by value are binary searches, hence O(log n). The insertion is O(n), since the indices of the knots
+    after the new one are updated.
  */
 template<typename TDataType>
 class KnotArray1D
@@ -46,7 +54,7 @@ public:
     typedef TDataType value_type; // this is to be in consistent with std::vector
     typedef typename KnotType::Pointer knot_t;
     typedef typename KnotType::ConstPointer const_knot_t;
-    typedef std::deque<knot_t> knot_container_t;
+    typedef std::vector<knot_t> knot_container_t;
     typedef typename knot_container_t::iterator iterator;
     typedef typename knot_container_t::const_iterator const_iterator;
 
@@ -60,27 +68,26 @@ public:
     void clear()
     {
         mpKnots.clear();
+        mpKnotsByHandle.clear();
     }
 
     /// Insert the knot to the array and return its pointer.
     /// This function creates the new knot regardless it is repetitive or not.
     knot_t pCreateKnot(const TDataType& k)
     {
-        // insert to the correct location
-        iterator it;
-        for(it = mpKnots.begin(); it != mpKnots.end(); ++it)
-            if(k < (*it)->Value())
-                break;
-        knot_t p_knot = knot_t(new KnotType(k));
+        // insert to the correct location, i.e. after the knots with the same value
+        iterator it = std::upper_bound(mpKnots.begin(), mpKnots.end(), k, KnotValueLess());
+        if (mpMemoryPool == NULL)
+            mpMemoryPool = MemoryPool::Pointer(new MemoryPool());
+        knot_t p_knot = MemoryPool::Create<KnotType>(mpMemoryPool, k);
+        p_knot->SetHandle(mpKnotsByHandle.size());
+        mpKnotsByHandle.push_back(p_knot);
+        std::size_t index = it - mpKnots.begin();
         mpKnots.insert(it, p_knot);
 
-        // update the index of the knot
-        std::size_t index = 0;
-        for(iterator it = mpKnots.begin(); it != mpKnots.end(); ++it)
-        {
-            (*it)->UpdateIndex(index);
-            ++index;
-        }
+        // update the index of the knot and the knots after it
+        for(std::size_t i = index; i < mpKnots.size(); ++i)
+            mpKnots[i]->UpdateIndex(i);
 
         return p_knot;
     }
@@ -104,15 +111,26 @@ public:
     /// In the case that the knot are repetitive within the tolerance, return the internal one.
     knot_t pCreateUniqueKnot(const TDataType& k, const TDataType& tol)
     {
-        // insert to the correct location
-        for(iterator it = mpKnots.begin(); it != mpKnots.end(); ++it)
+        std::size_t index = this->FindKnot(k, tol);
+        if (index < mpKnots.size())
+            return mpKnots[index];
+        return pCreateKnot(k);
+    }
+
+    /// Find the first knot which value is within the tolerance to k. Return size() if no knot is found.
+    std::size_t FindKnot(const TDataType& k, const TDataType& tol) const
+    {
+        const_iterator it = std::lower_bound(mpKnots.begin(), mpKnots.end(), k - tol, KnotValueLess());
+        if (it != mpKnots.begin())
+            --it; // in case of rounding of k - tol
+        for(; it != mpKnots.end(); ++it)
         {
             if(fabs(k - (*it)->Value()) < tol)
-            {
-                return *it;
-            }
+                return it - mpKnots.begin();
+            if((*it)->Value() - k >= tol)
+                break;
         }
-        return pCreateKnot(k);
+        return mpKnots.size();
     }
 
     /// Reverse this knot
@@ -167,6 +185,24 @@ public:
             KRATOS_THROW_ERROR(std::runtime_error, "Index access out of range", "")
     }
 
+    /// Get the knot by its handle
+    const knot_t pKnotByHandle(const std::size_t& h) const
+    {
+        if(h < mpKnotsByHandle.size())
+            return mpKnotsByHandle[h];
+        else
+            KRATOS_THROW_ERROR(std::runtime_error, "Handle access out of range", h)
+    }
+
+    /// Get the knot by its handle
+    knot_t pKnotByHandle(const std::size_t& h)
+    {
+        if(h < mpKnotsByHandle.size())
+            return mpKnotsByHandle[h];
+        else
+            KRATOS_THROW_ERROR(std::runtime_error, "Handle access out of range", h)
+    }
+
     /// Get the size of the knot vector
     std::size_t size() const {return mpKnots.size();}
 
@@ -411,6 +447,7 @@ public:
     KnotArray1D& operator=(const KnotArray1D& rOther)
     {
         this->mpKnots = rOther.mpKnots;
+        this->mpKnotsByHandle = rOther.mpKnotsByHandle;
         return *this;
     }
 
@@ -447,7 +484,16 @@ public:
 
 private:
 
+    /// Compare the knots by their values, for the binary searches
+    struct KnotValueLess
+    {
+        bool operator()(const TDataType& k, const knot_t& p_knot) const {return k < p_knot->Value();}
+        bool operator()(const knot_t& p_knot, const TDataType& k) const {return p_knot->Value() < k;}
+    };
+
     knot_container_t mpKnots;
+    knot_container_t mpKnotsByHandle; // the knots in the creation order, i.e. mpKnotsByHandle[i]->Handle() == i
+    MemoryPool::Pointer mpMemoryPool; // the knots created by pCreateKnot are allocated here; it is created at the first knot
 };
 
 /// output stream function
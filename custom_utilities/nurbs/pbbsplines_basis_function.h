@@ -220,8 +220,23 @@ public:
     /// Get the derivative of point-based B-splines basis function
     virtual void GetDerivativeAt(std::vector<double>& res, const std::vector<double>& xi) const
     {
-        // TODO
-        KRATOS_THROW_ERROR(std::logic_error, "Error calling unimplemented function", __FUNCTION__)
+        std::vector<double> values(TDim), derivatives(TDim);
+        for (std::size_t dim = 0; dim < TDim; ++dim)
+        {
+            std::vector<double> local_knots;
+            this->LocalKnots(dim, local_knots);
+            BSplineUtils::CoxDeBoor3Der(values[dim], derivatives[dim], xi[dim], this->Order(dim), local_knots);
+        }
+
+        if (res.size() != TDim)
+            res.resize(TDim);
+        for (std::size_t dim = 0; dim < TDim; ++dim)
+        {
+            res[dim] = derivatives[dim];
+            for (std::size_t dim2 = 0; dim2 < TDim; ++dim2)
+                if (dim2 != dim)
+                    res[dim] *= values[dim2];
+        }
     }
 
     /**************************************************************************
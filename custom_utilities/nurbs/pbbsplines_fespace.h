@@ -10,7 +10,10 @@
 #define  KRATOS_ISOGEOMETRIC_APPLICATION_PBBSPLINES_FESPACE_H_INCLUDED
 
 // System includes
+#include <cmath>
 #include <vector>
+#include <algorithm>
+#include <atomic>
 
 // External includes
 #include <boost/array.hpp>
@@ -20,6 +23,7 @@
 #include "containers/array_1d.h"
 #include "custom_utilities/iga_define.h"
 #include "custom_utilities/fespace.h"
+#include "custom_utilities/memory_pool.h"
 #include "isogeometric_application/isogeometric_application.h"
 
 #define DEBUG_GEN_CELL
@@ -55,7 +59,7 @@ public:
     typedef std::map<std::size_t, bf_t> function_map_t;
 
     /// Default constructor
-    PBBSplinesFESpace() : BaseType(), m_function_map_is_created(false)
+    PBBSplinesFESpace() : BaseType(), mpMemoryPool(new MemoryPool()), m_function_map_is_created(false), m_bf_index_is_created(false)
     {
         mpCellManager = typename cell_container_t::Pointer(new TCellManagerType());
     }
@@ -78,6 +82,7 @@ public:
     void AddBf(bf_t p_bf)
     {
         mpBasisFuncs.insert(p_bf);
+        m_bf_index_is_created = false;
     }
 
     /// Check if the bf exists in the list; otherwise create new bf and return
@@ -90,7 +95,7 @@ public:
                 return *it;
 
         // create the new bf and add the knot
-        bf_t p_bf = bf_t(new BasisFunctionType(Id));
+        bf_t p_bf = MemoryPool::Create<BasisFunctionType>(mpMemoryPool, Id);
         for (int dim = 0; dim < TDim; ++dim)
         {
             p_bf->SetLocalKnotVectors(dim, rpKnots[dim]);
@@ -98,6 +103,7 @@ public:
         }
         mpBasisFuncs.insert(p_bf);
         m_function_map_is_created = false;
+        m_bf_index_is_created = false;
 
         return p_bf;
     }
@@ -106,6 +112,7 @@ public:
     void RemoveBf(bf_t p_bf)
     {
         mpBasisFuncs.erase(p_bf);
+        m_bf_index_is_created = false;
     }
 
     // Iterators for the basis functions
@@ -133,15 +140,8 @@ public:
     /// Get the lower and upper bound of the parametric space in a specific direction
     virtual std::vector<double> ParametricBounds(const std::size_t& di) const
     {
-        std::vector<double> bound = {1.0e99, -1.0e99};
-
-        for (bf_iterator it = bf_begin(); it != bf_end(); ++it)
-        {
-            std::vector<double> bb = (*it)->GetBoundingBox();
-            if (bound[0] > bb[2*di]) bound[0] = bb[2*di];
-            if (bound[1] < bb[2*di+1]) bound[1] = bb[2*di+1];
-        }
-
+        this->CheckBfIndex();
+        std::vector<double> bound = {mIndexBounds[2*di], mIndexBounds[2*di+1]};
         return bound;
     }
 
@@ -180,17 +180,11 @@ public:
     /// REMARK: This function only returns the unweighted basis function value. To obtain the correct one, use WeightedFESpace
     virtual void GetValue(double& v, const std::size_t& i, const std::vector<double>& xi) const
     {
-        std::size_t j = 0;
-        for (bf_const_iterator it = bf_begin(); it != bf_end(); ++it)
-        {
-            if (j == i)
-            {
-                v = (*it)->GetValueAt(xi);
-                return;
-            }
-            ++j;
-        }
-        v = 0.0;
+        this->CheckBfIndex();
+        if (i < mBfArray.size())
+            v = this->GetBfValue(i, xi);
+        else
+            v = 0.0;
     }
 
     /// Get the values of the basis functions at point xi
@@ -199,9 +193,32 @@ public:
     {
         if (values.size() != this->TotalNumber())
             values.resize(this->TotalNumber());
-        std::size_t i = 0;
-        for (bf_const_iterator it = bf_begin(); it != bf_end(); ++it)
-            values[i++] = (*it)->GetValueAt(xi);
+        std::fill(values.begin(), values.end(), 0.0);
+
+        // only the functions whose support contains xi are evaluated
+        this->CheckBfIndex();
+        const std::size_t bucket = this->FindBucket(xi);
+        for (std::size_t k = mBucketOffsets[bucket]; k < mBucketOffsets[bucket+1]; ++k)
+        {
+            const std::size_t& i = mBucketItems[k];
+            if (this->IsInSupport(i, xi))
+                values[i] = this->GetBfValue(i, xi);
+        }
+    }
+
+    /// Get the local indices of the basis functions whose support contains the point xi
+    void FindSupportingFunctions(std::vector<std::size_t>& local_ids, const std::vector<double>& xi) const
+    {
+        local_ids.clear();
+
+        this->CheckBfIndex();
+        const std::size_t bucket = this->FindBucket(xi);
+        for (std::size_t k = mBucketOffsets[bucket]; k < mBucketOffsets[bucket+1]; ++k)
+        {
+            const std::size_t& i = mBucketItems[k];
+            if (this->IsInSupport(i, xi))
+                local_ids.push_back(i);
+        }
     }
 
     /// Get the derivative of the basis function i at point xi
@@ -209,15 +226,11 @@ public:
     /// REMARK: This function only returns the unweighted basis function derivatives. To obtain the correct one, use WeightedFESpace
     virtual void GetDerivative(std::vector<double>& values, const std::size_t& i, const std::vector<double>& xi) const
     {
-        std::size_t j = 0;
-        for (bf_const_iterator it = bf_begin(); it != bf_end(); ++it)
+        this->CheckBfIndex();
+        if (i < mBfArray.size())
         {
-            if (j == i)
-            {
-                (*it)->GetDerivativeAt(values, xi);
-                return;
-            }
-            ++j;
+            this->GetBfDerivative(values, i, xi);
+            return;
         }
         if (values.size() != TDim)
             values.resize(TDim);
@@ -231,13 +244,20 @@ public:
     {
         if (values.size() != this->TotalNumber())
             values.resize(this->TotalNumber());
-        std::size_t i = 0;
-        for (bf_const_iterator it = bf_begin(); it != bf_end(); ++it)
+        for (std::size_t i = 0; i < values.size(); ++i)
         {
             if (values[i].size() != TDim)
                 values[i].resize(TDim);
-            (*it)->GetDerivativeAt(values[i], xi);
-            ++i;
+            std::fill(values[i].begin(), values[i].end(), 0.0);
+        }
+
+        this->CheckBfIndex();
+        const std::size_t bucket = this->FindBucket(xi);
+        for (std::size_t k = mBucketOffsets[bucket]; k < mBucketOffsets[bucket+1]; ++k)
+        {
+            const std::size_t& i = mBucketItems[k];
+            if (this->IsInSupport(i, xi))
+                this->GetBfDerivative(values[i], i, xi);
         }
     }
 
@@ -248,25 +268,63 @@ public:
     {
         if (values.size() != this->TotalNumber())
             values.resize(this->TotalNumber());
+        std::fill(values.begin(), values.end(), 0.0);
         if (derivatives.size() != this->TotalNumber())
             derivatives.resize(this->TotalNumber());
-
-        std::size_t i = 0;
-        for (bf_const_iterator it = bf_begin(); it != bf_end(); ++it)
+        for (std::size_t i = 0; i < derivatives.size(); ++i)
         {
-            values[i] = (*it)->GetValueAt(xi);
             if (derivatives[i].size() != TDim)
                 derivatives[i].resize(TDim);
-            (*it)->GetDerivativeAt(derivatives[i], xi);
-            ++i;
+            std::fill(derivatives[i].begin(), derivatives[i].end(), 0.0);
+        }
+
+        this->CheckBfIndex();
+        const std::size_t bucket = this->FindBucket(xi);
+        for (std::size_t k = mBucketOffsets[bucket]; k < mBucketOffsets[bucket+1]; ++k)
+        {
+            const std::size_t& i = mBucketItems[k];
+            if (this->IsInSupport(i, xi))
+            {
+                values[i] = this->GetBfValue(i, xi);
+                this->GetBfDerivative(derivatives[i], i, xi);
+            }
         }
     }
 
-    /// Check if a point lies inside the parametric domain of the BSplinesFESpace
+    /// Get the local indices and values of the basis functions whose support contains the point xi
+    virtual void GetActiveValues(std::vector<std::size_t>& indices, std::vector<double>& values, const std::vector<double>& xi) const
+    {
+        this->FindSupportingFunctions(indices, xi);
+
+        if (values.size() != indices.size())
+            values.resize(indices.size());
+        for (std::size_t k = 0; k < indices.size(); ++k)
+            values[k] = this->GetBfValue(indices[k], xi);
+    }
+
+    /// Get the local indices, values and derivatives of the basis functions whose support contains the point xi
+    /// the output derivatives has the form of derivatives[active_index][dim_index]
+    virtual void GetActiveValuesAndDerivatives(std::vector<std::size_t>& indices, std::vector<double>& values,
+        std::vector<std::vector<double> >& derivatives, const std::vector<double>& xi) const
+    {
+        this->FindSupportingFunctions(indices, xi);
+
+        if (values.size() != indices.size())
+            values.resize(indices.size());
+        if (derivatives.size() != indices.size())
+            derivatives.resize(indices.size());
+        for (std::size_t k = 0; k < indices.size(); ++k)
+        {
+            values[k] = this->GetBfValue(indices[k], xi);
+            this->GetBfDerivative(derivatives[k], indices[k], xi);
+        }
+    }
+
+    /// Check if a point lies inside the parametric domain of the PBBSplinesFESpace, i.e. in one of its cells.
+    /// It may be called concurrently, since the lazy re-packing of the spatial index of the cell manager is guarded.
     virtual bool IsInside(const std::vector<double>& xi) const
     {
-        // TODO
-        KRATOS_THROW_ERROR(std::logic_error, "Error calling unimplemented function", __FUNCTION__)
+        return mpCellManager->FindCells(xi).size() > 0;
     }
 
     /// Compare between two BSplines patches in terms of parametric information
@@ -320,9 +378,9 @@ public:
         for (bf_iterator it = bf_begin(); it != bf_end(); ++it)
         {
             (*it)->SetEquationId(func_indices[cnt]);
-            BaseType::mGlobalToLocal[(*it)->EquationId()] = cnt;
             ++cnt;
         }
+        BaseType::mGlobalToLocal.Assign(func_indices);
     }
 
     /// Enumerate the dofs of each grid function. This function is used to initialize the equation id for all basis functions.
@@ -330,13 +388,11 @@ public:
     /// This function can be used after refinement, providing that all the -1 are overrided, and the start value must be the latest one on the multipatch.
     virtual std::size_t& Enumerate(std::size_t& start)
     {
-        BaseType::mGlobalToLocal.clear();
-        std::size_t cnt = 0;
         for (bf_iterator it = bf_begin(); it != bf_end(); ++it)
         {
             if ((*it)->EquationId() == -1) (*it)->SetEquationId(start++);
-            BaseType::mGlobalToLocal[(*it)->EquationId()] = cnt++;
         }
+        BaseType::mGlobalToLocal.Assign(this->FunctionIndices());
 
         return start;
     }
@@ -357,8 +413,6 @@ public:
     /// Update the function indices using a map. The map shall be the mapping from old index to new index.
     virtual void UpdateFunctionIndices(const std::map<std::size_t, std::size_t>& indices_map)
     {
-        std::size_t cnt = 0;
-        BaseType::mGlobalToLocal.clear();
         for (bf_iterator it = bf_begin(); it != bf_end(); ++it)
         {
             std::map<std::size_t, std::size_t>::const_iterator it2 = indices_map.find((*it)->EquationId());
@@ -370,9 +424,8 @@ public:
             }
 
             (*it)->SetEquationId(it2->second);
-            BaseType::mGlobalToLocal[(*it)->EquationId()] = cnt;
-            ++cnt;
         }
+        BaseType::mGlobalToLocal.Assign(this->FunctionIndices());
     }
 
     /// Get the first equation_id in this space
@@ -531,6 +584,7 @@ public:
     virtual void UpdateCells()
     {
         this->ResetCells();
+        m_bf_index_is_created = false;
 
         // for each cell compute the extraction operator and add to the anchor
         Vector Crow;
@@ -545,7 +599,7 @@ public:
     }
 
     /// Create the cell manager for all the cells in the support domain of the PBBSplinesFESpace
-    virtual typename BaseType::cell_container_t::Pointer ConstructCellManager() const
+    virtual typename BaseType::cell_container_t::ConstPointer ConstructCellManager() const
     {
         return mpCellManager;
     }
@@ -553,9 +607,8 @@ public:
     /// Overload operator[], this allows to access the basis function randomly based on index
     bf_t operator[](const std::size_t& i)
     {
-        typename bf_container_t::iterator it = mpBasisFuncs.begin();
-        std::advance(it, i);
-        return *it;
+        this->CheckBfIndex();
+        return mBfArray[i];
     }
 
     /// Overload operator(), this allows to access the basis function based on its id
@@ -576,7 +629,7 @@ public:
     /// Check if the functional space has the function with equation id
     bool HasBfByEquationId(const std::size_t& EquationId) const
     {
-        return (BaseType::mGlobalToLocal.find(EquationId) != BaseType::mGlobalToLocal.end());
+        return BaseType::mGlobalToLocal.has(EquationId);
     }
 
     /// Check if the functional space has the function with Id
@@ -585,10 +638,17 @@ public:
         return (mFunctionsMap.find(Id) != mFunctionsMap.end());
     }
 
+    /// Check if the basis function is in the functional space
+    bool HasBf(const bf_t& p_bf) const
+    {
+        bf_const_iterator it = mpBasisFuncs.find(p_bf);
+        return (it != mpBasisFuncs.end()) && (*it == p_bf);
+    }
+
     /// Get the basis function by equation id
     bf_t pGetBfByEquationId(const std::size_t& EquationId)
     {
-        return this->operator[](BaseType::mGlobalToLocal[EquationId]);
+        return this->operator[](BaseType::LocalId(EquationId));
     }
 
     /// Overload assignment operator
@@ -641,10 +701,22 @@ protected:
 
     typename cell_container_t::Pointer mpCellManager;
 
+    MemoryPool::Pointer mpMemoryPool; // the basis functions created by CreateBf are allocated here
     bf_container_t mpBasisFuncs;
     mutable function_map_t mFunctionsMap; // map from basis function id to the basis function. It's mainly used to search for the bf quickly. But it needs to be re-initialized whenever new bf is added to the set
     bool m_function_map_is_created;
 
+    /// Uniform grid index of the supports of the basis functions. It is built lazily on the first query and must
+    /// be invalidated (m_bf_index_is_created = false) whenever the basis functions are added, removed or modified.
+    /// The flag is atomic since the first query may come from several threads, e.g. in GridFunction::GetValues.
+    mutable std::vector<bf_t> mBfArray; // basis functions in the order of local index
+    mutable std::vector<double> mBfSupports; // support box of each basis function, [xmin, xmax, ymin, ymax, ...]
+    mutable std::vector<double> mIndexBounds; // bounding box of the space
+    mutable boost::array<std::size_t, TDim> mIndexResolution; // number of buckets in each direction
+    mutable std::vector<std::size_t> mBucketOffsets; // CSR offsets of the buckets
+    mutable std::vector<std::size_t> mBucketItems; // local indices of the basis functions overlapping each bucket
+    mutable std::atomic<bool> m_bf_index_is_created;
+
     void CreateFunctionsMap()
     {
         mFunctionsMap.clear();
@@ -652,6 +724,164 @@ protected:
             mFunctionsMap[(*it)->Id()] = *it;
         m_function_map_is_created = true;
     }
+
+    /// Get the value of the basis function with local index i at point xi. The index must be created.
+    virtual double GetBfValue(const std::size_t& i, const std::vector<double>& xi) const
+    {
+        return mBfArray[i]->GetValueAt(xi);
+    }
+
+    /// Get the derivatives of the basis function with local index i at point xi. The index must be created.
+    virtual void GetBfDerivative(std::vector<double>& values, const std::size_t& i, const std::vector<double>& xi) const
+    {
+        mBfArray[i]->GetDerivativeAt(values, xi);
+    }
+
+    /// Build the data of the derived space which depends on the basis functions in the order of local index, e.g. the
+    /// truncated basis functions. It is called whenever the support index is built, before the index is published.
+    virtual void CreateBfIndexData() const
+    {
+    }
+
+    /// Build the support index if it is not yet available
+    void CheckBfIndex() const
+    {
+        // the acquire load pairs with the release store in CreateBfIndex, so that a thread seeing the flag also sees the index
+        if (!m_bf_index_is_created.load(std::memory_order_acquire))
+        {
+            #pragma omp critical (PBBSplinesFESpace_CreateBfIndex)
+            {
+                if (!m_bf_index_is_created.load(std::memory_order_relaxed))
+                    this->CreateBfIndex();
+            }
+        }
+    }
+
+    /// Build the uniform grid index of the basis function supports
+    void CreateBfIndex() const
+    {
+        const std::size_t n = mpBasisFuncs.size();
+
+        // collect the basis functions and their supports
+        mBfArray.assign(mpBasisFuncs.begin(), mpBasisFuncs.end());
+        mBfSupports.resize(2*TDim*n);
+        mIndexBounds.resize(2*TDim);
+        for (std::size_t dim = 0; dim < TDim; ++dim)
+        {
+            mIndexBounds[2*dim] = 1.0e99;
+            mIndexBounds[2*dim+1] = -1.0e99;
+        }
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            for (std::size_t dim = 0; dim < TDim; ++dim)
+            {
+                const std::vector<knot_t>& local_knots = mBfArray[i]->LocalKnots(dim);
+                const double xmin = CellType::GetValue(local_knots.front());
+                const double xmax = CellType::GetValue(local_knots.back());
+                mBfSupports[2*(i*TDim + dim)] = xmin;
+                mBfSupports[2*(i*TDim + dim) + 1] = xmax;
+                if (mIndexBounds[2*dim] > xmin) mIndexBounds[2*dim] = xmin;
+                if (mIndexBounds[2*dim+1] < xmax) mIndexBounds[2*dim+1] = xmax;
+            }
+        }
+
+        // select the resolution to have about one bucket per basis function
+        const std::size_t nb = std::max(static_cast<std::size_t>(1),
+                static_cast<std::size_t>(std::ceil(std::pow(static_cast<double>(n), 1.0/TDim))));
+        std::size_t nbuckets = 1;
+        for (std::size_t dim = 0; dim < TDim; ++dim)
+        {
+            mIndexResolution[dim] = (mIndexBounds[2*dim+1] > mIndexBounds[2*dim]) ? nb : 1;
+            nbuckets *= mIndexResolution[dim];
+        }
+
+        // distribute the basis functions to the buckets they overlap, in two passes to form the CSR layout
+        mBucketOffsets.assign(nbuckets+1, 0);
+        std::vector<std::size_t> first(TDim), last(TDim);
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            std::vector<std::size_t> pos;
+            if (pass == 1)
+            {
+                for (std::size_t b = 0; b < nbuckets; ++b)
+                    mBucketOffsets[b+1] += mBucketOffsets[b];
+                mBucketItems.resize(mBucketOffsets[nbuckets]);
+                pos.assign(mBucketOffsets.begin(), mBucketOffsets.end()-1);
+            }
+
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                for (std::size_t dim = 0; dim < TDim; ++dim)
+                {
+                    first[dim] = this->FindBucket(dim, mBfSupports[2*(i*TDim + dim)]);
+                    last[dim] = this->FindBucket(dim, mBfSupports[2*(i*TDim + dim) + 1]);
+                }
+
+                // loop over the bucket range of the support
+                std::vector<std::size_t> ijk(first);
+                bool finished = false;
+                while (!finished)
+                {
+                    std::size_t b = 0;
+                    for (int dim = TDim-1; dim >= 0; --dim)
+                        b = b*mIndexResolution[dim] + ijk[dim];
+
+                    if (pass == 0)
+                        ++mBucketOffsets[b+1];
+                    else
+                        mBucketItems[pos[b]++] = i;
+
+                    finished = true;
+                    for (std::size_t dim = 0; dim < TDim; ++dim)
+                    {
+                        if (ijk[dim] < last[dim])
+                        {
+                            ++ijk[dim];
+                            finished = false;
+                            break;
+                        }
+                        ijk[dim] = first[dim];
+                    }
+                }
+            }
+        }
+
+        this->CreateBfIndexData();
+
+        m_bf_index_is_created.store(true, std::memory_order_release);
+    }
+
+    /// Find the bucket index of a coordinate in a specific direction
+    std::size_t FindBucket(const std::size_t& dim, const double& x) const
+    {
+        const double& xmin = mIndexBounds[2*dim];
+        const double& xmax = mIndexBounds[2*dim+1];
+        if (!(xmax > xmin) || x <= xmin)
+            return 0;
+        std::size_t b = static_cast<std::size_t>((x - xmin) / (xmax - xmin) * mIndexResolution[dim]);
+        return std::min(b, mIndexResolution[dim]-1);
+    }
+
+    /// Find the bucket containing a point
+    std::size_t FindBucket(const std::vector<double>& xi) const
+    {
+        std::size_t b = 0;
+        for (int dim = TDim-1; dim >= 0; --dim)
+            b = b*mIndexResolution[dim] + this->FindBucket(dim, xi[dim]);
+        return b;
+    }
+
+    /// Check if the point lies in the (closed) support of the basis function i
+    bool IsInSupport(const std::size_t& i, const std::vector<double>& xi) const
+    {
+        for (std::size_t dim = 0; dim < TDim; ++dim)
+        {
+            if (xi[dim] < mBfSupports[2*(i*TDim + dim)] || xi[dim] > mBfSupports[2*(i*TDim + dim) + 1])
+                return false;
+        }
+        return true;
+    }
 };
 
 /// output stream function
@@ -61,10 +61,10 @@ public:
 
     /// Set the data at specific point
     /// Be careful with this method. You can destroy the coherency of internal data.
-    virtual void SetData(const std::size_t& i, const TDataType& value) {mData[i] = value;}
+    virtual void SetData(const std::size_t& i, const TDataType& value) {mData[i] = value; BaseType::Modified();}
 
     /// overload operator []
-    virtual TDataType& operator[] (const std::size_t& i) {return mData[i];}
+    virtual TDataType& operator[] (const std::size_t& i) {BaseType::Modified(); return mData[i];}
 
     /// overload operator []
     virtual const TDataType& operator[] (const std::size_t& i) const {return mData[i];}
@@ -72,8 +72,8 @@ public:
     /// Overload assignment operator
     BaseStructuredControlGrid<TDataType>& operator=(const BaseStructuredControlGrid<TDataType>& rOther)
     {
-        BaseType::operator=(rOther);
         this->mData = rOther.mData;
+        BaseType::operator=(rOther);
         return *this;
     }
 
@@ -90,13 +90,13 @@ public:
     /************************************/
 
     /// resize the underlying container
-    void Resize(const std::size_t& new_size) {mData.resize(new_size);}
+    void Resize(const std::size_t& new_size) {mData.resize(new_size); BaseType::Modified();}
 
     /// resize the underlying container
-    void resize(const std::size_t& new_size) {mData.resize(new_size);}
+    void resize(const std::size_t& new_size) {mData.resize(new_size); BaseType::Modified();}
 
     /// Access the underlying data
-    DataContainerType& Data() {return mData;}
+    DataContainerType& Data() {BaseType::Modified(); return mData;}
 
     /// Access the underlying data
     const DataContainerType& Data() const {return mData;}
@@ -228,6 +228,7 @@ public:
     void SetValue(const std::size_t& i, const TDataType& value)
     {
         BaseType::Data()[i] = value;
+        BaseType::Modified();
     }
 
     // overload operator ()
@@ -283,6 +284,7 @@ public:
     {
         if (idir == 0)
             std::reverse(BaseType::Data().begin(), BaseType::Data().end());
+        BaseType::Modified();
     }
 
     /// Overload assignment operator
@@ -391,6 +393,7 @@ public:
     void SetValue(const std::size_t& i, const std::size_t& j, const TDataType& value)
     {
         BaseType::Data()[j*mSize[0] + i] = value;
+        BaseType::Modified();
     }
 
     // overload operator ()
@@ -493,6 +496,7 @@ public:
         // }
 
         BSplinesIndexingUtility::Reverse<2, DataContainerType, std::size_t*>(BaseType::Data(), mSize, idir);
+        BaseType::Modified();
     }
 
     /// Get the layer of control grid from the boundary, if the level = 0, the control grid on the boundary will be extracted.
@@ -657,6 +661,7 @@ public:
     void SetValue(const std::size_t& i, const std::size_t& j, const std::size_t& k, const TDataType& value)
     {
         BaseType::Data()[(k*mSize[1] + j)*mSize[0] + i] = value;
+        BaseType::Modified();
     }
 
     // overload operator ()
@@ -798,6 +803,7 @@ public:
         // }
 
         BSplinesIndexingUtility::Reverse<3, DataContainerType, std::size_t*>(BaseType::Data(), mSize, idir);
+        BaseType::Modified();
     }
 
     /// Get the layer of control grid from the boundary, if the level = 0, the control grid on the boundary will be extracted.
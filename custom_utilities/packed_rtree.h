@@ -0,0 +1,367 @@
+//
+//   Project Name:        Kratos
+//   Last Modified by:    $Author: hbui $
+//   Date:                $Date: 18 Oct 2026 $
+//   Revision:            $Revision: 1.0 $
+//
+//
+
+#if !defined(KRATOS_ISOGEOMETRIC_APPLICATION_PACKED_RTREE_H_INCLUDED )
+#define  KRATOS_ISOGEOMETRIC_APPLICATION_PACKED_RTREE_H_INCLUDED
+
+// System includes
+#include <vector>
+#include <map>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+// External includes
+
+// Project includes
+#include "includes/define.h"
+
+namespace Kratos
+{
+
+/**
+An R-tree of axis-aligned boxes which is bulk-loaded by Sort-Tile-Recursive (STR) packing. The tree is stored in flat
+arrays, level by level. It is updated incrementally: the inserted boxes are kept in a pending list which is scanned
+linearly by Search() and indexed by the data for Remove(), and the removed boxes are masked. Update() re-packs the tree in O(n log n) when the pending changes become
+too many, i.e. after a large refinement; small changes are absorbed without re-packing.
+TDataType is the data attached to each box. It must be comparable by operator== and operator<.
+ */
+template<int TDim, class TDataType>
+class PackedRTree
+{
+public:
+    /// Pointer definition
+    KRATOS_CLASS_POINTER_DEFINITION(PackedRTree);
+
+    /// Type definitions
+    typedef TDataType DataType;
+
+    /// Maximum number of children of a node
+    static const std::size_t NodeCapacity = 16;
+
+    /// Default constructor
+    PackedRTree() : mNumberOfRemoved(0) {}
+
+    /// Destructor
+    virtual ~PackedRTree() {}
+
+    /// Get the number of boxes in the tree
+    std::size_t size() const {return mData.size() - mNumberOfRemoved + mPendingData.size();}
+
+    /// Check if the tree is empty
+    bool empty() const {return this->size() == 0;}
+
+    /// Remove all the boxes
+    void Clear()
+    {
+        mBoxes.clear();
+        mData.clear();
+        mNodeBoxes.clear();
+        mNodeChildren.clear();
+        mLevelStart.clear();
+        mRemoved.clear();
+        mNumberOfRemoved = 0;
+        mPendingBoxes.clear();
+        mPendingData.clear();
+        mPendingIndex.clear();
+    }
+
+    /// Insert a box. The tree is not re-packed until Update() is called.
+    void Insert(const double* cmin, const double* cmax, const TDataType& data)
+    {
+        mPendingIndex.insert(typename pending_index_t::value_type(data, mPendingData.size()));
+        mPendingBoxes.push_back(BoxType(cmin, cmax));
+        mPendingData.push_back(data);
+    }
+
+    /// Remove a box with its data. Return false if the box is not found.
+    bool Remove(const double* cmin, const double* cmax, const TDataType& data)
+    {
+        // search in the pending list first
+        typename pending_index_t::iterator it = mPendingIndex.find(data);
+        if (it != mPendingIndex.end())
+        {
+            const std::size_t i = it->second;
+            const std::size_t last = mPendingData.size() - 1;
+            mPendingIndex.erase(it);
+
+            // move the last pending box to the freed slot and update its position in the index
+            if (i != last)
+            {
+                std::pair<typename pending_index_t::iterator, typename pending_index_t::iterator> range = mPendingIndex.equal_range(mPendingData[last]);
+                for (typename pending_index_t::iterator it_last = range.first; it_last != range.second; ++it_last)
+                {
+                    if (it_last->second == last)
+                    {
+                        it_last->second = i;
+                        break;
+                    }
+                }
+                mPendingBoxes[i] = mPendingBoxes[last];
+                mPendingData[i] = mPendingData[last];
+            }
+
+            mPendingBoxes.pop_back();
+            mPendingData.pop_back();
+            return true;
+        }
+
+        // then search in the packed tree and mask it
+        BoxType box(cmin, cmax);
+        std::vector<std::size_t> entries;
+        this->SearchEntries(box, entries);
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            if (!mRemoved[entries[i]] && mData[entries[i]] == data)
+            {
+                mRemoved[entries[i]] = true;
+                ++mNumberOfRemoved;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// Re-pack the tree if the pending insertions or removals are too many to be handled incrementally
+    void Update()
+    {
+        const std::size_t n = mData.size();
+        const std::size_t max_pending = NodeCapacity + static_cast<std::size_t>(std::sqrt(static_cast<double>(n)));
+        if (mPendingData.size() > max_pending || mNumberOfRemoved > NodeCapacity + n/4)
+            this->Rebuild();
+    }
+
+    /// Re-pack the tree with all the current boxes. This is O(n log n).
+    void Rebuild()
+    {
+        std::vector<BoxType> boxes;
+        std::vector<TDataType> data;
+        boxes.reserve(this->size());
+        data.reserve(this->size());
+
+        for (std::size_t i = 0; i < mData.size(); ++i)
+        {
+            if (!mRemoved[i])
+            {
+                boxes.push_back(mBoxes[i]);
+                data.push_back(mData[i]);
+            }
+        }
+
+        boxes.insert(boxes.end(), mPendingBoxes.begin(), mPendingBoxes.end());
+        data.insert(data.end(), mPendingData.begin(), mPendingData.end());
+
+        this->Clear();
+        this->Pack(boxes, data);
+    }
+
+    /// Search for all the boxes overlapping with the box [cmin, cmax]. The results are appended.
+    void Search(const double* cmin, const double* cmax, std::vector<TDataType>& results) const
+    {
+        BoxType box(cmin, cmax);
+
+        std::vector<std::size_t> entries;
+        this->SearchEntries(box, entries);
+        for (std::size_t i = 0; i < entries.size(); ++i)
+            if (!mRemoved[entries[i]])
+                results.push_back(mData[entries[i]]);
+
+        for (std::size_t i = 0; i < mPendingData.size(); ++i)
+            if (mPendingBoxes[i].Overlap(box))
+                results.push_back(mPendingData[i]);
+    }
+
+    /// Information
+    void PrintInfo(std::ostream& rOStream) const
+    {
+        rOStream << "PackedRTree" << TDim << "D, number of boxes = " << this->size()
+                 << ", number of levels = " << mLevelStart.size()
+                 << ", pending = " << mPendingData.size() << ", removed = " << mNumberOfRemoved;
+    }
+
+    void PrintData(std::ostream& rOStream) const
+    {
+    }
+
+private:
+
+    struct BoxType
+    {
+        BoxType() {}
+        BoxType(const double* cmin, const double* cmax)
+        {
+            for (int d = 0; d < TDim; ++d)
+            {
+                min[d] = cmin[d];
+                max[d] = cmax[d];
+            }
+        }
+
+        bool Overlap(const BoxType& rOther) const
+        {
+            for (int d = 0; d < TDim; ++d)
+                if (min[d] > rOther.max[d] || max[d] < rOther.min[d])
+                    return false;
+            return true;
+        }
+
+        void Merge(const BoxType& rOther)
+        {
+            for (int d = 0; d < TDim; ++d)
+            {
+                min[d] = std::min(min[d], rOther.min[d]);
+                max[d] = std::max(max[d], rOther.max[d]);
+            }
+        }
+
+        double Center(const int& d) const {return 0.5*(min[d] + max[d]);}
+
+        double min[TDim];
+        double max[TDim];
+    };
+
+    struct CenterLess
+    {
+        CenterLess(const std::vector<BoxType>& boxes, const int& d) : mrBoxes(boxes), mD(d) {}
+        bool operator()(const std::size_t& a, const std::size_t& b) const
+        {
+            return mrBoxes[a].Center(mD) < mrBoxes[b].Center(mD);
+        }
+        const std::vector<BoxType>& mrBoxes;
+        int mD;
+    };
+
+    typedef std::multimap<TDataType, std::size_t> pending_index_t;
+
+    // packed entries, in the order of the leaves
+    std::vector<BoxType> mBoxes;
+    std::vector<TDataType> mData;
+
+    // nodes of all levels; the children of node i are [mNodeChildren[i].first, mNodeChildren[i].second), which are
+    // the entries for the leaves (level 0) and the nodes of the level below otherwise
+    std::vector<BoxType> mNodeBoxes;
+    std::vector<std::pair<std::size_t, std::size_t> > mNodeChildren;
+    std::vector<std::size_t> mLevelStart;
+
+    // incremental changes
+    std::vector<bool> mRemoved;
+    std::size_t mNumberOfRemoved;
+    std::vector<BoxType> mPendingBoxes;
+    std::vector<TDataType> mPendingData;
+    pending_index_t mPendingIndex; // map from the data to its position in the pending list
+
+    /// Pack the boxes by STR: sort by the center along the first axis, cut into slabs, and recursively tile each slab along the next axes
+    void Pack(const std::vector<BoxType>& boxes, const std::vector<TDataType>& data)
+    {
+        const std::size_t n = boxes.size();
+        if (n == 0)
+            return;
+
+        std::vector<std::size_t> order(n);
+        for (std::size_t i = 0; i < n; ++i)
+            order[i] = i;
+        this->Tile(boxes, order, 0, n, 0);
+
+        mBoxes.resize(n);
+        mData.resize(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            mBoxes[i] = boxes[order[i]];
+            mData[i] = data[order[i]];
+        }
+        mRemoved.assign(n, false);
+
+        // the leaves
+        mLevelStart.push_back(0);
+        for (std::size_t i = 0; i < n; i += NodeCapacity)
+            this->AddNode(mBoxes, i, std::min(i + NodeCapacity, n));
+
+        // the upper levels; the nodes of a level are already spatially coherent hence they are grouped consecutively
+        std::size_t level_begin = 0, level_end = mNodeBoxes.size();
+        while (level_end - level_begin > 1)
+        {
+            mLevelStart.push_back(level_end);
+            for (std::size_t i = level_begin; i < level_end; i += NodeCapacity)
+                this->AddNode(mNodeBoxes, i, std::min(i + NodeCapacity, level_end));
+            level_begin = level_end;
+            level_end = mNodeBoxes.size();
+        }
+    }
+
+    /// Sort the range [begin, end) of order along axis d and cut it into slabs, each of them is tiled along the next axis
+    void Tile(const std::vector<BoxType>& boxes, std::vector<std::size_t>& order, const std::size_t& begin, const std::size_t& end, const int& d)
+    {
+        std::sort(order.begin() + begin, order.begin() + end, CenterLess(boxes, d));
+        if (d == TDim - 1)
+            return;
+
+        const std::size_t n = end - begin;
+        const double nleaves = std::ceil(static_cast<double>(n) / NodeCapacity);
+        const std::size_t nslabs = static_cast<std::size_t>(std::ceil(std::pow(nleaves, 1.0 / (TDim - d))));
+        const std::size_t slab_size = NodeCapacity * static_cast<std::size_t>(std::ceil(nleaves / nslabs));
+        for (std::size_t i = begin; i < end; i += slab_size)
+            this->Tile(boxes, order, i, std::min(i + slab_size, end), d + 1);
+    }
+
+    /// Add a node covering the children [begin, end) of the given list of boxes
+    void AddNode(const std::vector<BoxType>& children, const std::size_t& begin, const std::size_t& end)
+    {
+        BoxType box = children[begin];
+        for (std::size_t i = begin + 1; i < end; ++i)
+            box.Merge(children[i]);
+        mNodeBoxes.push_back(box);
+        mNodeChildren.push_back(std::make_pair(begin, end));
+    }
+
+    /// Search the packed tree for the entries overlapping with the box, including the masked ones
+    void SearchEntries(const BoxType& box, std::vector<std::size_t>& entries) const
+    {
+        if (mNodeBoxes.empty())
+            return;
+
+        std::vector<std::pair<std::size_t, std::size_t> > stack; // (node, level)
+        stack.push_back(std::make_pair(mNodeBoxes.size() - 1, mLevelStart.size() - 1));
+        while (!stack.empty())
+        {
+            const std::size_t node = stack.back().first;
+            const std::size_t level = stack.back().second;
+            stack.pop_back();
+
+            if (!mNodeBoxes[node].Overlap(box))
+                continue;
+
+            const std::pair<std::size_t, std::size_t>& children = mNodeChildren[node];
+            if (level == 0)
+            {
+                for (std::size_t i = children.first; i < children.second; ++i)
+                    if (mBoxes[i].Overlap(box))
+                        entries.push_back(i);
+            }
+            else
+            {
+                for (std::size_t i = children.first; i < children.second; ++i)
+                    stack.push_back(std::make_pair(i, level - 1));
+            }
+        }
+    }
+};
+
+/// output stream function
+template<int TDim, class TDataType>
+inline std::ostream& operator <<(std::ostream& rOStream, const PackedRTree<TDim, TDataType>& rThis)
+{
+    rThis.PrintInfo(rOStream);
+    rOStream << std::endl;
+    rThis.PrintData(rOStream);
+    return rOStream;
+}
+
+}// namespace Kratos.
+
+#endif // KRATOS_ISOGEOMETRIC_APPLICATION_PACKED_RTREE_H_INCLUDED
@@ -12,7 +12,9 @@
 // System includes
 #include <vector>
 #include <list>
+#include <algorithm>
 #include <tuple>
+#include <exception>
 
 // External includes
 #include <boost/any.hpp>
@@ -205,7 +207,7 @@ public:
         typedef typename ControlPointType::CoordinatesType CoordinatesType;
         ControlGrid<CoordinatesType>::Pointer pControlPointCoordinatesGrid = ControlGridUtility::CreateControlPointValueGrid<ControlPointType>(pControlPointGrid);
         pControlPointCoordinatesGrid->SetName("CONTROL_POINT_COORDINATES");
-        typename FESpace<TDim>::Pointer pNewFESpace = WeightedFESpace<TDim>::Create(mpFESpace, this->GetControlWeights());
+        typename FESpace<TDim>::Pointer pNewFESpace = this->pWeightedFESpace();
         typename GridFunction<TDim, CoordinatesType>::Pointer pNewCoordinatesGridFunc = GridFunction<TDim, CoordinatesType>::Create(pNewFESpace, pControlPointCoordinatesGrid);
         mpGridFunctions["CONTROL_POINT_COORDINATES"] = pNewCoordinatesGridFunc;
 
@@ -234,6 +236,17 @@ public:
         return Weights;
     }
 
+    /// Get the weighted FESpace of the patch, i.e. the FESpace weighted by the control point weights. It is shared by the
+    /// grid functions created by CreateGridFunction, so that their basis functions can be evaluated once. A new one is
+    /// created when the FESpace or the weights of the patch are changed.
+    typename FESpace<TDim>::Pointer pWeightedFESpace()
+    {
+        std::vector<double> Weights = this->GetControlWeights();
+        if ((mpWeightedFESpace == NULL) || (mpWeightedFESpace->pFESpace() != mpFESpace) || (mpWeightedFESpace->Weights() != Weights))
+            mpWeightedFESpace = WeightedFESpace<TDim>::Create(mpFESpace, Weights);
+        return mpWeightedFESpace;
+    }
+
     /// Apply the homogeneous transformation to the patch by applying the homogeneous transformation to the control points grid. For DISPLACEMENT, access the grid function for DISPLACEMENT directly and transform it.
     void ApplyTransformation(const TransformationType& trans)
     {
@@ -244,20 +257,20 @@ public:
         typedef typename ControlPointType::CoordinatesType CoordinatesType;
         ControlGrid<CoordinatesType>::Pointer pControlPointCoordinatesGrid = ControlGridUtility::CreateControlPointValueGrid<ControlPointType>(pControlPointGrid);
         pControlPointCoordinatesGrid->SetName("CONTROL_POINT_COORDINATES");
-        typename FESpace<TDim>::Pointer pNewFESpace = WeightedFESpace<TDim>::Create(mpFESpace, this->GetControlWeights());
+        typename FESpace<TDim>::Pointer pNewFESpace = this->pWeightedFESpace();
         typename GridFunction<TDim, CoordinatesType>::Pointer pNewCoordinatesGridFunc = GridFunction<TDim, CoordinatesType>::Create(pNewFESpace, pControlPointCoordinatesGrid);
         mpGridFunctions["CONTROL_POINT_COORDINATES"] = pNewCoordinatesGridFunc;
     }
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    /// Create and add the grid function. This function will create the new FESpace based on the original FESpace of the control grid and the weights, and then assign to the new grid function.
+    /// Create and add the grid function. This function will assign the weighted FESpace of the patch, i.e. the original FESpace of the control grid and the weights, to the new grid function.
     /// One must not use this function for the ControlPoint data type.
     template<typename TDataType>
     typename GridFunction<TDim, TDataType>::Pointer CreateGridFunction(typename ControlGrid<TDataType>::Pointer pControlGrid)
     {
         CheckSize(*pControlGrid, __FUNCTION__);
-        typename FESpace<TDim>::Pointer pNewFESpace = WeightedFESpace<TDim>::Create(mpFESpace, this->GetControlWeights());
+        typename FESpace<TDim>::Pointer pNewFESpace = this->pWeightedFESpace();
         typename GridFunction<TDim, TDataType>::Pointer pNewGridFunc = GridFunction<TDim, TDataType>::Create(pNewFESpace, pControlGrid);
         mpGridFunctions[pControlGrid->Name()] = pNewGridFunc;
         return pNewGridFunc;
@@ -345,6 +358,76 @@ public:
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////
 
+    /// Evaluate the grid functions of a set of variables at a batch of points. Each grid function is evaluated with its own FESpace;
+    /// the basis functions are evaluated once per point and FESpace and contracted against the grid functions sharing it.
+    /// The points are given as [xi_0(0), .., xi_0(TDim-1), xi_1(0), ...].
+    /// On the output, values[i][ip] is the value of the grid function of variables[i] at point ip.
+    /// An error raised in a thread is rethrown after the parallel region.
+    template<class TVariableType>
+    void GetValues(std::vector<std::vector<typename TVariableType::Type> >& values,
+        const std::vector<TVariableType*>& variables, const std::vector<double>& points) const
+    {
+        typedef typename GridFunction<TDim, typename TVariableType::Type>::ConstPointer GridFunctionPointerType;
+
+        // collect the distinct FESpaces of the grid functions
+        std::vector<GridFunctionPointerType> pGridFuncs(variables.size());
+        std::vector<const FESpace<TDim>*> pFESpaces;
+        std::vector<std::size_t> fespace_index(variables.size());
+        for (std::size_t i = 0; i < variables.size(); ++i)
+        {
+            pGridFuncs[i] = this->pGetGridFunction(*variables[i]);
+            pGridFuncs[i]->Validate();
+            const FESpace<TDim>* pFESpace = pGridFuncs[i]->pFESpace().get();
+            fespace_index[i] = std::find(pFESpaces.begin(), pFESpaces.end(), pFESpace) - pFESpaces.begin();
+            if (fespace_index[i] == pFESpaces.size())
+                pFESpaces.push_back(pFESpace);
+        }
+
+        const int npoints = static_cast<int>(points.size() / TDim);
+        if (values.size() != variables.size())
+            values.resize(variables.size());
+        for (std::size_t i = 0; i < values.size(); ++i)
+            if (values[i].size() != npoints)
+                values[i].resize(npoints);
+
+        // the first error raised in the parallel region is kept and rethrown after it
+        std::exception_ptr p_error;
+
+        #pragma omp parallel
+        {
+            std::vector<double> xi(TDim);
+            std::vector<std::vector<std::size_t> > indices(pFESpaces.size());
+            std::vector<std::vector<double> > f_values(pFESpaces.size());
+
+            #pragma omp for
+            for (int ip = 0; ip < npoints; ++ip)
+            {
+                try
+                {
+                    std::copy(points.begin() + ip*TDim, points.begin() + (ip+1)*TDim, xi.begin());
+                    for (std::size_t j = 0; j < pFESpaces.size(); ++j)
+                        pFESpaces[j]->GetActiveValues(indices[j], f_values[j], xi);
+
+                    for (std::size_t i = 0; i < pGridFuncs.size(); ++i)
+                        pGridFuncs[i]->GetValue(values[i][ip], indices[fespace_index[i]], f_values[fespace_index[i]]);
+                }
+                catch (...)
+                {
+                    #pragma omp critical (Patch_GetValues)
+                    {
+                        if (!p_error)
+                            p_error = std::current_exception();
+                    }
+                }
+            }
+        }
+
+        if (p_error)
+            std::rethrow_exception(p_error);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////
+
     /// Compute a rough estimation of the local coordinates of a point by sampling technique
     void Predict(const array_1d<double, 3>& point, array_1d<double, 3>& xi, const std::vector<int>& nsampling,
         const array_1d<double, 3>& xi_min, const array_1d<double, 3>& xi_max) const
@@ -360,6 +443,13 @@ public:
         return pGridFunc->LocalCoordinates(point, xi);
     }
 
+    /// Compute the local coordinates of a batch of points. The starting points are predicted by the point locator of the grid function.
+    void LocalCoordinates(const std::vector<array_1d<double, 3> >& points, std::vector<array_1d<double, 3> >& xis, std::vector<int>& stats) const
+    {
+        typename GridFunction<TDim, array_1d<double, 3> >::ConstPointer pGridFunc = this->pGetGridFunction(CONTROL_POINT_COORDINATES);
+        pGridFunc->LocalCoordinates(points, xis, stats);
+    }
+
     /// Check if the point is inside the patch
     /// This subroutine requires xi0, which is a prediction of the projected local point. This has to be determined, i.e. using a sampling technique.
     bool IsInside(const array_1d<double, 3>& point, const array_1d<double, 3>& xi0) const
@@ -848,6 +938,9 @@ private:
     // Because the control point grid is in homogeneous coordinates, the FESpace shall be an unweighted spaces
     typename FESpace<TDim>::Pointer mpFESpace;
 
+    // the FESpace weighted by the control point weights, shared by the grid functions of the patch
+    typename WeightedFESpace<TDim>::Pointer mpWeightedFESpace;
+
     // container to contain all the grid functions
     GridFunctionContainerType mpGridFunctions; // using boost::any to store pointer to grid function
 
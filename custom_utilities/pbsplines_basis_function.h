@@ -10,6 +10,7 @@
 #define  KRATOS_ISOGEOMETRIC_APPLICATION_PBSPLINES_BASIS_FUNCTION_H_INCLUDED
 
 // System includes
+#include <atomic>
 
 // External includes
 
@@ -40,6 +41,34 @@ struct PBSplinesBasisFunction_InitializeValue_Helper
     }
 };
 
+/**
+ * Track the mutable accesses to the values of the point-based basis functions, see PointBasedControlGrid::Version.
+ * A mutable access only sets a flag, and only if it is not set yet, hence the parallel loops over the basis functions
+ * do not contend on it. Version() consumes the flag and increases the counter, which is shared by all the basis functions.
+ */
+struct PBSplinesBasisFunction_Values_Tracker
+{
+    /// Mark the values as changed
+    static void Modified()
+    {
+        if (!Flag().load(std::memory_order_relaxed))
+            Flag().store(true, std::memory_order_release);
+    }
+
+    /// Get the version of the values. It changes if a value has been accessed mutably since the previous call.
+    static std::size_t Version()
+    {
+        if (Flag().exchange(false, std::memory_order_acq_rel))
+            ++Counter();
+        return Counter().load();
+    }
+
+private:
+
+    static std::atomic<bool>& Flag() {static std::atomic<bool> flag(false); return flag;}
+    static std::atomic<std::size_t>& Counter() {static std::atomic<std::size_t> counter(0); return counter;}
+};
+
 /**
  * Abstract class for point-based Splines basis function.
  * Each basis function associates with a control point via CONTROL_POINT variable.
@@ -83,26 +112,16 @@ public:
                             MODIFICATION SUBROUTINES
     **************************************************************************/
 
-    /// Add a cell support this basis function to the list
+    /// Add a cell support this basis function to the list. If the cell is already in the list, the existing one is returned.
     cell_iterator AddCell(cell_t p_cell)
     {
-        for(cell_iterator it = cell_begin(); it != cell_end(); ++it)
-            if(*it == p_cell)
-                return it;
         return mpCells.insert(p_cell).first;
     }
 
     /// Remove the cell from the list
     void RemoveCell(cell_t p_cell)
     {
-        for(cell_iterator it = cell_begin(); it != cell_end(); ++it)
-        {
-            if(*it == p_cell)
-            {
-                mpCells.erase(it);
-                break;
-            }
-        }
+        mpCells.erase(p_cell);
     }
 
     /// Remove the cell from the list
@@ -174,17 +193,19 @@ public:
     }
 
     /// Access the internal data container, be very careful with this function
-    DataValueContainer& Data() {return mData;}
+    DataValueContainer& Data() {PBSplinesBasisFunction_Values_Tracker::Modified(); return mData;}
     const DataValueContainer& Data() const {return mData;}
 
     /**************************************************************************
                             CONTROL VALUES
       IT IS IMPORTANT TO NOTE THAT THE CONTROL VALUE MUST BE THE WEIGHTED ONE
+      THE MUTABLE ACCESSES ARE TRACKED, SEE PBSplinesBasisFunction_Values_Tracker
     **************************************************************************/
 
     template<class TVariableType>
     typename TVariableType::Type& GetValue(const TVariableType& rThisVariable)
     {
+        PBSplinesBasisFunction_Values_Tracker::Modified();
         return mData.GetValue(rThisVariable);
     }
 
@@ -197,6 +218,7 @@ public:
     template<class TVariableType>
     void SetValue(const TVariableType& rThisVariable, typename TVariableType::Type const& rValue)
     {
+        PBSplinesBasisFunction_Values_Tracker::Modified();
         mData.SetValue(rThisVariable, rValue);
     }
 
@@ -19,6 +19,7 @@
 #include "containers/variable.h"
 #include "custom_utilities/control_point.h"
 #include "custom_utilities/control_grid.h"
+#include "custom_utilities/pbsplines_basis_function.h"
 
 namespace Kratos
 {
@@ -77,13 +78,22 @@ public:
         return mpFESpace->TotalNumber();
     }
 
+    /// Get the version of the control values. The values are stored in the basis functions, hence the version also changes
+    /// when they are written through the basis functions, e.g. by the refinement, see PBSplinesBasisFunction_Values_Tracker
+    virtual std::size_t Version() const
+    {
+        return BaseType::Version() + PBSplinesBasisFunction_Values_Tracker::Version();
+    }
+
     /// Get the data at specific point
     /// It is noted that the return value is unweighted one
     virtual DataType GetData(const std::size_t& i) const
     {
         // TODO Get and Set data in the sequential manner can be expensive if the underlying FESPace uses std::set to store the basis functions.
         // It is suggested to implement the iterator for get and set the values.
-        return (*mpFESpace)[i]->GetValue(mrVariable) / (*mpFESpace)[i]->Weight();
+        // The basis function is read through a const reference, which does not change the version.
+        const typename FESpaceType::BasisFunctionType& r_bf = *(*mpFESpace)[i];
+        return r_bf.GetValue(mrVariable) / r_bf.Weight();
     }
 
     /// Set the data at specific point
@@ -92,12 +102,14 @@ public:
     {
         // TODO see comment in GetData
         (*mpFESpace)[i]->SetValue(mrVariable, value * (*mpFESpace)[i]->Weight());
+        BaseType::Modified();
     }
 
     // overload operator []
     virtual DataType& operator[] (const std::size_t& i)
     {
         // TODO see comment in GetData
+        BaseType::Modified();
         return (*mpFESpace)[i]->GetValue(mrVariable);
     }
 
@@ -105,7 +117,8 @@ public:
     virtual const DataType& operator[] (const std::size_t& i) const
     {
         // TODO see comment in GetData
-        return (*mpFESpace)[i]->GetValue(mrVariable);
+        const typename FESpaceType::BasisFunctionType& r_bf = *(*mpFESpace)[i];
+        return r_bf.GetValue(mrVariable);
     }
 
     /// Information
@@ -180,17 +193,26 @@ public:
         return mpFESpace->TotalNumber();
     }
 
+    /// Get the version of the control values. The values are stored in the basis functions, hence the version also changes
+    /// when they are written through the basis functions, e.g. by the refinement, see PBSplinesBasisFunction_Values_Tracker
+    virtual std::size_t Version() const
+    {
+        return BaseType::Version() + PBSplinesBasisFunction_Values_Tracker::Version();
+    }
+
     /// Get the data at specific point
     virtual DataType GetData(const std::size_t& i) const
     {
         // TODO Get and Set data in the sequential manner can be expensive if the underlying FESPace uses set to store the basis functions. It is suggested to implement the iterator for get and set the values.
-        return (*mpFESpace)[i]->GetValue(mrVariable);
+        const typename FESpaceType::BasisFunctionType& r_bf = *(*mpFESpace)[i];
+        return r_bf.GetValue(mrVariable);
     }
 
     // overload operator []
     virtual DataType& operator[] (const std::size_t& i)
     {
         // TODO see comment in GetData
+        BaseType::Modified();
         return (*mpFESpace)[i]->GetValue(mrVariable);
     }
 
@@ -198,7 +220,8 @@ public:
     virtual const DataType& operator[] (const std::size_t& i) const
     {
         // TODO see comment in GetData
-        return (*mpFESpace)[i]->GetValue(mrVariable);
+        const typename FESpaceType::BasisFunctionType& r_bf = *(*mpFESpace)[i];
+        return r_bf.GetValue(mrVariable);
     }
 
     /// Information
@@ -0,0 +1,315 @@
+//
+//   Project Name:        Kratos
+//   Last Modified by:    $Author: hbui $
+//   Date:                $Date: 18 Oct 2026 $
+//   Revision:            $Revision: 1.0 $
+//
+//
+
+#if !defined(KRATOS_ISOGEOMETRIC_APPLICATION_REGION_TREE_H_INCLUDED )
+#define  KRATOS_ISOGEOMETRIC_APPLICATION_REGION_TREE_H_INCLUDED
+
+// System includes
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <iostream>
+
+// External includes
+
+// Project includes
+#include "includes/define.h"
+
+namespace Kratos
+{
+
+/**
+A region quadtree (TDim = 2) or octree (TDim = 3) which represents a union of cells of an integer grid. Each node
+covers a cube of 2^k x 2^k (x 2^k) grid cells and is either empty, full or partially filled; only the partial nodes have
+children. Adding a box of cells or checking if a box is contained in the region only visits the nodes along the box
+boundary, i.e. O(perimeter * log n) instead of O(area). The full siblings are merged, hence a refined domain which
+consists of large blocks is represented with few nodes. The tree grows automatically when the grid is extended.
+The boxes are given by the half-open index ranges [lo[d], hi[d]).
+ */
+template<int TDim>
+class RegionTree
+{
+public:
+    /// Pointer definition
+    KRATOS_CLASS_POINTER_DEFINITION(RegionTree);
+
+    /// Type definitions
+    typedef std::array<std::size_t, TDim> index_t;
+
+    /// Number of children of a node
+    static const std::size_t NumberOfChildren = (1 << TDim);
+
+    /// Default constructor
+    RegionTree() : mSize(1)
+    {
+        this->Clear();
+    }
+
+    /// Destructor
+    virtual ~RegionTree() {}
+
+    /// Remove all the cells
+    void Clear()
+    {
+        mNodes.assign(1, Node());
+        mFreeBlocks.clear();
+        mSize = 1;
+    }
+
+    /// Get the number of grid cells covered by the tree in each direction
+    const std::size_t& Size() const {return mSize;}
+
+    /// Add the cells in the box [lo, hi) to the region
+    void Insert(const index_t& lo, const index_t& hi)
+    {
+        for (int d = 0; d < TDim; ++d)
+            if (lo[d] >= hi[d])
+                return;
+
+        std::size_t max_hi = 0;
+        for (int d = 0; d < TDim; ++d)
+            if (hi[d] > max_hi)
+                max_hi = hi[d];
+        while (mSize < max_hi)
+            this->Grow();
+
+        index_t origin;
+        for (int d = 0; d < TDim; ++d)
+            origin[d] = 0;
+        this->Insert(0, origin, mSize, lo, hi);
+    }
+
+    /// Check if all the cells in the box [lo, hi) belong to the region. An empty box is always contained.
+    bool Contains(const index_t& lo, const index_t& hi) const
+    {
+        for (int d = 0; d < TDim; ++d)
+            if (lo[d] >= hi[d])
+                return true;
+
+        for (int d = 0; d < TDim; ++d)
+            if (hi[d] > mSize)
+                return false;
+
+        index_t origin;
+        for (int d = 0; d < TDim; ++d)
+            origin[d] = 0;
+        return this->Contains(0, origin, mSize, lo, hi);
+    }
+
+    /// Get all the cells in the region, in the lexicographical order of the index
+    void GetCells(std::vector<index_t>& cells) const
+    {
+        cells.clear();
+        index_t origin;
+        for (int d = 0; d < TDim; ++d)
+            origin[d] = 0;
+        this->CollectCells(0, origin, mSize, cells);
+        std::sort(cells.begin(), cells.end());
+    }
+
+    /// Get the number of nodes in use
+    std::size_t NumberOfNodes() const {return mNodes.size() - mFreeBlocks.size() * NumberOfChildren;}
+
+    /// Get the memory used by the tree, in bytes
+    std::size_t MemoryUsage() const
+    {
+        return mNodes.capacity() * sizeof(Node) + mFreeBlocks.capacity() * sizeof(std::size_t);
+    }
+
+    /// Information
+    void PrintInfo(std::ostream& rOStream) const
+    {
+        rOStream << "RegionTree" << TDim << "D, size = " << mSize << ", number of nodes = " << this->NumberOfNodes()
+                 << ", memory = " << this->MemoryUsage() << " bytes";
+    }
+
+    void PrintData(std::ostream& rOStream) const
+    {
+    }
+
+private:
+
+    enum NodeState {_EMPTY_ = 0, _FULL_ = 1, _PARTIAL_ = 2};
+
+    struct Node
+    {
+        Node() : State(_EMPTY_), FirstChild(0) {}
+        int State;
+        std::size_t FirstChild; // the children are stored contiguously, only valid for partial node
+    };
+
+    std::vector<Node> mNodes; // the root is mNodes[0]
+    std::vector<std::size_t> mFreeBlocks; // the released blocks of children, for reuse
+    std::size_t mSize; // the root covers [0, mSize)^TDim; mSize is a power of 2
+
+    /// Allocate a block of children, all empty
+    std::size_t AllocateChildren()
+    {
+        std::size_t first;
+        if (!mFreeBlocks.empty())
+        {
+            first = mFreeBlocks.back();
+            mFreeBlocks.pop_back();
+            for (std::size_t i = 0; i < NumberOfChildren; ++i)
+                mNodes[first + i] = Node();
+        }
+        else
+        {
+            first = mNodes.size();
+            mNodes.resize(first + NumberOfChildren);
+        }
+        return first;
+    }
+
+    /// Release the children of a node and their descendants
+    void ReleaseChildren(const std::size_t& node)
+    {
+        const std::size_t first = mNodes[node].FirstChild;
+        for (std::size_t i = 0; i < NumberOfChildren; ++i)
+            if (mNodes[first + i].State == _PARTIAL_)
+                this->ReleaseChildren(first + i);
+        mFreeBlocks.push_back(first);
+    }
+
+    /// Double the size of the tree; the old root becomes the first child of the new root
+    void Grow()
+    {
+        if (mNodes[0].State != _EMPTY_)
+        {
+            Node old_root = mNodes[0];
+            const std::size_t first = this->AllocateChildren();
+            mNodes[first] = old_root;
+            mNodes[0].State = _PARTIAL_;
+            mNodes[0].FirstChild = first;
+        }
+        mSize *= 2;
+    }
+
+    /// Get the origin of child c of a node with the given origin and size
+    static index_t ChildOrigin(const index_t& origin, const std::size_t& half, const std::size_t& c)
+    {
+        index_t child_origin = origin;
+        for (int d = 0; d < TDim; ++d)
+            if (c & (1 << d))
+                child_origin[d] += half;
+        return child_origin;
+    }
+
+    void Insert(const std::size_t& node, const index_t& origin, const std::size_t& size, const index_t& lo, const index_t& hi)
+    {
+        if (mNodes[node].State == _FULL_)
+            return;
+
+        bool covered = true;
+        for (int d = 0; d < TDim; ++d)
+        {
+            if (hi[d] <= origin[d] || lo[d] >= origin[d] + size)
+                return; // no intersection
+            if (lo[d] > origin[d] || hi[d] < origin[d] + size)
+                covered = false;
+        }
+
+        if (covered)
+        {
+            if (mNodes[node].State == _PARTIAL_)
+                this->ReleaseChildren(node);
+            mNodes[node].State = _FULL_;
+            return;
+        }
+
+        if (mNodes[node].State == _EMPTY_)
+        {
+            const std::size_t first = this->AllocateChildren(); // mNodes may be reallocated here
+            mNodes[node].State = _PARTIAL_;
+            mNodes[node].FirstChild = first;
+        }
+
+        const std::size_t first = mNodes[node].FirstChild;
+        const std::size_t half = size / 2;
+        bool all_full = true;
+        for (std::size_t c = 0; c < NumberOfChildren; ++c)
+        {
+            this->Insert(first + c, ChildOrigin(origin, half, c), half, lo, hi);
+            all_full = all_full && (mNodes[first + c].State == _FULL_);
+        }
+
+        // merge the full children
+        if (all_full)
+        {
+            mFreeBlocks.push_back(first);
+            mNodes[node].State = _FULL_;
+        }
+    }
+
+    bool Contains(const std::size_t& node, const index_t& origin, const std::size_t& size, const index_t& lo, const index_t& hi) const
+    {
+        for (int d = 0; d < TDim; ++d)
+            if (hi[d] <= origin[d] || lo[d] >= origin[d] + size)
+                return true; // no intersection
+
+        if (mNodes[node].State == _FULL_)
+            return true;
+
+        if (mNodes[node].State == _EMPTY_)
+            return false;
+
+        const std::size_t first = mNodes[node].FirstChild;
+        const std::size_t half = size / 2;
+        for (std::size_t c = 0; c < NumberOfChildren; ++c)
+            if (!this->Contains(first + c, ChildOrigin(origin, half, c), half, lo, hi))
+                return false;
+
+        return true;
+    }
+
+    void CollectCells(const std::size_t& node, const index_t& origin, const std::size_t& size, std::vector<index_t>& cells) const
+    {
+        if (mNodes[node].State == _EMPTY_)
+            return;
+
+        if (mNodes[node].State == _FULL_)
+        {
+            // enumerate all the cells of the node
+            index_t cell = origin;
+            while (true)
+            {
+                cells.push_back(cell);
+                int d = 0;
+                while (d < TDim)
+                {
+                    if (++cell[d] < origin[d] + size)
+                        break;
+                    cell[d] = origin[d];
+                    ++d;
+                }
+                if (d == TDim)
+                    break;
+            }
+            return;
+        }
+
+        const std::size_t first = mNodes[node].FirstChild;
+        const std::size_t half = size / 2;
+        for (std::size_t c = 0; c < NumberOfChildren; ++c)
+            this->CollectCells(first + c, ChildOrigin(origin, half, c), half, cells);
+    }
+};
+
+/// output stream function
+template<int TDim>
+inline std::ostream& operator <<(std::ostream& rOStream, const RegionTree<TDim>& rThis)
+{
+    rThis.PrintInfo(rOStream);
+    rOStream << std::endl;
+    rThis.PrintData(rOStream);
+    return rOStream;
+}
+
+}// namespace Kratos.
+
+#endif // KRATOS_ISOGEOMETRIC_APPLICATION_REGION_TREE_H_INCLUDED
@@ -0,0 +1,228 @@
+//
+//   Project Name:        Kratos
+//   Last Modified by:    $Author: hbui $
+//   Date:                $Date: 18 Oct 2026 $
+//   Revision:            $Revision: 1.0 $
+//
+//
+
+#if !defined(KRATOS_ISOGEOMETRIC_APPLICATION_SAMPLED_POINT_LOCATOR_H_INCLUDED )
+#define  KRATOS_ISOGEOMETRIC_APPLICATION_SAMPLED_POINT_LOCATOR_H_INCLUDED
+
+// System includes
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+// External includes
+
+// Project includes
+#include "includes/define.h"
+
+namespace Kratos
+{
+
+/**
+A static kd-tree over a cloud of sampled points of a grid function. Each sample keeps its parametric coordinates
+(TDim components) and its interpolated value (an arbitrary number of components). The nearest sample to a given
+value is found in O(log n), which is used to predict the starting point for the inversion of the grid function.
+The tree is implicit: it is a permutation of the samples where the median of each range is the splitting node.
+ */
+template<int TDim>
+class SampledPointLocator
+{
+public:
+    /// Pointer definition
+    KRATOS_CLASS_POINTER_DEFINITION(SampledPointLocator);
+
+    /// Default constructor
+    SampledPointLocator() : mNumberOfComponents(0) {}
+
+    /// Destructor
+    virtual ~SampledPointLocator() {}
+
+    /// Set the samples and build the tree. The parametric coordinates are given as [xi_0(0), .., xi_0(TDim-1), xi_1(0), ...]
+    /// and the values as [v_0(0), .., v_0(ncomp-1), v_1(0), ...].
+    void Initialize(const std::vector<double>& xi, const std::vector<double>& values, const std::size_t& ncomp)
+    {
+        if (ncomp == 0)
+            KRATOS_THROW_ERROR(std::logic_error, "The number of components must be positive", "")
+
+        if (xi.size() / TDim != values.size() / ncomp)
+            KRATOS_THROW_ERROR(std::logic_error, "The number of parametric points and values are incompatible", "")
+
+        mNumberOfComponents = ncomp;
+        mXi = xi;
+        mValues = values;
+
+        const std::size_t n = xi.size() / TDim;
+        mTree.resize(n);
+        for (std::size_t i = 0; i < n; ++i)
+            mTree[i] = i;
+        mSplitComponent.resize(n);
+
+        this->Build(0, n);
+    }
+
+    /// Remove all the samples
+    void Clear()
+    {
+        mXi.clear();
+        mValues.clear();
+        mTree.clear();
+        mSplitComponent.clear();
+        mNumberOfComponents = 0;
+    }
+
+    /// Get the number of samples
+    std::size_t size() const {return mTree.size();}
+
+    /// Check if the locator has no sample
+    bool empty() const {return mTree.empty();}
+
+    /// Get the number of components of the values
+    std::size_t NumberOfComponents() const {return mNumberOfComponents;}
+
+    /// Get the parametric coordinates of sample i
+    const double* ParametricCoordinates(const std::size_t& i) const {return &mXi[i*TDim];}
+
+    /// Get the value of sample i
+    const double* Value(const std::size_t& i) const {return &mValues[i*mNumberOfComponents];}
+
+    /// Find the sample whose value is closest to v (in the Euclidean norm). v must have NumberOfComponents() components.
+    std::size_t FindNearest(const double* v) const
+    {
+        if (this->empty())
+            KRATOS_THROW_ERROR(std::logic_error, "The locator is empty", "")
+
+        std::size_t best = mTree[0];
+        double best_dist = this->SquaredDistance(best, v);
+        this->Search(0, this->size(), v, best, best_dist);
+        return best;
+    }
+
+    /// Information
+    void PrintInfo(std::ostream& rOStream) const
+    {
+        rOStream << "SampledPointLocator" << TDim << "D, number of samples = " << this->size()
+                 << ", number of components = " << mNumberOfComponents;
+    }
+
+    void PrintData(std::ostream& rOStream) const
+    {
+    }
+
+private:
+
+    std::vector<double> mXi;
+    std::vector<double> mValues;
+    std::size_t mNumberOfComponents;
+    std::vector<std::size_t> mTree;
+    std::vector<std::size_t> mSplitComponent; // the splitting component of the node, indexed by position in mTree
+
+    struct ComponentLess
+    {
+        ComponentLess(const std::vector<double>& values, const std::size_t& ncomp, const std::size_t& c)
+        : mrValues(values), mNcomp(ncomp), mC(c) {}
+        bool operator()(const std::size_t& a, const std::size_t& b) const
+        {
+            return mrValues[a*mNcomp + mC] < mrValues[b*mNcomp + mC];
+        }
+        const std::vector<double>& mrValues;
+        std::size_t mNcomp, mC;
+    };
+
+    double SquaredDistance(const std::size_t& i, const double* v) const
+    {
+        double d = 0.0;
+        for (std::size_t c = 0; c < mNumberOfComponents; ++c)
+            d += (mValues[i*mNumberOfComponents + c] - v[c]) * (mValues[i*mNumberOfComponents + c] - v[c]);
+        return d;
+    }
+
+    /// Build the tree on the range [lo, hi) by splitting on the component of largest extent
+    void Build(const std::size_t& lo, const std::size_t& hi)
+    {
+        if (hi <= lo + 1)
+        {
+            if (hi == lo + 1)
+                mSplitComponent[lo] = 0;
+            return;
+        }
+
+        std::size_t split = 0;
+        double max_extent = -1.0;
+        for (std::size_t c = 0; c < mNumberOfComponents; ++c)
+        {
+            double vmin = mValues[mTree[lo]*mNumberOfComponents + c], vmax = vmin;
+            for (std::size_t k = lo + 1; k < hi; ++k)
+            {
+                const double& v = mValues[mTree[k]*mNumberOfComponents + c];
+                vmin = std::min(vmin, v);
+                vmax = std::max(vmax, v);
+            }
+
+            if (vmax - vmin > max_extent)
+            {
+                max_extent = vmax - vmin;
+                split = c;
+            }
+        }
+
+        const std::size_t mid = (lo + hi) / 2;
+        std::nth_element(mTree.begin() + lo, mTree.begin() + mid, mTree.begin() + hi, ComponentLess(mValues, mNumberOfComponents, split));
+        mSplitComponent[mid] = split;
+
+        this->Build(lo, mid);
+        this->Build(mid + 1, hi);
+    }
+
+    /// Search the range [lo, hi) for the nearest sample, visiting the far side only if it may contain a closer one
+    void Search(const std::size_t& lo, const std::size_t& hi, const double* v, std::size_t& best, double& best_dist) const
+    {
+        if (hi <= lo)
+            return;
+
+        const std::size_t mid = (lo + hi) / 2;
+        const std::size_t& i = mTree[mid];
+
+        const double dist = this->SquaredDistance(i, v);
+        if (dist < best_dist)
+        {
+            best_dist = dist;
+            best = i;
+        }
+
+        if (hi == lo + 1)
+            return;
+
+        const std::size_t& c = mSplitComponent[mid];
+        const double diff = v[c] - mValues[i*mNumberOfComponents + c];
+        if (diff < 0.0)
+        {
+            this->Search(lo, mid, v, best, best_dist);
+            if (diff*diff < best_dist)
+                this->Search(mid + 1, hi, v, best, best_dist);
+        }
+        else
+        {
+            this->Search(mid + 1, hi, v, best, best_dist);
+            if (diff*diff < best_dist)
+                this->Search(lo, mid, v, best, best_dist);
+        }
+    }
+};
+
+/// output stream function
+template<int TDim>
+inline std::ostream& operator <<(std::ostream& rOStream, const SampledPointLocator<TDim>& rThis)
+{
+    rThis.PrintInfo(rOStream);
+    rOStream << std::endl;
+    rThis.PrintData(rOStream);
+    return rOStream;
+}
+
+}// namespace Kratos.
+
+#endif // KRATOS_ISOGEOMETRIC_APPLICATION_SAMPLED_POINT_LOCATOR_H_INCLUDED
@@ -24,6 +24,7 @@ namespace Kratos
         mLastVertex = 0;
         mLockConstruct = true;
         mIsExtended = false;
+        mpMemoryPool = MemoryPool::Pointer(new MemoryPool());
     }
 
     TsMesh2D::~TsMesh2D()
@@ -64,7 +65,7 @@ namespace Kratos
     TsVertex::Pointer TsMesh2D::AddVertex(knot_t pXi, knot_t pEta)
     {
         LockQuery();
-        TsVertex::Pointer pV = TsVertex::Pointer(new TsVertex(++mLastVertex, pXi, pEta));
+        TsVertex::Pointer pV = MemoryPool::Create<TsVertex>(mpMemoryPool, ++mLastVertex, pXi, pEta);
         mVertices.push_back(pV);
         return pV;
     }
@@ -72,7 +73,7 @@ namespace Kratos
     /// Add a horizontal edge to the topology mesh. User must be responsible for the correctness of the underlying topology since no internal check is performed. However, horizontalness of the edge will be validated in EndConstruct()
     TsEdge::Pointer TsMesh2D::AddHEdge(TsVertex::Pointer pV1, TsVertex::Pointer pV2)
     {
-        TsEdge::Pointer pE = TsEdge::Pointer(new TsHEdge(++mLastEdge, pV1, pV2));
+        TsEdge::Pointer pE = MemoryPool::Create<TsHEdge>(mpMemoryPool, ++mLastEdge, pV1, pV2);
         mEdges.push_back(pE);
 //        std::cout << "add a horizontal edge " << pV1->Id() << " " << pV2->Id() << std::endl;
         return pE;
@@ -81,7 +82,7 @@ namespace Kratos
     /// Add a vertical edge to the topology mesh. User must be responsible for the correctness of the underlying topology since no internal check is performed. However, verticalness of the edge will be validated in EndConstruct()
     TsEdge::Pointer TsMesh2D::AddVEdge(TsVertex::Pointer pV1, TsVertex::Pointer pV2)
     {
-        TsEdge::Pointer pE = TsEdge::Pointer(new TsVEdge(++mLastEdge, pV1, pV2));
+        TsEdge::Pointer pE = MemoryPool::Create<TsVEdge>(mpMemoryPool, ++mLastEdge, pV1, pV2);
         mEdges.push_back(pE);
 //        std::cout << "add a vertical edge " << pV1->Id() << " " << pV2->Id() << std::endl;
         return pE;
@@ -633,7 +634,7 @@ namespace Kratos
                 for(std::size_t i = 0; i < span; ++i)
                 {
                     int new_xi_index = *(tmp_left.end() - span + i);
-                    p_vertex = TsVertex::Pointer(new TsVertex(++mLastVertex, mKnots[0][new_xi_index], mKnots[1][eta_index]));
+                    p_vertex = MemoryPool::Create<TsVertex>(mpMemoryPool, ++mLastVertex, mKnots[0][new_xi_index], mKnots[1][eta_index]);
                     new_virtual_vertices.push_back(p_vertex);
                 }
                 mVirtualVertices.insert(mVirtualVertices.end(), new_virtual_vertices.begin(), new_virtual_vertices.end());
@@ -641,11 +642,11 @@ namespace Kratos
 
                 // insert virtual edges
                 TsEdge::Pointer p_edge;
-                p_edge = TsEdge::Pointer(new TsVirtualHEdge(++mLastEdge, *it, new_virtual_vertices[0]));
+                p_edge = MemoryPool::Create<TsVirtualHEdge>(mpMemoryPool, ++mLastEdge, *it, new_virtual_vertices[0]);
                 mEdges.push_back(p_edge);
                 for(std::size_t i = 0; i < new_virtual_vertices.size() - 1; ++i)
                 {
-                    p_edge = TsEdge::Pointer(new TsVirtualHEdge(++mLastEdge, new_virtual_vertices[i], new_virtual_vertices[i+1]));
+                    p_edge = MemoryPool::Create<TsVirtualHEdge>(mpMemoryPool, ++mLastEdge, new_virtual_vertices[i], new_virtual_vertices[i+1]);
                     mEdges.push_back(p_edge);
                 }
 //                std::cout << *(*it) << " insert virtual edges completed" << std::endl;
@@ -674,7 +675,7 @@ namespace Kratos
                 for(std::size_t i = 0; i < span; ++i)
                 {
                     int new_xi_index = *(tmp_right.begin() + i);
-                    p_vertex = TsVertex::Pointer(new TsVertex(++mLastVertex, mKnots[0][new_xi_index], mKnots[1][eta_index]));
+                    p_vertex = MemoryPool::Create<TsVertex>(mpMemoryPool, ++mLastVertex, mKnots[0][new_xi_index], mKnots[1][eta_index]);
                     new_virtual_vertices.push_back(p_vertex);
                 }
                 mVirtualVertices.insert(mVirtualVertices.end(), new_virtual_vertices.begin(), new_virtual_vertices.end());
@@ -682,11 +683,11 @@ namespace Kratos
 
                 // insert virtual edges
                 TsEdge::Pointer p_edge;
-                p_edge = TsEdge::Pointer(new TsVirtualHEdge(++mLastEdge, *it, new_virtual_vertices[0]));
+                p_edge = MemoryPool::Create<TsVirtualHEdge>(mpMemoryPool, ++mLastEdge, *it, new_virtual_vertices[0]);
                 mEdges.push_back(p_edge);
                 for(std::size_t i = 0; i < new_virtual_vertices.size() - 1; ++i)
                 {
-                    p_edge = TsEdge::Pointer(new TsVirtualHEdge(++mLastEdge, new_virtual_vertices[i], new_virtual_vertices[i+1]));
+                    p_edge = MemoryPool::Create<TsVirtualHEdge>(mpMemoryPool, ++mLastEdge, new_virtual_vertices[i], new_virtual_vertices[i+1]);
                     mEdges.push_back(p_edge);
                 }
 //                std::cout << *(*it) << " insert virtual edges completed" << std::endl;
@@ -715,7 +716,7 @@ namespace Kratos
                 for(std::size_t i = 0; i < span; ++i)
                 {
                     int new_eta_index = *(tmp_up.begin() + i);
-                    p_vertex = TsVertex::Pointer(new TsVertex(++mLastVertex, mKnots[1][xi_index], mKnots[1][new_eta_index]));
+                    p_vertex = MemoryPool::Create<TsVertex>(mpMemoryPool, ++mLastVertex, mKnots[1][xi_index], mKnots[1][new_eta_index]);
                     new_virtual_vertices.push_back(p_vertex);
                 }
                 mVirtualVertices.insert(mVirtualVertices.end(), new_virtual_vertices.begin(), new_virtual_vertices.end());
@@ -723,11 +724,11 @@ namespace Kratos
 
                 // insert virtual edges
                 TsEdge::Pointer p_edge;
-                p_edge = TsEdge::Pointer(new TsVirtualVEdge(++mLastEdge, *it, new_virtual_vertices[0]));
+                p_edge = MemoryPool::Create<TsVirtualVEdge>(mpMemoryPool, ++mLastEdge, *it, new_virtual_vertices[0]);
                 mEdges.push_back(p_edge);
                 for(std::size_t i = 0; i < new_virtual_vertices.size() - 1; ++i)
                 {
-                    p_edge = TsEdge::Pointer(new TsVirtualVEdge(++mLastEdge, new_virtual_vertices[i], new_virtual_vertices[i+1]));
+                    p_edge = MemoryPool::Create<TsVirtualVEdge>(mpMemoryPool, ++mLastEdge, new_virtual_vertices[i], new_virtual_vertices[i+1]);
                     mEdges.push_back(p_edge);
                 }
 //                std::cout << *(*it) << " insert virtual edges completed" << std::endl;
@@ -756,7 +757,7 @@ namespace Kratos
                 for(std::size_t i = 0; i < span; ++i)
                 {
                     int new_eta_index = *(tmp_down.end() - span + i);
-                    p_vertex = TsVertex::Pointer(new TsVertex(++mLastVertex, mKnots[1][xi_index], mKnots[1][new_eta_index]));
+                    p_vertex = MemoryPool::Create<TsVertex>(mpMemoryPool, ++mLastVertex, mKnots[1][xi_index], mKnots[1][new_eta_index]);
                     new_virtual_vertices.push_back(p_vertex);
                 }
                 mVirtualVertices.insert(mVirtualVertices.end(), new_virtual_vertices.begin(), new_virtual_vertices.end());
@@ -764,11 +765,11 @@ namespace Kratos
 
                 // insert virtual edges
                 TsEdge::Pointer p_edge;
-                p_edge = TsEdge::Pointer(new TsVirtualVEdge(++mLastEdge, *it, new_virtual_vertices[0]));
+                p_edge = MemoryPool::Create<TsVirtualVEdge>(mpMemoryPool, ++mLastEdge, *it, new_virtual_vertices[0]);
                 mEdges.push_back(p_edge);
                 for(std::size_t i = 0; i < new_virtual_vertices.size() - 1; ++i)
                 {
-                    p_edge = TsEdge::Pointer(new TsVirtualVEdge(++mLastEdge, new_virtual_vertices[i], new_virtual_vertices[i+1]));
+                    p_edge = MemoryPool::Create<TsVirtualVEdge>(mpMemoryPool, ++mLastEdge, new_virtual_vertices[i], new_virtual_vertices[i+1]);
                     mEdges.push_back(p_edge);
                 }
 //                std::cout << *(*it) << " insert virtual edges completed" << std::endl;
@@ -849,7 +850,7 @@ namespace Kratos
                         dist = sqrt(pow(Xi - (*it).first, 2) + pow(Eta - (*it).second, 2));
                         if(dist < tol)
                         {
-                            pAnchor = TsAnchor::Pointer(new TsAnchor(Id, (*it).first, (*it).second, X, Y, W));
+                            pAnchor = MemoryPool::Create<TsAnchor>(mpMemoryPool, Id, (*it).first, (*it).second, X, Y, W);
                             mAnchors.push_back(pAnchor);
                             found = true;
                             break;
@@ -896,11 +897,11 @@ namespace Kratos
                           fabs(mKnots[1][(*it).second.first]->Value() - mKnots[1][(*it).second.second]->Value());
             if(area > tol)
             {
-                pCell = BCell::Pointer(new BCell(++LastCell,
+                pCell = MemoryPool::Create<BCell>(mpMemoryPool, ++LastCell,
                                                mKnots[0][(*it).first.first],
                                                mKnots[0][(*it).first.second],
                                                mKnots[1][(*it).second.first],
-                                               mKnots[1][(*it).second.second]));
+                                               mKnots[1][(*it).second.second]);
                 mCells.push_back(pCell);
             }
         }
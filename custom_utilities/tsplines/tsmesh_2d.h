@@ -27,6 +27,7 @@
 #include "includes/define.h"
 #include "includes/ublas_interface.h"
 #include "custom_utilities/nurbs/bcell.h"
+#include "custom_utilities/memory_pool.h"
 #include "custom_utilities/tsplines/tsedge.h"
 #include "custom_utilities/tsplines/tsanchor.h"
 
@@ -310,6 +311,8 @@ private:
 
     boost::array<int, 2> mOrder; // order of the Tsplines mesh in horizontal and vertical direction
 
+    MemoryPool::Pointer mpMemoryPool; // the vertices, edges, anchors and cells of the T-splines mesh are allocated here
+
     std::size_t mLastVertex; // internal variable point to the last vertex identification in the T-splines mesh
     std::size_t mLastEdge; // internal variable point to the last edge identification in the T-splines mesh
 
@@ -66,17 +66,17 @@ public:
     virtual std::size_t size() const {return mData.size();}
 
     /// Resize the underlying container
-    void resize(const std::size_t& new_size) {mData.resize(new_size);}
+    void resize(const std::size_t& new_size) {mData.resize(new_size); BaseType::Modified();}
 
     /// Get the data at specific point
     virtual TDataType GetData(const std::size_t& i) const {return mData[i];}
 
     /// Set the data at specific point
     /// Be careful with this method. You can destroy the coherency of internal data.
-    virtual void SetData(const std::size_t& i, const TDataType& value) {mData[i] = value;}
+    virtual void SetData(const std::size_t& i, const TDataType& value) {mData[i] = value; BaseType::Modified();}
 
     /// overload operator []
-    virtual TDataType& operator[] (const std::size_t& i) {return mData[i];}
+    virtual TDataType& operator[] (const std::size_t& i) {BaseType::Modified(); return mData[i];}
 
     /// overload operator []
     virtual const TDataType& operator[] (const std::size_t& i) const {return mData[i];}
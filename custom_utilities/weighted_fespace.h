@@ -11,6 +11,7 @@
 
 // System includes
 #include <vector>
+#include <algorithm>
 
 // External includes
 
@@ -71,6 +72,12 @@ public:
         return mpFESpace->Order(i);
     }
 
+    /// Get the lower and upper bound of the parametric space in a specific direction
+    virtual std::vector<double> ParametricBounds(const std::size_t& di) const
+    {
+        return mpFESpace->ParametricBounds(di);
+    }
+
     /// Set the weight vector
     void SetWeights(const std::vector<double>& weights)
     {
@@ -82,6 +89,9 @@ public:
     /// Get the weight vector
     const std::vector<double>& Weights() const {return mWeights;}
 
+    /// Get the underlying unweighted FESpace
+    typename BaseType::ConstPointer pFESpace() const {return mpFESpace;}
+
     /// Get the string representing the type of the WeightedFESpace
     virtual std::string Type() const
     {
@@ -103,113 +113,122 @@ public:
     /// Get the values of the basis function i at point xi
     virtual void GetValue(double& v, const std::size_t& i, const std::vector<double>& xi) const
     {
+        std::vector<std::size_t> indices;
         std::vector<double> values;
-        mpFESpace->GetValues(values, xi);
+        this->GetActiveValues(indices, values, xi);
 
-        double sum_value = 0.0;
-        for (std::size_t j = 0; j < values.size(); ++j)
-            sum_value += mWeights[j] * values[j];
-
-        if (sum_value == 0.0)
-            v = 0.0;
-        else
-            v = mWeights[i]*values[i] / sum_value;
+        v = 0.0;
+        for (std::size_t k = 0; k < indices.size(); ++k)
+        {
+            if (indices[k] == i)
+            {
+                v = values[k];
+                break;
+            }
+        }
     }
 
     /// Get the values of the basis functions at point xi
     virtual void GetValues(std::vector<double>& new_values, const std::vector<double>& xi) const
     {
+        std::vector<std::size_t> indices;
         std::vector<double> values;
-        mpFESpace->GetValues(values, xi);
-
-        if (new_values.size() != values.size())
-            new_values.resize(values.size());
+        this->GetActiveValues(indices, values, xi);
 
-        double sum_value = 0.0;
-        for (std::size_t i = 0; i < values.size(); ++i)
-            sum_value += mWeights[i] * values[i];
+        if (new_values.size() != this->TotalNumber())
+            new_values.resize(this->TotalNumber());
+        std::fill(new_values.begin(), new_values.end(), 0.0);
 
-        if (sum_value == 0.0)
-            std::fill(new_values.begin(), new_values.end(), 0.0);
-        else
-            for (std::size_t i = 0; i < new_values.size(); ++i)
-                new_values[i] = mWeights[i]*values[i] / sum_value;
+        for (std::size_t k = 0; k < indices.size(); ++k)
+            new_values[indices[k]] = values[k];
     }
 
     /// Get the derivatives of the basis function i at point xi
     virtual void GetDerivative(std::vector<double>& new_dvalues, const std::size_t& i, const std::vector<double>& xi) const
     {
+        std::vector<std::size_t> indices;
         std::vector<double> values;
         std::vector<std::vector<double> > dvalues;
-        mpFESpace->GetValuesAndDerivatives(values, dvalues, xi);
+        this->GetActiveValuesAndDerivatives(indices, values, dvalues, xi);
 
         if (new_dvalues.size() != TDim)
             new_dvalues.resize(TDim);
+        std::fill(new_dvalues.begin(), new_dvalues.end(), 0.0);
 
-        double sum_value = 0.0;
-        std::vector<double> dsum_value(TDim);
-        std::fill(dsum_value.begin(), dsum_value.end(), 0.0);
-        for (std::size_t j = 0; j < values.size(); ++j)
+        for (std::size_t k = 0; k < indices.size(); ++k)
         {
-            sum_value += mWeights[j] * values[j];
-            for (int dim = 0; dim < TDim; ++dim)
-                dsum_value[dim] += mWeights[j] * dvalues[j][dim];
+            if (indices[k] == i)
+            {
+                std::copy(dvalues[k].begin(), dvalues[k].end(), new_dvalues.begin());
+                break;
+            }
         }
-
-        if (sum_value == 0.0)
-            std::fill(new_dvalues.begin(), new_dvalues.end(), 0.0);
-        else
-            for (int dim = 0; dim < TDim; ++dim)
-                new_dvalues[dim] = mWeights[i] * (dvalues[i][dim]/sum_value - values[i]*dsum_value[dim]/pow(sum_value, 2));
     }
 
     /// Get the derivatives of the basis functions at point xi
     /// the output values has the form of values[func_index][dim_index]
     virtual void GetDerivatives(std::vector<std::vector<double> >& new_dvalues, const std::vector<double>& xi) const
     {
+        std::vector<double> new_values;
+        this->GetValuesAndDerivatives(new_values, new_dvalues, xi);
+    }
+
+    /// Get the values and derivatives of the basis functions at point xi
+    /// the output derivatives has the form of values[func_index][dim_index]
+    virtual void GetValuesAndDerivatives(std::vector<double>& new_values, std::vector<std::vector<double> >& new_dvalues, const std::vector<double>& xi) const
+    {
+        std::vector<std::size_t> indices;
         std::vector<double> values;
         std::vector<std::vector<double> > dvalues;
-        mpFESpace->GetValuesAndDerivatives(values, dvalues, xi);
+        this->GetActiveValuesAndDerivatives(indices, values, dvalues, xi);
+
+        if (new_values.size() != this->TotalNumber())
+            new_values.resize(this->TotalNumber());
+        std::fill(new_values.begin(), new_values.end(), 0.0);
 
-        if (new_dvalues.size() != dvalues.size())
-            new_dvalues.resize(dvalues.size());
+        if (new_dvalues.size() != this->TotalNumber())
+            new_dvalues.resize(this->TotalNumber());
         for (std::size_t i = 0; i < new_dvalues.size(); ++i)
+        {
             if (new_dvalues[i].size() != TDim)
                 new_dvalues[i].resize(TDim);
+            std::fill(new_dvalues[i].begin(), new_dvalues[i].end(), 0.0);
+        }
 
-        double sum_value = 0.0;
-        std::vector<double> dsum_value(TDim);
-        std::fill(dsum_value.begin(), dsum_value.end(), 0.0);
-        for (std::size_t i = 0; i < values.size(); ++i)
+        for (std::size_t k = 0; k < indices.size(); ++k)
         {
-            sum_value += mWeights[i] * values[i];
-            for (int dim = 0; dim < TDim; ++dim)
-                dsum_value[dim] += mWeights[i] * dvalues[i][dim];
+            new_values[indices[k]] = values[k];
+            std::copy(dvalues[k].begin(), dvalues[k].end(), new_dvalues[indices[k]].begin());
         }
+    }
 
-        // KRATOS_WATCH(sum_value)
-        // KRATOS_WATCH(dsum_value[0])
+    /// Get the local indices and values of the nonzero rational basis functions at point xi
+    virtual void GetActiveValues(std::vector<std::size_t>& indices, std::vector<double>& values, const std::vector<double>& xi) const
+    {
+        std::vector<std::vector<double> > dummy1, dummy2;
+        mpFESpace->GetActiveValues(indices, values, xi);
+        this->ComputeRationalValuesAndDerivatives(indices, values, dummy1, dummy2, 0);
+    }
 
-        if (sum_value == 0.0)
-        {
-            for (std::size_t i = 0; i < new_dvalues.size(); ++i)
-            {
-                std::fill(new_dvalues[i].begin(), new_dvalues[i].end(), 0.0);
-            }
-        }
-        else
-        {
-            for (std::size_t i = 0; i < new_dvalues.size(); ++i)
-            {
-                for (int dim = 0; dim < TDim; ++dim)
-                {
-                    new_dvalues[i][dim] = mWeights[i] * (dvalues[i][dim]/sum_value - values[i]*dsum_value[dim]/pow(sum_value, 2));
-                }
-            }
-        }
+    /// Get the local indices, values and derivatives of the nonzero rational basis functions at point xi
+    /// the output derivatives has the form of derivatives[active_index][dim_index]
+    virtual void GetActiveValuesAndDerivatives(std::vector<std::size_t>& indices, std::vector<double>& values,
+        std::vector<std::vector<double> >& derivatives, const std::vector<double>& xi) const
+    {
+        std::vector<std::vector<double> > dummy;
+        mpFESpace->GetActiveValuesAndDerivatives(indices, values, derivatives, xi);
+        this->ComputeRationalValuesAndDerivatives(indices, values, derivatives, dummy, 1);
+    }
 
-        // for (std::size_t i = 0; i < new_dvalues.size(); ++i)
-        //     KRATOS_WATCH(new_dvalues[i][0])
+    /// Get the local indices, values, first and second derivatives of the nonzero rational basis functions at point xi
+    /// the output derivatives has the form of derivatives[active_index][dim_index]
+    /// the output second derivatives has the form of second_derivatives[active_index][dim_index_1*TDim + dim_index_2]
+    virtual void GetActiveValuesAndDerivatives(std::vector<std::size_t>& indices, std::vector<double>& values,
+        std::vector<std::vector<double> >& derivatives, std::vector<std::vector<double> >& second_derivatives,
+        const std::vector<double>& xi) const
+    {
+        mpFESpace->GetActiveValuesAndDerivatives(indices, values, derivatives, second_derivatives, xi);
+        this->ComputeRationalValuesAndDerivatives(indices, values, derivatives, second_derivatives, 2);
     }
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -385,6 +404,67 @@ private:
     typename BaseType::Pointer mpFESpace;
     std::vector<double> mWeights;
 
+    /// Transform in place the polynomial values and derivatives (up to order nders) of the active functions to the rational ones.
+    /// The weights are gathered once and the weight function and its derivatives are accumulated in the same pass.
+    /// With R = w*N/W, the derivatives follow from differentiating R*W = w*N:
+    ///     R_a  = (w*N_a - R*W_a) / W
+    ///     R_ab = (w*N_ab - R_a*W_b - R_b*W_a - R*W_ab) / W
+    void ComputeRationalValuesAndDerivatives(const std::vector<std::size_t>& indices, std::vector<double>& values,
+        std::vector<std::vector<double> >& derivatives, std::vector<std::vector<double> >& second_derivatives,
+        const int& nders) const
+    {
+        const std::size_t n = indices.size();
+
+        std::vector<double> w(n);
+        double W = 0.0, dW[TDim], d2W[TDim*TDim];
+        std::fill(dW, dW + TDim, 0.0);
+        std::fill(d2W, d2W + TDim*TDim, 0.0);
+        for (std::size_t k = 0; k < n; ++k)
+        {
+            w[k] = mWeights[indices[k]];
+            W += w[k] * values[k];
+            if (nders > 0)
+                for (int i = 0; i < TDim; ++i)
+                    dW[i] += w[k] * derivatives[k][i];
+            if (nders > 1)
+                for (int i = 0; i < TDim*TDim; ++i)
+                    d2W[i] += w[k] * second_derivatives[k][i];
+        }
+
+        if (W == 0.0)
+        {
+            std::fill(values.begin(), values.end(), 0.0);
+            if (nders > 0)
+                for (std::size_t k = 0; k < n; ++k)
+                    std::fill(derivatives[k].begin(), derivatives[k].end(), 0.0);
+            if (nders > 1)
+                for (std::size_t k = 0; k < n; ++k)
+                    std::fill(second_derivatives[k].begin(), second_derivatives[k].end(), 0.0);
+            return;
+        }
+
+        const double inv_W = 1.0 / W;
+        for (std::size_t k = 0; k < n; ++k)
+        {
+            const double R = w[k] * values[k] * inv_W;
+            values[k] = R;
+
+            if (nders > 0)
+            {
+                for (int i = 0; i < TDim; ++i)
+                    derivatives[k][i] = (w[k] * derivatives[k][i] - R * dW[i]) * inv_W;
+            }
+
+            if (nders > 1)
+            {
+                for (int i = 0; i < TDim; ++i)
+                    for (int j = 0; j < TDim; ++j)
+                        second_derivatives[k][i*TDim + j] = (w[k] * second_derivatives[k][i*TDim + j]
+                            - derivatives[k][i] * dW[j] - derivatives[k][j] * dW[i] - R * d2W[i*TDim + j]) * inv_W;
+            }
+        }
+    }
+
     /// Serializer
     friend class Serializer;
 
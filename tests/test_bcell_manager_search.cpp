@@ -0,0 +1,138 @@
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+#include "includes/define.h"
+#include "custom_utilities/nurbs/knot_array_1d.h"
+#include "custom_utilities/nurbs/bcell.h"
+#include "custom_utilities/nurbs/bcell_manager.h"
+
+using namespace Kratos;
+
+/// Check that the spatial index of BCellManager::GetCells and BCellManager::FindCells gives the same cells as the
+/// brute-force search on a uniform 2D grid of cells
+int main(int argc, char** argv)
+{
+    typedef KnotArray1D<double> knot_container_t;
+    typedef knot_container_t::knot_t knot_t;
+    typedef BCellManager<2, BCell> cell_container_t;
+    typedef cell_container_t::cell_t cell_t;
+
+    std::size_t n = 20;
+    if (argc > 1)
+        n = atoi(argv[1]);
+
+    knot_container_t knots_u, knots_v;
+    for (std::size_t i = 0; i < n+1; ++i)
+    {
+        knots_u.pCreateKnot(((double) i) / n);
+        knots_v.pCreateKnot(((double) i) / n);
+    }
+
+    cell_container_t cells;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            std::vector<knot_t> pKnots = {knots_u.pKnotAt(i), knots_u.pKnotAt(i+1), knots_v.pKnotAt(j), knots_v.pKnotAt(j+1)};
+            cells.CreateCell(pKnots);
+        }
+    }
+
+    // the queries are the 2x2 patches of cells
+    std::vector<cell_t> queries;
+    for (std::size_t i = 0; i < n-1; i += 2)
+    {
+        for (std::size_t j = 0; j < n-1; j += 2)
+        {
+            queries.push_back(cell_t(new BCell(0, knots_u.pKnotAt(i), knots_u.pKnotAt(i+2), knots_v.pKnotAt(j), knots_v.pKnotAt(j+2))));
+        }
+    }
+
+    std::vector<std::vector<std::vector<cell_t> > > found(2, std::vector<std::vector<cell_t> >(queries.size()));
+    const int methods[] = {_CELL_SEARCH_BRUTE_FORCE_, _CELL_SEARCH_SPATIAL_INDEX_};
+    for (int m = 0; m < 2; ++m)
+    {
+        cells.SetSearchMethod(methods[m]);
+        for (std::size_t q = 0; q < queries.size(); ++q)
+        {
+            found[m][q] = cells.GetCells(queries[q]);
+            std::sort(found[m][q].begin(), found[m][q].end());
+        }
+    }
+
+    for (std::size_t q = 0; q < queries.size(); ++q)
+    {
+        if (found[0][q].empty() || found[1][q] != found[0][q])
+        {
+            std::cout << "The cells of the query " << q << " found by the spatial index (" << found[1][q].size()
+                      << ") are different from the brute-force search (" << found[0][q].size() << ")" << std::endl;
+            return 1;
+        }
+    }
+
+    // locate the points of a sorted sampling grid, some of them lie on the cell boundaries
+    const std::size_t np = 4*n + 1;
+    std::vector<std::vector<double> > points;
+    for (std::size_t i = 0; i < np; ++i)
+        for (std::size_t j = 0; j < np; ++j)
+            points.push_back(std::vector<double>{((double) i) / (np-1), ((double) j) / (np-1)});
+
+    std::vector<std::vector<std::vector<cell_t> > > located(3);
+    for (int m = 0; m < 3; ++m)
+    {
+        cells.SetSearchMethod(m == 0 ? _CELL_SEARCH_BRUTE_FORCE_ : _CELL_SEARCH_SPATIAL_INDEX_);
+        if (m < 2)
+        {
+            located[m].resize(points.size());
+            for (std::size_t q = 0; q < points.size(); ++q)
+                located[m][q] = cells.FindCells(points[q]);
+        }
+        else
+            cells.FindCells(located[m], points);
+    }
+
+    for (std::size_t q = 0; q < points.size(); ++q)
+    {
+        if (located[0][q].empty() || located[1][q] != located[0][q] || located[2][q] != located[0][q])
+        {
+            std::cout << "The cells containing point (" << points[q][0] << ", " << points[q][1] << ") are not located correctly" << std::endl;
+            return 1;
+        }
+    }
+
+    // the cells are the same only if they are spanned by the same knots, also when the knot values are equal or
+    // within the tolerance, e.g. the knots of different levels of a hierarchical B-Splines space
+    typedef BCellManager<1, BCell> cell_container_1d_t;
+    cell_container_1d_t cells_1d;
+    cells_1d.SetTolerance(1.0e-3);
+    knot_container_t knots_w, knots_w2;
+    knot_t pKnot1 = knots_w.pCreateKnot(0.49e-3);
+    knot_t pKnot2 = knots_w.pCreateKnot(0.51e-3); // within the tolerance of pKnot1
+    knot_t pKnot3 = knots_w.pCreateKnot(1.0);
+    knot_t pKnot4 = knots_w2.pCreateKnot(0.49e-3); // same value as pKnot1
+    cell_t p_cell1 = cells_1d.CreateCell(std::vector<knot_t>{pKnot1, pKnot3});
+    cell_t p_cell2 = cells_1d.CreateCell(std::vector<knot_t>{pKnot2, pKnot3});
+    cell_t p_cell3 = cells_1d.CreateCell(std::vector<knot_t>{pKnot4, pKnot3});
+    cell_t p_cell4 = cells_1d.CreateCell(std::vector<knot_t>{pKnot1, pKnot3});
+    if (p_cell1 == p_cell2 || p_cell1 == p_cell3 || p_cell2 == p_cell3 || p_cell4 != p_cell1 || cells_1d.size() != 3)
+    {
+        std::cout << "The cells with near-coincident or coincident knots are not distinguished by their knots" << std::endl;
+        return 1;
+    }
+
+    // a cell is removed from the index and the spatial index also when its knot values changed after it was added
+    const std::size_t id1 = p_cell1->Id();
+    pKnot3->Value() = 2.0;
+    cells_1d.erase(p_cell1);
+    knot_t pKnot5 = knots_w2.pCreateKnot(-1.0);
+    knot_t pKnot6 = knots_w2.pCreateKnot(3.0);
+    std::vector<cell_t> covered = cells_1d.GetCells(cell_t(new BCell(0, pKnot5, pKnot6)));
+    cell_t p_cell5 = cells_1d.CreateCell(std::vector<knot_t>{pKnot1, pKnot3});
+    if (cells_1d.size() != 3 || covered.size() != 2 || std::find(covered.begin(), covered.end(), p_cell1) != covered.end() || p_cell5->Id() == id1)
+    {
+        std::cout << "The cell is not removed correctly after its knot values changed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
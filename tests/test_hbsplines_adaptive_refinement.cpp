@@ -0,0 +1,144 @@
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <set>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include "includes/define.h"
+#include "includes/kernel.h"
+#include "includes/model_part.h"
+#include "includes/variables.h"
+#include "isogeometric_application.h"
+#include "custom_utilities/multipatch_model_part.h"
+#include "custom_utilities/hbsplines/hbsplines_adaptive_refinement.h"
+#include "test_hbsplines_utils.h"
+
+using namespace Kratos;
+
+/// Check the model_part against the patch after a refinement step: one node per equation id at the control point, the
+/// transferred values and the deformation, and one element per cell on the anchors of the cell
+bool CheckModelPart(ModelPart& r_model_part, Patch<2>::Pointer pPatch, const double& tol)
+{
+    typedef HBSplinesFESpace<2> FESpaceType;
+    FESpaceType::Pointer pFESpace = boost::dynamic_pointer_cast<FESpaceType>(pPatch->pFESpace());
+
+    if (r_model_part.NumberOfNodes() != pFESpace->TotalNumber())
+    {
+        std::cout << "The number of nodes " << r_model_part.NumberOfNodes() << " is different from the number of basis functions "
+                  << pFESpace->TotalNumber() << std::endl;
+        return false;
+    }
+
+    const std::vector<std::size_t> func_ids = pFESpace->FunctionIndices();
+    for (std::size_t i = 0; i < func_ids.size(); ++i)
+    {
+        ModelPart::NodesContainerType::iterator it_node = r_model_part.Nodes().find(CONVERT_INDEX_IGA_TO_KRATOS(func_ids[i]));
+        if (it_node == r_model_part.Nodes().end())
+        {
+            std::cout << "The node of the equation id " << func_ids[i] << " is missing" << std::endl;
+            return false;
+        }
+
+        const ControlPoint<double>& rPoint = pPatch->pControlPointGridFunction()->pControlGrid()->GetData(i);
+        const double temperature = it_node->GetSolutionStepValue(TEMPERATURE);
+        const array_1d<double, 3>& displacement = it_node->GetSolutionStepValue(DISPLACEMENT);
+
+        double error = std::fabs(it_node->X0() - rPoint.X()) + std::fabs(it_node->Y0() - rPoint.Y());
+        error += std::fabs(temperature - (it_node->X0() + it_node->Y0()));
+        error += std::fabs(displacement[0] - 0.1*it_node->X0());
+        error += std::fabs(it_node->X() - it_node->X0() - displacement[0]) + std::fabs(it_node->Y() - it_node->Y0());
+        if (error > tol)
+        {
+            std::cout << "The node " << it_node->Id() << " is not updated correctly, error = " << error << std::endl;
+            return false;
+        }
+    }
+
+    pFESpace->UpdateCells();
+    std::multiset<std::vector<std::size_t> > cell_nodes, element_nodes;
+    for (FESpaceType::cell_container_t::iterator it = pFESpace->pCellManager()->begin(); it != pFESpace->pCellManager()->end(); ++it)
+    {
+        std::vector<std::size_t> nodes = (*it)->GetSupportedAnchors();
+        for (std::size_t i = 0; i < nodes.size(); ++i)
+            nodes[i] = CONVERT_INDEX_IGA_TO_KRATOS(nodes[i]);
+        cell_nodes.insert(nodes);
+    }
+
+    for (ModelPart::ElementsContainerType::iterator it = r_model_part.Elements().begin(); it != r_model_part.Elements().end(); ++it)
+    {
+        std::vector<std::size_t> nodes(it->GetGeometry().size());
+        for (std::size_t i = 0; i < nodes.size(); ++i)
+            nodes[i] = it->GetGeometry()[i].Id();
+        element_nodes.insert(nodes);
+    }
+
+    if (cell_nodes != element_nodes)
+    {
+        std::cout << "The elements (" << element_nodes.size() << ") do not match the cells (" << cell_nodes.size() << ")" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/// Refine a hierarchical B-Splines patch twice through the model_part and check that the nodes, the transferred values,
+/// the deformed positions and the elements are updated consistently with the refined patch
+int main(int argc, char** argv)
+{
+    std::size_t n = 4;
+    if (argc > 1)
+        n = atoi(argv[1]);
+    const double tol = 1.0e-10;
+
+    Kernel kernel;
+    KratosIsogeometricApplication application;
+    kernel.Initialize();
+    kernel.AddApplication(application);
+
+    MultiPatch<2>::Pointer pMultiPatch;
+    Patch<2>::Pointer pPatch = CreateHBSplinesPatch<2>(n, 2, pMultiPatch);
+
+    MultiPatchModelPart<2>::Pointer pMPModelPart = MultiPatchModelPart<2>::Pointer(new MultiPatchModelPart<2>(pMultiPatch));
+    pMPModelPart->BeginModelPart();
+    pMPModelPart->pModelPart()->AddNodalSolutionStepVariable(TEMPERATURE);
+    pMPModelPart->pModelPart()->AddNodalSolutionStepVariable(DISPLACEMENT);
+    pMPModelPart->CreateNodes();
+    pMPModelPart->EndModelPart();
+
+    ModelPart& r_model_part = *(pMPModelPart->pModelPart());
+    for (ModelPart::NodesContainerType::iterator it = r_model_part.NodesBegin(); it != r_model_part.NodesEnd(); ++it)
+    {
+        it->GetSolutionStepValue(TEMPERATURE) = it->X0() + it->Y0();
+        it->GetSolutionStepValue(DISPLACEMENT_X) = 0.1*it->X0();
+        it->X() = it->X0() + 0.1*it->X0();
+    }
+
+    HBSplinesAdaptiveRefinement<2> refinement(pMPModelPart);
+    refinement.AddElements(pPatch, "DummyElementBezier2D", r_model_part.pGetProperties(1));
+    refinement.AddTransferVariable(TEMPERATURE);
+    refinement.AddTransferVariable(DISPLACEMENT);
+
+    for (std::size_t step = 0; step < 2; ++step)
+    {
+        // refine the first element, and the last one at the second step, which lies in the refined region
+        std::size_t element_id = r_model_part.Elements().begin()->Id();
+        if (step == 1)
+            element_id = (r_model_part.Elements().end() - 1)->Id();
+
+        const std::size_t nrefined = refinement.RefineElements(std::vector<std::size_t>(1, element_id));
+        if (nrefined == 0)
+        {
+            std::cout << "No basis function is refined at step " << step << std::endl;
+            return 1;
+        }
+
+        if (!CheckModelPart(r_model_part, pPatch, tol))
+        {
+            std::cout << "The model_part is not consistent with the patch after step " << step << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <set>
+#include <map>
+#include <algorithm>
+#include "includes/define.h"
+#include "custom_utilities/hbsplines/hbsplines_refinement_utility.h"
+#include "test_hbsplines_utils.h"
+
+using namespace Kratos;
+
+/// Create a hierarchical B-Splines patch of order p with n x n (x n) elements over the unit square/cube. The control
+/// points are perturbed, so that the geometry is not reproduced by any of the refined patches trivially. The refined bfs
+/// are kept for the coarsening, unless coarsening_enabled is false.
+template<int TDim>
+typename Patch<TDim>::Pointer CreatePerturbedPatch(const std::size_t& n, const std::size_t& p, typename MultiPatch<TDim>::Pointer& pMultiPatch,
+        const bool& coarsening_enabled = true)
+{
+    typename Patch<TDim>::Pointer pPatch = CreateHBSplinesPatch<TDim>(n, p, pMultiPatch);
+
+    typedef HBSplinesFESpace<TDim> FESpaceType;
+    typename FESpaceType::Pointer pFESpace = boost::dynamic_pointer_cast<FESpaceType>(pPatch->pFESpace());
+    pFESpace->SetCoarseningEnabled(coarsening_enabled);
+    for (typename FESpaceType::bf_iterator it = pFESpace->bf_begin(); it != pFESpace->bf_end(); ++it)
+    {
+        ControlPoint<double>& rPoint = (*it)->GetValue(CONTROL_POINT);
+        const double id = static_cast<double>((*it)->Id());
+        rPoint[0] += 0.01 * std::sin(id);
+        rPoint[1] += 0.01 * std::cos(3.0*id);
+        rPoint[2] += 0.01 * std::sin(7.0*id);
+        rPoint[3] *= 1.0 + 0.1 * std::cos(id);
+    }
+
+    return pPatch;
+}
+
+/// Compute the Bezier control points of all the cells, identified by the bounds of the cell, since the cells created
+/// by the coarsening have new Ids
+template<int TDim>
+void Extract(typename Patch<TDim>::Pointer pPatch, std::map<std::vector<long long>, Matrix>& rBezierPoints)
+{
+    typedef HBSplinesFESpace<TDim> FESpaceType;
+    typename FESpaceType::Pointer pFESpace = boost::dynamic_pointer_cast<FESpaceType>(pPatch->pFESpace());
+    pFESpace->UpdateCells();
+
+    rBezierPoints.clear();
+    for (typename FESpaceType::cell_container_t::iterator it = pFESpace->pCellManager()->begin(); it != pFESpace->pCellManager()->end(); ++it)
+    {
+        std::vector<long long> key;
+        key.push_back(static_cast<long long>(std::floor((*it)->XiMinValue() * 1.0e8 + 0.5)));
+        key.push_back(static_cast<long long>(std::floor((*it)->XiMaxValue() * 1.0e8 + 0.5)));
+        key.push_back(static_cast<long long>(std::floor((*it)->EtaMinValue() * 1.0e8 + 0.5)));
+        key.push_back(static_cast<long long>(std::floor((*it)->EtaMaxValue() * 1.0e8 + 0.5)));
+        key.push_back(static_cast<long long>(std::floor((*it)->ZetaMinValue() * 1.0e8 + 0.5)));
+        key.push_back(static_cast<long long>(std::floor((*it)->ZetaMaxValue() * 1.0e8 + 0.5)));
+        rBezierPoints[key] = ComputeBezierPoints<TDim>(pFESpace, *it);
+    }
+}
+
+/// Compute the maximum difference of the Bezier control points of the cells of two patches
+template<int TDim>
+double Difference(typename Patch<TDim>::Pointer pPatch1, typename Patch<TDim>::Pointer pPatch2)
+{
+    std::map<std::vector<long long>, Matrix> points1, points2;
+    Extract<TDim>(pPatch1, points1);
+    Extract<TDim>(pPatch2, points2);
+
+    if (points1.size() != points2.size() || pPatch1->pFESpace()->TotalNumber() != pPatch2->pFESpace()->TotalNumber())
+        return 1.0e99;
+
+    double diff = 0.0;
+    for (std::map<std::vector<long long>, Matrix>::iterator it = points1.begin(); it != points1.end(); ++it)
+    {
+        std::map<std::vector<long long>, Matrix>::iterator it2 = points2.find(it->first);
+        if (it2 == points2.end() || it2->second.size1() != it->second.size1())
+            return 1.0e99;
+        for (std::size_t i = 0; i < it->second.size1(); ++i)
+            for (std::size_t j = 0; j < it->second.size2(); ++j)
+                diff = std::max(diff, std::fabs(it2->second(i, j) - it->second(i, j)));
+    }
+
+    return diff;
+}
+
+/// Refine and coarsen the patch in several ways; the coarsened patch must be the same as the patch which is refined
+/// without the coarsened part. The refined bfs must only be kept if the coarsening is enabled.
+template<int TDim>
+bool Check(const std::size_t& n, const std::size_t& p)
+{
+    const double tol = 1.0e-10;
+
+    // refine two nested windows and coarsen everything, the patch must return to the original one
+    typename MultiPatch<TDim>::Pointer pMultiPatch, pRefMultiPatch;
+    typename Patch<TDim>::Pointer pPatch = CreatePerturbedPatch<TDim>(n, p, pMultiPatch);
+    typename Patch<TDim>::Pointer pRefPatch = CreatePerturbedPatch<TDim>(n, p, pRefMultiPatch);
+
+    HBSplinesRefinementUtility::RefineWindow<TDim>(pPatch, Window<TDim>(0.0, 0.5), 0);
+    HBSplinesRefinementUtility::RefineWindow<TDim>(pPatch, Window<TDim>(0.0, 0.3), 0);
+    HBSplinesRefinementUtility::CoarsenWindow<TDim>(pPatch, Window<TDim>(0.0, 1.0), 0);
+
+    double error = Difference<TDim>(pPatch, pRefPatch);
+    if (error > tol)
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the coarsening does not revert the refinement, error = " << error << std::endl;
+        return false;
+    }
+
+    // coarsen only the finest level, the patch must be the one refined once
+    HBSplinesRefinementUtility::RefineWindow<TDim>(pPatch, Window<TDim>(0.0, 0.5), 0);
+    HBSplinesRefinementUtility::RefineWindow<TDim>(pPatch, Window<TDim>(0.0, 0.3), 0);
+    HBSplinesRefinementUtility::RefineWindow<TDim>(pRefPatch, Window<TDim>(0.0, 0.5), 0);
+
+    typename HBSplinesFESpace<TDim>::Pointer pFESpace = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatch->pFESpace());
+    std::vector<std::size_t> Ids;
+    for (typename HBSplinesFESpace<TDim>::refined_bf_iterator it = pFESpace->refined_bf_begin(); it != pFESpace->refined_bf_end(); ++it)
+        if (it->second->Level() == 2)
+            Ids.push_back(it->first);
+    HBSplinesRefinementUtility::Coarsen<TDim>(pPatch, Ids, 0);
+    pMultiPatch->Enumerate();
+
+    error = Difference<TDim>(pPatch, pRefPatch);
+    if (error > tol)
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the coarsening of the finest level is different from the refinement"
+                  << " of the coarse level, error = " << error << std::endl;
+        return false;
+    }
+
+    // refine two separated windows and coarsen one of them
+    typename MultiPatch<TDim>::Pointer pMultiPatch2, pRefMultiPatch2;
+    typename Patch<TDim>::Pointer pPatch2 = CreatePerturbedPatch<TDim>(n, p, pMultiPatch2);
+    typename Patch<TDim>::Pointer pRefPatch2 = CreatePerturbedPatch<TDim>(n, p, pRefMultiPatch2);
+
+    HBSplinesRefinementUtility::RefineWindow<TDim>(pPatch2, Window<TDim>(0.0, 0.4), 0);
+    HBSplinesRefinementUtility::RefineWindow<TDim>(pPatch2, Window<TDim>(0.6, 1.0), 0);
+    HBSplinesRefinementUtility::RefineWindow<TDim>(pRefPatch2, Window<TDim>(0.6, 1.0), 0);
+    HBSplinesRefinementUtility::CoarsenWindow<TDim>(pPatch2, Window<TDim>(0.0, 0.4), 0);
+
+    error = Difference<TDim>(pPatch2, pRefPatch2);
+    if (error > tol)
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the coarsening of one window is different from the refinement"
+                  << " of the other window, error = " << error << std::endl;
+        return false;
+    }
+
+    // the refined bfs are only kept if the coarsening is enabled, and are released when it is disabled
+    typename MultiPatch<TDim>::Pointer pMultiPatch3;
+    typename Patch<TDim>::Pointer pPatch3 = CreatePerturbedPatch<TDim>(n, p, pMultiPatch3, false);
+    HBSplinesRefinementUtility::RefineWindow<TDim>(pPatch3, Window<TDim>(0.0, 0.5), 0);
+    typename HBSplinesFESpace<TDim>::Pointer pFESpace2 = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatch2->pFESpace());
+    if (boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatch3->pFESpace())->NumberOfRefinedBfs() != 0
+        || pFESpace2->NumberOfRefinedBfs() == 0)
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the refined bfs are not kept if and only if the coarsening is enabled" << std::endl;
+        return false;
+    }
+
+    pFESpace2->SetCoarseningEnabled(false);
+    if (pFESpace2->NumberOfRefinedBfs() != 0)
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the refined bfs are not released when the coarsening is disabled" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/// Check that the coarsening of the hierarchical B-Splines patches reverts the refinement
+int main(int argc, char** argv)
+{
+    std::size_t n = 8;
+    if (argc > 1)
+        n = atoi(argv[1]);
+
+    if (!Check<2>(n, 2)) return 1;
+    if (!Check<2>(n, 3)) return 1;
+    if (!Check<3>(n/2, 2)) return 1;
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <algorithm>
+#include "includes/define.h"
+#include "custom_utilities/hbsplines/hbsplines_refinement_utility.h"
+#include "test_hbsplines_utils.h"
+
+using namespace Kratos;
+
+/// Describe the basis functions and the cells of the patch in the order of their Id
+template<int TDim>
+std::string Describe(typename Patch<TDim>::Pointer pPatch)
+{
+    typedef HBSplinesFESpace<TDim> FESpaceType;
+    typename FESpaceType::Pointer pFESpace = boost::dynamic_pointer_cast<FESpaceType>(pPatch->pFESpace());
+
+    std::stringstream ss;
+    ss << std::setprecision(17);
+    for (typename FESpaceType::bf_iterator it = pFESpace->bf_begin(); it != pFESpace->bf_end(); ++it)
+    {
+        const ControlPoint<double>& rPoint = (*it)->GetValue(CONTROL_POINT);
+        ss << "bf " << (*it)->Id() << " " << (*it)->EquationId() << " " << (*it)->Level()
+           << " " << rPoint.X() << " " << rPoint.Y() << " " << rPoint.Z() << " " << rPoint.W() << " cells";
+
+        // the cells of a bf are ordered by their address, hence they are sorted by Id here
+        std::vector<std::size_t> cell_ids;
+        for (typename FESpaceType::BasisFunctionType::cell_iterator it_cell = (*it)->cell_begin(); it_cell != (*it)->cell_end(); ++it_cell)
+            cell_ids.push_back((*it_cell)->Id());
+        std::sort(cell_ids.begin(), cell_ids.end());
+        for (std::size_t i = 0; i < cell_ids.size(); ++i)
+            ss << " " << cell_ids[i];
+        ss << std::endl;
+    }
+
+    for (typename FESpaceType::cell_container_t::iterator it = pFESpace->pCellManager()->begin(); it != pFESpace->pCellManager()->end(); ++it)
+    {
+        ss << "cell " << (*it)->Id() << " " << (*it)->Level() << " " << (*it)->XiMinValue() << " " << (*it)->XiMaxValue()
+           << " " << (*it)->EtaMinValue() << " " << (*it)->EtaMaxValue() << " " << (*it)->ZetaMinValue() << " " << (*it)->ZetaMaxValue()
+           << " bfs " << std::distance((*it)->bf_begin(), (*it)->bf_end()) << std::endl;
+    }
+
+    return ss.str();
+}
+
+/// Refine a sequence of windows of the patch with the given number of threads and describe the result
+template<int TDim>
+std::string RefineWindows(const std::size_t& n, const std::size_t& p, const int& nthreads)
+{
+    typename MultiPatch<TDim>::Pointer pMultiPatch;
+    typename Patch<TDim>::Pointer pPatch = CreateHBSplinesPatch<TDim>(n, p, pMultiPatch);
+
+    omp_set_num_threads(nthreads);
+    for (std::size_t cycle = 0; cycle < 3; ++cycle)
+        HBSplinesRefinementUtility::RefineWindow<TDim>(pPatch, Window<TDim>(0.1 + 0.05*cycle, 0.8 - 0.1*cycle), 0);
+
+    return Describe<TDim>(pPatch);
+}
+
+/// Refine the patch with one thread, half of the threads and all the threads; the results must be identical
+template<int TDim>
+bool Check(const std::size_t& n, const std::size_t& p)
+{
+    const int max_threads = omp_get_max_threads();
+    std::vector<int> nthreads(1, 1);
+    if (max_threads > 3)
+        nthreads.push_back(max_threads / 2);
+    if (max_threads > 1)
+        nthreads.push_back(max_threads);
+
+    std::string reference;
+    for (std::size_t i = 0; i < nthreads.size(); ++i)
+    {
+        std::string result = RefineWindows<TDim>(n, p, nthreads[i]);
+        if (i == 0)
+            reference = result;
+
+        if (result != reference)
+        {
+            std::cout << TDim << "D, n = " << n << ", p = " << p << ": the refinement with " << nthreads[i]
+                      << " threads is different from the one with 1 thread" << std::endl;
+            omp_set_num_threads(max_threads);
+            return false;
+        }
+    }
+
+    omp_set_num_threads(max_threads);
+    return true;
+}
+
+/// Refine the hierarchical B-Splines patches with different number of threads. The basis functions, their Id, equation
+/// Id and control points, and the cells must be identical.
+int main(int argc, char** argv)
+{
+    std::size_t n = 32;
+    if (argc > 1)
+        n = atoi(argv[1]);
+
+    if (!Check<2>(n, 2)) return 1;
+    if (!Check<2>(n, 3)) return 1;
+    if (!Check<3>(n/4, 2)) return 1;
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <set>
+#include <map>
+#include <algorithm>
+#include "includes/define.h"
+#include "custom_utilities/hbsplines/hbsplines_refinement_utility.h"
+#include "test_hbsplines_utils.h"
+
+using namespace Kratos;
+
+/// Create a hierarchical B-Splines patch of order p with n x n (x n) elements representing the identity map of the
+/// unit square/cube, i.e. the control points are the Greville abscissae. The refined bfs are kept for the coarsening.
+template<int TDim>
+typename Patch<TDim>::Pointer CreateIdentityPatch(const std::size_t& n, const std::size_t& p, typename MultiPatch<TDim>::Pointer& pMultiPatch)
+{
+    typename Patch<TDim>::Pointer pPatch = CreateIdentityPatch<TDim>(n, p, pMultiPatch);
+
+    typedef HBSplinesFESpace<TDim> FESpaceType;
+    typename FESpaceType::Pointer pFESpace = boost::dynamic_pointer_cast<FESpaceType>(pPatch->pFESpace());
+    pFESpace->SetCoarseningEnabled(true);
+    for (typename FESpaceType::bf_iterator it = pFESpace->bf_begin(); it != pFESpace->bf_end(); ++it)
+    {
+        ControlPoint<double>& rPoint = (*it)->GetValue(CONTROL_POINT);
+        for (int dim = 0; dim < 3; ++dim)
+            rPoint[dim] = 0.0;
+        rPoint[3] = 1.0;
+
+        for (int dim = 0; dim < TDim; ++dim)
+        {
+            std::vector<double> knots;
+            (*it)->LocalKnots(dim, knots);
+            for (std::size_t i = 1; i < knots.size() - 1; ++i)
+                rPoint[dim] += knots[i] / p;
+        }
+    }
+
+    return pPatch;
+}
+
+/// Check that the patch still represents the identity map, i.e. on each cell the Bezier control points in each
+/// direction span the cell and are centered in it, and the weights are one. The widths of the cells in each direction
+/// are collected.
+template<int TDim>
+double ComputeError(typename Patch<TDim>::Pointer pPatch, std::vector<std::set<long long> >& rWidths)
+{
+    typedef HBSplinesFESpace<TDim> FESpaceType;
+    typename FESpaceType::Pointer pFESpace = boost::dynamic_pointer_cast<FESpaceType>(pPatch->pFESpace());
+    pFESpace->UpdateCells();
+
+    rWidths.clear();
+    rWidths.resize(TDim);
+
+    double error = 0.0;
+    for (typename FESpaceType::cell_container_t::iterator it = pFESpace->pCellManager()->begin(); it != pFESpace->pCellManager()->end(); ++it)
+    {
+        const Matrix B = ComputeBezierPoints<TDim>(pFESpace, *it);
+
+        std::vector<double> bounds;
+        bounds.push_back((*it)->XiMinValue());
+        bounds.push_back((*it)->XiMaxValue());
+        bounds.push_back((*it)->EtaMinValue());
+        bounds.push_back((*it)->EtaMaxValue());
+        bounds.push_back((*it)->ZetaMinValue());
+        bounds.push_back((*it)->ZetaMaxValue());
+
+        for (int dim = 0; dim < TDim; ++dim)
+        {
+            double vmin = 1.0e99, vmax = -1.0e99, mean = 0.0;
+            for (std::size_t j = 0; j < B.size1(); ++j)
+            {
+                vmin = std::min(vmin, B(j, dim));
+                vmax = std::max(vmax, B(j, dim));
+                mean += B(j, dim) / B.size1();
+            }
+
+            error = std::max(error, std::fabs(vmin - bounds[2*dim]));
+            error = std::max(error, std::fabs(vmax - bounds[2*dim+1]));
+            error = std::max(error, std::fabs(mean - 0.5*(bounds[2*dim] + bounds[2*dim+1])));
+            rWidths[dim].insert(static_cast<long long>(std::floor((bounds[2*dim+1] - bounds[2*dim]) * 1.0e8 + 0.5)));
+        }
+
+        for (std::size_t j = 0; j < B.size1(); ++j)
+            error = std::max(error, std::fabs(B(j, 3) - 1.0));
+    }
+
+    return error;
+}
+
+/// Check if the set of the cell widths in a direction is as expected, the widths are given in multiples of 1/(12n)
+bool CheckWidths(const std::set<long long>& rWidths, const std::size_t& n, const std::vector<int>& expected)
+{
+    std::set<long long> widths;
+    for (std::size_t i = 0; i < expected.size(); ++i)
+        widths.insert(static_cast<long long>(std::floor(expected[i] / (12.0*n) * 1.0e8 + 0.5)));
+    return widths == rWidths;
+}
+
+/// Refine the patch anisotropically at the first level, with 2 inserted knots in the first direction and none in the
+/// others, and with a graded insertion at the second level. The patch must represent the same geometry at each step,
+/// also in the truncated basis, and the cells must have the expected widths.
+template<int TDim>
+bool Check(const std::size_t& n, const std::size_t& p)
+{
+    const double tol = 1.0e-10;
+
+    typename MultiPatch<TDim>::Pointer pMultiPatch;
+    typename Patch<TDim>::Pointer pPatch = CreateIdentityPatch<TDim>(n, p, pMultiPatch);
+    typename HBSplinesFESpace<TDim>::Pointer pFESpace = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatch->pFESpace());
+    const std::size_t nbfs = pFESpace->TotalNumber();
+
+    pFESpace->SetNumberOfInsertedKnots(1, 0, 2);
+    for (int dim = 1; dim < TDim; ++dim)
+        pFESpace->SetRefinementRatios(1, dim, std::vector<double>());
+    pFESpace->SetRefinementRatios(2, 0, std::vector<double>());
+    pFESpace->SetRefinementRatios(2, 1, std::vector<double>(1, 0.25));
+
+    std::vector<std::set<long long> > widths;
+    HBSplinesRefinementUtility::RefineWindow<TDim>(pPatch, Window<TDim>(0.0, 0.6), 0);
+    double error = ComputeError<TDim>(pPatch, widths);
+    if (error > tol || !CheckWidths(widths[0], n, std::vector<int>{4, 12}) || !CheckWidths(widths[1], n, std::vector<int>{12}))
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the anisotropic refinement is wrong, error = " << error << std::endl;
+        return false;
+    }
+
+    // the ratios of a refined level are fixed
+    bool is_thrown = false;
+    try
+    {
+        pFESpace->SetRefinementRatios(1, 0, std::vector<double>(1, 0.5));
+    }
+    catch (std::exception& e)
+    {
+        is_thrown = true;
+    }
+    if (!is_thrown)
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the refinement ratios of a refined level are changed" << std::endl;
+        return false;
+    }
+
+    HBSplinesRefinementUtility::RefineWindow<TDim>(pPatch, Window<TDim>(0.0, 0.4), 0);
+    error = ComputeError<TDim>(pPatch, widths);
+    if (error > tol || !CheckWidths(widths[0], n, std::vector<int>{4, 12}) || !CheckWidths(widths[1], n, std::vector<int>{3, 9, 12}))
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the graded refinement is wrong, error = " << error << std::endl;
+        return false;
+    }
+
+    HBSplinesRefinementUtility::LinearDependencyRefine<TDim>(pPatch, 0, 0);
+    error = ComputeError<TDim>(pPatch, widths);
+    if (error > tol)
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the linear dependency refinement is wrong, error = " << error << std::endl;
+        return false;
+    }
+
+    HBSplinesRefinementUtility::SetTruncation<TDim>(pPatch, true);
+    error = ComputeError<TDim>(pPatch, widths);
+    HBSplinesRefinementUtility::SetTruncation<TDim>(pPatch, false);
+    if (error > tol)
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the truncation is wrong, error = " << error << std::endl;
+        return false;
+    }
+
+    HBSplinesRefinementUtility::CoarsenWindow<TDim>(pPatch, Window<TDim>(0.0, 1.0), 0);
+    error = ComputeError<TDim>(pPatch, widths);
+    if (error > tol || pFESpace->TotalNumber() != nbfs)
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the coarsening is wrong, error = " << error << ", " << pFESpace->TotalNumber()
+                  << " bfs instead of " << nbfs << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/// Check the anisotropic and graded refinement of the hierarchical B-Splines patches
+int main(int argc, char** argv)
+{
+    std::size_t n = 8;
+    if (argc > 1)
+        n = atoi(argv[1]);
+
+    if (!Check<2>(n, 2)) return 1;
+    if (!Check<2>(n, 3)) return 1;
+    if (!Check<3>(n/2, 2)) return 1;
+
+    return 0;
+}
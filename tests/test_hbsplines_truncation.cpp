@@ -0,0 +1,244 @@
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <set>
+#include <map>
+#include <algorithm>
+#include "includes/define.h"
+#include "custom_utilities/bezier_utils.h"
+#include "custom_utilities/hbsplines/hbsplines_refinement_utility.h"
+#include "test_hbsplines_utils.h"
+
+using namespace Kratos;
+
+/// Compute the Bezier control points of all the cells, i.e. the sum of the homogeneous control points of the anchors
+/// weighted by the extraction operator, and the number of nonzeros of the system matrix, i.e. the number of the pairs
+/// of equation ids sharing a cell
+template<int TDim>
+void Extract(typename Patch<TDim>::Pointer pPatch, std::map<std::size_t, Matrix>& rBezierPoints, std::size_t& nnz)
+{
+    typedef HBSplinesFESpace<TDim> FESpaceType;
+    typename FESpaceType::Pointer pFESpace = boost::dynamic_pointer_cast<FESpaceType>(pPatch->pFESpace());
+    pFESpace->UpdateCells();
+
+    rBezierPoints.clear();
+    std::set<std::pair<std::size_t, std::size_t> > pairs;
+    for (typename FESpaceType::cell_container_t::iterator it = pFESpace->pCellManager()->begin(); it != pFESpace->pCellManager()->end(); ++it)
+    {
+        const std::vector<std::size_t>& anchors = (*it)->GetSupportedAnchors();
+        for (std::size_t i = 0; i < anchors.size(); ++i)
+            for (std::size_t j = 0; j < anchors.size(); ++j)
+                pairs.insert(std::make_pair(anchors[i], anchors[j]));
+        rBezierPoints[(*it)->Id()] = ComputeBezierPoints<TDim>(pFESpace, *it);
+    }
+
+    nnz = pairs.size();
+}
+
+/// Compute the maximum difference of the Bezier control points of the cells
+double Difference(std::map<std::size_t, Matrix>& rPoints1, std::map<std::size_t, Matrix>& rPoints2)
+{
+    if (rPoints1.size() != rPoints2.size())
+        return 1.0e99;
+
+    double diff = 0.0;
+    for (std::map<std::size_t, Matrix>::iterator it = rPoints1.begin(); it != rPoints1.end(); ++it)
+    {
+        const Matrix& B = rPoints2[it->first];
+        if (B.size1() != it->second.size1())
+            return 1.0e99;
+        for (std::size_t i = 0; i < B.size1(); ++i)
+            for (std::size_t j = 0; j < B.size2(); ++j)
+                diff = std::max(diff, std::fabs(B(i, j) - it->second(i, j)));
+    }
+
+    return diff;
+}
+
+/// Evaluate the basis functions and their derivatives at a point inside each cell of the patch and return the maximum
+/// difference to the ones given by the extraction operator of the cell. The basis functions which are not anchors of the cell must vanish.
+template<int TDim>
+double ComputeEvaluationError(typename Patch<TDim>::Pointer pPatch)
+{
+    typedef HBSplinesFESpace<TDim> FESpaceType;
+    typename FESpaceType::Pointer pFESpace = boost::dynamic_pointer_cast<FESpaceType>(pPatch->pFESpace());
+    pFESpace->UpdateCells();
+
+    const double t[] = {0.3, 0.6, 0.45};
+    double error = 0.0;
+    std::vector<double> values;
+    std::vector<std::vector<double> > derivatives;
+    for (typename FESpaceType::cell_container_t::iterator it = pFESpace->pCellManager()->begin(); it != pFESpace->pCellManager()->end(); ++it)
+    {
+        const double bounds[] = {(*it)->XiMinValue(), (*it)->XiMaxValue(), (*it)->EtaMinValue(), (*it)->EtaMaxValue(),
+            (*it)->ZetaMinValue(), (*it)->ZetaMaxValue()};
+        std::vector<double> xi(TDim);
+        for (int dim = 0; dim < TDim; ++dim)
+            xi[dim] = bounds[2*dim] + t[dim] * (bounds[2*dim+1] - bounds[2*dim]);
+        pFESpace->GetValues(values, xi);
+        pFESpace->GetDerivatives(derivatives, xi);
+
+        // the Bernstein polynomials and their derivatives w.r.t xi on the cell, the last direction runs fastest as in
+        // the extraction operator
+        std::vector<double> bernstein(1, 1.0);
+        std::vector<std::vector<double> > bernstein_derivatives(TDim, std::vector<double>(1, 1.0));
+        for (int dim = 0; dim < TDim; ++dim)
+        {
+            const int p = static_cast<int>(pFESpace->Order(dim));
+            const double scale = 1.0 / (bounds[2*dim+1] - bounds[2*dim]);
+            std::vector<double> b(p + 1), db(p + 1);
+            for (int j = 0; j < p + 1; ++j)
+                BezierUtils::bernstein(b[j], db[j], j, p, t[dim]);
+
+            std::vector<double> product;
+            for (std::size_t i = 0; i < bernstein.size(); ++i)
+                for (int j = 0; j < p + 1; ++j)
+                    product.push_back(bernstein[i] * b[j]);
+            bernstein.swap(product);
+
+            for (int dim2 = 0; dim2 < TDim; ++dim2)
+            {
+                product.clear();
+                for (std::size_t i = 0; i < bernstein_derivatives[dim2].size(); ++i)
+                    for (int j = 0; j < p + 1; ++j)
+                        product.push_back(bernstein_derivatives[dim2][i] * ((dim2 == dim) ? scale * db[j] : b[j]));
+                bernstein_derivatives[dim2].swap(product);
+            }
+        }
+
+        std::vector<double> expected(values.size(), 0.0);
+        std::vector<std::vector<double> > expected_derivatives(values.size(), std::vector<double>(TDim, 0.0));
+        const std::vector<std::size_t>& anchors = (*it)->GetSupportedAnchors();
+        Matrix C = (*it)->GetExtractionOperator();
+        for (std::size_t i = 0; i < anchors.size(); ++i)
+        {
+            const std::size_t local_id = pFESpace->LocalId(anchors[i]);
+            for (std::size_t j = 0; j < C.size2(); ++j)
+            {
+                expected[local_id] += C(i, j) * bernstein[j];
+                for (int dim = 0; dim < TDim; ++dim)
+                    expected_derivatives[local_id][dim] += C(i, j) * bernstein_derivatives[dim][j];
+            }
+        }
+
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            error = std::max(error, std::fabs(values[i] - expected[i]));
+
+            double v;
+            pFESpace->GetValue(v, i, xi);
+            error = std::max(error, std::fabs(v - expected[i]));
+
+            // the derivatives are compared w.r.t the local coordinates of the cell
+            for (int dim = 0; dim < TDim; ++dim)
+                error = std::max(error, (bounds[2*dim+1] - bounds[2*dim]) * std::fabs(derivatives[i][dim] - expected_derivatives[i][dim]));
+        }
+    }
+
+    return error;
+}
+
+/// Refine the patch, switch it to the truncated basis and back; the geometry must not change, the truncated basis
+/// must form a partition of unity with fewer nonzeros in the system matrix, and the FESpace must evaluate the basis
+/// functions given by the extraction operators
+template<int TDim>
+bool Check(const std::size_t& n, const std::size_t& p)
+{
+    const double tol = 1.0e-10;
+
+    typename MultiPatch<TDim>::Pointer pMultiPatch;
+    typename Patch<TDim>::Pointer pPatch = CreateHBSplinesPatch<TDim>(n, p, pMultiPatch);
+    typename HBSplinesFESpace<TDim>::Pointer pFESpace = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatch->pFESpace());
+
+    for (std::size_t cycle = 0; cycle < 2; ++cycle)
+        HBSplinesRefinementUtility::RefineWindow<TDim>(pPatch, Window<TDim>(0.0, 0.5 - 0.2*cycle), 0);
+
+    std::map<std::size_t, Matrix> hb_points, thb_points, back_points;
+    std::size_t hb_nnz, thb_nnz, back_nnz;
+    Extract<TDim>(pPatch, hb_points, hb_nnz);
+    const double hb_evaluation_error = ComputeEvaluationError<TDim>(pPatch);
+
+    HBSplinesRefinementUtility::SetTruncation<TDim>(pPatch, true);
+    Extract<TDim>(pPatch, thb_points, thb_nnz);
+    const double thb_evaluation_error = ComputeEvaluationError<TDim>(pPatch);
+
+    double max_weight_error = 0.0;
+    for (typename HBSplinesFESpace<TDim>::bf_iterator it = pFESpace->bf_begin(); it != pFESpace->bf_end(); ++it)
+        max_weight_error = std::max(max_weight_error, std::fabs((*it)->GetValue(CONTROL_POINT).W() - 1.0));
+
+    HBSplinesRefinementUtility::SetTruncation<TDim>(pPatch, false);
+    Extract<TDim>(pPatch, back_points, back_nnz);
+
+    const double thb_error = Difference(hb_points, thb_points);
+    const double back_error = Difference(hb_points, back_points);
+
+    if (thb_error > tol || back_error > tol)
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the geometry is changed by the truncation, error = "
+                  << std::max(thb_error, back_error) << std::endl;
+        return false;
+    }
+
+    if (max_weight_error > tol)
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the truncated basis functions do not form a partition of unity, error = "
+                  << max_weight_error << std::endl;
+        return false;
+    }
+
+    if (hb_evaluation_error > tol || thb_evaluation_error > tol)
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the basis functions evaluated by the FESpace are different from the ones"
+                  << " given by the extraction operators, error HB = " << hb_evaluation_error << ", THB = " << thb_evaluation_error << std::endl;
+        return false;
+    }
+
+    if (thb_nnz >= hb_nnz || back_nnz != hb_nnz)
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the truncated basis does not reduce the nonzeros of the system matrix, nnz HB = "
+                  << hb_nnz << ", THB = " << thb_nnz << std::endl;
+        return false;
+    }
+
+    // refining a truncated patch must give the same patch as refining the hierarchical patch
+    typename MultiPatch<TDim>::Pointer pMultiPatch2;
+    typename Patch<TDim>::Pointer pPatch2 = CreateHBSplinesPatch<TDim>(n, p, pMultiPatch2);
+    HBSplinesRefinementUtility::SetTruncation<TDim>(pPatch2, true);
+
+    for (std::size_t cycle = 0; cycle < 3; ++cycle)
+    {
+        const std::vector<std::vector<double> > window = Window<TDim>(0.3*(cycle/2), 0.5 - 0.2*cycle + 0.7*(cycle/2));
+        if (cycle == 2)
+            HBSplinesRefinementUtility::RefineWindow<TDim>(pPatch, window, 0);
+        HBSplinesRefinementUtility::RefineWindow<TDim>(pPatch2, window, 0);
+    }
+
+    typename HBSplinesFESpace<TDim>::Pointer pFESpace2 = boost::dynamic_pointer_cast<HBSplinesFESpace<TDim> >(pPatch2->pFESpace());
+    const bool is_truncated = pFESpace2->IsTruncated();
+    HBSplinesRefinementUtility::SetTruncation<TDim>(pPatch2, false);
+    Extract<TDim>(pPatch, hb_points, hb_nnz);
+    Extract<TDim>(pPatch2, back_points, back_nnz);
+
+    if (!is_truncated || Difference(hb_points, back_points) > tol)
+    {
+        std::cout << TDim << "D, n = " << n << ", p = " << p << ": the refinement of the truncated patch is different from the one of the"
+                  << " hierarchical patch" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/// Compare the hierarchical (HB) and the truncated hierarchical (THB) B-Splines on the same refinement pattern
+int main(int argc, char** argv)
+{
+    std::size_t n = 8;
+    if (argc > 1)
+        n = atoi(argv[1]);
+
+    if (!Check<2>(n, 2)) return 1;
+    if (!Check<2>(n, 3)) return 1;
+    if (!Check<3>(n/2, 2)) return 1;
+
+    return 0;
+}
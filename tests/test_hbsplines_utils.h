@@ -0,0 +1,88 @@
+//
+//   Project Name:        Kratos
+//   Last Modified by:    $Author: hbui $
+//   Date:                $Date: 18 Oct 2026 $
+//   Revision:            $Revision: 1.0 $
+//
+//
+
+#if !defined(KRATOS_ISOGEOMETRIC_APPLICATION_TEST_HBSPLINES_UTILS_H_INCLUDED)
+#define  KRATOS_ISOGEOMETRIC_APPLICATION_TEST_HBSPLINES_UTILS_H_INCLUDED
+
+// System includes
+#include <vector>
+
+// External includes
+
+// Project includes
+#include "includes/define.h"
+#include "custom_utilities/control_grid_library.h"
+#include "custom_utilities/multipatch.h"
+#include "custom_utilities/nurbs/bsplines_fespace_library.h"
+#include "custom_utilities/hbsplines/hbsplines_patch_utility.h"
+
+namespace Kratos
+{
+
+/// Create a hierarchical B-Splines patch of order p with n x n (x n) elements over the unit square/cube, and a multipatch
+/// containing it
+template<int TDim>
+typename Patch<TDim>::Pointer CreateHBSplinesPatch(const std::size_t& n, const std::size_t& p, typename MultiPatch<TDim>::Pointer& pMultiPatch)
+{
+    std::vector<std::size_t> numbers(TDim, n + p), orders(TDim, p);
+    typename FESpace<TDim>::Pointer pFESpace = BSplinesFESpaceLibrary::CreateUniformFESpace<TDim>(numbers, orders);
+
+    std::vector<double> start(TDim, 0.0), end(TDim, 1.0);
+    typename Patch<TDim>::Pointer pPatch = Patch<TDim>::Create(1, pFESpace);
+    pPatch->CreateControlPointGridFunction(ControlGridLibrary::CreateStructuredControlPointGrid<TDim>(start, numbers, end));
+
+    typename Patch<TDim>::Pointer pHBPatch = HBSplinesPatchUtility::CreatePatchFromBSplines<TDim>(pPatch);
+
+    pMultiPatch = typename MultiPatch<TDim>::Pointer(new MultiPatch<TDim>());
+    pMultiPatch->AddPatch(pHBPatch);
+    pMultiPatch->Enumerate();
+
+    return pHBPatch;
+}
+
+/// Create a window [a, b] in all directions
+template<int TDim>
+std::vector<std::vector<double> > Window(const double& a, const double& b)
+{
+    std::vector<std::vector<double> > window(TDim);
+    for (std::size_t dim = 0; dim < TDim; ++dim)
+    {
+        window[dim].push_back(a);
+        window[dim].push_back(b);
+    }
+    return window;
+}
+
+/// Compute the Bezier control points of a cell, i.e. the sum of the homogeneous control points of the anchors weighted
+/// by the extraction operator. Each row of the result is (wx, wy, wz, w).
+template<int TDim>
+Matrix ComputeBezierPoints(typename HBSplinesFESpace<TDim>::Pointer pFESpace, typename HBSplinesFESpace<TDim>::cell_t pCell)
+{
+    const std::vector<std::size_t>& anchors = pCell->GetSupportedAnchors();
+    Matrix C = pCell->GetExtractionOperator();
+
+    Matrix B(C.size2(), 4);
+    noalias(B) = ZeroMatrix(C.size2(), 4);
+    for (std::size_t i = 0; i < anchors.size(); ++i)
+    {
+        const ControlPoint<double>& rPoint = pFESpace->pGetBfByEquationId(anchors[i])->GetValue(CONTROL_POINT);
+        for (std::size_t j = 0; j < C.size2(); ++j)
+        {
+            B(j, 0) += C(i, j) * rPoint.WX();
+            B(j, 1) += C(i, j) * rPoint.WY();
+            B(j, 2) += C(i, j) * rPoint.WZ();
+            B(j, 3) += C(i, j) * rPoint.W();
+        }
+    }
+
+    return B;
+}
+
+} // namespace Kratos.
+
+#endif // KRATOS_ISOGEOMETRIC_APPLICATION_TEST_HBSPLINES_UTILS_H_INCLUDED defined
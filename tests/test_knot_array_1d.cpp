@@ -27,6 +27,15 @@ int main(int argc, char** argv)
     KRATOS_WATCH(std::get<1>(span)->Index())
     KRATOS_WATCH(std::get<1>(span)->Value())
 
+    // the handles do not change when knots are inserted before
+    knot_t p_knot = knot_vector.pCreateUniqueKnot(0.5, 1.0e-10);
+    knot_vector.pCreateKnot(0.25);
+    if (knot_vector.pKnotByHandle(p_knot->Handle()) != p_knot || p_knot->Index() != 5)
+    {
+        std::cout << "The knot handle or index is wrong: " << *p_knot << std::endl;
+        return 1;
+    }
+
     return 0;
 }
 
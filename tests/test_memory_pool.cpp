@@ -0,0 +1,119 @@
+#include <iostream>
+#include <cstdlib>
+#include <new>
+#include <set>
+#include "includes/define.h"
+#include "custom_utilities/memory_pool.h"
+#include "custom_utilities/nurbs/knot_array_1d.h"
+#include "custom_utilities/nurbs/bcell.h"
+
+using namespace Kratos;
+
+/// count the calls to the global allocation functions
+static std::size_t number_of_heap_allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    ++number_of_heap_allocations;
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t size) noexcept
+{
+    std::free(p);
+}
+
+/// Check that the cells created in a memory pool take fewer heap allocations than the cells created by new, that the
+/// released cells are returned to the pool and that their blocks are reused without going to the heap
+int main(int argc, char** argv)
+{
+    typedef KnotArray1D<double> knot_container_t;
+    typedef knot_container_t::knot_t knot_t;
+
+    std::size_t n = 10000;
+    if (argc > 1)
+        n = atoi(argv[1]);
+
+    knot_container_t knots;
+    knot_t pLeft = knots.pCreateKnot(0.0);
+    knot_t pRight = knots.pCreateKnot(1.0);
+
+    std::vector<BCell::Pointer> cells;
+    cells.reserve(n);
+
+    std::size_t start = number_of_heap_allocations;
+    for (std::size_t i = 0; i < n; ++i)
+        cells.push_back(BCell::Pointer(new BCell(i, pLeft, pRight, pLeft, pRight, pLeft, pRight)));
+    std::size_t heap_allocations = number_of_heap_allocations - start;
+    cells.clear();
+
+    // without a pool the cells are created on the heap
+    if (MemoryPool::Create<BCell>(MemoryPool::Pointer(), 0, pLeft, pRight, pLeft, pRight, pLeft, pRight) == NULL)
+    {
+        std::cout << "The cell is not created without a memory pool" << std::endl;
+        return 1;
+    }
+
+    MemoryPool::Pointer pPool = MemoryPool::Pointer(new MemoryPool());
+    start = number_of_heap_allocations;
+    for (std::size_t i = 0; i < n; ++i)
+        cells.push_back(MemoryPool::Create<BCell>(pPool, i, pLeft, pRight, pLeft, pRight, pLeft, pRight));
+    std::size_t pool_allocations = number_of_heap_allocations - start;
+
+    if (pPool->NumberOfAllocations() != n || pPool->NumberOfDeallocations() != 0 || pool_allocations * 10 > heap_allocations)
+    {
+        std::cout << "The memory pool does not reduce the number of heap allocations: " << pool_allocations << " instead of "
+                  << heap_allocations << " for " << n << " cells, " << *pPool << std::endl;
+        return 1;
+    }
+
+    std::set<const BCell*> addresses;
+    for (std::size_t i = 0; i < cells.size(); ++i)
+        addresses.insert(cells[i].get());
+
+    // the released cells are returned to the pool
+    cells.clear();
+    const std::size_t nchunks = pPool->NumberOfChunks();
+    const std::size_t memory_usage = pPool->MemoryUsage();
+    if (pPool->NumberOfDeallocations() != n)
+    {
+        std::cout << "The released cells are not returned to the memory pool, " << *pPool << std::endl;
+        return 1;
+    }
+
+    // the blocks of the released cells are reused without going to the heap
+    start = number_of_heap_allocations;
+    for (std::size_t i = 0; i < n; ++i)
+        cells.push_back(MemoryPool::Create<BCell>(pPool, i, pLeft, pRight, pLeft, pRight, pLeft, pRight));
+    std::size_t recycled_allocations = number_of_heap_allocations - start;
+
+    bool is_reused = true;
+    for (std::size_t i = 0; i < cells.size(); ++i)
+        if (addresses.find(cells[i].get()) == addresses.end())
+            is_reused = false;
+
+    if (recycled_allocations != 0 || !is_reused || pPool->NumberOfAllocations() != 2*n
+        || pPool->NumberOfChunks() != nchunks || pPool->MemoryUsage() != memory_usage)
+    {
+        std::cout << "The blocks of the released cells are not reused, " << recycled_allocations << " heap allocations, "
+                  << *pPool << std::endl;
+        return 1;
+    }
+
+    cells.clear();
+    if (pPool->NumberOfDeallocations() != 2*n)
+    {
+        std::cout << "The reused cells are not returned to the memory pool, " << *pPool << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
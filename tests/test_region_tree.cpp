@@ -0,0 +1,189 @@
+#include <iostream>
+#include <cstdlib>
+#include <set>
+#include "includes/define.h"
+#include "custom_utilities/region_tree.h"
+
+using namespace Kratos;
+
+typedef RegionTree<2> tree_2d_t;
+typedef tree_2d_t::index_t index_2d_t;
+
+/// Add the cells in the box [lo, hi) to a reference set of cells
+template<int TDim>
+void InsertReference(std::set<std::array<std::size_t, TDim> >& cells, const std::array<std::size_t, TDim>& lo, const std::array<std::size_t, TDim>& hi)
+{
+    for (int d = 0; d < TDim; ++d)
+        if (lo[d] >= hi[d])
+            return;
+
+    std::array<std::size_t, TDim> cell = lo;
+    while (true)
+    {
+        cells.insert(cell);
+        int d = 0;
+        while (d < TDim)
+        {
+            if (++cell[d] < hi[d])
+                break;
+            cell[d] = lo[d];
+            ++d;
+        }
+        if (d == TDim)
+            break;
+    }
+}
+
+/// Check if all the cells in the box [lo, hi) are in a reference set of cells
+template<int TDim>
+bool ContainsReference(const std::set<std::array<std::size_t, TDim> >& cells, const std::array<std::size_t, TDim>& lo, const std::array<std::size_t, TDim>& hi)
+{
+    std::set<std::array<std::size_t, TDim> > box;
+    InsertReference<TDim>(box, lo, hi);
+    for (typename std::set<std::array<std::size_t, TDim> >::const_iterator it = box.begin(); it != box.end(); ++it)
+        if (cells.find(*it) == cells.end())
+            return false;
+    return true;
+}
+
+/// Insert random boxes into the tree and compare Contains and GetCells with a brute-force set of cells
+template<int TDim>
+int CheckRandomBoxes(const std::size_t& n, const std::size_t& nboxes, const std::size_t& nqueries)
+{
+    typedef RegionTree<TDim> tree_t;
+    typedef typename tree_t::index_t index_t;
+
+    tree_t tree;
+    std::set<index_t> reference;
+
+    for (std::size_t b = 0; b < nboxes; ++b)
+    {
+        index_t lo, hi;
+        for (int d = 0; d < TDim; ++d)
+        {
+            lo[d] = rand() % n;
+            hi[d] = lo[d] + 1 + rand() % (n/4);
+        }
+        tree.Insert(lo, hi);
+        InsertReference<TDim>(reference, lo, hi);
+
+        for (std::size_t q = 0; q < nqueries; ++q)
+        {
+            index_t qlo, qhi;
+            for (int d = 0; d < TDim; ++d)
+            {
+                qlo[d] = rand() % (n + n/4);
+                qhi[d] = qlo[d] + 1 + rand() % 4;
+            }
+            if (tree.Contains(qlo, qhi) != ContainsReference<TDim>(reference, qlo, qhi))
+            {
+                std::cout << "Contains is not correct in " << TDim << "D after " << b+1 << " boxes" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    std::vector<index_t> cells;
+    tree.GetCells(cells);
+    if (cells != std::vector<index_t>(reference.begin(), reference.end()))
+    {
+        std::cout << "GetCells is not correct in " << TDim << "D" << std::endl;
+        return 1;
+    }
+
+    std::cout << tree << "random boxes in " << TDim << "D: " << cells.size() << " cells" << std::endl;
+    return 0;
+}
+
+/// Check the insertion, the search and the node management of RegionTree against a brute-force set of cells
+int main(int argc, char** argv)
+{
+    std::size_t n = 32;
+    if (argc > 1)
+        n = atoi(argv[1]);
+
+    // the empty box is always contained, the cells outside the tree are not
+    {
+        tree_2d_t tree;
+        index_2d_t lo = {2, 3}, hi = {2, 5}, far = {100, 100}, far_hi = {101, 101};
+        if (!tree.Contains(lo, hi) || tree.Contains(far, far_hi))
+        {
+            std::cout << "Contains is not correct for the empty box or the box outside the tree" << std::endl;
+            return 1;
+        }
+    }
+
+    // the four quadrants which are inserted separately are merged into a single full node
+    {
+        tree_2d_t tree;
+        index_2d_t q_lo[] = {{0, 0}, {4, 0}, {0, 4}, {4, 4}};
+        for (int c = 0; c < 4; ++c)
+        {
+            index_2d_t q_hi = {q_lo[c][0] + 4, q_lo[c][1] + 4};
+            tree.Insert(q_lo[c], q_hi);
+        }
+
+        index_2d_t lo = {0, 0}, hi = {8, 8};
+        if (tree.Size() != 8 || tree.NumberOfNodes() != 1 || !tree.Contains(lo, hi))
+        {
+            std::cout << "The full siblings are not merged: " << tree << std::endl;
+            return 1;
+        }
+    }
+
+    // the tree grows when the cells are inserted beyond its size, keeping the existing cells, and the released
+    // blocks of children are reused
+    {
+        tree_2d_t tree;
+        index_2d_t lo1 = {0, 0}, hi1 = {1, 1};
+        tree.Insert(lo1, hi1);
+        index_2d_t lo2 = {3, 3}, hi2 = {4, 4};
+        tree.Insert(lo2, hi2);
+        if (tree.Size() != 4 || !tree.Contains(lo1, hi1) || !tree.Contains(lo2, hi2))
+        {
+            std::cout << "The cells are not kept when the tree grows: " << tree << std::endl;
+            return 1;
+        }
+        const std::size_t number_of_nodes = tree.NumberOfNodes();
+
+        // filling the whole tree releases all the children
+        index_2d_t lo3 = {0, 0}, hi3 = {4, 4};
+        tree.Insert(lo3, hi3);
+        if (tree.NumberOfNodes() != 1)
+        {
+            std::cout << "The children are not released when the node becomes full: " << tree << std::endl;
+            return 1;
+        }
+        const std::size_t memory = tree.MemoryUsage();
+
+        // growing again and inserting the same number of levels reuses the released blocks
+        index_2d_t lo4 = {5, 5}, hi4 = {6, 6};
+        tree.Insert(lo4, hi4);
+        if (tree.Size() != 8 || !tree.Contains(lo3, hi3) || !tree.Contains(lo4, hi4))
+        {
+            std::cout << "The cells are not kept when the tree grows: " << tree << std::endl;
+            return 1;
+        }
+        if (tree.NumberOfNodes() != number_of_nodes || tree.MemoryUsage() != memory)
+        {
+            std::cout << "The released blocks are not reused: " << tree << std::endl;
+            return 1;
+        }
+
+        std::vector<index_2d_t> cells;
+        tree.GetCells(cells);
+        if (cells.size() != 17 || cells.front() != lo3 || cells.back() != lo4)
+        {
+            std::cout << "GetCells is not correct after the growth" << std::endl;
+            return 1;
+        }
+    }
+
+    srand(0);
+    if (CheckRandomBoxes<2>(n, 40, 50) != 0)
+        return 1;
+    if (CheckRandomBoxes<3>(n/2, 20, 50) != 0)
+        return 1;
+
+    return 0;
+}